@@ -0,0 +1,158 @@
+// include/audio.h
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+// Most parts one device can mix at once (ROLE_PART_1..ROLE_PART_4)
+#define AUDIO_MAX_VOICES  4
+
+// Synthesis cost of the voice mixer, measured in CPU cycles per audio block
+typedef struct {
+    uint8_t  voices;               // voices in the current/last song
+    uint32_t block_cycles_avg;     // all voices + mixdown, smoothed
+    uint32_t block_cycles_max;
+    uint32_t cycles_per_voice;     // avg / voices
+    uint32_t block_budget_cycles;  // one core's cycles per block period
+    uint32_t max_voices_est;       // budget / cycles_per_voice
+} audio_render_stats_t;
+
+// Command latency as seen by the engine (microseconds, esp_timer clock)
+typedef struct {
+    int64_t  play_last_us;   // PLAY posted -> first block of the song handed to I2S
+    int64_t  play_max_us;
+    uint32_t play_count;
+    int64_t  stop_last_us;   // STOP posted -> render-ahead ring flushed
+    int64_t  stop_max_us;
+    uint32_t stop_count;
+    int64_t  dma_tail_us;    // audio still in DMA after a flush (upper bound)
+} audio_latency_stats_t;
+
+// Tracking of the conductor timeline (see audio_sync_timeline)
+typedef struct {
+    uint32_t checks;         // timeline comparisons this song
+    int32_t  last_err_us;    // audible position - expected (+ = ahead)
+    int32_t  max_err_us;     // worst |err| after the first check
+    uint32_t skipped;        // single-sample slips
+    uint32_t repeated;
+    uint32_t jumps;          // hard corrections (> 10 ms off)
+} audio_timeline_stats_t;
+
+// DAC sample clock: samples actually clocked out, not samples written.
+// Counted from I2S DMA completions, so it advances by DMA_BUF_LEN steps;
+// audio_frames_played_at() interpolates between them.
+typedef struct {
+    uint64_t frames;         // samples played since boot, silence included
+    int64_t  t_us;           // esp_timer time the last DMA buffer completed
+    uint64_t written;        // samples handed to i2s_write()
+    uint64_t silence;        // samples the driver played with nothing of ours (idle, underruns)
+    int32_t  rate_ppm;       // DAC clock vs. esp_timer, + = fast; 0 for the first 2 s
+} audio_play_clock_t;
+
+// Latency profiles: render block, render-ahead ring and I2S DMA depth.
+// Smaller is lower latency but less tolerant of the engine being held off
+// (Wi-Fi bursts, flash writes). Pick one at build time with
+// -DAUDIO_PROFILE=AUDIO_PROFILE_..., or at run time below.
+typedef enum {
+    AUDIO_PROFILE_ULTRA_LOW = 0,
+    AUDIO_PROFILE_BALANCED,        // default
+    AUDIO_PROFILE_ROBUST,
+    AUDIO_PROFILE_COUNT
+} audio_profile_id_t;
+
+typedef struct {
+    const char *name;
+    uint16_t block_samples;        // render block (engine tick)
+    uint8_t  ring_blocks;          // render-ahead ring depth (power of two)
+    uint8_t  dma_buf_count;
+    uint16_t dma_buf_len;          // samples per DMA buffer
+} audio_profile_t;
+
+// PCM cache filled by audio_prerender()
+typedef struct {
+    uint32_t hits;                 // PLAYs that started from the cache
+    uint32_t misses;
+    uint32_t handovers;            // cached PLAYs that ran past it into synthesis
+    uint8_t  song_id;              // last song pre-rendered
+    uint32_t cached_ms;            // how much of it
+    uint32_t render_us;            // time the pre-render took
+    uint32_t bytes;                // buffer size
+    bool     psram;                // buffer is in PSRAM (whole song) vs internal (head only)
+    int64_t  first_block_hit_us;   // avg PLAY -> first block to I2S, cache hit
+    int64_t  first_block_miss_us;  // same, synthesized
+} audio_cache_stats_t;
+
+// Bring up I2S, the audio engine task and the I2S feeder
+void audio_init(void);
+
+// Playback control. These post commands to the long-lived audio engine task
+// and return immediately; audio_stop() waits (briefly) for the engine to
+// acknowledge, which happens within one audio block.
+void audio_play_song(uint8_t song_id);
+void audio_play_song_for_role(uint8_t song_id, uint8_t role);
+// Play 'role' plus every part in extra_parts (PART_1..PART_4 bits) mixed together
+void audio_play_song_parts(uint8_t song_id, uint8_t role, uint8_t extra_parts);
+// Same, with song position 0 at local esp_timer time epoch_us: if that is
+// already past, playback starts mid-song at the matching note and sample
+// (e.g. a performer joining late). 0 plays from the top.
+void audio_play_song_parts_at(uint8_t song_id, uint8_t role, uint8_t extra_parts, int64_t epoch_us);
+void audio_seek_ms(uint32_t ms);
+// Pre-render this device's mix (role + extra_parts) of song_id in the
+// background, e.g. on SELECT: the whole song if PSRAM is available, else
+// its first AUDIO_CACHE_HEAD_MS. A later PLAY of the same song/role/parts
+// starts by copying PCM instead of synthesizing and hands over to synthesis
+// where the cache ends (phase-exact for enveloped voices). A newer request replaces an older one.
+void audio_prerender(uint8_t song_id, uint8_t role, uint8_t extra_parts);
+// Empty the PCM cache and stop any pre-render in progress; returns once the
+// cache task no longer reads song data. Call with playback stopped, before
+// the song library changes (song ids then mean other songs).
+void audio_cache_drop(void);
+// The song should be at song_us (conductor timeline) at local time at_us.
+// The engine compares that with the sample at the DAC at at_us (DAC sample
+// clock) and corrects by skipping or repeating single samples, spread one
+// per block.
+void audio_sync_timeline(int64_t song_us, int64_t at_us);
+void audio_stop(void);
+void audio_set_volume(float vol);
+bool audio_is_playing(void);
+
+// Snapshot of the DAC sample clock
+void audio_get_play_clock(audio_play_clock_t *out);
+// Samples the DAC will have played by local esp_timer time t_us (monotonic,
+// extrapolated from the last DMA completion; t_us may be in the future)
+uint64_t audio_frames_played_at(int64_t t_us);
+
+// Pipeline health: rendered blocks queued ahead of I2S, ring size, and how
+// many times the feeder found the ring empty mid-song (audible gap risk).
+uint32_t audio_get_buffer_fill(void);
+uint32_t audio_get_buffer_capacity(void);
+uint32_t audio_get_underrun_count(void);
+
+// Voice mixer cost for the current/last song
+void audio_get_render_stats(audio_render_stats_t *out);
+
+// PCM cache use, memory and first-block latency with and without it
+void audio_get_cache_stats(audio_cache_stats_t *out);
+
+// Timeline error and corrections for the current/last song
+void audio_get_timeline_stats(audio_timeline_stats_t *out);
+
+// Latency of the last/worst PLAY and STOP commands
+void audio_get_latency_stats(audio_latency_stats_t *out);
+
+// Profile table entry (NULL if out of range) and the one in use
+const audio_profile_t *audio_get_profile(audio_profile_id_t id);
+audio_profile_id_t audio_get_profile_id(void);
+// Output latency of a profile: full render-ahead ring plus DMA
+uint32_t audio_profile_latency_us(const audio_profile_t *p);
+// Switch profile. Stops playback and reinstalls the I2S driver (a few ms of
+// silence); before audio_init() it just picks the boot profile.
+esp_err_t audio_set_profile(audio_profile_id_t id);
+// Try profiles from the smallest up, playing every part of song_id for
+// tone_ms each, and keep the first with no underrun. Logs the chosen
+// output latency. Blocks the caller.
+audio_profile_id_t audio_autotune_profile(uint8_t song_id, uint32_t tone_ms);
+
+// Run 'rounds' PLAY/STOP cycles and log the latency figures (blocks caller)
+void audio_run_latency_benchmark(uint8_t song_id, uint8_t role, int rounds);
@@ -0,0 +1,207 @@
+// include/blob_xfer.h
+#pragma once
+
+// Bulk transfer of one blob (a song library or firmware image) from the
+// conductor to every performer, in frames that fit ESP-NOW. Frame types
+// are WIRE_T_BLOB + blob_msg_type_t; payloads are little-endian:
+//
+//   OFFER   id u16, kind u8, len u32, chunk u16, n_chunks u16, hash u64
+//   DATA    id u16, index u16, crc u16, chunk bytes (the last may be short)
+//   POLL    id u16
+//   STATUS  id u16, state u8, have u16, base u16, nbits u16, bitmap
+//
+// hash is FNV-1a 64 of the whole blob, crc is CRC-16/CCITT (wire_crc16) of
+// one chunk. STATUS is a selective NACK: bit i of the bitmap set means
+// chunk base+i is still missing, base being the first missing chunk.
+//
+// Sender: OFFER, and once a peer has answered with a STATUS one pass of
+// every chunk by broadcast, then rounds of POLL and repair. A chunk still
+// missing at two or more peers is broadcast again, one missing at a single
+// peer goes to it by unicast. Peers that have not answered the OFFER keep
+// getting it in between and catch up through the repairs; a peer silent
+// for max_silent OFFERs or POLLs in a row is given up. Frames are paced
+// (gap_us) and a send the radio refuses is retried.
+//
+// Receiver: each chunk goes to the sink, is read back and checked against
+// its CRC (a chunk that does not read back stays missing). Once all are
+// held the stored blob is hashed; a match commits it, a mismatch begins
+// the sink again and requests everything (BLOB_HASH_TRIES times). The
+// receiver reports DONE on its own when it finishes, so the last round
+// needs no POLL.
+//
+// No radio, flash or RTOS calls: the caller supplies time, a send function
+// and the storage, so the same code runs on the device and in host
+// simulations (tools/blob_sim.c).
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "wire_proto.h"
+
+#define BLOB_MAX_PEERS      8
+#define BLOB_DATA_HDR       6
+#define BLOB_CHUNK_MAX      (WIRE_MAX_PAYLOAD - BLOB_DATA_HDR)   // 234 bytes
+#define BLOB_MAX_CHUNKS     8192      // receiver bitmap 1 KB, ~1.9 MB blobs
+#define BLOB_STATUS_BITS    1024      // missing chunks reported per STATUS
+#define BLOB_FRAME_GAP_US   2500      // default pacing, ~90 KB/s ceiling
+#define BLOB_BURST          8         // frames per poll when catching up
+#define BLOB_OFFER_RETRY_US 50000
+#define BLOB_POLL_WAIT_US   40000     // for STATUS replies after a POLL
+#define BLOB_MAX_SILENT     12        // default unanswered OFFERs/POLLs before giving up
+#define BLOB_MAX_ROUNDS     64        // POLL + repair rounds
+#define BLOB_HASH_TRIES     2
+#define BLOB_RX_IDLE_US     5000000   // receiver abandons a silent transfer
+
+// Firmware into flash: receivers erase the slot (~2 s) before they answer
+// the OFFER and check the image (~1 s) before DONE. A chunk's flash write
+// (~1 ms) is shorter than its airtime, so the pacing stays the default.
+#define BLOB_FW_MAX_SILENT  80
+
+#define BLOB_FNV_INIT       0xCBF29CE484222325ull
+
+typedef enum {
+    BLOB_MSG_OFFER = 0,
+    BLOB_MSG_DATA,
+    BLOB_MSG_POLL,
+    BLOB_MSG_STATUS,
+} blob_msg_type_t;
+
+// What the blob is; the receiver's sink decides where it goes
+typedef enum {
+    BLOB_KIND_SONGS = 1,    // song library image (song_lib.h)
+    BLOB_KIND_FIRMWARE,     // application image for the inactive OTA slot (fw_update.h)
+} blob_kind_t;
+
+// Receiver state, also the STATUS state byte
+typedef enum {
+    BLOB_RX_IDLE = 0,
+    BLOB_RX_RECEIVING,
+    BLOB_RX_DONE,           // hash matched and the sink committed it
+    BLOB_RX_FAILED,         // sink refused, or the hash kept failing
+} blob_rx_state_t;
+
+// mac NULL = broadcast. Return false if the radio cannot take the frame
+// now; it is offered again on a later poll.
+typedef bool (*blob_send_fn)(void *ctx, const uint8_t *mac, uint8_t type,
+                             const uint8_t *payload, size_t len);
+
+uint64_t blob_fnv1a64(uint64_t h, const uint8_t *data, size_t len);
+
+// ----------------------
+// Sender
+// ----------------------
+typedef enum {
+    BLOB_TX_IDLE = 0,
+    BLOB_TX_OFFER,
+    BLOB_TX_DATA,           // first pass, every chunk broadcast once
+    BLOB_TX_POLL,
+    BLOB_TX_REPAIR,
+    BLOB_TX_DONE,
+} blob_tx_phase_t;
+
+typedef struct {
+    uint8_t  mac[6];
+    uint8_t  state;         // blob_rx_state_t as last reported; IDLE = no answer yet
+    bool     answered;      // STATUS since the last OFFER/POLL
+    uint8_t  silent;        // consecutive OFFERs/POLLs it did not answer
+    uint16_t have;
+    uint16_t base;          // missing window from the last STATUS
+    uint16_t nbits;
+    uint8_t  missing[BLOB_STATUS_BITS / 8];
+    int64_t  done_us;       // DONE/FAILED reported (or given up)
+    uint32_t unicast;       // repair frames sent to this peer alone
+} blob_tx_peer_t;
+
+typedef struct {
+    blob_send_fn    send;
+    void           *ctx;
+    uint32_t        gap_us;     // between frames; BLOB_FRAME_GAP_US after init
+    uint8_t         max_silent; // BLOB_MAX_SILENT after init; raise it for sinks slow to answer
+
+    const uint8_t  *data;
+    uint32_t        len;
+    uint64_t        hash;
+    uint16_t        id;
+    uint8_t         kind;
+    uint16_t        chunk;
+    uint16_t        n_chunks;
+
+    blob_tx_phase_t phase;
+    blob_tx_peer_t  peers[BLOB_MAX_PEERS];
+    uint8_t         n_peers;
+    uint16_t        cursor;     // next chunk of the DATA pass / repair scan
+    uint16_t        rounds;
+    int64_t         start_us;
+    int64_t         end_us;
+    int64_t         next_us;    // next frame slot
+    bool            asked;      // an OFFER/POLL is waiting for answers
+    int64_t         wait_us;    // ... until then
+    bool            offered;    // an OFFER is out, not yet timed out
+    int64_t         offer_us;   // next OFFER while some peer has not answered one
+
+    uint32_t        frames;     // everything sent, including OFFER/POLL
+    uint32_t        data_frames;
+    uint32_t        repairs_bcast;
+    uint32_t        repairs_ucast;
+} blob_tx_t;
+
+void blob_tx_init(blob_tx_t *tx, blob_send_fn send, void *ctx);
+// Begin sending len bytes (which must stay valid until done) to the peers.
+// False if a transfer is running, there are no peers or the blob is empty
+// or needs more than BLOB_MAX_CHUNKS chunks.
+bool blob_tx_start(blob_tx_t *tx, const uint8_t *data, uint32_t len, uint8_t kind, uint16_t id,
+                   const uint8_t (*macs)[6], size_t n_peers, int64_t now_us);
+// A STATUS frame arrived from mac; false if it is not for this transfer
+bool blob_tx_handle(blob_tx_t *tx, const uint8_t mac[6], const wire_frame_t *f, int64_t now_us);
+// Send what is due. Returns when to call again, INT64_MAX when idle/done.
+int64_t blob_tx_poll(blob_tx_t *tx, int64_t now_us);
+static inline bool blob_tx_busy(const blob_tx_t *tx)
+{
+    return tx->phase != BLOB_TX_IDLE && tx->phase != BLOB_TX_DONE;
+}
+
+// ----------------------
+// Receiver
+// ----------------------
+
+// Where a received blob goes. write/read address the blob from offset 0;
+// read serves the read-back and hash checks. commit makes a verified blob
+// live; abort drops a begun transfer that will not be committed. begin is
+// called again, without abort, when the hash fails and the blob restarts.
+typedef struct {
+    bool (*begin)(void *ctx, uint8_t kind, uint32_t len);
+    bool (*write)(void *ctx, uint32_t off, const uint8_t *data, size_t len);
+    bool (*read)(void *ctx, uint32_t off, uint8_t *data, size_t len);
+    bool (*commit)(void *ctx, uint8_t kind, uint32_t len);
+    void (*abort)(void *ctx);
+} blob_sink_t;
+
+typedef struct {
+    const blob_sink_t *sink;
+    blob_send_fn       send;
+    void              *ctx;     // passed to both
+
+    blob_rx_state_t    state;
+    uint8_t            src[6];  // sender of the current transfer
+    uint16_t           id;
+    uint8_t            kind;
+    uint32_t           len;
+    uint64_t           hash;
+    uint16_t           chunk;
+    uint16_t           n_chunks;
+    uint16_t           have;
+    uint8_t            held[BLOB_MAX_CHUNKS / 8];
+    uint8_t            hash_fails;
+    int64_t            first_us;
+    int64_t            last_us;
+
+    uint32_t           dups;        // chunks received again
+    uint32_t           bad_chunks;  // CRC mismatch on arrival or read-back
+} blob_rx_t;
+
+void blob_rx_init(blob_rx_t *rx, const blob_sink_t *sink, blob_send_fn send, void *ctx);
+// An OFFER, DATA or POLL frame arrived from mac
+void blob_rx_handle(blob_rx_t *rx, const uint8_t mac[6], const wire_frame_t *f, int64_t now_us);
+// Abandon a transfer that has been silent for BLOB_RX_IDLE_US
+void blob_rx_poll(blob_rx_t *rx, int64_t now_us);
@@ -0,0 +1,77 @@
+// include/clock_sync.h
+#pragma once
+
+// Two-way (NTP-style) clock estimation against the conductor.
+//
+// Each exchange gives four timestamps: t1 request sent (local), t2 request
+// received (conductor), t3 response sent (conductor), t4 response received
+// (local). From those:
+//   offset = ((t2 - t1) + (t3 - t4)) / 2      conductor - local
+//   rtt    = (t4 - t1) - (t3 - t2)            air + stack time, both ways
+// The true offset lies within +-rtt/2 of the measured one, so samples with
+// a low RTT are the trustworthy ones. A window of recent samples is kept;
+// samples whose RTT is well above the window minimum are rejected as
+// outliers (queueing, retries) and the rest are fitted with a line to get
+// both the offset and the drift rate between the two crystals. The fit is
+// weighted by how far each RTT is above the minimum, so a few slow but
+// accepted exchanges barely tilt the line.
+// Pure C, usable on the host.
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CLOCK_SYNC_WINDOW         16
+// A sample is an outlier if its RTT exceeds the window minimum by this much
+#define CLOCK_SYNC_RTT_SLACK_US   1500
+// Fit weight is 1 / sigma^2, sigma = this + (rtt - window minimum) / 2.
+// The floor keeps samples within normal radio jitter at near equal weight;
+// at 20 us a few fast samples decide the drift alone and orch_sim's worst
+// start spread doubled.
+#define CLOCK_SYNC_SIGMA_US       300
+// Need this many accepted samples spanning this long before fitting drift
+#define CLOCK_SYNC_FIT_MIN        4
+#define CLOCK_SYNC_FIT_SPAN_US    2000000
+// Drift beyond this is treated as a bad fit (ESP32 crystals are +-10..40 ppm)
+#define CLOCK_SYNC_MAX_DRIFT_PPB  200000
+// Drift uncertainty assumed when extrapolating, before and after a fit
+#define CLOCK_SYNC_UNFIT_PPM      100
+#define CLOCK_SYNC_FIT_PPM        5
+
+typedef struct {
+    int64_t  local_us;     // local midpoint of the exchange
+    int64_t  offset_us;    // conductor - local
+    uint32_t rtt_us;
+} clock_sync_sample_t;
+
+typedef struct {
+    clock_sync_sample_t samples[CLOCK_SYNC_WINDOW];
+    uint8_t  count;
+    uint8_t  head;         // next slot to overwrite
+
+    // Current estimate: offset(t) = ref_offset + (t - ref_local) * drift_ppb / 1e9
+    bool     valid;
+    bool     fitted;       // drift_ppb comes from a fit (not assumed 0)
+    int64_t  ref_local_us;
+    int64_t  ref_offset_us;
+    int32_t  drift_ppb;
+    uint32_t base_err_us;  // error bound at ref_local (rtt/2 + fit residual)
+    uint32_t min_rtt_us;   // best RTT in the window
+} clock_sync_t;
+
+void clock_sync_init(clock_sync_t *cs);
+
+// Feed one exchange; false if it was rejected (negative RTT or outlier)
+bool clock_sync_add(clock_sync_t *cs, int64_t t1, int64_t t2, int64_t t3, int64_t t4);
+
+// Conductor time for a local time, and the +-error bound in us.
+// Returns false (remote = local, bound = UINT32_MAX) without an estimate.
+bool clock_sync_to_remote(const clock_sync_t *cs, int64_t local_us,
+                          int64_t *remote_us, uint32_t *err_bound_us);
+
+// Inverse: local time at which the conductor clock reads remote_us
+int64_t clock_sync_to_local(const clock_sync_t *cs, int64_t remote_us);
+
+// True while more exchanges are needed soon: no drift fit yet and the window
+// not yet full. Polling fast until the fit would never end, since a full
+// window of fast samples can span less than CLOCK_SYNC_FIT_SPAN_US.
+bool clock_sync_wants_fast(const clock_sync_t *cs);
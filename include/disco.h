@@ -0,0 +1,110 @@
+// include/disco.h
+#pragma once
+
+// Peer discovery: who is on the air and which part each device plays.
+//
+// Every node broadcasts an ANNOUNCE (role, MAC, name) every
+// DISCO_ANNOUNCE_MS and keeps a table of the peers it hears (ANNOUNCE,
+// PRESENT, READY); a peer not heard for DISCO_PEER_TIMEOUT_MS is offline.
+// The conductor hands the first free part to a device that announces itself
+// without a role or asks for one (ROLE_REQUEST -> ROLE_ASSIGN), and a device
+// without a role takes the assignment and announces again. ROLL_CALL asks
+// everyone for a PRESENT by unicast.
+//
+// Roles are device_role_t values (device_config.h), kept as bytes so this
+// builds without ESP-IDF. No radio or RTOS calls: the caller supplies time
+// and a send function and serialises the calls, so the same code runs on the
+// device (espnow_discovery.c) and in host runs (tools/host_node.c).
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "wire_proto.h"
+
+#define DISCO_MAX_PEERS         5
+#define DISCO_ANNOUNCE_MS       2000
+#define DISCO_PEER_TIMEOUT_MS   10000
+#define DISCO_ROLE_REQUEST_MS   100      // after the first ANNOUNCE, if we have no role
+#define DISCO_NAME_LEN          32
+
+// device_role_t values used here
+#define DISCO_ROLE_CONDUCTOR    0
+#define DISCO_ROLE_PART_1       1
+#define DISCO_ROLE_PART_4       4
+#define DISCO_ROLE_UNKNOWN      0xFF
+
+// ---- discovery message types (on air as WIRE_T_DISCO + type; append only) ----
+typedef enum {
+    DISCO_MSG_ANNOUNCE = 0,
+    DISCO_MSG_ROLE_REQUEST,
+    DISCO_MSG_ROLE_ASSIGN,
+    DISCO_MSG_ROLL_CALL,
+    DISCO_MSG_PRESENT,
+    DISCO_MSG_READY,
+} discovery_msg_type_t;
+
+typedef struct {
+    uint8_t  mac[6];
+    uint8_t  role;
+    char     name[DISCO_NAME_LEN];
+    bool     online;
+    int64_t  last_seen_us;
+} disco_peer_t;
+
+typedef struct {
+    // Send a finished frame, dst NULL = broadcast; false if it did not go out
+    bool     (*send)(void *ctx, const uint8_t *dst, const uint8_t *frame, size_t len);
+    // Header seq for the next frame this node sends
+    uint16_t (*next_seq)(void *ctx);
+    // A new peer entered the table (register it with the link for unicast);
+    // optional
+    void     (*peer_added)(void *ctx, const uint8_t mac[6]);
+    // The conductor assigned us a role; disco_t.role already holds it and an
+    // ANNOUNCE follows. The caller may change disco_t.name here. Optional.
+    void     (*role_set)(void *ctx, uint8_t role);
+    // Conductor: role handed to the device at mac; optional
+    void     (*assigned)(void *ctx, const uint8_t mac[6], uint8_t role);
+} disco_hooks_t;
+
+typedef struct {
+    const disco_hooks_t *hooks;
+    void        *ctx;
+    uint8_t      sender;               // header sender id
+    uint8_t      mac[6];               // our own address
+    uint8_t      role;
+    char         name[DISCO_NAME_LEN];
+
+    disco_peer_t peers[DISCO_MAX_PEERS];
+    uint8_t      n_peers;
+    int64_t      announce_us;          // next ANNOUNCE
+    int64_t      request_us;           // pending ROLE_REQUEST, INT64_MAX = none
+} disco_t;
+
+void disco_init(disco_t *d, const disco_hooks_t *hooks, void *ctx, uint8_t sender,
+                const uint8_t mac[6], uint8_t role, const char *name);
+
+// First ANNOUNCE now, and a ROLE_REQUEST shortly after if we have no role
+void disco_start(disco_t *d, int64_t now_us);
+
+// A discovery frame (WIRE_T_IS_DISCO) from src at now_us; false if it is
+// not one, is truncated or is our own
+bool disco_handle(disco_t *d, const uint8_t src[6], const wire_frame_t *f, int64_t now_us);
+
+// Periodic ANNOUNCE, timeouts and a pending ROLE_REQUEST. Returns when to
+// call again.
+int64_t disco_poll(disco_t *d, int64_t now_us);
+
+// Send one discovery message with our role and name (dst NULL = broadcast)
+bool disco_send(disco_t *d, const uint8_t *dst, discovery_msg_type_t type, int64_t now_us);
+// Conductor: tell the device at mac to play role
+bool disco_assign(disco_t *d, const uint8_t mac[6], uint8_t role, int64_t now_us);
+
+// Queries on the peer table
+uint8_t disco_online_count(const disco_t *d);
+// Performer parts seen online, bit (role - PART_1) per part
+uint8_t disco_online_part_mask(const disco_t *d);
+// MACs of online performers, up to max; returns the count
+size_t  disco_online_performers(const disco_t *d, uint8_t (*macs)[6], size_t max);
+// Role of a known peer, DISCO_ROLE_UNKNOWN if not in the table
+uint8_t disco_peer_role(const disco_t *d, const uint8_t mac[6]);
@@ -4,12 +4,75 @@
 #include <stdint.h>
 #include "esp_err.h"
 #include "orchestra.h"   // for msg_type_t, espnow_msg_t (single source of truth)
+#include "wire_proto.h"  // wire_writer_t
+#include "orch_state.h"  // orch_state_t
+#include "reliable.h"    // reliable_peer_stats_t
+#include "transport.h"   // transport_t
+
+// Link to send and receive on, before espnow_init(); ESP-NOW if never set
+void espnow_set_transport(transport_t *t);
 
 // Initialize ESP-NOW layer (id is an optional local identifier you can use in messages)
 esp_err_t espnow_init(uint8_t id);
 
-// Broadcast a control message to all peers (FF:FF:FF:FF:FF:FF)
+// Broadcast a control message to all peers (FF:FF:FF:FF:FF:FF).
+// START/STOP/SELECT are acknowledged: performers that were online ACK by
+// unicast, and the ones that did not are retried within the start lead.
 esp_err_t espnow_broadcast(msg_type_t type, uint8_t song_id);
 
+// Replicated orchestra state (orch_state.h). START/STOP broadcasts update
+// the conductor's state vector, which rides along on every control frame
+// and heartbeat; performers converge to it, so one that missed a command or
+// rebooted mid-song resyncs within a heartbeat period. Conductor only: set
+// the output volume the performers should follow.
+void espnow_state_set_volume(float volume);
+// Conductor: its current state; performer: the last state applied
+void espnow_get_state(orch_state_t *out);
+
+// Per-peer delivery stats for acknowledged control messages (conductor);
+// returns the number of entries written
+size_t espnow_get_delivery_report(reliable_peer_stats_t *out, size_t max);
+void   espnow_log_delivery_report(void);
+
+// Framed sends for any module (discovery, sync, ...): begin fills in the
+// header with our sender id and the next sequence number (returned), the
+// caller appends the payload with wire_put_*(), send adds the CRC.
+uint16_t  espnow_frame_begin(wire_writer_t *w, uint8_t *buf, size_t cap, uint8_t type);
+esp_err_t espnow_frame_send(const uint8_t *mac, wire_writer_t *w);
+// For modules that build their own frames (disco.h): the header sender id,
+// the next sequence number, and a send of a finished frame (mac NULL =
+// broadcast)
+uint8_t   espnow_device_id(void);
+uint16_t  espnow_next_seq(void);
+esp_err_t espnow_send(const uint8_t *mac, const uint8_t *frame, size_t len);
+// Register mac as an ESP-NOW peer (if it is not one yet) so unicast to it works
+void      espnow_ensure_peer(const uint8_t *mac);
+// Our own address on the transport (the STA MAC on ESP-NOW)
+void      espnow_own_mac(uint8_t *mac);
+
+// Delay between a frame arriving in the ESP-NOW receive callback (where it
+// is timestamped) and espnow_task picking it up. All sync timing uses the
+// callback timestamp, so this is error that no longer reaches the clock.
+// Bucket i counts delays below ESPNOW_RX_LAT_EDGES_US[i]; the last bucket
+// is everything above the final edge.
+#define ESPNOW_RX_LAT_EDGES_US   { 50, 100, 200, 500, 1000, 2000, 5000 }
+#define ESPNOW_RX_LAT_BUCKETS    8
+
+typedef struct {
+    uint32_t bucket[ESPNOW_RX_LAT_BUCKETS];
+    uint32_t count;
+    int64_t  last_us;
+    int64_t  max_us;
+    int64_t  sum_us;
+} espnow_rx_latency_t;
+
+void espnow_get_rx_latency(espnow_rx_latency_t *out);
+
+// Current conductor clock (us, conductor's esp_timer_get_time() timebase),
+// estimated from two-way sync exchanges with offset and drift correction.
+// *err_bound_us (optional) receives the +- bound on the estimate; UINT32_MAX
+// means not synced yet. On the conductor this is its own clock, bound 0.
+int64_t conductor_time_now(uint32_t *err_bound_us);
+
 // (Optional) If later you want unicast helpers, declare them here.
 // esp_err_t espnow_send_to(const uint8_t mac[6], msg_type_t type, uint8_t song_id);
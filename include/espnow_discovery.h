@@ -2,36 +2,16 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
 #include <stdbool.h>
-#include "esp_now.h"
 #include "esp_err.h"
 #include "device_config.h"
+#include "wire_proto.h"
+#include "disco.h"          // discovery_msg_type_t, disco_peer_t
 
-// ---- discovery message types (if you already have these, keep yours) ----
-typedef enum {
-    DISCO_MSG_ANNOUNCE = 0,
-    DISCO_MSG_ROLE_REQUEST,
-    DISCO_MSG_ROLE_ASSIGN,
-    DISCO_MSG_ROLL_CALL,
-    DISCO_MSG_PRESENT,
-    DISCO_MSG_READY,
-} discovery_msg_type_t;
-
-typedef struct {
-    discovery_msg_type_t type;
-    device_role_t        role;
-    uint8_t              mac_address[6];
-    char                 device_name[32];
-    uint32_t             timestamp;     // ms
-} discovery_msg_t;
-
-typedef struct {
-    uint8_t      mac_address[6];
-    device_role_t role;
-    char         name[32];
-    bool         is_online;
-    uint32_t     last_seen;             // ticks
-} peer_device_t;
+// Device glue for disco.h: the peer table and role handshake run on the
+// discovery task; the queries below are safe from any task.
+typedef disco_peer_t peer_device_t;
 
 // ---- public APIs used elsewhere ----
 esp_err_t espnow_discovery_init(void);
@@ -41,9 +21,16 @@ esp_err_t espnow_discovery_request_role(void);
 esp_err_t espnow_discovery_assign_role(const uint8_t *mac, device_role_t role);
 esp_err_t espnow_discovery_roll_call(void);
 uint8_t   espnow_discovery_get_online_count(void);
+// Performer parts seen online, bit (role - ROLE_PART_1) per part (PART_1..PART_4)
+uint8_t   espnow_discovery_get_online_part_mask(void);
 bool      espnow_discovery_all_devices_ready(void);
-const peer_device_t* espnow_discovery_get_peers(void);
+// MACs of online performers (PART_1..PART_4), up to max; returns the count
+size_t    espnow_discovery_get_online_performers(uint8_t (*macs)[6], size_t max);
+// Role of a known peer, ROLE_UNKNOWN if not in the table
+device_role_t espnow_discovery_get_peer_role(const uint8_t *mac);
+// Copy of the peer table, up to max entries; returns the count
+size_t    espnow_discovery_get_peers(peer_device_t *out, size_t max);
 
-// ---- IMPORTANT: RX callback prototype so others can call it ----
-void espnow_discovery_recv_cb(const esp_now_recv_info_t *recv_info,
-                              const uint8_t *data, int len);
+// ---- RX hook: called by the dispatcher in espnow_comm.c for WIRE_T_DISCO frames ----
+// (receive callback context: the frame is copied and handled on the task)
+void espnow_discovery_handle_frame(const uint8_t *src_mac, const wire_frame_t *frame, int64_t rx_us);
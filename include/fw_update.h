@@ -0,0 +1,38 @@
+// include/fw_update.h
+#pragma once
+
+// Firmware updates over ESP-NOW. partitions.csv has two app slots
+// (ota_0/ota_1); a device runs one and the other is the update target.
+//
+// The conductor holds the new image in its own inactive slot, written over
+// USB (FLASHING.md), and fw_update_push() sends it to every online
+// performer at once through song_sync.h (blob kind BLOB_KIND_FIRMWARE).
+// Each performer writes the chunks into its inactive slot, checks the
+// whole-image hash and the image itself (esp_ota_end()), makes that slot
+// the boot partition and restarts. The bootloader rolls back to the old
+// slot if the new firmware does not get as far as fw_update_confirm().
+//
+// Roles are baked into the per-role builds, so the image pushed to the
+// performers is the role-neutral build (platformio.ini env "fleet"); it
+// takes the role the device last held from NVS.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "blob_xfer.h"
+
+// Log the running firmware and what the other slot holds
+void fw_update_init(void);
+// Call once the radio is up: the running firmware is good, cancel rollback
+void fw_update_confirm(void);
+// Conductor: the valid application image in the inactive slot (mapped);
+// false if that slot holds none or an image of another project
+bool fw_update_staged_image(const uint8_t **img, size_t *len);
+// Conductor: send the staged image to the online performers and return;
+// the fleet update time and throughput are logged. With
+// -DFW_PUSH_SEQUENTIAL the performers are updated one after another by
+// unicast instead, as the baseline to compare with.
+esp_err_t fw_update_push(void);
+// Performer: blob sink that writes into the inactive slot
+const blob_sink_t *fw_update_sink(void);
@@ -0,0 +1,85 @@
+// include/note_timeline.h
+#pragma once
+
+// Sample-accurate note scheduling. Note boundaries live on an absolute
+// sample counter: note N ends at floor(cum_ms(N) * rate / 1000), computed
+// with an integer (Bresenham-style) remainder so no rounding error ever
+// accumulates and every device reaches note N at the same sample index,
+// whatever block size the renderer uses. Pure C, usable on the host.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "orchestra.h"   // note_t
+#include "song_pack.h"
+
+// Running boundary clock: converts a sequence of ms durations to sample
+// boundaries, carrying the sub-sample remainder from note to note.
+typedef struct {
+    uint32_t rate;       // samples per second
+    uint32_t rem;        // carried (ms * rate) mod 1000
+    uint64_t end;        // absolute sample index of the last boundary
+} note_clock_t;
+
+void     note_clock_init(note_clock_t *c, uint32_t rate);
+// Advance by one note of dur_ms; returns the new boundary (sample index)
+uint64_t note_clock_add(note_clock_t *c, uint16_t dur_ms);
+
+// Exact sample index of a time in ms from song start
+static inline uint64_t note_timeline_ms_to_sample(uint64_t ms, uint32_t rate)
+{
+    return ms * rate / 1000u;
+}
+
+// Cumulative time index of one melody: cum_ms[i] is the start of note i in
+// ms and cum_ms[count] the melody length, so cum_ms needs count + 1 entries.
+// Note i then spans samples [ms_to_sample(cum_ms[i]), ms_to_sample(cum_ms[i+1])),
+// which lets a seek binary-search instead of walking the notes.
+void note_index_build(uint32_t *cum_ms, const song_pack_tables_t *t,
+                      const uint8_t *notes, uint16_t count);
+
+// Walks one packed melody, handing out runs of samples that belong to one
+// note. Notes are decoded as they come due; only the current one is held.
+typedef struct {
+    song_pack_iter_t it;      // positioned just past the current note
+    note_t        cur;        // current note, decoded
+    const uint32_t *cum_ms;   // optional note_index_build() index, NULL = linear seek
+    uint16_t      count;
+    uint16_t      index;      // current note (== count when finished)
+    note_clock_t  clk;
+    uint64_t      pos;        // absolute sample index of the next sample
+    uint64_t      note_start; // boundary where the current note began
+} note_seq_t;
+
+// Start at note 0, sample 0. Zero-length notes are skipped.
+void note_seq_start(note_seq_t *s, const song_pack_tables_t *t,
+                    const uint8_t *notes, uint16_t count, uint32_t rate);
+// Attach the melody's cumulative index (after note_seq_start) for O(log n) seeks
+static inline void note_seq_set_index(note_seq_t *s, const uint32_t *cum_ms) { s->cum_ms = cum_ms; }
+// Jump to an absolute sample index; false if that is past the end of the melody.
+// Lands on the same note, boundary and remainder as playing up to it would.
+bool note_seq_seek(note_seq_t *s, uint64_t sample);
+// Samples left in the current note (0 once the melody is done)
+uint32_t note_seq_run(const note_seq_t *s);
+// Consume n <= note_seq_run() samples; true if this crossed into a new note
+bool note_seq_advance(note_seq_t *s, uint32_t n);
+
+static inline bool note_seq_done(const note_seq_t *s) { return s->index >= s->count; }
+static inline const note_t *note_seq_note(const note_seq_t *s)
+{
+    return note_seq_done(s) ? NULL : &s->cur;
+}
+// Length of the current note, and how far into it pos is (samples)
+static inline uint32_t note_seq_note_len(const note_seq_t *s)
+{
+    return (uint32_t)(s->clk.end - s->note_start);
+}
+static inline uint32_t note_seq_note_elapsed(const note_seq_t *s)
+{
+    return (uint32_t)(s->pos - s->note_start);
+}
+// True exactly when pos sits on the first sample of the current note
+static inline bool note_seq_at_note_start(const note_seq_t *s)
+{
+    return !note_seq_done(s) && s->pos == s->note_start;
+}
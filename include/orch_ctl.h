@@ -0,0 +1,132 @@
+// include/orch_ctl.h
+#pragma once
+
+// The control protocol one node runs, conductor or performer, on frames
+// that have already passed wire_parse():
+//
+//   conductor  answers clock-sync requests, sends START/STOP/SELECT with
+//              the state vector attached and retries them until every
+//              online performer has acknowledged (reliable.h), and repeats
+//              the state on a heartbeat every ORCH_HEARTBEAT_MS
+//   performer  polls the conductor's clock (clock_sync.h), ACKs and
+//              de-duplicates commands, follows the state vector
+//              (orch_state.h) and, on heartbeats, reports where the song
+//              should be so playback can be steered
+//
+// What the node does about a frame goes out through orch_ctl_hooks_t:
+// frames to send and, on a performer, the playback actions. Like the other
+// protocol modules there are no radio, audio or RTOS calls and nothing
+// blocks: the caller serialises all calls on one task and calls
+// orch_ctl_poll() by the time it last returned. espnow_comm.c runs it in
+// espnow_task on the device; tools/host_node.c runs the same code on the
+// UDP transport and in tools/orch_sim.c.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "wire_proto.h"
+#include "clock_sync.h"
+#include "reliable.h"
+#include "orch_state.h"
+
+#define ORCH_CTL_CONDUCTOR_ID   0                    // header sender id of the conductor
+#define ORCH_CTL_MAX_FRAME      RELIABLE_MAX_FRAME   // control and clock frames fit
+
+// Conductor time as a performer knows it: the two-way estimate once it has
+// one, before that the one-way offset seen on heartbeats
+typedef struct {
+    clock_sync_t sync;
+    int64_t      coarse_offset_us;   // conductor - local, low-passed
+    bool         coarse_valid;
+} orch_clock_t;
+
+// Conductor time at local_us. *bound_us (optional) gets the +- error bound,
+// UINT32_MAX while only the coarse offset (or nothing) is known.
+int64_t orch_clock_to_remote(const orch_clock_t *ck, int64_t local_us, uint32_t *bound_us);
+int64_t orch_clock_to_local(const orch_clock_t *ck, int64_t conductor_us);
+
+typedef struct {
+    // Send a finished frame, dst NULL = broadcast; false if it did not go
+    // out. A unicast dst may have to be registered with the link first.
+    bool     (*send)(void *ctx, const uint8_t *dst, const uint8_t *frame, size_t len);
+    // Header seq for the next frame this node sends (shared with any other
+    // sender on the node, so (sender, seq) stays unique)
+    uint16_t (*next_seq)(void *ctx);
+    // Local monotonic time, us
+    int64_t  (*now)(void *ctx);
+
+    // Conductor: MACs of the performers that must ACK a command
+    size_t   (*performers)(void *ctx, uint8_t (*macs)[6], size_t max);
+    // Conductor: a command finished (every ACK in, or given up); optional
+    reliable_done_fn delivered;
+
+    // Performer playback, each optional. schedule: start song_id so that
+    // its first sample sounds at local time epoch_us, replacing a pending
+    // start; the epoch is normally ahead (rx_us is when the command came
+    // in). play: the song is already running, join it now where epoch_us
+    // puts it (join_ms in). stop: drop a pending start and stop playback.
+    void     (*schedule)(void *ctx, uint8_t song_id, int64_t epoch_us, int64_t rx_us);
+    void     (*play)(void *ctx, uint8_t song_id, int64_t epoch_us, uint32_t join_ms);
+    void     (*stop)(void *ctx);
+    // SONG_SELECT: a START for song_id is likely next
+    void     (*prepare)(void *ctx, uint8_t song_id);
+    // The state's volume or tempo differs from what was applied before
+    void     (*params)(void *ctx, const orch_state_t *st);
+    // Heartbeat while following a song: it should be at song_us at local
+    // time at_us
+    void     (*timeline)(void *ctx, int64_t song_us, int64_t at_us);
+} orch_ctl_hooks_t;
+
+typedef struct {
+    const orch_ctl_hooks_t *hooks;
+    void    *ctx;
+    uint8_t  id;                 // header sender id
+    bool     conductor;
+
+    // Conductor: the state vector is the source of truth
+    orch_state_t  state;
+    reliable_tx_t rtx;
+    int64_t       rtx_next_us;
+    int64_t       hb_next_us;
+
+    // Performer
+    orch_clock_t    clock;
+    uint16_t        sync_seq;    // header seq of the outstanding request
+    int64_t         sync_next_us;
+    uint32_t        sync_accepted;
+    uint32_t        sync_rejected;
+    reliable_rx_t   rrx;
+    orch_follower_t follow;      // what has been applied
+    int64_t         heard_us;    // last frame from the conductor, 0 = none yet
+    uint32_t        dups;        // repeated commands ACKed but not acted on
+    uint32_t        stale;       // states older than the one applied
+} orch_ctl_t;
+
+// Conductor: boot_id should be random per boot (orch_state.h); volume_q15
+// is the initial output gain. Performers ignore both.
+void orch_ctl_init(orch_ctl_t *c, const orch_ctl_hooks_t *hooks, void *ctx,
+                   uint8_t id, bool conductor, uint16_t boot_id, uint16_t volume_q15);
+
+// A frame from src that arrived at local time rx_us. Control, clock-sync
+// and ACK frames are handled; false for anything else (and for frames the
+// node sent itself or cannot decode).
+bool orch_ctl_handle(orch_ctl_t *c, const uint8_t src[6], const wire_frame_t *f, int64_t rx_us);
+
+// Send what is due: heartbeats and retries (conductor), clock-sync requests
+// (performer). Returns the local time to call again.
+int64_t orch_ctl_poll(orch_ctl_t *c);
+
+// Conductor: broadcast a control frame. START and STOP update the state
+// vector, and START's epoch is ORCH_START_LEAD_US ahead; START/STOP/SELECT
+// are acknowledged. *ts_us (optional) gets the frame's timestamp (the
+// epoch for START). Returns how many performers are expected to ACK.
+size_t orch_ctl_command(orch_ctl_t *c, uint8_t type, uint8_t song_id, uint64_t *ts_us);
+// Conductor: output volume for the performers, sent with the next frame
+void orch_ctl_set_volume(orch_ctl_t *c, uint16_t volume_q15);
+
+// Conductor: its state; performer: the last state applied
+static inline const orch_state_t *orch_ctl_state(const orch_ctl_t *c)
+{
+    return c->conductor ? &c->state : &c->follow.state;
+}
@@ -0,0 +1,68 @@
+// include/orch_state.h
+#pragma once
+
+// Replicated orchestra state. The conductor owns a small versioned state
+// vector and sends it with every START/STOP and on every heartbeat; each
+// performer converges to it idempotently. Applying the same state twice
+// does nothing, so a performer that missed a command or rebooted mid-song
+// catches up from the next heartbeat without any extra traffic.
+//
+// Ordering: version increments on every change; boot_id is random per
+// conductor boot so a restarted conductor (version back to 1) is still
+// accepted. Frames carrying an older version than the last one applied
+// (e.g. a heartbeat built just before a START) are ignored.
+//
+// No RTOS calls: the caller supplies the conductor time, so the same code
+// runs on the device and in host simulations.
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ORCH_TEMPO_NOMINAL   100    // tempo_pct of the song as written
+
+// Protocol timing, the same for the devices (espnow_comm.c) and host nodes
+#define ORCH_START_LEAD_US       200000   // START epoch is this far ahead of the send
+#define ORCH_RETRY_WINDOW_US     (ORCH_START_LEAD_US - 20000)   // acked commands retried this long
+#define ORCH_HEARTBEAT_MS        500
+#define ORCH_CLOCK_SYNC_FAST_MS  100      // performer polls while clock_sync_wants_fast(),
+#define ORCH_CLOCK_SYNC_POLL_MS  1000     // then relaxes
+
+typedef struct {
+    uint16_t boot_id;          // conductor boot, random
+    uint16_t version;          // bumped on every change
+    bool     playing;
+    uint8_t  song_id;          // valid while playing
+    uint64_t start_epoch_us;   // conductor clock at song start (beat 0)
+    uint16_t tempo_pct;
+    uint16_t volume_q15;       // output gain, Q15: SYNTH_Q15_ONE (32767) = full scale
+} orch_state_t;
+
+typedef enum {
+    ORCH_ACT_NONE = 0,
+    ORCH_ACT_START_AT,         // start is still ahead: schedule it at the epoch
+    ORCH_ACT_JOIN,             // song already running: start and seek to *join_ms
+    ORCH_ACT_STOP,
+} orch_action_t;
+
+// Performer side: the last state accepted, and which start it has acted on
+typedef struct {
+    orch_state_t state;
+    bool         have;         // any state accepted yet
+    bool         started;      // acted on (song_id, start_epoch_us) below
+    uint8_t      started_song;
+    uint64_t     started_epoch_us;
+} orch_follower_t;
+
+void orch_follower_init(orch_follower_t *f);
+
+// True if in is not older than what f has applied (same or newer version,
+// or a different conductor boot)
+bool orch_state_is_current(const orch_follower_t *f, const orch_state_t *in);
+
+// Converge to in. conductor_now_us is the current conductor time and
+// song_len_ms the length of in->song_id; a start that is already over
+// yields no action. Returns what the caller must do; for ORCH_ACT_JOIN,
+// *join_ms is the position to seek to.
+orch_action_t orch_follow(orch_follower_t *f, const orch_state_t *in,
+                          int64_t conductor_now_us, uint32_t song_len_ms,
+                          uint32_t *join_ms);
@@ -23,31 +23,41 @@ typedef struct {
     uint16_t duration_ms;
 } note_t;
 
-// Part assignment for multi-part songs
+struct song_pack_tables;   // song_pack.h
+
+// Part assignment for multi-part songs. Melodies are packed (song_pack.h):
+// note_count notes, decoded against the song's tables.
 typedef struct {
-    const note_t* notes;
+    const uint8_t* notes;
     uint16_t note_count;
+    uint8_t envelope;             // SYNTH_ENV_* preset, 0 = use the song's
 } part_melody_t;
 
 // Song structure
 typedef struct {
     const char* name;
     song_type_t type;
-    const note_t* notes;          // Default/solo melody
+    const uint8_t* notes;         // Default/solo melody
     uint16_t note_count;
+    const struct song_pack_tables* tables;   // pitch/duration tables of the library
     uint8_t parts_mask;           // Bit mask for which parts play
+    uint8_t envelope;             // SYNTH_ENV_* preset, 0 = engine default
     part_melody_t parts[5];       // Individual part melodies for multi-part songs
 } song_t;
 
-// ESP-NOW message types
+// ESP-NOW message types. These values are the on-air frame type
+// (wire_proto.h): append only, never renumber.
 typedef enum {
     MSG_SYNC_START = 0,
     MSG_SYNC_STOP,
     MSG_SONG_SELECT,
-    MSG_HEARTBEAT
+    MSG_HEARTBEAT,
+    MSG_CLOCK_REQ,      // performer -> conductor, wire_clock_t
+    MSG_CLOCK_RESP,     // conductor -> performer, wire_clock_t
+    MSG_ACK             // receiver -> sender, wire_ack_t (for WIRE_F_ACK_REQ frames)
 } msg_type_t;
 
-// ESP-NOW message structure
+// Decoded control message (in memory; the air format is wire_ctrl_t)
 typedef struct {
     msg_type_t type;
     uint8_t song_id;
@@ -55,9 +65,17 @@ typedef struct {
     uint8_t sender_id;
 } espnow_msg_t;
 
+#define ORCHESTRA_DEFAULT_VOLUME  0.08f   // 0..1, same as audio.c's default
+
 // Function declarations
 void orchestra_init(void);
 void orchestra_play_song(uint8_t song_id);
+// Play with song position 0 at local esp_timer time epoch_us; a past epoch
+// joins mid-song where the other performers are (0 = from the top)
+void orchestra_play_song_at(uint8_t song_id, int64_t epoch_us);
+// SELECT: pre-render this device's part so the next START of it begins
+// without synthesis on the critical path
+void orchestra_prepare_song(uint8_t song_id);
 void orchestra_stop(void);
 void orchestra_set_volume(float volume);
 void orchestra_handle_button_a(void);
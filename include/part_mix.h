@@ -0,0 +1,69 @@
+// include/part_mix.h
+#pragma once
+
+// The play cursor of the audio engine. Each voice plays one part; note
+// boundaries come from the sample-accurate sequencer (note_timeline.h), so
+// a note may start anywhere inside a block. Voices are summed into an int32
+// accumulator and scaled once with 1/sqrt(N) headroom (synth.h). Pure C:
+// host tools render with it exactly what a performer plays
+// (tools/virtual_performer.c).
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "orchestra.h"       // song_t
+#include "note_timeline.h"
+#include "synth.h"
+
+#define PART_MIX_MAX_VOICES  4
+
+// Envelope for songs/parts that do not pick one (SYNTH_ENV_NONE = old flat
+// notes); the engine and the host renderers pass it as default_env
+#ifndef AUDIO_DEFAULT_ENVELOPE
+#define AUDIO_DEFAULT_ENVELOPE  SYNTH_ENV_SOFT
+#endif
+
+typedef struct {
+    note_seq_t seq;
+    uint16_t freq;         // current note after role transform
+    uint32_t inc;          // its phase increment
+    uint32_t phase;
+    synth_env_t env;       // per-note ADSR
+    const synth_adsr_t *shape;
+    uint8_t  preset;       // envelope preset the shape came from
+    uint8_t  role;
+    bool     using_lead;
+} part_voice_t;
+
+typedef struct {
+    const song_t *song;
+    part_voice_t  voices[PART_MIX_MAX_VOICES];
+    uint8_t       n_voices;     // voices[0] is this device's own part
+    int32_t       headroom_q15;
+    uint32_t      rate;
+} part_mix_t;
+
+// Start song_id at sample 0. 'role' is this device's own part; 'parts'
+// (PART_1..PART_4 bits) adds further parts to mix in, e.g. those of
+// performers that are offline. default_env is used where neither the part
+// nor the song picks an envelope. False for an unknown song or no notes.
+// synth_init() must have run.
+bool part_mix_start(part_mix_t *m, uint8_t song_id, uint8_t role, uint8_t parts,
+                    uint8_t default_env, uint32_t rate);
+// Jump to an absolute sample of the song: a binary search per voice over
+// the song's precomputed index. False if every voice is past its end.
+bool part_mix_seek(part_mix_t *m, uint64_t sample);
+// True once every voice has ended
+bool part_mix_done(const part_mix_t *m);
+// Accumulate len samples of every voice into acc (ended voices add
+// nothing); true if voices[0] crossed into a new note
+bool part_mix_block(part_mix_t *m, int32_t *acc, size_t len);
+// Advance voices[0] by len samples without synthesizing (playout from a
+// PCM cache); true if it crossed into a new note
+bool part_mix_skip(part_mix_t *m, size_t len);
+// voices[0]'s current note (NULL once it ended); its pitch after the role
+// transform is voices[0].freq
+static inline const note_t *part_mix_note(const part_mix_t *m)
+{
+    return m->n_voices ? note_seq_note(&m->voices[0].seq) : NULL;
+}
@@ -0,0 +1,36 @@
+// include/pcm_ring.h
+#pragma once
+
+// Lock-free single-producer / single-consumer ring of fixed-size PCM blocks.
+// The producer (render stage) and consumer (I2S feeder) each own one index;
+// no locks, no allocation. Pure C, usable on the host.
+//
+// Producer:  slot = pcm_ring_write_slot(); fill; pcm_ring_commit();
+// Consumer:  slot = pcm_ring_read_slot();  use;  pcm_ring_release();
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    int16_t  *storage;        // n_blocks * block_len samples
+    uint16_t  block_len;      // samples per block
+    uint16_t  n_blocks;       // must be a power of two
+    uint32_t  head;           // next block to write (producer-owned)
+    uint32_t  tail;           // next block to read (consumer-owned)
+} pcm_ring_t;
+
+// storage must hold n_blocks * block_len samples; n_blocks a power of two.
+void pcm_ring_init(pcm_ring_t *r, int16_t *storage, uint16_t n_blocks, uint16_t block_len);
+
+// Producer side. write_slot returns NULL when the ring is full.
+int16_t *pcm_ring_write_slot(pcm_ring_t *r);
+void     pcm_ring_commit(pcm_ring_t *r);
+
+// Consumer side. read_slot returns NULL when the ring is empty.
+const int16_t *pcm_ring_read_slot(pcm_ring_t *r);
+void           pcm_ring_release(pcm_ring_t *r);
+// Discard everything currently queued (consumer side only).
+void           pcm_ring_drop_all(pcm_ring_t *r);
+
+// Number of committed blocks not yet released (safe from either side).
+uint32_t pcm_ring_fill(const pcm_ring_t *r);
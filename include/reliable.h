@@ -0,0 +1,107 @@
+// include/reliable.h
+#pragma once
+
+// Acknowledged delivery for control frames (START/STOP/SELECT).
+//
+// Sender: a frame is broadcast once, then kept as the pending message.
+// Each peer that was online at submit time is expected to send an ACK
+// carrying the frame's sequence number; peers that have not acked by the
+// next retry time get the identical frame again by unicast, until every
+// peer has acked, RELIABLE_MAX_TRIES is reached or the deadline (for START:
+// the start lead) passes. A newer command supersedes the pending one so a
+// late retry can never resurrect a START after a STOP.
+//
+// Receiver: ACK every copy (the previous ACK may be the one that was lost)
+// but act on a (sender, seq) only once.
+//
+// No radio or RTOS calls: the caller supplies time and a send function,
+// so the same code runs on the device and in host simulations.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define RELIABLE_MAX_PEERS     8
+#define RELIABLE_MAX_FRAME     64      // control frames are ~20 bytes
+#define RELIABLE_RETRY_US      15000   // first retry after this, then +50% each
+#define RELIABLE_MAX_TRIES     8       // including the first broadcast
+#define RELIABLE_DEDUP_DEPTH   8       // seqs remembered per sender
+
+typedef struct {
+    uint8_t  mac[6];
+    uint32_t sent;          // messages that expected an ACK from this peer
+    uint32_t delivered;     // ... and got one
+    uint32_t missed;        // ... and gave up
+    uint32_t retries;       // extra transmissions needed before the ACK
+    int64_t  lat_sum_us;    // first transmission -> ACK, delivered only
+    int64_t  lat_max_us;
+} reliable_peer_stats_t;
+
+typedef struct {
+    bool     active;
+    uint8_t  type;
+    uint16_t seq;
+    uint8_t  frame[RELIABLE_MAX_FRAME];
+    uint8_t  len;
+    uint8_t  tries;
+    int64_t  first_us;
+    int64_t  next_us;
+    int64_t  deadline_us;
+    uint32_t retry_us;
+    uint16_t want;          // bit per entry in peers[] expected to ACK
+    uint16_t acked;
+    int64_t  ack_us[RELIABLE_MAX_PEERS];
+    uint8_t  ack_tries[RELIABLE_MAX_PEERS];
+} reliable_msg_t;
+
+struct reliable_tx;
+
+typedef void (*reliable_send_fn)(void *ctx, const uint8_t mac[6], const uint8_t *frame, size_t len);
+typedef void (*reliable_done_fn)(void *ctx, const struct reliable_tx *tx, const reliable_msg_t *m);
+
+typedef struct reliable_tx {
+    reliable_msg_t        msg;          // pending command (one at a time)
+    reliable_peer_stats_t peers[RELIABLE_MAX_PEERS];
+    uint8_t               n_peers;
+    bool                  online[RELIABLE_MAX_PEERS];
+} reliable_tx_t;
+
+void reliable_tx_init(reliable_tx_t *tx);
+
+// Peers expected to ACK from now on (the online performers)
+void reliable_tx_set_peers(reliable_tx_t *tx, const uint8_t (*macs)[6], size_t n);
+
+// Track a frame that has just been broadcast once at now_us. A pending
+// message is superseded (reported and dropped). False if the frame is too
+// big or there is nobody to wait for.
+bool reliable_tx_submit(reliable_tx_t *tx, const uint8_t *frame, size_t len,
+                        uint8_t type, uint16_t seq, int64_t now_us, int64_t deadline_us,
+                        reliable_done_fn done, void *ctx);
+
+// An ACK for seq arrived from mac; false if it matched nothing pending
+bool reliable_tx_ack(reliable_tx_t *tx, const uint8_t mac[6], uint16_t seq, int64_t now_us);
+
+// Send due retries and retire the message once finished. Returns the time
+// of the next retry, or INT64_MAX when nothing is pending.
+int64_t reliable_tx_poll(reliable_tx_t *tx, int64_t now_us,
+                         reliable_send_fn send, reliable_done_fn done, void *ctx);
+
+// ----------------------
+// Receiver de-duplication
+// ----------------------
+typedef struct {
+    uint8_t  mac[6];
+    bool     used;
+    uint8_t  head;
+    uint8_t  n;
+    uint16_t seqs[RELIABLE_DEDUP_DEPTH];
+} reliable_rx_sender_t;
+
+typedef struct {
+    reliable_rx_sender_t senders[RELIABLE_MAX_PEERS];
+    uint8_t next;           // round-robin victim when the table is full
+} reliable_rx_t;
+
+void reliable_rx_init(reliable_rx_t *rx);
+// True if (mac, seq) was already seen; records it otherwise
+bool reliable_rx_seen(reliable_rx_t *rx, const uint8_t mac[6], uint16_t seq);
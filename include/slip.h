@@ -0,0 +1,48 @@
+// include/slip.h
+#pragma once
+
+// Sample-slip timeline correction. Each performer's I2S clock runs a few
+// tens of ppm off nominal (use_apll = false), so over a song its playout
+// drifts against the conductor timeline. The engine periodically measures
+// err = audible song position - expected position (samples, + = ahead) and
+// this controller turns it into single-sample slips, at most one per block:
+// skip one song sample (behind) or play one twice (ahead). A slip in the
+// middle of a 10 ms block is inaudible; large errors (a hiccup, a bad
+// estimate) are fixed with one jump instead.
+//
+// The engine renders ahead of the DAC, so slips already rendered but not
+// yet audible (in_flight) are credited before correcting again. Pure C,
+// usable on the host.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SLIP_DEADBAND       2      // |err| <= this many samples is left alone
+#define SLIP_HARD_SAMPLES   441    // beyond 10 ms: jump instead of slipping
+
+typedef struct {
+    int32_t  pending;      // + = song samples still to skip, - = to repeat
+    int64_t  cum;          // net slip rendered so far (skipped - repeated)
+    uint32_t skipped;
+    uint32_t repeated;
+    uint32_t jumps;
+    uint32_t n_meas;
+    int32_t  last_err;     // samples
+    int32_t  max_err;      // worst |err| after the first measurement
+} slip_ctl_t;
+
+void slip_init(slip_ctl_t *s);
+
+// Feed one measurement. Returns a jump to apply to the render position at
+// once (song samples, may be negative; already counted in cum), or 0 when
+// the error is left to single-sample slips.
+int32_t slip_measure(slip_ctl_t *s, int32_t err, int32_t in_flight);
+
+// Slip for the next block: +1 skip one song sample, -1 repeat one, 0 none.
+// The block then consumes block_len + slip song samples.
+int slip_next(slip_ctl_t *s);
+
+// Turn block_len + d rendered samples in acc into block_len output samples
+// by dropping (d = +1) or duplicating (d = -1) the middle one. acc must have
+// room for block_len + 1 samples.
+void slip_apply_block(int32_t *acc, size_t block_len, int d);
@@ -0,0 +1,94 @@
+// include/song_lib.h
+#pragma once
+
+// Song library image, as stored in the "songs" data partition and read in
+// place through a flash mapping: nothing is copied to RAM but one song_t
+// per song, whose melody pointers point into the image. Little-endian;
+// every section starts on a 4-byte boundary so the structs below can be
+// overlaid on the mapping directly:
+//
+//   off          size               section
+//   0            32                 song_lib_hdr_t
+//   tables_off   2*(n_pitch+n_dur)  u16 pitch_hz[], u16 dur_ms[] (song_pack.h)
+//   index_off    4*song_count       u32 offset of each song's record
+//   (records)    76 each            song_lib_rec_t
+//   (melodies)   any                packed notes, found through the records
+//
+// crc32 covers bytes 32 .. total_len-1, i.e. everything after the header.
+// Built by tools/songlib.c. Pure C, usable on the host.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "orchestra.h"   // song_t
+#include "song_pack.h"
+
+#define SONG_LIB_MAGIC      0x424C534Fu   // "OSLB"
+#define SONG_LIB_VERSION    1
+#define SONG_LIB_NAME_LEN   24
+#define SONG_LIB_MAX_SONGS  255           // song ids are uint8_t
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t song_count;
+    uint32_t total_len;     // image bytes, header included
+    uint32_t crc32;
+    uint32_t tables_off;
+    uint32_t index_off;
+    uint8_t  n_pitch;
+    uint8_t  n_dur;
+    uint8_t  reserved[6];
+} song_lib_hdr_t;
+
+typedef struct {
+    uint32_t off;           // packed notes, from the image start; 0 = none
+    uint16_t count;         // notes
+    uint8_t  envelope;      // SYNTH_ENV_* (parts), 0 = the song's
+    uint8_t  reserved;
+} song_lib_mel_t;
+
+typedef struct {
+    char           name[SONG_LIB_NAME_LEN];   // NUL terminated
+    uint8_t        type;                      // song_type_t
+    uint8_t        parts_mask;
+    uint8_t        envelope;
+    uint8_t        reserved;
+    song_lib_mel_t lead;
+    song_lib_mel_t parts[5];
+} song_lib_rec_t;
+
+_Static_assert(sizeof(song_lib_hdr_t) == 32, "library header layout");
+_Static_assert(sizeof(song_lib_rec_t) == 76, "library record layout");
+
+typedef enum {
+    SONG_LIB_OK = 0,
+    SONG_LIB_ERR_SHORT,     // smaller than its header or total_len
+    SONG_LIB_ERR_MAGIC,     // also an erased (0xFF) partition
+    SONG_LIB_ERR_VERSION,
+    SONG_LIB_ERR_CRC,
+    SONG_LIB_ERR_LAYOUT,    // a table, record or melody outside the image
+} song_lib_err_t;
+
+// A checked image
+typedef struct {
+    const uint8_t        *img;
+    const song_lib_hdr_t *hdr;
+    const uint32_t       *index;
+    song_pack_tables_t    tables;
+} song_lib_t;
+
+uint32_t       song_lib_crc32(uint32_t crc, const uint8_t *data, size_t len);
+// Check the header, CRC and every offset, and that each melody decodes
+// within the image. len is the space available (e.g. the partition size).
+song_lib_err_t song_lib_open(song_lib_t *lib, const uint8_t *img, size_t len);
+const char    *song_lib_err_str(song_lib_err_t err);
+
+static inline uint16_t song_lib_count(const song_lib_t *lib) { return lib->hdr->song_count; }
+static inline const song_lib_rec_t *song_lib_rec(const song_lib_t *lib, uint16_t id)
+{
+    return (const song_lib_rec_t *)(lib->img + lib->index[id]);
+}
+// Fill a song_t whose name and melodies point into the image
+void song_lib_song(const song_lib_t *lib, uint16_t id, song_t *out);
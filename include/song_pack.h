@@ -0,0 +1,69 @@
+// include/song_pack.h
+#pragma once
+
+// Compact melody encoding. A note is one byte, a 5-bit index into a pitch
+// table and a 3-bit index into a duration table, instead of the 4-byte
+// note_t. Pitches or durations that are not in the tables are escaped and
+// carried inline, so any melody can be coded:
+//
+//   byte 0: pppppddd
+//     p < SONG_PACK_PITCH_ESC  frequency = pitch_hz[p]
+//     p == SONG_PACK_PITCH_ESC frequency follows as uint16 LE
+//     d < SONG_PACK_DUR_ESC    duration  = dur_ms[d]
+//     d == SONG_PACK_DUR_ESC   duration follows as uint16 LE (after the Hz)
+//
+// A note therefore takes 1, 3 or 5 bytes. The tables are shared by a whole
+// library, not stored per melody. Melodies are decoded one note at a time by
+// an iterator, never expanded in RAM. Pure C, usable on the host.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "orchestra.h"   // note_t
+
+#define SONG_PACK_PITCH_ESC   31
+#define SONG_PACK_DUR_ESC     7
+#define SONG_PACK_MAX_PITCHES SONG_PACK_PITCH_ESC   // table entries usable
+#define SONG_PACK_MAX_DURS    SONG_PACK_DUR_ESC
+#define SONG_PACK_MAX_NOTE    5                     // bytes, both escaped
+
+// One byte for a note whose pitch and duration are both in the tables
+#define SONG_PACK_NOTE(pitch_idx, dur_idx) \
+    ((uint8_t)(((pitch_idx) << 3) | (dur_idx)))
+// Inline value after an escaped pitch or duration (generated sources)
+#define SONG_PACK_U16(v)  (uint8_t)((v) & 0xFF), (uint8_t)((v) >> 8)
+
+typedef struct song_pack_tables {
+    const uint16_t *pitch_hz;   // index 0 is conventionally the rest (0 Hz)
+    const uint16_t *dur_ms;
+    uint8_t         n_pitch;    // <= SONG_PACK_MAX_PITCHES
+    uint8_t         n_dur;      // <= SONG_PACK_MAX_DURS
+} song_pack_tables_t;
+
+// Forward-only cursor over one packed melody
+typedef struct {
+    const song_pack_tables_t *t;
+    const uint8_t *base;
+    const uint8_t *p;       // next byte to decode
+    uint16_t       count;   // notes in the melody
+    uint16_t       index;   // notes decoded so far
+} song_pack_iter_t;
+
+void song_pack_iter_init(song_pack_iter_t *it, const song_pack_tables_t *t,
+                         const uint8_t *notes, uint16_t count);
+// Decode the next note; false once all count notes have been read
+bool song_pack_next(song_pack_iter_t *it, note_t *out);
+// Step over n notes without decoding them (reads only the first byte of each)
+void song_pack_skip(song_pack_iter_t *it, uint16_t n);
+
+// Bytes one note takes, given its first byte
+static inline size_t song_pack_note_size(uint8_t b)
+{
+    return 1u + ((b >> 3) == SONG_PACK_PITCH_ESC ? 2u : 0u)
+              + ((b & 7u) == SONG_PACK_DUR_ESC ? 2u : 0u);
+}
+
+// Encode count notes into out. Returns the bytes the melody needs; nothing
+// past cap is written, so a NULL/0 call sizes the buffer (like snprintf).
+size_t song_pack_encode(const song_pack_tables_t *t, const note_t *notes, uint16_t count,
+                        uint8_t *out, size_t cap);
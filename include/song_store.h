@@ -0,0 +1,29 @@
+// include/song_store.h
+#pragma once
+
+// The "songs" data partition (partitions.csv). It holds a song library
+// image (song_lib.h) that is mapped into the address space and read in
+// place, so a new repertoire is one partition write instead of a reflash
+// (parttool.py, or pushed by the conductor over ESP-NOW: song_sync.h).
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#define SONG_STORE_LABEL    "songs"
+#define SONG_STORE_SUBTYPE  0x40       // first custom data subtype
+
+// Map the partition and, if it holds a valid library, make it the active
+// one (songs_use_library()); otherwise the built-in songs stay active.
+void song_store_init(void);
+// True when songs come from the partition rather than the firmware
+bool song_store_active(void);
+// The active library image (the mapping), e.g. to send to performers;
+// false when the built-in songs are in use
+bool song_store_image(const uint8_t **img, size_t *len);
+// Write a new library image to the partition and make it active. The image
+// is checked first (song_lib_open()), so a bad one never replaces a good
+// one. Song ids change meaning: stop playback and drop the PCM cache
+// (audio_cache_drop()) before calling.
+esp_err_t song_store_install(const uint8_t *img, size_t len);
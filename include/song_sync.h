@@ -0,0 +1,31 @@
+// include/song_sync.h
+#pragma once
+
+// Song library distribution over ESP-NOW (blob_xfer.h). The conductor
+// pushes its active library image (song_store_image()) to the performers
+// that are online; each one receives it into RAM and, once the whole-blob
+// hash matches, stops playback and writes it to its "songs" partition
+// (song_store_install()). It is then both persistent and the active
+// library, with no reboot. Songs are selected by index, so every device
+// must hold the same library: write the new image to the conductor
+// (FLASHING.md), then push it. Firmware images travel the same way
+// (fw_update.h); performers pick the sink by the blob kind.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "wire_proto.h"
+
+#define SONG_SYNC_MAX_LEN   (64 * 1024)   // largest library a performer takes (RAM)
+
+esp_err_t song_sync_init(void);
+// Receive path: a WIRE_T_BLOB frame, copied and handled on the sync task
+void      song_sync_handle_frame(const uint8_t *src_mac, const wire_frame_t *f, int64_t rx_us);
+// Conductor: start sending the active library to the online performers and
+// return; progress and the result (time per performer, KB/s) are logged.
+// ESP_ERR_NOT_FOUND if the built-in songs are active (nothing to send).
+esp_err_t song_sync_push(void);
+// Conductor: send any blob (data must stay valid until done) to the online
+// performers, all at once or, for comparison, one after another by unicast
+esp_err_t song_sync_send(uint8_t kind, const uint8_t *data, size_t len, bool one_by_one);
+bool      song_sync_busy(void);
@@ -2,7 +2,9 @@
 #define SONGS_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "orchestra.h"
+#include "song_pack.h"
 
 // Numeric Song IDs (used by main.c to pick songs)
 #define SONG_JUPITER_HYMN       0
@@ -48,6 +50,7 @@
 #define NOTE_A6  1760
 
 #define REST     0
+#define NOTE_REST REST
 
 // Note duration helpers (in milliseconds)
 #define WHOLE_NOTE      2000
@@ -56,6 +59,28 @@
 #define EIGHTH_NOTE     250
 #define SIXTEENTH_NOTE  125
 
+// Pitch and duration tables of the built-in library, in table order.
+// Melodies in songs.c are written as NOTE(C5, QUARTER): one byte each
+// (song_pack.h). Append only: reordering changes every packed note.
+#define SONG_PITCHES(X)                                                       \
+    X(REST)                                                                   \
+    X(C3) X(D3) X(E3) X(F3) X(G3) X(A3) X(B3)                                 \
+    X(C4) X(D4) X(E4) X(F4) X(G4) X(A4) X(AS4) X(B4)                          \
+    X(C5) X(D5) X(E5) X(F5) X(G5) X(A5) X(AS5) X(B5)                          \
+    X(C6) X(D6) X(E6) X(F6) X(G6) X(A6)
+#define SONG_DURATIONS(X) X(WHOLE) X(HALF) X(QUARTER) X(EIGHTH) X(SIXTEENTH)
+
+#define SONG_PITCH_ENUM(n) PITCH_##n,
+#define SONG_DUR_ENUM(n)   DUR_##n,
+enum { SONG_PITCHES(SONG_PITCH_ENUM) PITCH_COUNT };
+enum { SONG_DURATIONS(SONG_DUR_ENUM) DUR_COUNT };
+_Static_assert(PITCH_COUNT <= SONG_PACK_MAX_PITCHES, "too many pitches for one byte");
+_Static_assert(DUR_COUNT <= SONG_PACK_MAX_DURS, "too many durations for one byte");
+
+#define NOTE(pitch, dur) SONG_PACK_NOTE(PITCH_##pitch, DUR_##dur)
+
+extern const song_pack_tables_t song_tables;
+
 // Part masks for multi-part songs
 #define PART_1     0x01
 #define PART_2     0x02
@@ -64,8 +89,28 @@
 #define PART_5     0x10
 #define ALL_PARTS  0x1F
 
-// External song arrays (must be defined in songs.c)
+// Built-in library, compiled into the firmware (songs.c)
 extern const song_t songs[];
 extern const uint8_t total_songs;
 
+// Active library: song ids index this one. It is the built-in library
+// until songs_use_library() installs another table (e.g. the flash song
+// partition, song_store.h); NULL goes back to the built-in one. Swap only
+// while nothing plays: seek indexes built so far are rebuilt for the new
+// table. Lookups are O(1).
+void          songs_use_library(const song_t *table, uint8_t count);
+uint8_t       song_count(void);
+const song_t *song_get(uint8_t song_id);   // NULL for an invalid id
+
+// Length of the longest part of a song, ms (0 for an invalid id)
+uint32_t song_duration_ms(uint8_t song_id);
+
+// Cumulative time indexes (note_timeline.h) for every melody of every song,
+// so seeking into a song is a binary search. Built once at boot;
+// song_melody_index() returns NULL before that, or for a melody that does
+// not belong to the song (callers then fall back to a linear seek).
+void            songs_index_init(void);
+bool            song_melody_index_ready(void);
+const uint32_t *song_melody_index(uint8_t song_id, const uint8_t *melody);
+
 #endif // SONGS_H
@@ -0,0 +1,112 @@
+// include/synth.h
+#pragma once
+
+// Fixed-point tone synthesis shared by the audio engine and the host tools.
+// Pure C (no ESP-IDF headers) so it can be built and benchmarked on a PC.
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Sine wavetable: 2^SYNTH_LUT_BITS entries of Q15, plus one guard entry so
+// linear interpolation never has to wrap the index.
+#define SYNTH_LUT_BITS    10
+#define SYNTH_LUT_SIZE    (1u << SYNTH_LUT_BITS)
+
+// Q15 unity gain (0x7FFF ~= 1.0)
+#define SYNTH_Q15_ONE     32767
+
+// Build the sine table. Cheap (one sinf() per entry) and idempotent.
+void synth_init(void);
+
+// Phase increment for a 32-bit phase accumulator: freq * 2^32 / sample_rate.
+// Returns 0 for a rest (freq == 0).
+uint32_t synth_phase_inc(uint16_t freq_hz, uint32_t sample_rate);
+
+// Convert a 0..1 float volume to a Q15 gain (clamped).
+int16_t synth_gain_q15(float vol);
+// ... and back (exact inverse for values synth_gain_q15() produced)
+float synth_gain_from_q15(int32_t gain_q15);
+
+// Render n samples of a sine at 'inc' into buf, scaled by gain_q15.
+// *phase_io is carried across calls so the waveform stays continuous.
+// inc == 0 renders silence and leaves the phase untouched.
+void synth_render_tone(int16_t *buf, size_t n, uint32_t *phase_io,
+                       uint32_t inc, int16_t gain_q15);
+
+// ----------------------
+// Polyphonic mixing
+// ----------------------
+// Voices are summed unscaled (Q15 each) into an int32 accumulator, then the
+// sum is scaled once by volume * headroom and saturated to int16.
+
+// Accumulate n samples of a full-scale sine into acc (inc == 0 adds nothing)
+void synth_mix_tone(int32_t *acc, size_t n, uint32_t *phase_io, uint32_t inc);
+
+// Headroom gain for n summed voices, 1/sqrt(n) in Q15 (1 voice = unity)
+int32_t synth_headroom_q15(unsigned n_voices);
+
+// out[i] = sat16(acc[i] * gain_q15 >> 15)
+void synth_mix_out(int16_t *out, const int32_t *acc, size_t n, int32_t gain_q15);
+
+// ----------------------
+// ADSR envelopes
+// ----------------------
+// Per-note attack/decay/sustain/release applied in fixed point while mixing.
+// Stage shapes come from a small rise-curve table; the level ramps linearly
+// from one table point to the next (one division per ramp, ramps of at least
+// SYNTH_ENV_SEG samples), held for SYNTH_ENV_STEP samples at a time. Ramps
+// cost one multiply per sample; sustaining costs nothing over the bare
+// oscillator, at full level or (for the presets) from a sine table scaled
+// to the sustain level. The whole envelope, release included, fits inside
+// the note's duration so the sample-accurate timeline is unchanged.
+
+#define SYNTH_ENV_SEG     32
+#define SYNTH_ENV_STEP    16
+
+// Envelope presets, selectable per song (song_t.envelope) or per part
+// (part_melody_t.envelope). DEFAULT means "inherit" / engine default.
+typedef enum {
+    SYNTH_ENV_DEFAULT = 0,
+    SYNTH_ENV_NONE,        // flat: full level for the whole note
+    SYNTH_ENV_SOFT,        // short attack and release, click-free legato
+    SYNTH_ENV_PLUCK,       // fast attack, long decay to a low sustain
+    SYNTH_ENV_PAD,         // slow swell
+    SYNTH_ENV_COUNT
+} synth_env_preset_t;
+
+typedef struct {
+    uint16_t attack_ms;
+    uint16_t decay_ms;
+    int16_t  sustain_q15;
+    uint16_t release_ms;
+} synth_adsr_t;
+
+// Per-voice envelope state; times are samples since note-on
+typedef struct {
+    const synth_adsr_t *shape;   // NULL = flat
+    const int16_t *lut;          // sine table at the sustain level, NULL = scale per sample
+    uint32_t t;
+    uint32_t a_end;              // attack ends
+    uint32_t d_end;              // decay ends
+    uint32_t r_start;            // gate off
+    uint32_t r_end;              // release ends (== note length)
+    int32_t  sustain;            // Q15
+    int32_t  r_level;            // level at gate off, Q15
+    // Running ramp through the current stage
+    int32_t  g;                  // level at g_t, Q15 << 16
+    int32_t  dg;                 // per-sample step
+    uint32_t g_t;
+    uint32_t ramp_end;           // sample where it reaches curve point 'knee'
+    uint8_t  knee;
+} synth_env_t;
+
+// Preset lookup; NULL for SYNTH_ENV_NONE (and anything unknown)
+const synth_adsr_t *synth_env_preset(uint8_t preset);
+
+// Start a note of note_len samples, t0 samples already elapsed (for seeks)
+void synth_env_note_on(synth_env_t *e, const synth_adsr_t *shape,
+                       uint32_t note_len, uint32_t t0, uint32_t sample_rate);
+
+// synth_mix_tone() with the envelope applied; advances the envelope by n
+void synth_mix_tone_env(int32_t *acc, size_t n, uint32_t *phase_io,
+                        uint32_t inc, synth_env_t *env);
@@ -0,0 +1,96 @@
+// include/transport.h
+#pragma once
+
+// The link wire frames (wire_proto.h) travel on. espnow_comm.c,
+// espnow_discovery.c and song_sync.c send and receive only through this,
+// so the radio can be swapped: ESP-NOW on the devices (transport_espnow.c),
+// UDP multicast on Linux (transport_udp.c), where one process per node, on
+// one machine or across a LAN, stands in for a board.
+//
+// Nodes have 6-byte addresses (the STA MAC on ESP-NOW); a frame sent to
+// NULL or TRANSPORT_BROADCAST reaches every other node, one sent to an
+// address only that node. Frames arrive whole or not at all, never to
+// their sender, up to TRANSPORT_MAX_FRAME bytes.
+//
+// rx gets each frame with the sender's address and the time it arrived on
+// the backend's clock (now_us; esp_timer on the device), taken before any
+// queueing. It runs on the backend's thread (the WiFi task, or whoever
+// calls poll) and must not block. tx_done reports each send: for ESP-NOW
+// unicast whether the peer acknowledged it, otherwise whether the link
+// took it; it may run before send returns.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define TRANSPORT_ADDR_LEN   6
+#define TRANSPORT_MAX_FRAME  250   // ESP_NOW_MAX_DATA_LEN
+
+extern const uint8_t TRANSPORT_BROADCAST[TRANSPORT_ADDR_LEN];
+
+struct transport;
+
+typedef void (*transport_rx_fn)(void *ctx, const uint8_t *src, const uint8_t *frame, size_t len, int64_t rx_us);
+typedef void (*transport_tx_done_fn)(void *ctx, const uint8_t *dst, bool ok);
+
+// A backend fills in the operations; the callbacks are set by the user.
+// Error codes are the backend's own (esp_err_t on the device, errno on
+// Linux), 0 meaning success.
+typedef struct transport {
+    const char *name;
+    int     (*start)(struct transport *t);
+    int     (*send)(struct transport *t, const uint8_t *dst, const uint8_t *frame, size_t len);
+    // Unicast to a node needs it registered first on some links (ESP-NOW peer table)
+    void    (*add_peer)(struct transport *t, const uint8_t *addr);
+    void    (*own_addr)(struct transport *t, uint8_t *addr);
+    // Backends without a receive thread: wait up to timeout_ms for frames and
+    // deliver them; returns how many. NULL where frames arrive on their own.
+    int     (*poll)(struct transport *t, int timeout_ms);
+    int64_t (*now_us)(struct transport *t);
+
+    transport_rx_fn      rx;
+    void                *rx_ctx;
+    transport_tx_done_fn tx_done;
+    void                *tx_done_ctx;
+    void                *priv;      // backend state
+} transport_t;
+
+void transport_set_rx(transport_t *t, transport_rx_fn fn, void *ctx);
+void transport_set_tx_done(transport_t *t, transport_tx_done_fn fn, void *ctx);
+bool transport_is_broadcast(const uint8_t *addr);   // NULL counts as broadcast
+
+static inline int transport_start(transport_t *t) { return t->start ? t->start(t) : 0; }
+static inline int transport_send(transport_t *t, const uint8_t *dst, const uint8_t *frame, size_t len)
+{
+    return t->send(t, dst, frame, len);
+}
+static inline void transport_add_peer(transport_t *t, const uint8_t *addr)
+{
+    if (t->add_peer) t->add_peer(t, addr);
+}
+static inline void transport_own_addr(transport_t *t, uint8_t *addr) { t->own_addr(t, addr); }
+static inline int  transport_poll(transport_t *t, int timeout_ms) { return t->poll ? t->poll(t, timeout_ms) : 0; }
+static inline int64_t transport_now_us(transport_t *t) { return t->now_us(t); }
+
+// Backend side: hand a received frame / a send result to the user
+void transport_deliver(transport_t *t, const uint8_t *src, const uint8_t *frame, size_t len, int64_t rx_us);
+void transport_report_tx(transport_t *t, const uint8_t *dst, bool ok);
+
+// ----------------------
+// Backends
+// ----------------------
+
+// ESP-NOW over the WiFi STA interface (device only; one instance). start
+// brings up WiFi and ESP-NOW; NVS must be initialised before.
+transport_t *transport_espnow(void);
+
+// UDP multicast (Linux). Every node joins group:port; frames carry the
+// destination and source address so unicast is filtered by the receiver.
+// node gives the address 02:4F:52:43:hi:lo and must be unique in the group.
+// iface_addr NULL keeps the traffic on loopback (one machine); an interface
+// address (dotted quad) spans the LAN. NULL if the socket cannot be set up.
+#define TRANSPORT_UDP_GROUP  "239.255.77.1"
+#define TRANSPORT_UDP_PORT   47701
+
+transport_t *transport_udp_open(uint16_t node, const char *group, uint16_t port, const char *iface_addr);
+void         transport_udp_close(transport_t *t);
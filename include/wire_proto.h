@@ -0,0 +1,161 @@
+// include/wire_proto.h
+#pragma once
+
+// On-air frame format shared by control, clock-sync and discovery traffic.
+// Explicitly serialised little-endian, no compiler layout or padding:
+//
+//   off size field
+//   0   1    magic    WIRE_MAGIC
+//   1   1    version  major << 4 | minor
+//   2   1    type     WIRE_T_*
+//   3   1    flags    WIRE_F_*
+//   4   1    sender   device id
+//   5   2    seq      per-sender frame counter
+//   7   1    len      payload bytes
+//   8   len  payload  type specific, see the wire_*_t structs below
+//   8+len 2  crc      CRC-16/CCITT-FALSE over bytes 0 .. 8+len-1
+//
+// Compatibility: frames with a different major version are rejected;
+// within a major version new fields are only ever appended to a payload,
+// and readers ignore payload bytes they do not know about. Pure C, usable
+// on the host.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "orch_state.h"
+
+#define WIRE_MAGIC          0xA5
+#define WIRE_VERSION_MAJOR  1
+#define WIRE_VERSION_MINOR  1   // 1: state vector appended to control frames
+#define WIRE_VERSION        ((WIRE_VERSION_MAJOR << 4) | WIRE_VERSION_MINOR)
+
+#define WIRE_HDR_LEN        8
+#define WIRE_CRC_LEN        2
+#define WIRE_MAX_PAYLOAD    (250 - WIRE_HDR_LEN - WIRE_CRC_LEN)   // ESP_NOW_MAX_DATA_LEN
+#define WIRE_MAX_FRAME      (WIRE_HDR_LEN + WIRE_MAX_PAYLOAD + WIRE_CRC_LEN)
+
+// Frame types. Control types are the msg_type_t values (orchestra.h),
+// discovery types are WIRE_T_DISCO + discovery_msg_type_t and bulk transfer
+// types WIRE_T_BLOB + blob_msg_type_t (blob_xfer.h), so all three enums
+// are append-only.
+#define WIRE_T_CONTROL      0x00   // 0x00..0x3F: msg_type_t
+#define WIRE_T_DISCO        0x40   // 0x40..0x7F: discovery_msg_type_t
+#define WIRE_T_IS_DISCO(t)  ((t) >= WIRE_T_DISCO && (t) < 0x80)
+#define WIRE_T_BLOB         0x80   // 0x80..0x8F: blob_msg_type_t
+#define WIRE_T_IS_BLOB(t)   ((t) >= WIRE_T_BLOB && (t) < 0x90)
+
+#define WIRE_F_NONE         0x00
+#define WIRE_F_ACK_REQ      0x01   // receiver must answer with an ACK frame
+
+typedef enum {
+    WIRE_OK = 0,
+    WIRE_ERR_SHORT,       // shorter than header + CRC
+    WIRE_ERR_MAGIC,
+    WIRE_ERR_VERSION,     // different major version
+    WIRE_ERR_LEN,         // payload length disagrees with frame length
+    WIRE_ERR_CRC,
+} wire_err_t;
+
+// Parsed header; payload points into the caller's buffer
+typedef struct {
+    uint8_t        version;
+    uint8_t        type;
+    uint8_t        flags;
+    uint8_t        sender;
+    uint16_t       seq;
+    uint8_t        len;
+    const uint8_t *payload;
+} wire_frame_t;
+
+uint16_t   wire_crc16(const uint8_t *data, size_t len);
+
+// Validate and split a received frame (no copies)
+wire_err_t wire_parse(const uint8_t *buf, size_t len, wire_frame_t *out);
+const char *wire_err_str(wire_err_t err);
+
+// ----------------------
+// Payload cursors
+// ----------------------
+// Bounds-checked LE writer/reader. Overruns set ok = false and stop
+// writing/return zeros, so encoders check once at the end.
+typedef struct {
+    uint8_t *buf;
+    size_t   cap;
+    size_t   pos;
+    bool     ok;
+} wire_writer_t;
+
+typedef struct {
+    const uint8_t *buf;
+    size_t         len;
+    size_t         pos;
+    bool           ok;
+} wire_reader_t;
+
+void     wire_writer_init(wire_writer_t *w, uint8_t *buf, size_t cap);
+void     wire_put_u8(wire_writer_t *w, uint8_t v);
+void     wire_put_u16(wire_writer_t *w, uint16_t v);
+void     wire_put_u32(wire_writer_t *w, uint32_t v);
+void     wire_put_u64(wire_writer_t *w, uint64_t v);
+void     wire_put_bytes(wire_writer_t *w, const void *p, size_t n);
+
+void     wire_reader_init(wire_reader_t *r, const wire_frame_t *f);
+uint8_t  wire_get_u8(wire_reader_t *r);
+uint16_t wire_get_u16(wire_reader_t *r);
+uint32_t wire_get_u32(wire_reader_t *r);
+uint64_t wire_get_u64(wire_reader_t *r);
+void     wire_get_bytes(wire_reader_t *r, void *p, size_t n);
+
+// Start a frame in buf (cap >= WIRE_MAX_FRAME is always enough); the
+// returned writer is positioned at the payload.
+void   wire_begin(wire_writer_t *w, uint8_t *buf, size_t cap,
+                  uint8_t type, uint8_t flags, uint8_t sender, uint16_t seq);
+// Set header flags after wire_begin()
+void   wire_set_flags(wire_writer_t *w, uint8_t flags);
+// Fill in len and CRC; returns the frame length, or 0 if it overflowed
+size_t wire_finish(wire_writer_t *w);
+
+// ----------------------
+// Payloads
+// ----------------------
+
+// START / STOP / SELECT / HEARTBEAT. The conductor's state vector is
+// appended (minor 1); frames from older senders decode with has_state false.
+typedef struct {
+    uint8_t      song_id;
+    uint64_t     timestamp;   // conductor clock, us
+    bool         has_state;
+    orch_state_t state;
+} wire_ctrl_t;
+
+// CLOCK_REQ (t1 only) / CLOCK_RESP
+typedef struct {
+    uint8_t  target;      // RESP: requester id
+    uint16_t req_seq;     // RESP: header seq of the request
+    uint64_t t1, t2, t3;
+} wire_clock_t;
+
+// Discovery frames
+typedef struct {
+    uint8_t  role;
+    uint8_t  mac[6];
+    uint32_t timestamp;   // ms
+    char     name[32];    // sent length-prefixed, NUL-terminated on read
+} wire_disco_t;
+
+// ACK for a WIRE_F_ACK_REQ frame
+typedef struct {
+    uint16_t seq;         // header seq being acknowledged
+    uint8_t  type;        // its frame type
+} wire_ack_t;
+
+void wire_put_ctrl(wire_writer_t *w, const wire_ctrl_t *p);
+bool wire_get_ctrl(const wire_frame_t *f, wire_ctrl_t *p);
+void wire_put_clock(wire_writer_t *w, bool response, const wire_clock_t *p);
+bool wire_get_clock(const wire_frame_t *f, bool response, wire_clock_t *p);
+void wire_put_disco(wire_writer_t *w, const wire_disco_t *p);
+bool wire_get_disco(const wire_frame_t *f, wire_disco_t *p);
+void wire_put_ack(wire_writer_t *w, const wire_ack_t *p);
+bool wire_get_ack(const wire_frame_t *f, wire_ack_t *p);
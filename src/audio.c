@@ -1,14 +1,24 @@
 // src/audio.c
-#include <math.h>
-#include <stdlib.h>
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "driver/i2s.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
 
+#include "audio.h"
 #include "songs.h"
+#include "synth.h"
+#include "pcm_ring.h"
+#include "note_timeline.h"
+#include "part_mix.h"
+#include "slip.h"
 #include "device_config.h"
 #include "display_animations.h"
 
@@ -18,21 +28,156 @@ static const char *TAG = "AUDIO";
 // Audio configuration
 // ----------------------
 #define SAMPLE_RATE       44100
-#define DMA_BUF_COUNT     8
-#define DMA_BUF_LEN       64
 
-// Tick timing (make sure SAMPLE_RATE * TICK_MS / 1000 is an integer)
-#ifndef AUDIO_TICK_MS
-#define AUDIO_TICK_MS     10          // 10 ms => 100 ticks/sec
+// Latency profile used from boot; build with e.g.
+// -DAUDIO_PROFILE=AUDIO_PROFILE_ROBUST, or switch at run time with
+// audio_set_profile() / audio_autotune_profile()
+#ifndef AUDIO_PROFILE
+#define AUDIO_PROFILE     AUDIO_PROFILE_BALANCED
 #endif
-#define SAMPLES_PER_TICK  (SAMPLE_RATE * AUDIO_TICK_MS / 1000)
+
+// Largest block and ring any profile uses (static buffers are sized by them)
+#define AUDIO_BLOCK_MAX   441
+#define AUDIO_RING_MAX    4
+
+// Longest the engine and feeder sleep when nobody wakes them
+#define AUDIO_WAIT_MS     10
+
+// PCM pre-rendered on SELECT: the whole song when PSRAM is present,
+// otherwise this much of its head in internal RAM
+#ifndef AUDIO_CACHE_HEAD_MS
+#define AUDIO_CACHE_HEAD_MS  400
+#endif
+
+#define AUDIO_CMD_QUEUE_LEN  8
+
+// Fade applied to the first flushed block on STOP/PLAY/SEEK so the cut is
+// click-free (shortened to the block on small-block profiles)
+#define STOP_FADE_SAMPLES   (SAMPLE_RATE * 5 / 1000)
+
+// ----------------------
+// Latency profiles
+// ----------------------
+// Render block, render-ahead ring (power of two) and DMA depth. Note
+// boundaries are sample-accurate (note_timeline.c), so the block need not
+// be a whole number of milliseconds. Output latency = ring + DMA.
+static const audio_profile_t k_profiles[AUDIO_PROFILE_COUNT] = {
+    //                           name         block ring dma x len
+    [AUDIO_PROFILE_ULTRA_LOW] = { "ultra-low",  128,  2,   4,  32 },   //  8.7 ms
+    [AUDIO_PROFILE_BALANCED]  = { "balanced",   256,  4,   4,  64 },   // 29.0 ms
+    [AUDIO_PROFILE_ROBUST]    = { "robust",     441,  4,   8,  64 },   // 51.6 ms
+};
+
+static audio_profile_id_t s_prof_id = AUDIO_PROFILE;
+static audio_profile_t    s_prof;
+
+static inline uint32_t dma_samples(void) { return (uint32_t)s_prof.dma_buf_count * s_prof.dma_buf_len; }
+// Worst-case audio still in DMA after the ring is flushed
+static inline int64_t dma_tail_us(void) { return (int64_t)dma_samples() * 1000000 / SAMPLE_RATE; }
 
 // ----------------------
 // Audio state
 // ----------------------
-static bool          audio_playing = false;
+static volatile bool audio_playing = false;
 static float         volume = 0.08f;        // 0..1
-static TaskHandle_t  playback_task_handle = NULL;
+static int16_t       volume_q15 = 2621;     // volume in Q15, used by the renderer
+
+// Engine task (ring producer) and its command queue
+typedef enum {
+    AUDIO_CMD_PLAY = 0,
+    AUDIO_CMD_STOP,
+    AUDIO_CMD_SEEK,
+    AUDIO_CMD_SET_VOLUME,
+    AUDIO_CMD_SYNC,
+    AUDIO_CMD_SET_PROFILE,
+} audio_cmd_type_t;
+
+typedef struct {
+    audio_cmd_type_t type;
+    uint8_t  song_id;
+    uint8_t  role;         // PLAY: this device's own part
+    uint8_t  parts;        // PLAY: extra parts to mix in (PART_1..PART_4 bits)
+    uint32_t arg;          // SEEK: ms from song start, SET_VOLUME: Q15 gain, SET_PROFILE: id
+    int64_t  epoch_us;     // PLAY: local esp_timer time of song position 0, 0 = from the top
+                           // SYNC: local time at which the song should be at song_us
+    int64_t  song_us;      // SYNC: expected song position
+    int64_t  issued_us;    // esp_timer time the caller posted the command
+} audio_cmd_t;
+
+static QueueHandle_t     s_cmd_queue = NULL;
+static TaskHandle_t      s_engine_task = NULL;
+static SemaphoreHandle_t s_stop_ack = NULL;
+static SemaphoreHandle_t s_profile_ack = NULL;
+
+// Render stage -> I2S feeder pipeline
+static pcm_ring_t    s_ring;
+static int16_t       s_ring_storage[AUDIO_RING_MAX * AUDIO_BLOCK_MAX];
+static TaskHandle_t  s_feeder_task = NULL;
+static volatile bool s_stream_active = false;   // producer has more blocks coming
+static volatile bool s_flush_req = false;       // feeder should drop queued blocks
+static int16_t       s_fade_buf[AUDIO_BLOCK_MAX];
+static volatile uint32_t s_underruns = 0;       // ring empty while streaming
+
+// Latency bookkeeping: the feeder stamps the first block of a new song
+static volatile bool     s_first_pending = false;
+static volatile uint32_t s_first_seq = 0;       // ring index of that block
+static volatile int64_t  s_play_issued_us = 0;
+static volatile bool     s_first_cached = false;  // that block came from the PCM cache
+static int64_t           s_first_hit_sum_us = 0, s_first_miss_sum_us = 0;
+static uint32_t          s_first_hit_n = 0, s_first_miss_n = 0;
+static audio_latency_stats_t s_lat;
+
+// Timeline tracking. The engine knows the song position of every block it
+// renders (s_song_pos: next sample, after slips); per ring slot it records
+// the position and net slip at the block's end, and the feeder carries that
+// into the played-block history below when it hands the block to I2S.
+static slip_ctl_t    s_slip;
+static uint64_t      s_song_pos = 0;
+static uint64_t      s_blk_end_pos[AUDIO_RING_MAX];
+static int64_t       s_blk_end_cum[AUDIO_RING_MAX];
+static int64_t       s_align_epoch_us = 0;      // PLAY epoch still to be checked at the DAC
+
+// DAC sample clock. i2s_write() only tells what was handed to the driver,
+// which runs up to dma_samples() ahead of the DAC. The driver posts
+// I2S_EVENT_TX_DONE each time DMA finishes a descriptor (dma_buf_len
+// samples), and with tx_desc_auto_clear it keeps clocking out silence when
+// nothing is written, so counting events gives the samples actually played.
+// Silence the driver inserted (idle, underruns) is inferred whenever more
+// has been played than was written: written-stream sample w is at the DAC
+// when frames - silence == w.
+#define I2S_EVENT_QUEUE_LEN  32                 // >= 23 ms of completions
+#define DAC_LEAK_NS          2000               // per event, see dac_clock_task
+
+typedef struct {
+    uint64_t frames;       // samples clocked out since the driver started
+    int64_t  t_ns;         // filtered esp_timer time 'frames' was reached
+    uint64_t written;      // samples handed to i2s_write()
+    uint64_t silence;      // samples played that were not ours
+    uint32_t events;
+    uint64_t ref_frames;   // first completion, for the rate estimate
+    int64_t  ref_ns;
+} dac_clock_t;
+
+// Blocks that may still be in DMA, newest last (written-stream end index);
+// must cover dma_samples() / block + 2 for every profile
+#define PLAYED_HIST  8
+typedef struct {
+    uint64_t w_end;
+    uint64_t end_pos;      // song sample at the block's end
+    int64_t  cum;          // net slip rendered up to there
+} played_blk_t;
+
+static QueueHandle_t s_i2s_events = NULL;
+static dac_clock_t   s_dac;
+static played_blk_t  s_played[PLAYED_HIST];
+static uint32_t      s_played_n = 0;
+static portMUX_TYPE  s_dac_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Profile change: the feeder and DAC clock step off the I2S driver while
+// the engine reinstalls it
+static volatile bool s_park_req = false;
+static volatile bool s_feeder_parked = false;
+static volatile bool s_clock_parked = false;
 
 // ----------------------
 // Animation helpers
@@ -59,179 +204,759 @@ static void audio_init_i2s(void) {
         .channel_format = I2S_CHANNEL_FMT_ONLY_RIGHT,
         .communication_format = I2S_COMM_FORMAT_STAND_MSB,
         .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-        .dma_buf_count = DMA_BUF_COUNT,
-        .dma_buf_len = DMA_BUF_LEN,
+        .dma_buf_count = s_prof.dma_buf_count,
+        .dma_buf_len = s_prof.dma_buf_len,
         .use_apll = false,
         .tx_desc_auto_clear = true,
     };
-    ESP_ERROR_CHECK(i2s_driver_install(I2S_NUM_0, &i2s_config, 0, NULL));
+    ESP_ERROR_CHECK(i2s_driver_install(I2S_NUM_0, &i2s_config, I2S_EVENT_QUEUE_LEN, &s_i2s_events));
     ESP_ERROR_CHECK(i2s_set_dac_mode(I2S_DAC_CHANNEL_RIGHT_EN));
     ESP_ERROR_CHECK(i2s_set_pin(I2S_NUM_0, NULL));
-    ESP_LOGI(TAG, "I2S audio initialized (%d Hz, %d-sample tick)", SAMPLE_RATE, SAMPLES_PER_TICK);
+    ESP_LOGI(TAG, "I2S audio initialized (%d Hz, profile '%s': %u-sample blocks x %u, DMA %u x %u, %u us output latency)",
+             SAMPLE_RATE, s_prof.name, (unsigned)s_prof.block_samples, (unsigned)s_prof.ring_blocks,
+             (unsigned)s_prof.dma_buf_count, (unsigned)s_prof.dma_buf_len,
+             (unsigned)audio_profile_latency_us(&s_prof));
 }
 
 // ----------------------
-// Tick renderer
+// DAC sample clock
 // ----------------------
-// This generates exactly SAMPLES_PER_TICK samples each tick at 'freq' Hz,
-// preserving 'phase' across ticks to keep waveform continuous.
-static void render_tick(int16_t *buf, uint16_t freq, float *phase_io) {
-    float phase = *phase_io;
-    float step  = (freq == 0) ? 0.f : (2.0f * (float)M_PI * (float)freq / (float)SAMPLE_RATE);
-
-    if (freq == 0) {
-        // Silence (rest)
-        memset(buf, 0, SAMPLES_PER_TICK * sizeof(int16_t));
-    } else {
-        for (size_t i = 0; i < SAMPLES_PER_TICK; ++i) {
-            float s = sinf(phase) * volume;
-            // scale to int16
-            buf[i] = (int16_t)(s * 32767.0f);
-            phase += step;
-            if (phase >= 2.0f * (float)M_PI) phase -= 2.0f * (float)M_PI;
+// Highest-priority audio task: all it does is count DMA completions
+static void dac_clock_task(void *pv) {
+    (void)pv;
+    i2s_event_t ev;
+    for (;;) {
+        if (s_park_req) {
+            s_clock_parked = true;
+            while (s_park_req) vTaskDelay(1);
+            s_clock_parked = false;
+            continue;
         }
+        // Bounded wait so a park request is seen even if DMA stalls
+        if (xQueueReceive(s_i2s_events, &ev, pdMS_TO_TICKS(AUDIO_WAIT_MS)) != pdTRUE) continue;
+        if (ev.type != I2S_EVENT_TX_DONE) continue;
+        int64_t now_ns = esp_timer_get_time() * 1000;
+
+        portENTER_CRITICAL(&s_dac_lock);
+        dac_clock_t *c = &s_dac;
+        // Wake-up latency only ever makes now_ns late, so keep the earliest
+        // time consistent with the previous completion. The small leak lets
+        // the estimate follow a DAC clock slower than nominal.
+        int64_t pred = c->t_ns + (int64_t)s_prof.dma_buf_len * 1000000000 / SAMPLE_RATE + DAC_LEAK_NS;
+        c->t_ns = (c->events && pred < now_ns) ? pred : now_ns;
+        c->frames += s_prof.dma_buf_len;
+        if (!c->events) {
+            c->ref_frames = c->frames;
+            c->ref_ns     = c->t_ns;
+        }
+        c->events++;
+        if (c->frames - c->silence > c->written) c->silence = c->frames - c->written;
+        portEXIT_CRITICAL(&s_dac_lock);
     }
-    *phase_io = phase;
 }
 
-// ----------------------
-// Role part selection / transform
-// ----------------------
-static void select_melody_for_role(const song_t *song, uint8_t role,
-                                   const note_t **out_notes, uint16_t *out_count)
-{
-    // Prefer explicit part if present
-    if (role >= ROLE_PART_1 && role <= ROLE_PART_4) {
-        int part_idx = (int)role; // ROLE_PART_1 = 1
-        if (song->parts[part_idx].notes && song->parts[part_idx].note_count) {
-            *out_notes = song->parts[part_idx].notes;
-            *out_count = song->parts[part_idx].note_count;
-            return;
+static void dac_snapshot(dac_clock_t *c) {
+    portENTER_CRITICAL(&s_dac_lock);
+    *c = s_dac;
+    portEXIT_CRITICAL(&s_dac_lock);
+}
+
+// Samples played by local time t_us, extrapolated from the last completion
+static uint64_t dac_frames_at(const dac_clock_t *c, int64_t t_us) {
+    int64_t d = (t_us * 1000 - c->t_ns) * SAMPLE_RATE / 1000000000;
+    if (d < 0 && (uint64_t)-d > c->frames) return 0;
+    return c->frames + d;
+}
+
+// Called by the feeder right before handing a block to i2s_write(): counting
+// it first means the DAC can never look ahead of what the driver holds
+static void dac_wrote(uint32_t samples, const played_blk_t *song_blk) {
+    portENTER_CRITICAL(&s_dac_lock);
+    s_dac.written += samples;
+    if (song_blk) {
+        played_blk_t *b = &s_played[s_played_n++ & (PLAYED_HIST - 1)];
+        *b = *song_blk;
+        b->w_end = s_dac.written;
+    }
+    portEXIT_CRITICAL(&s_dac_lock);
+}
+
+// New driver instance: nothing of ours is in DMA, the rate estimate restarts
+static void dac_restart(void) {
+    portENTER_CRITICAL(&s_dac_lock);
+    s_dac.written = s_dac.frames - s_dac.silence;
+    s_dac.events  = 0;
+    s_played_n    = 0;
+    portEXIT_CRITICAL(&s_dac_lock);
+}
+
+static void played_clear(void) {
+    portENTER_CRITICAL(&s_dac_lock);
+    s_played_n = 0;
+    portEXIT_CRITICAL(&s_dac_lock);
+}
+
+// Song sample at the DAC at local time t_us and the net slip rendered up to
+// its block; false if no block of the current song is playing then
+static bool song_pos_at(int64_t t_us, int64_t *pos, int64_t *cum) {
+    portENTER_CRITICAL(&s_dac_lock);
+    dac_clock_t c = s_dac;
+    uint32_t n = s_played_n;
+    played_blk_t hist[PLAYED_HIST];
+    memcpy(hist, s_played, sizeof(hist));
+    portEXIT_CRITICAL(&s_dac_lock);
+
+    uint64_t w = dac_frames_at(&c, t_us) - c.silence;
+    for (uint32_t i = 0; i < n && i < PLAYED_HIST; ++i) {
+        const played_blk_t *b = &hist[(n - 1 - i) & (PLAYED_HIST - 1)];
+        if (w < b->w_end && w + s_prof.block_samples >= b->w_end) {
+            *pos = (int64_t)b->end_pos - (int64_t)(b->w_end - w);
+            *cum = b->cum;
+            return true;
         }
     }
-    // Fallback to lead
-    *out_notes = song->notes;
-    *out_count = song->note_count;
+    return false;
 }
 
-// Simple transform when we fell back to the lead melody (to create harmonies)
-static uint16_t transform_freq_for_role(uint16_t base_freq, uint8_t role) {
-    if (base_freq == 0) return 0;
-    switch (role) {
-        case ROLE_PART_1: return base_freq;                 // lead
-        case ROLE_PART_2: {                                  // down an octave (if too low, revert)
-            uint16_t f = (uint16_t)(base_freq / 2);
-            return (f < 50) ? base_freq : f;
+// ----------------------
+// I2S feeder (ring consumer)
+// ----------------------
+// Drains rendered blocks into I2S DMA. i2s_write() blocking here is the wall
+// clock; the engine only ever waits for a free ring slot.
+static void i2s_feeder_task(void *pv) {
+    (void)pv;
+    bool starved = false;
+    for (;;) {
+        if (s_park_req) {
+            s_feeder_parked = true;
+            while (s_park_req) vTaskDelay(1);
+            s_feeder_parked = false;
+            continue;
+        }
+        const uint16_t block = s_prof.block_samples;
+        if (s_flush_req) {
+            // Play the next queued block as a short fade-out instead of cutting
+            // mid-waveform, then drop the rest
+            const int16_t *next = pcm_ring_read_slot(&s_ring);
+            bool fade = next != NULL;
+            if (fade) {
+                const size_t fade_len = block < STOP_FADE_SAMPLES ? block : STOP_FADE_SAMPLES;
+                for (size_t i = 0; i < block; ++i) {
+                    int32_t g = (i < fade_len) ? (int32_t)((fade_len - i) * 32767 / fade_len) : 0;
+                    s_fade_buf[i] = (int16_t)((next[i] * g) >> 15);
+                }
+            }
+            pcm_ring_drop_all(&s_ring);
+            s_flush_req = false;
+            xTaskNotifyGive(s_engine_task);
+            if (fade) {
+                dac_wrote(block, NULL);
+                size_t bytes_written = 0;
+                ESP_ERROR_CHECK(i2s_write(I2S_NUM_0, s_fade_buf,
+                                          block * sizeof(int16_t),
+                                          &bytes_written, portMAX_DELAY));
+            }
+            continue;
         }
-        case ROLE_PART_3: return (uint16_t)(base_freq * 2); // up an octave
-        case ROLE_PART_4: return (uint16_t)((base_freq * 3) / 2); // perfect fifth
-        default:          return base_freq;
+
+        const int16_t *blk = pcm_ring_read_slot(&s_ring);
+        if (!blk) {
+            // Count each starvation episode once, not every poll
+            if (s_stream_active && !starved) {
+                s_underruns++;
+                starved = true;
+            }
+            // Sleep until the engine commits (or a tick passes)
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(AUDIO_WAIT_MS));
+            continue;
+        }
+        starved = false;
+
+        if (s_first_pending && s_ring.tail == s_first_seq) {
+            int64_t lat = esp_timer_get_time() - s_play_issued_us;
+            s_lat.play_last_us = lat;
+            if (lat > s_lat.play_max_us) s_lat.play_max_us = lat;
+            s_lat.play_count++;
+            if (s_first_cached) {
+                s_first_hit_sum_us += lat;
+                s_first_hit_n++;
+            } else {
+                s_first_miss_sum_us += lat;
+                s_first_miss_n++;
+            }
+            s_first_pending = false;
+        }
+
+        uint32_t slot = s_ring.tail & (s_ring.n_blocks - 1);
+        played_blk_t pb = { .end_pos = s_blk_end_pos[slot], .cum = s_blk_end_cum[slot] };
+        dac_wrote(block, &pb);
+        size_t bytes_written = 0;
+        ESP_ERROR_CHECK(i2s_write(I2S_NUM_0, blk,
+                                  block * sizeof(int16_t),
+                                  &bytes_written, portMAX_DELAY));
+        pcm_ring_release(&s_ring);
+
+        // A slot just freed up: wake the engine if it is waiting
+        xTaskNotifyGive(s_engine_task);
     }
 }
 
 // ----------------------
-// Playback task (tick-based)
+// Play cursor (part_mix.h)
 // ----------------------
-typedef struct {
-    uint8_t song_id;
-    uint8_t role;
-} play_role_param_t;
+_Static_assert(AUDIO_MAX_VOICES <= PART_MIX_MAX_VOICES, "part_mix has fewer voices");
 
-static void playback_task(void *pv) {
-    play_role_param_t *p = (play_role_param_t *)pv;
-    uint8_t song_id = p->song_id;
-    uint8_t role    = p->role;
-    free(p);
+static part_mix_t s_cur;
+static int32_t    s_mix_acc[AUDIO_BLOCK_MAX + 1];   // +1: a block that skips a sample
 
-    if (song_id >= total_songs) {
+// Render cost bookkeeping (CPU cycles per block)
+static uint32_t s_block_cycles_avg = 0;
+static uint32_t s_block_cycles_max = 0;
+
+// Pulse stronger exactly on note edge (own part drives the display)
+static void beat_on_note(const part_mix_t *c) {
+    const note_t *n = part_mix_note(c);
+    if (n) {
+        display_animations_update_beat(pulse_intensity_for_note(c->voices[0].freq, n->duration_ms));
+    }
+}
+
+// 'role' is this device's own part; 'parts' (PART_1..PART_4 bits) adds
+// further parts to mix in, e.g. those of performers that are offline.
+static bool cursor_start(part_mix_t *c, uint8_t song_id, uint8_t role, uint8_t parts, bool display) {
+    if (!part_mix_start(c, song_id, role, parts, AUDIO_DEFAULT_ENVELOPE, SAMPLE_RATE)) {
         ESP_LOGE(TAG, "Invalid song ID: %u", (unsigned)song_id);
-        playback_task_handle = NULL;
-        vTaskDelete(NULL);
-        return;
+        return false;
     }
+    if (display) beat_on_note(c);
+    return true;
+}
+
+static bool cursor_seek_sample(part_mix_t *c, uint64_t sample) {
+    if (!part_mix_seek(c, sample)) return false;
+    beat_on_note(c);
+    return true;
+}
+
+// ----------------------
+// PCM cache (pre-render on SELECT)
+// ----------------------
+// A low-priority task renders this device's mix of the selected song into
+// memory, so the following PLAY copies blocks instead of synthesizing them.
+// The cache holds the mix at 1/sqrt(N) headroom; volume is applied at
+// play-out. Samples below 'rendered' are final (release/acquire), so the
+// engine may start on a cache that is still filling. The task only
+// overwrites the cache once the engine has let go of it (in_use).
+typedef enum { CACHE_EMPTY = 0, CACHE_FILLING, CACHE_READY } cache_state_t;
 
-    const song_t *song = &songs[song_id];
-    const note_t *mel  = NULL;
-    uint16_t count     = 0;
+typedef struct {
+    uint8_t   state;          // cache_state_t, under s_cache_lock
+    bool      in_use;         // engine is playing out of it, under s_cache_lock
+    uint8_t   song_id, role, parts;
+    bool      psram;
+    int16_t  *pcm;
+    uint32_t  cap;            // samples allocated
+    uint32_t  rendered;       // samples final so far
+} pcm_cache_t;
 
-    select_melody_for_role(song, role, &mel, &count);
-    bool using_lead = (mel == song->notes);
+static pcm_cache_t    s_cache;
+static portMUX_TYPE   s_cache_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t   s_cache_task = NULL;
+static part_mix_t     s_pre_cur;
+static int32_t        s_pre_acc[AUDIO_BLOCK_MAX];
+static bool           s_cache_play = false;     // engine-owned: current song comes from the cache
+static audio_cache_stats_t s_cache_stats;
 
-    ESP_LOGI(TAG, "Starting tick playback: '%s' (notes=%u, role=%u)", song->name, (unsigned)count, (unsigned)role);
+#define CACHE_REQ(song, role, parts)  ((1u << 24) | ((uint32_t)(song) << 16) | ((uint32_t)(role) << 8) | (parts))
+#define CACHE_REQ_DROP                0u      // empty the cache, render nothing
 
-    audio_playing = true;
+static SemaphoreHandle_t s_cache_dropped = NULL;
 
-    // Start equalizer animation
-    display_animations_start_playback(SONG_TYPE_SOLO);
+static uint32_t cache_rendered(void) {
+    return __atomic_load_n(&s_cache.rendered, __ATOMIC_ACQUIRE);
+}
 
-    // One tick buffer (tiny RAM)
-    static int16_t tick_buf[SAMPLES_PER_TICK];
-    float phase = 0.0f;
+// Size the buffer for 'song': PSRAM for the whole song if there is any,
+// else the head in internal RAM. Only called with the cache EMPTY.
+static bool cache_alloc(uint8_t song_id, uint32_t *target) {
+    uint32_t song_samples = (uint32_t)note_timeline_ms_to_sample(song_duration_ms(song_id), SAMPLE_RATE)
+                          + s_prof.block_samples;
+    uint32_t head_samples = (uint32_t)note_timeline_ms_to_sample(AUDIO_CACHE_HEAD_MS, SAMPLE_RATE);
+    bool psram = heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0;
 
-    for (uint16_t i = 0; i < count && audio_playing; ++i) {
-        uint16_t freq = mel[i].frequency;
-        uint16_t dur  = mel[i].duration_ms;
+    for (int attempt = 0; attempt < 2; ++attempt, psram = false) {
+        uint32_t want = psram ? song_samples : (song_samples < head_samples ? song_samples : head_samples);
+        if (!s_cache.pcm || s_cache.psram != psram || s_cache.cap < want) {
+            heap_caps_free(s_cache.pcm);
+            s_cache.cap = 0;
+            s_cache.pcm = heap_caps_malloc((size_t)want * sizeof(int16_t),
+                                           psram ? MALLOC_CAP_SPIRAM : MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+            if (!s_cache.pcm) continue;
+            s_cache.cap   = want;
+            s_cache.psram = psram;
+        }
+        *target = want;
+        return true;
+    }
+    ESP_LOGW(TAG, "PCM cache: no memory for song %u", (unsigned)song_id);
+    return false;
+}
 
-        if (using_lead) {
-            freq = transform_freq_for_role(freq, role);
+// Fill the cache for one request; returns early with a newer request in *next
+static bool cache_fill(uint32_t req, uint32_t *next) {
+    uint8_t song_id = (uint8_t)(req >> 16), role = (uint8_t)(req >> 8), parts = (uint8_t)req;
+
+    // Wait for the engine to finish playing out of the old contents
+    for (;;) {
+        bool same = false, got = false;
+        portENTER_CRITICAL(&s_cache_lock);
+        same = s_cache.state != CACHE_EMPTY && s_cache.song_id == song_id
+            && s_cache.role == role && s_cache.parts == parts;
+        if (!same && !s_cache.in_use) {
+            s_cache.state = CACHE_EMPTY;
+            got = true;
         }
+        portEXIT_CRITICAL(&s_cache_lock);
+        if (same) return false;
+        if (got) break;
+        if (xTaskNotifyWait(0, UINT32_MAX, next, pdMS_TO_TICKS(AUDIO_WAIT_MS)) == pdTRUE) return true;
+    }
 
-        // Pulse stronger exactly on note edge
-        display_animations_update_beat(pulse_intensity_for_note(freq, dur));
+    uint32_t target = 0;
+    if (!cache_alloc(song_id, &target)) return false;
+    if (!cursor_start(&s_pre_cur, song_id, role, parts, false)) return false;
 
-        // Convert ms -> ticks (round to nearest, min 1 for any non-zero)
-        uint32_t ticks = (dur + (AUDIO_TICK_MS / 2)) / AUDIO_TICK_MS;
-        if (freq != 0 && ticks == 0) ticks = 1;
+    s_cache.song_id = song_id;
+    s_cache.role    = role;
+    s_cache.parts   = parts;
+    __atomic_store_n(&s_cache.rendered, 0, __ATOMIC_RELEASE);
+    portENTER_CRITICAL(&s_cache_lock);
+    s_cache.state = CACHE_FILLING;
+    portEXIT_CRITICAL(&s_cache_lock);
 
-        // Render this note in fixed-sized ticks
-        for (uint32_t t = 0; t < ticks && audio_playing; ++t) {
-            render_tick(tick_buf, freq, &phase);
+    int64_t t0 = esp_timer_get_time();
+    uint32_t done = 0, blocks = 0;
+    while (done < target) {
+        if (part_mix_done(&s_pre_cur)) break;
+        uint32_t n = target - done;
+        if (n > AUDIO_BLOCK_MAX) n = AUDIO_BLOCK_MAX;
+        memset(s_pre_acc, 0, n * sizeof(int32_t));
+        part_mix_block(&s_pre_cur, s_pre_acc, n);
+        synth_mix_out(&s_cache.pcm[done], s_pre_acc, n, s_pre_cur.headroom_q15);
+        done += n;
+        __atomic_store_n(&s_cache.rendered, done, __ATOMIC_RELEASE);
 
-            size_t bytes_written = 0;
-            // I2S pacing is the wall clock (blocking until DMA has room)
-            ESP_ERROR_CHECK(i2s_write(I2S_NUM_0, tick_buf,
-                                      SAMPLES_PER_TICK * sizeof(int16_t),
-                                      &bytes_written, portMAX_DELAY));
+        // A newer SELECT wins; the engine may already be reading what is done
+        if (xTaskNotifyWait(0, UINT32_MAX, next, 0) == pdTRUE) return true;
+        // Let the idle task run now and then (task watchdog)
+        if ((++blocks & 31) == 0) vTaskDelay(1);
+    }
+    portENTER_CRITICAL(&s_cache_lock);
+    s_cache.state = CACHE_READY;
+    portEXIT_CRITICAL(&s_cache_lock);
 
-            // very small decay so bars don't stick at peak between ticks of the same note
-            // (keeps pulse feel without needing extra RAM)
-            if (freq != 0) {
-                display_animations_update_beat(0.25f);
-            } else {
-                display_animations_update_beat(0.0f);
-            }
+    s_cache_stats.song_id   = song_id;
+    s_cache_stats.cached_ms = (uint32_t)((uint64_t)done * 1000 / SAMPLE_RATE);
+    s_cache_stats.bytes     = s_cache.cap * sizeof(int16_t);
+    s_cache_stats.psram     = s_cache.psram;
+    s_cache_stats.render_us = (uint32_t)(esp_timer_get_time() - t0);
+    ESP_LOGI(TAG, "PCM cache: '%s' role %u parts 0x%02X, %u ms pre-rendered in %u ms (%u KB %s)",
+             song_get(song_id)->name, (unsigned)role, (unsigned)parts, (unsigned)s_cache_stats.cached_ms,
+             (unsigned)(s_cache_stats.render_us / 1000), (unsigned)(s_cache_stats.bytes / 1024),
+             s_cache.psram ? "PSRAM" : "internal");
+    return false;
+}
+
+// Forget the contents so the next PLAY misses (benchmark, library change)
+static void cache_invalidate(void) {
+    portENTER_CRITICAL(&s_cache_lock);
+    if (!s_cache.in_use) s_cache.state = CACHE_EMPTY;
+    portEXIT_CRITICAL(&s_cache_lock);
+}
+
+static void cache_task(void *pv) {
+    (void)pv;
+    uint32_t req = 0;
+    bool have = false;
+    for (;;) {
+        if (!have && xTaskNotifyWait(0, UINT32_MAX, &req, portMAX_DELAY) != pdTRUE) continue;
+        if (req == CACHE_REQ_DROP) {
+            cache_invalidate();
+            xSemaphoreGive(s_cache_dropped);
+            have = false;
+            continue;
         }
+        have = cache_fill(req, &req);
+    }
+}
+
+// Engine: play the song from the cache if it holds this song/role/parts
+// and at least a block from 'from'
+static bool cache_acquire(uint8_t song_id, uint8_t role, uint8_t parts, uint64_t from) {
+    bool hit = false;
+    portENTER_CRITICAL(&s_cache_lock);
+    if (s_cache.state != CACHE_EMPTY && s_cache.song_id == song_id && s_cache.role == role
+        && s_cache.parts == parts && from + s_prof.block_samples + 1 <= cache_rendered()) {
+        s_cache.in_use = true;
+        hit = true;
+    }
+    portEXIT_CRITICAL(&s_cache_lock);
+    if (hit) s_cache_stats.hits++;
+    else     s_cache_stats.misses++;
+    return hit;
+}
+
+static void cache_release(void) {
+    if (!s_cache_play) return;
+    s_cache_play = false;
+    portENTER_CRITICAL(&s_cache_lock);
+    s_cache.in_use = false;
+    portEXIT_CRITICAL(&s_cache_lock);
+}
+
+static bool cache_ready(void) {
+    portENTER_CRITICAL(&s_cache_lock);
+    bool ready = s_cache.state == CACHE_READY;
+    portEXIT_CRITICAL(&s_cache_lock);
+    return ready;
+}
+
+static bool cursor_render_tick(part_mix_t *c, int16_t *buf) {
+    const size_t block = s_prof.block_samples;
+    if (s_cache_play && s_song_pos + block + 1 > cache_rendered()) {
+        // Past what was pre-rendered: synthesis takes over from here
+        cache_release();
+        s_cache_stats.handovers++;
+        if (!cursor_seek_sample(c, s_song_pos)) return false;
+    }
+    if (!s_cache_play && part_mix_done(c)) return false;
+
+    uint32_t t0 = esp_cpu_get_cycle_count();
+
+    // A slip makes this block consume one song sample more or less
+    int d = slip_next(&s_slip);
+    size_t len = (size_t)((int)block + d);
+
+    bool edge = false;
+    int32_t gain;
+    if (s_cache_play) {
+        const int16_t *src = &s_cache.pcm[s_song_pos];
+        for (size_t i = 0; i < len; ++i) s_mix_acc[i] = src[i];
+        edge = part_mix_skip(c, len);
+        gain = volume_q15;                  // headroom is already in the cache
+    } else {
+        memset(s_mix_acc, 0, sizeof(s_mix_acc));
+        edge = part_mix_block(c, s_mix_acc, len);
+        gain = ((int32_t)volume_q15 * c->headroom_q15) >> 15;
+    }
+    slip_apply_block(s_mix_acc, block, d);
+    s_song_pos += len;
+    synth_mix_out(buf, s_mix_acc, block, gain);
+
+    uint32_t cyc = esp_cpu_get_cycle_count() - t0;
+    s_block_cycles_avg = s_block_cycles_avg
+        ? s_block_cycles_avg + (uint32_t)(((int32_t)cyc - (int32_t)s_block_cycles_avg) / 16)
+        : cyc;
+    if (cyc > s_block_cycles_max) s_block_cycles_max = cyc;
+
+    // very small decay so bars don't stick at peak between ticks of the same note
+    // (keeps pulse feel without needing extra RAM)
+    if (edge) {
+        beat_on_note(c);
+    } else {
+        display_animations_update_beat(c->voices[0].freq != 0 ? 0.25f : 0.0f);
+    }
+    return true;
+}
+
+// ----------------------
+// Audio engine task (ring producer)
+// ----------------------
+// One long-lived task owns the play cursor. Commands are applied between
+// blocks, so STOP/PLAY take effect within one audio block.
 
-        // Optional tiny gap shaping (prevents harsh transitions), keep zero to disable
-        // phase is kept continuous; we don't reset it at note boundaries to avoid clicks
+// Drop every queued block and wait for the feeder to confirm
+static void engine_flush(void) {
+    s_stream_active = false;
+    s_flush_req = true;
+    xTaskNotifyGive(s_feeder_task);
+    while (s_flush_req) {
+        ulTaskNotifyTake(pdTRUE, 1);
     }
+}
 
-    // Song finished or stopped
+static void engine_finish(const char *why) {
+    cache_release();
     audio_playing = false;
+    s_stream_active = false;
     display_animations_stop();
     display_animations_start_idle();
+    if (s_cur.song) {
+        audio_render_stats_t rs;
+        audio_get_render_stats(&rs);
+        ESP_LOGI(TAG, "Playback %s: '%s' (role=%u, voices=%u, underruns=%u)", why,
+                 s_cur.song->name, (unsigned)s_cur.voices[0].role,
+                 (unsigned)s_cur.n_voices, (unsigned)s_underruns);
+        // The envelope is what moves the cost per voice: ramps take a
+        // multiply per sample, flat and sustained notes do not
+        static const char *const k_env_names[SYNTH_ENV_COUNT] = {
+            "default", "none", "soft", "pluck", "pad",
+        };
+        uint8_t env = s_cur.voices[0].preset;
+        ESP_LOGI(TAG, "Render cost (env %s): %u cycles/block avg, %u max, %u per voice (~%u voices/core)",
+                 env < SYNTH_ENV_COUNT ? k_env_names[env] : "?",
+                 (unsigned)rs.block_cycles_avg, (unsigned)rs.block_cycles_max,
+                 (unsigned)rs.cycles_per_voice, (unsigned)rs.max_voices_est);
+        if (s_slip.n_meas) {
+            audio_play_clock_t pc;
+            audio_get_play_clock(&pc);
+            ESP_LOGI(TAG, "Timeline: max |err| %d us over %u checks (last %+d us), slips +%u/-%u, jumps %u, DAC %+d ppm",
+                     (int)((int64_t)s_slip.max_err * 1000000 / SAMPLE_RATE), (unsigned)s_slip.n_meas,
+                     (int)((int64_t)s_slip.last_err * 1000000 / SAMPLE_RATE),
+                     (unsigned)s_slip.skipped, (unsigned)s_slip.repeated, (unsigned)s_slip.jumps,
+                     (int)pc.rate_ppm);
+        }
+    }
+}
+
+// Compare the song sample at the DAC at local time at_us with where it
+// should be (song_us), and steer with slips (or one jump). False if nothing
+// of the song is audible at at_us yet.
+static bool engine_check_timeline(int64_t song_us, int64_t at_us) {
+    int64_t played, cum;
+    if (song_us < 0 || !song_pos_at(at_us, &played, &cum)) return false;
+
+    int64_t expected = song_us * SAMPLE_RATE / 1000000;
+    int64_t err = played - expected;
+    if (err > INT32_MAX / 2) err = INT32_MAX / 2;
+    if (err < -INT32_MAX / 2) err = -INT32_MAX / 2;
 
-    ESP_LOGI(TAG, "Playback finished: '%s' (role=%u)", song->name, (unsigned)role);
-    playback_task_handle = NULL;
-    vTaskDelete(NULL);
+    int32_t jump = slip_measure(&s_slip, (int32_t)err, (int32_t)(s_slip.cum - cum));
+    ESP_LOGD(TAG, "Timeline err %+d samples, pending %d", (int)err, (int)s_slip.pending);
+    if (jump) {
+        int64_t to = (int64_t)s_song_pos + jump;
+        s_song_pos = to > 0 ? (uint64_t)to : 0;
+        ESP_LOGW(TAG, "Timeline off by %+lld us, jumping %+d samples",
+                 (long long)(err * 1000000 / SAMPLE_RATE), (int)jump);
+        if (!cursor_seek_sample(&s_cur, s_song_pos)) {
+            engine_finish("finished");
+        }
+    }
+    return true;
+}
+
+// A PLAY with an epoch is positioned for when its first block should reach
+// the DAC; once it does, check that against the epoch on the local clock so
+// the start is right before the first heartbeat comes in
+static void engine_align_start(void) {
+    int64_t now = esp_timer_get_time();
+    if (engine_check_timeline(now - s_align_epoch_us, now)) {
+        ESP_LOGI(TAG, "Start at DAC: %+d us from epoch",
+                 (int)((int64_t)s_slip.last_err * 1000000 / SAMPLE_RATE));
+        s_align_epoch_us = 0;
+    }
+}
+
+// Stop, park the feeder and DAC clock, reinstall I2S with the new DMA
+// depth and rebuild the ring
+static void engine_set_profile(audio_profile_id_t id) {
+    if (id == s_prof_id) return;
+    if (audio_playing) {
+        engine_flush();
+        engine_finish("profile change");
+    }
+    played_clear();
+    s_align_epoch_us = 0;
+
+    s_park_req = true;
+    xTaskNotifyGive(s_feeder_task);
+    while (!s_feeder_parked || !s_clock_parked) {
+        ulTaskNotifyTake(pdTRUE, 1);
+    }
+    ESP_ERROR_CHECK(i2s_driver_uninstall(I2S_NUM_0));
+    s_prof_id = id;
+    s_prof    = k_profiles[id];
+    audio_init_i2s();
+    pcm_ring_init(&s_ring, s_ring_storage, s_prof.ring_blocks, s_prof.block_samples);
+    dac_restart();
+    s_park_req = false;
+}
+
+static void engine_handle_cmd(const audio_cmd_t *cmd) {
+    switch (cmd->type) {
+    case AUDIO_CMD_PLAY:
+        if (audio_playing) engine_flush();
+        cache_release();
+        played_clear();
+        slip_init(&s_slip);
+        s_song_pos = 0;
+        s_align_epoch_us = 0;
+        if (!cursor_start(&s_cur, cmd->song_id, cmd->role, cmd->parts, true)) {
+            engine_finish("rejected");
+            break;
+        }
+        if (cmd->epoch_us) {
+            // Position is taken here, right before the first block is
+            // rendered, so queueing and orchestra overhead don't count; the
+            // block reaches the DAC after whatever DMA still holds
+            dac_clock_t c;
+            dac_snapshot(&c);
+            int64_t now = esp_timer_get_time();
+            int64_t queued = (int64_t)c.written - (int64_t)(dac_frames_at(&c, now) - c.silence);
+            if (queued < 0) queued = 0;
+            int64_t late_us = now - cmd->epoch_us + (queued + s_prof.dma_buf_len) * 1000000 / SAMPLE_RATE;
+            s_align_epoch_us = cmd->epoch_us;
+            if (late_us > 0) {
+                uint64_t sample = (uint64_t)late_us * SAMPLE_RATE / 1000000u;
+                s_song_pos = sample;
+                if (!cursor_seek_sample(&s_cur, sample)) {
+                    engine_finish("already over");
+                    break;
+                }
+                if (late_us > 20000) {      // more than the start lead
+                    ESP_LOGI(TAG, "Joining '%s' at %lld ms (note %u)", s_cur.song->name,
+                             (long long)(late_us / 1000), (unsigned)s_cur.voices[0].seq.index);
+                }
+            }
+        }
+        s_block_cycles_avg = 0;
+        s_block_cycles_max = 0;
+        s_cache_play = cache_acquire(cmd->song_id, cmd->role, cmd->parts, s_song_pos);
+        s_first_cached = s_cache_play;
+        ESP_LOGI(TAG, "Starting playback: '%s' (notes=%u, role=%u, voices=%u, PCM cache %s)",
+                 s_cur.song->name, (unsigned)s_cur.voices[0].seq.count,
+                 (unsigned)cmd->role, (unsigned)s_cur.n_voices, s_cache_play ? "hit" : "miss");
+        // Start equalizer animation
+        display_animations_start_playback(SONG_TYPE_SOLO);
+        s_play_issued_us = cmd->issued_us;
+        s_first_seq = s_ring.head;
+        s_first_pending = true;
+        audio_playing = true;
+        break;
+
+    case AUDIO_CMD_STOP: {
+        bool was_playing = audio_playing;
+        audio_playing = false;
+        s_first_pending = false;
+        engine_flush();
+        cache_release();
+        played_clear();
+        s_align_epoch_us = 0;
+        // Ring is empty now; only the DMA tail (<= dma_tail_us()) is still audible
+        int64_t lat = esp_timer_get_time() - cmd->issued_us;
+        s_lat.stop_last_us = lat;
+        if (lat > s_lat.stop_max_us) s_lat.stop_max_us = lat;
+        s_lat.stop_count++;
+        if (was_playing) engine_finish("stopped");
+        xSemaphoreGive(s_stop_ack);
+        break;
+    }
+
+    case AUDIO_CMD_SEEK:
+        if (!audio_playing) break;
+        engine_flush();
+        played_clear();
+        s_align_epoch_us = 0;
+        s_song_pos = note_timeline_ms_to_sample(cmd->arg, SAMPLE_RATE);
+        if (!cursor_seek_sample(&s_cur, s_song_pos)) {
+            engine_finish("finished");
+        }
+        break;
+
+    case AUDIO_CMD_SET_VOLUME:
+        volume_q15 = (int16_t)cmd->arg;
+        break;
+
+    case AUDIO_CMD_SYNC:
+        if (audio_playing) engine_check_timeline(cmd->song_us, cmd->epoch_us);
+        break;
+
+    case AUDIO_CMD_SET_PROFILE:
+        engine_set_profile((audio_profile_id_t)cmd->arg);
+        xSemaphoreGive(s_profile_ack);
+        break;
+    }
+}
+
+static void audio_engine_task(void *pv) {
+    (void)pv;
+    audio_cmd_t cmd;
+    for (;;) {
+        // Idle: sleep on the queue. Playing: only poll it between blocks.
+        TickType_t wait = audio_playing ? 0 : portMAX_DELAY;
+        while (xQueueReceive(s_cmd_queue, &cmd, wait) == pdTRUE) {
+            engine_handle_cmd(&cmd);
+            wait = 0;
+        }
+        if (audio_playing && s_align_epoch_us) engine_align_start();
+        if (!audio_playing) continue;
+
+        int16_t *slot = pcm_ring_write_slot(&s_ring);
+        if (!slot) {
+            // Ring full: sleep until the feeder frees a slot or a command arrives
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(AUDIO_WAIT_MS));
+            continue;
+        }
+        if (!cursor_render_tick(&s_cur, slot)) {
+            // Song finished; the feeder plays out whatever is still queued
+            engine_finish("finished");
+            continue;
+        }
+        uint32_t idx = s_ring.head & (s_ring.n_blocks - 1);
+        s_blk_end_pos[idx] = s_song_pos;
+        s_blk_end_cum[idx] = s_slip.cum;
+        pcm_ring_commit(&s_ring);
+        s_stream_active = true;
+        xTaskNotifyGive(s_feeder_task);
+    }
+}
+
+static void post_cmd(audio_cmd_t *cmd) {
+    cmd->issued_us = esp_timer_get_time();
+    if (xQueueSend(s_cmd_queue, cmd, pdMS_TO_TICKS(AUDIO_WAIT_MS)) != pdTRUE) {
+        ESP_LOGW(TAG, "Audio command queue full, dropping cmd %d", (int)cmd->type);
+        return;
+    }
+    // Wake the engine if it is parked waiting for a ring slot
+    xTaskNotifyGive(s_engine_task);
 }
 
 // ----------------------
 // Public API
 // ----------------------
 void audio_init(void) {
+    synth_init();
+    songs_index_init();
+    s_prof = k_profiles[s_prof_id];
     audio_init_i2s();
+
+    pcm_ring_init(&s_ring, s_ring_storage, s_prof.ring_blocks, s_prof.block_samples);
+    s_cmd_queue   = xQueueCreate(AUDIO_CMD_QUEUE_LEN, sizeof(audio_cmd_t));
+    s_stop_ack    = xSemaphoreCreateBinary();
+    s_profile_ack = xSemaphoreCreateBinary();
+    s_cache_dropped = xSemaphoreCreateBinary();
+    if (!s_cmd_queue || !s_stop_ack || !s_profile_ack || !s_cache_dropped) {
+        ESP_LOGE(TAG, "Failed to create audio engine queue");
+        return;
+    }
+
+    // Higher prio than UI; modest stack is enough (ring storage is static).
+    // The feeder sits above the engine so a ready block never waits behind synthesis.
+    xTaskCreate(audio_engine_task, "audio_engine", 4096, NULL, 10, &s_engine_task);
+    xTaskCreate(i2s_feeder_task, "i2s_feeder", 2048, NULL, 12, &s_feeder_task);
+    xTaskCreate(dac_clock_task, "dac_clock", 2048, NULL, 13, NULL);
+    // Pre-rendering is background work: below the UI
+    xTaskCreate(cache_task, "pcm_cache", 3072, NULL, 2, &s_cache_task);
     ESP_LOGI(TAG, "Audio system initialized");
 }
 
 void audio_stop(void) {
-    audio_playing = false;
-    if (playback_task_handle != NULL) {
-        vTaskDelay(pdMS_TO_TICKS(100));
-        if (playback_task_handle != NULL) {
-            vTaskDelete(playback_task_handle);
-            playback_task_handle = NULL;
-        }
+    // Clear any stale ack from a previous timed-out stop
+    xSemaphoreTake(s_stop_ack, 0);
+    audio_cmd_t cmd = { .type = AUDIO_CMD_STOP };
+    post_cmd(&cmd);
+    if (xSemaphoreTake(s_stop_ack, pdMS_TO_TICKS(4 * AUDIO_WAIT_MS)) != pdTRUE) {
+        ESP_LOGW(TAG, "Audio engine did not acknowledge STOP");
     }
     display_animations_stop();
     display_animations_start_idle();
@@ -239,33 +964,242 @@ void audio_stop(void) {
 }
 
 void audio_play_song(uint8_t song_id) {
-    audio_stop();
+    audio_play_song_for_role(song_id, (uint8_t)device_config_get_role());
+}
 
-    play_role_param_t *p = (play_role_param_t *)malloc(sizeof(*p));
-    if (!p) { ESP_LOGE(TAG, "alloc play param failed"); return; }
-    p->song_id = song_id;
-    p->role    = (uint8_t)device_config_get_role();
+void audio_play_song_for_role(uint8_t song_id, uint8_t role) {
+    audio_play_song_parts(song_id, role, 0);
+}
 
-    // Higher prio than UI; modest stack is enough (tick buffer is static)
-    xTaskCreate(playback_task, "playback_tick", 4096, p, 10, &playback_task_handle);
+void audio_play_song_parts(uint8_t song_id, uint8_t role, uint8_t extra_parts) {
+    audio_play_song_parts_at(song_id, role, extra_parts, 0);
 }
 
-void audio_play_song_for_role(uint8_t song_id, uint8_t role) {
-    audio_stop();
+void audio_play_song_parts_at(uint8_t song_id, uint8_t role, uint8_t extra_parts, int64_t epoch_us) {
+    // PLAY replaces whatever is playing; no task churn, no allocation
+    audio_cmd_t cmd = { .type = AUDIO_CMD_PLAY, .song_id = song_id,
+                        .role = role, .parts = extra_parts, .epoch_us = epoch_us };
+    post_cmd(&cmd);
+}
 
-    play_role_param_t *p = (play_role_param_t *)malloc(sizeof(*p));
-    if (!p) { ESP_LOGE(TAG, "alloc play param failed"); return; }
-    p->song_id = song_id;
-    p->role    = role;
+void audio_seek_ms(uint32_t ms) {
+    audio_cmd_t cmd = { .type = AUDIO_CMD_SEEK, .arg = ms };
+    post_cmd(&cmd);
+}
+
+void audio_prerender(uint8_t song_id, uint8_t role, uint8_t extra_parts) {
+    if (!s_cache_task || !song_get(song_id)) return;
+    xTaskNotify(s_cache_task, CACHE_REQ(song_id, role, extra_parts), eSetValueWithOverwrite);
+}
 
-    xTaskCreate(playback_task, "playback_tick", 4096, p, 10, &playback_task_handle);
+void audio_cache_drop(void) {
+    if (!s_cache_task) return;
+    xSemaphoreTake(s_cache_dropped, 0);
+    xTaskNotify(s_cache_task, CACHE_REQ_DROP, eSetValueWithOverwrite);
+    if (xSemaphoreTake(s_cache_dropped, pdMS_TO_TICKS(4 * AUDIO_WAIT_MS)) != pdTRUE) {
+        ESP_LOGW(TAG, "PCM cache did not acknowledge DROP");
+    }
+}
+
+void audio_get_cache_stats(audio_cache_stats_t *out) {
+    *out = s_cache_stats;
+    out->first_block_hit_us  = s_first_hit_n  ? s_first_hit_sum_us  / s_first_hit_n  : 0;
+    out->first_block_miss_us = s_first_miss_n ? s_first_miss_sum_us / s_first_miss_n : 0;
+}
+
+void audio_sync_timeline(int64_t song_us, int64_t at_us) {
+    audio_cmd_t cmd = { .type = AUDIO_CMD_SYNC, .epoch_us = at_us, .song_us = song_us };
+    post_cmd(&cmd);
+}
+
+void audio_get_timeline_stats(audio_timeline_stats_t *out) {
+    out->checks      = s_slip.n_meas;
+    out->last_err_us = (int32_t)((int64_t)s_slip.last_err * 1000000 / SAMPLE_RATE);
+    out->max_err_us  = (int32_t)((int64_t)s_slip.max_err * 1000000 / SAMPLE_RATE);
+    out->skipped     = s_slip.skipped;
+    out->repeated    = s_slip.repeated;
+    out->jumps       = s_slip.jumps;
 }
 
 void audio_set_volume(float vol) {
     if (vol < 0.0f) vol = 0.0f;
     if (vol > 1.0f) vol = 1.0f;
     volume = vol;
+    audio_cmd_t cmd = { .type = AUDIO_CMD_SET_VOLUME, .arg = (uint32_t)synth_gain_q15(vol) };
+    post_cmd(&cmd);
     ESP_LOGI(TAG, "Volume set to %.2f", volume);
 }
 
 bool audio_is_playing(void) { return audio_playing; }
+
+void audio_get_play_clock(audio_play_clock_t *out) {
+    dac_clock_t c;
+    dac_snapshot(&c);
+    out->frames   = c.frames;
+    out->t_us     = c.t_ns / 1000;
+    out->written  = c.written;
+    out->silence  = c.silence;
+    out->rate_ppm = 0;
+    int64_t span_ns = c.t_ns - c.ref_ns;
+    if (span_ns > 2000000000LL) {
+        int64_t nominal_ns = (int64_t)(c.frames - c.ref_frames) * 1000000000 / SAMPLE_RATE;
+        out->rate_ppm = (int32_t)((nominal_ns - span_ns) * 1000000 / span_ns);
+    }
+}
+
+uint64_t audio_frames_played_at(int64_t t_us) {
+    dac_clock_t c;
+    dac_snapshot(&c);
+    return dac_frames_at(&c, t_us);
+}
+
+uint32_t audio_get_buffer_fill(void) { return pcm_ring_fill(&s_ring); }
+
+uint32_t audio_get_buffer_capacity(void) { return s_ring.n_blocks; }
+
+uint32_t audio_get_underrun_count(void) { return s_underruns; }
+
+void audio_get_render_stats(audio_render_stats_t *out) {
+    const uint32_t budget = (uint32_t)((uint64_t)CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1000000u
+                                       * s_prof.block_samples / SAMPLE_RATE);
+    out->voices = s_cur.n_voices;
+    out->block_cycles_avg = s_block_cycles_avg;
+    out->block_cycles_max = s_block_cycles_max;
+    out->cycles_per_voice = s_cur.n_voices ? s_block_cycles_avg / s_cur.n_voices : 0;
+    out->block_budget_cycles = budget;
+    out->max_voices_est = out->cycles_per_voice ? budget / out->cycles_per_voice : 0;
+}
+
+void audio_get_latency_stats(audio_latency_stats_t *out) {
+    *out = s_lat;
+    out->dma_tail_us = dma_tail_us();
+}
+
+// ----------------------
+// Latency profiles
+// ----------------------
+const audio_profile_t *audio_get_profile(audio_profile_id_t id) {
+    return (unsigned)id < AUDIO_PROFILE_COUNT ? &k_profiles[id] : NULL;
+}
+
+audio_profile_id_t audio_get_profile_id(void) { return s_prof_id; }
+
+uint32_t audio_profile_latency_us(const audio_profile_t *p) {
+    uint32_t samples = (uint32_t)p->ring_blocks * p->block_samples
+                     + (uint32_t)p->dma_buf_count * p->dma_buf_len;
+    return (uint32_t)((uint64_t)samples * 1000000u / SAMPLE_RATE);
+}
+
+esp_err_t audio_set_profile(audio_profile_id_t id) {
+    if ((unsigned)id >= AUDIO_PROFILE_COUNT) return ESP_ERR_INVALID_ARG;
+    if (!s_cmd_queue) {
+        s_prof_id = id;                      // before audio_init(): used at bring-up
+        return ESP_OK;
+    }
+    xSemaphoreTake(s_profile_ack, 0);
+    audio_cmd_t cmd = { .type = AUDIO_CMD_SET_PROFILE, .arg = (uint32_t)id };
+    post_cmd(&cmd);
+    if (xSemaphoreTake(s_profile_ack, pdMS_TO_TICKS(500)) != pdTRUE) {
+        ESP_LOGW(TAG, "Audio engine did not apply profile '%s'", k_profiles[id].name);
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+// Output latency right now: rendered blocks queued plus what DMA still holds
+static uint32_t measured_latency_us(void) {
+    dac_clock_t c;
+    dac_snapshot(&c);
+    int64_t dma = (int64_t)c.written - (int64_t)(dac_frames_at(&c, esp_timer_get_time()) - c.silence);
+    if (dma < 0) dma = 0;
+    int64_t samples = (int64_t)pcm_ring_fill(&s_ring) * s_prof.block_samples + dma;
+    return (uint32_t)(samples * 1000000 / SAMPLE_RATE);
+}
+
+// Smallest profile first: play every part of song_id for tone_ms and step up
+// until a pass has no underrun. Blocks the caller.
+audio_profile_id_t audio_autotune_profile(uint8_t song_id, uint32_t tone_ms) {
+    audio_profile_id_t pick = AUDIO_PROFILE_ROBUST;
+    uint32_t latency_us = 0;
+    bool clean = false;
+
+    for (int id = 0; id < AUDIO_PROFILE_COUNT; ++id) {
+        if (audio_set_profile((audio_profile_id_t)id) != ESP_OK) continue;
+        uint32_t under0 = s_underruns;
+        audio_play_song_parts(song_id, ROLE_PART_1, PART_1 | PART_2 | PART_3 | PART_4);
+        vTaskDelay(pdMS_TO_TICKS(tone_ms));
+        latency_us = measured_latency_us();
+        uint32_t under = s_underruns - under0;
+        audio_stop();
+        ESP_LOGI(TAG, "Auto-tune: '%s' %u underruns in %u ms",
+                 k_profiles[id].name, (unsigned)under, (unsigned)tone_ms);
+        pick = (audio_profile_id_t)id;
+        if (under == 0) {
+            clean = true;
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    if (!clean) ESP_LOGW(TAG, "Auto-tune: no profile ran clean, staying on '%s'", k_profiles[pick].name);
+    ESP_LOGI(TAG, "Auto-tune: using '%s', output latency %u us (%u us measured at the end of the tone)",
+             k_profiles[pick].name, (unsigned)audio_profile_latency_us(&k_profiles[pick]),
+             (unsigned)latency_us);
+    return pick;
+}
+
+// Alternate PLAY/STOP on one song and log command-to-first-sample and
+// command-to-silence latency. Every other round pre-renders the song first,
+// so PLAY is measured with and without the PCM cache. Blocks the caller for
+// roughly rounds * 300 ms (plus pre-render time).
+void audio_run_latency_benchmark(uint8_t song_id, uint8_t role, int rounds) {
+    int64_t play_sum = 0, stop_sum = 0;
+    int64_t play_max = 0, stop_max = 0;
+    int64_t hit_sum = 0, miss_sum = 0;
+    int n = 0, hits = 0;
+
+    for (int i = 0; i < rounds; ++i) {
+        if (i & 1) {
+            audio_prerender(song_id, role, 0);
+            for (int w = 0; w < 200 && !cache_ready(); ++w) {
+                vTaskDelay(pdMS_TO_TICKS(AUDIO_WAIT_MS));
+            }
+        } else {
+            cache_invalidate();
+        }
+        uint32_t plays = s_lat.play_count;
+        audio_play_song_for_role(song_id, role);
+        for (int w = 0; w < 20 && s_lat.play_count == plays; ++w) {
+            vTaskDelay(pdMS_TO_TICKS(AUDIO_WAIT_MS));
+        }
+        vTaskDelay(pdMS_TO_TICKS(200));       // let the ring fill up
+        audio_stop();
+        if (s_lat.play_count == plays) continue;
+
+        play_sum += s_lat.play_last_us;
+        stop_sum += s_lat.stop_last_us;
+        if (s_lat.play_last_us > play_max) play_max = s_lat.play_last_us;
+        if (s_lat.stop_last_us > stop_max) stop_max = s_lat.stop_last_us;
+        if (s_first_cached) {
+            hit_sum += s_lat.play_last_us;
+            hits++;
+        } else {
+            miss_sum += s_lat.play_last_us;
+        }
+        n++;
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+
+    if (n == 0) {
+        ESP_LOGW(TAG, "Latency benchmark: no successful rounds");
+        return;
+    }
+    ESP_LOGI(TAG, "Latency benchmark (%d rounds, profile '%s', %u-sample blocks, ring=%u):",
+             n, s_prof.name, (unsigned)s_prof.block_samples, (unsigned)s_prof.ring_blocks);
+    ESP_LOGI(TAG, "  PLAY -> first sample to DMA: avg %lld us, max %lld us",
+             (long long)(play_sum / n), (long long)play_max);
+    ESP_LOGI(TAG, "    with PCM cache: avg %lld us (%d), without: avg %lld us (%d)",
+             (long long)(hits ? hit_sum / hits : 0), hits,
+             (long long)(n - hits ? miss_sum / (n - hits) : 0), n - hits);
+    ESP_LOGI(TAG, "  STOP -> ring silent:         avg %lld us, max %lld us (+ <= %lld us DMA tail)",
+             (long long)(stop_sum / n), (long long)stop_max, (long long)dma_tail_us());
+}
@@ -0,0 +1,573 @@
+// src/blob_xfer.c — chunked blob transfer with selective NACK and a whole-blob hash
+#include <string.h>
+
+#include "blob_xfer.h"
+
+uint64_t blob_fnv1a64(uint64_t h, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; ++i) {
+        h ^= data[i];
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+static bool bit_get(const uint8_t *map, uint32_t i) { return (map[i >> 3] >> (i & 7)) & 1u; }
+static void bit_set(uint8_t *map, uint32_t i)       { map[i >> 3] |= (uint8_t)(1u << (i & 7)); }
+
+static uint32_t chunk_len(uint32_t len, uint16_t chunk, uint16_t idx)
+{
+    uint32_t off = (uint32_t)idx * chunk;
+    return len - off < chunk ? len - off : chunk;
+}
+
+// ----------------------
+// Sender
+// ----------------------
+
+typedef enum {
+    STEP_SENT,      // a frame went out: uses a pacing slot
+    STEP_AGAIN,     // phase changed, nothing sent yet
+    STEP_WAIT,      // waiting for answers
+    STEP_REFUSED,   // the radio did not take the frame
+} step_t;
+
+void blob_tx_init(blob_tx_t *tx, blob_send_fn send, void *ctx)
+{
+    memset(tx, 0, sizeof(*tx));
+    tx->send       = send;
+    tx->ctx        = ctx;
+    tx->gap_us     = BLOB_FRAME_GAP_US;
+    tx->max_silent = BLOB_MAX_SILENT;
+}
+
+static int peer_index(const blob_tx_t *tx, const uint8_t mac[6])
+{
+    for (int i = 0; i < tx->n_peers; ++i) {
+        if (memcmp(tx->peers[i].mac, mac, 6) == 0) return i;
+    }
+    return -1;
+}
+
+static bool xmit(blob_tx_t *tx, const uint8_t *mac, blob_msg_type_t type, const wire_writer_t *w)
+{
+    if (!w->ok || !tx->send(tx->ctx, mac, (uint8_t)(WIRE_T_BLOB + type), w->buf, w->pos)) return false;
+    tx->frames++;
+    return true;
+}
+
+static bool send_offer(blob_tx_t *tx)
+{
+    uint8_t buf[WIRE_MAX_PAYLOAD];
+    wire_writer_t w;
+    wire_writer_init(&w, buf, sizeof(buf));
+    wire_put_u16(&w, tx->id);
+    wire_put_u8(&w, tx->kind);
+    wire_put_u32(&w, tx->len);
+    wire_put_u16(&w, tx->chunk);
+    wire_put_u16(&w, tx->n_chunks);
+    wire_put_u64(&w, tx->hash);
+    return xmit(tx, NULL, BLOB_MSG_OFFER, &w);
+}
+
+static bool send_poll(blob_tx_t *tx)
+{
+    uint8_t buf[2];
+    wire_writer_t w;
+    wire_writer_init(&w, buf, sizeof(buf));
+    wire_put_u16(&w, tx->id);
+    return xmit(tx, NULL, BLOB_MSG_POLL, &w);
+}
+
+static bool send_chunk(blob_tx_t *tx, const uint8_t *mac, uint16_t idx)
+{
+    const uint8_t *p = tx->data + (uint32_t)idx * tx->chunk;
+    uint32_t n = chunk_len(tx->len, tx->chunk, idx);
+    uint8_t buf[WIRE_MAX_PAYLOAD];
+    wire_writer_t w;
+    wire_writer_init(&w, buf, sizeof(buf));
+    wire_put_u16(&w, tx->id);
+    wire_put_u16(&w, idx);
+    wire_put_u16(&w, wire_crc16(p, n));
+    wire_put_bytes(&w, p, n);
+    return xmit(tx, mac, BLOB_MSG_DATA, &w);
+}
+
+// Still receiving, as far as the sender knows
+static bool peer_live(const blob_tx_peer_t *p) { return p->state == BLOB_RX_RECEIVING; }
+
+static void give_up(blob_tx_peer_t *p, int64_t now_us)
+{
+    p->state   = BLOB_RX_FAILED;
+    p->done_us = now_us;
+}
+
+static void finish(blob_tx_t *tx, int64_t now_us)
+{
+    for (int i = 0; i < tx->n_peers; ++i) {
+        if (tx->peers[i].state == BLOB_RX_IDLE || peer_live(&tx->peers[i])) give_up(&tx->peers[i], now_us);
+    }
+    tx->phase  = BLOB_TX_DONE;
+    tx->end_us = now_us;
+}
+
+// After an unanswered OFFER/POLL: count the silence, drop peers that stay quiet
+static void count_silence(blob_tx_t *tx, bool offer, int64_t now_us)
+{
+    for (int i = 0; i < tx->n_peers; ++i) {
+        blob_tx_peer_t *p = &tx->peers[i];
+        bool waiting = offer ? p->state == BLOB_RX_IDLE : peer_live(p);
+        if (!waiting || p->answered) continue;
+        if (++p->silent >= tx->max_silent) give_up(p, now_us);
+    }
+}
+
+static bool any_peer(const blob_tx_t *tx, bool (*pred)(const blob_tx_peer_t *))
+{
+    for (int i = 0; i < tx->n_peers; ++i) {
+        if (pred(&tx->peers[i])) return true;
+    }
+    return false;
+}
+
+static bool peer_unoffered(const blob_tx_peer_t *p) { return p->state == BLOB_RX_IDLE; }
+static bool peer_unpolled(const blob_tx_peer_t *p)  { return peer_live(p) && !p->answered; }
+static bool peer_polled(const blob_tx_peer_t *p)    { return peer_live(p) && p->answered; }
+
+static void enter_poll(blob_tx_t *tx)
+{
+    tx->phase = BLOB_TX_POLL;
+    tx->asked = false;
+}
+
+static step_t offer(blob_tx_t *tx, int64_t now_us)
+{
+    if (!send_offer(tx)) return STEP_REFUSED;
+    tx->offered  = true;
+    tx->offer_us = now_us + BLOB_OFFER_RETRY_US;
+    return STEP_SENT;
+}
+
+// The last OFFER's retry time has come: whoever has not answered missed it
+static void offer_timeout(blob_tx_t *tx, int64_t now_us)
+{
+    if (tx->offered) count_silence(tx, true, now_us);
+    tx->offered = false;
+}
+
+// The data starts once anyone has answered the OFFER; peers that missed
+// it keep being offered between data frames and join through the repairs
+static void enter_data(blob_tx_t *tx)
+{
+    tx->phase  = BLOB_TX_DATA;
+    tx->cursor = 0;
+}
+
+static step_t step_offer(blob_tx_t *tx, int64_t now_us)
+{
+    if (!any_peer(tx, peer_unoffered)) {
+        tx->offered = false;
+        enter_data(tx);
+        return STEP_AGAIN;
+    }
+    if (tx->offered) {
+        if (now_us < tx->offer_us) {
+            tx->wait_us = tx->offer_us;
+            return STEP_WAIT;
+        }
+        offer_timeout(tx, now_us);
+        if (any_peer(tx, peer_live)) enter_data(tx);
+        return STEP_AGAIN;
+    }
+    return offer(tx, now_us);
+}
+
+static bool reoffer_due(const blob_tx_t *tx, int64_t now_us)
+{
+    return now_us >= tx->offer_us && any_peer(tx, peer_unoffered);
+}
+
+static step_t step_reoffer(blob_tx_t *tx, int64_t now_us)
+{
+    offer_timeout(tx, now_us);
+    return any_peer(tx, peer_unoffered) ? offer(tx, now_us) : STEP_AGAIN;
+}
+
+static step_t step_data(blob_tx_t *tx, int64_t now_us)
+{
+    (void)now_us;
+    if (tx->cursor >= tx->n_chunks || !any_peer(tx, peer_live)) {
+        enter_poll(tx);
+        return STEP_AGAIN;
+    }
+    if (!send_chunk(tx, NULL, tx->cursor)) return STEP_REFUSED;
+    tx->cursor++;
+    tx->data_frames++;
+    return STEP_SENT;
+}
+
+static step_t step_poll(blob_tx_t *tx, int64_t now_us)
+{
+    if (!any_peer(tx, peer_live)) {
+        if (!any_peer(tx, peer_unoffered)) {
+            finish(tx, now_us);
+            return STEP_AGAIN;
+        }
+        tx->wait_us = tx->offer_us;   // only latecomers left: keep offering
+        return STEP_WAIT;
+    }
+    if (tx->asked) {
+        if (any_peer(tx, peer_unpolled)) {
+            if (now_us < tx->wait_us) return STEP_WAIT;
+            count_silence(tx, false, now_us);
+            tx->asked = false;
+            // Repair whoever answered; the others are polled again after
+            if (!any_peer(tx, peer_polled)) return STEP_AGAIN;
+        }
+        if (++tx->rounds > BLOB_MAX_ROUNDS) {
+            finish(tx, now_us);
+            return STEP_AGAIN;
+        }
+        tx->phase  = BLOB_TX_REPAIR;
+        tx->cursor = 0;
+        tx->asked  = false;
+        return STEP_AGAIN;
+    }
+    for (int i = 0; i < tx->n_peers; ++i) tx->peers[i].answered = false;
+    if (!send_poll(tx)) return STEP_REFUSED;
+    tx->asked   = true;
+    tx->wait_us = now_us + BLOB_POLL_WAIT_US;
+    return STEP_SENT;
+}
+
+// Peers that reported chunk idx missing in their last answer; *who is one of them
+static int needed_by(const blob_tx_t *tx, uint16_t idx, int *who)
+{
+    int n = 0;
+    for (int i = 0; i < tx->n_peers; ++i) {
+        const blob_tx_peer_t *p = &tx->peers[i];
+        if (!peer_polled(p) || idx < p->base || idx - p->base >= p->nbits) continue;
+        if (bit_get(p->missing, idx - p->base)) {
+            *who = i;
+            n++;
+        }
+    }
+    return n;
+}
+
+static step_t step_repair(blob_tx_t *tx, int64_t now_us)
+{
+    (void)now_us;
+    int who = -1, n = 0;
+    uint16_t idx = tx->cursor;
+    for (; idx < tx->n_chunks; ++idx) {
+        if ((n = needed_by(tx, idx, &who)) > 0) break;
+    }
+    if (idx >= tx->n_chunks) {
+        enter_poll(tx);
+        return STEP_AGAIN;
+    }
+    // Broadcast costs the same airtime as unicast, so share it when it helps
+    // two or more; a lone straggler gets unicast with MAC-level retries
+    const uint8_t *mac = n >= 2 ? NULL : tx->peers[who].mac;
+    if (!send_chunk(tx, mac, idx)) {
+        tx->cursor = idx;
+        return STEP_REFUSED;
+    }
+    if (mac) {
+        tx->peers[who].unicast++;
+        tx->repairs_ucast++;
+    } else {
+        tx->repairs_bcast++;
+    }
+    tx->cursor = idx + 1;
+    return STEP_SENT;
+}
+
+bool blob_tx_start(blob_tx_t *tx, const uint8_t *data, uint32_t len, uint8_t kind, uint16_t id,
+                   const uint8_t (*macs)[6], size_t n_peers, int64_t now_us)
+{
+    if (blob_tx_busy(tx) || !n_peers || !len) return false;
+    uint32_t n_chunks = (len + BLOB_CHUNK_MAX - 1) / BLOB_CHUNK_MAX;
+    if (n_chunks > BLOB_MAX_CHUNKS) return false;
+
+    tx->data     = data;
+    tx->len      = len;
+    tx->hash     = blob_fnv1a64(BLOB_FNV_INIT, data, len);
+    tx->id       = id;
+    tx->kind     = kind;
+    tx->chunk    = BLOB_CHUNK_MAX;
+    tx->n_chunks = (uint16_t)n_chunks;
+
+    memset(tx->peers, 0, sizeof(tx->peers));
+    tx->n_peers = 0;
+    for (size_t k = 0; k < n_peers && tx->n_peers < BLOB_MAX_PEERS; ++k) {
+        memcpy(tx->peers[tx->n_peers++].mac, macs[k], 6);
+    }
+    tx->phase    = BLOB_TX_OFFER;
+    tx->asked    = false;
+    tx->offered  = false;
+    tx->offer_us = now_us;
+    tx->cursor   = 0;
+    tx->rounds   = 0;
+    tx->start_us = now_us;
+    tx->end_us   = 0;
+    tx->next_us  = now_us;
+    tx->frames = tx->data_frames = tx->repairs_bcast = tx->repairs_ucast = 0;
+    return true;
+}
+
+bool blob_tx_handle(blob_tx_t *tx, const uint8_t mac[6], const wire_frame_t *f, int64_t now_us)
+{
+    if (f->type != WIRE_T_BLOB + BLOB_MSG_STATUS || !blob_tx_busy(tx)) return false;
+    wire_reader_t r;
+    wire_reader_init(&r, f);
+    uint16_t id    = wire_get_u16(&r);
+    uint8_t  state = wire_get_u8(&r);
+    uint16_t have  = wire_get_u16(&r);
+    uint16_t base  = wire_get_u16(&r);
+    uint16_t nbits = wire_get_u16(&r);
+    int i = peer_index(tx, mac);
+    if (!r.ok || id != tx->id || i < 0 || nbits > BLOB_STATUS_BITS) return false;
+
+    blob_tx_peer_t *p = &tx->peers[i];
+    if (p->state == BLOB_RX_FAILED && p->done_us) return true;   // given up already
+    wire_get_bytes(&r, p->missing, (nbits + 7u) / 8u);
+    if (!r.ok) return false;
+    p->state    = state;
+    p->answered = true;
+    p->silent   = 0;
+    p->have     = have;
+    p->base     = base;
+    p->nbits    = nbits;
+    if ((state == BLOB_RX_DONE || state == BLOB_RX_FAILED) && !p->done_us) p->done_us = now_us;
+    return true;
+}
+
+int64_t blob_tx_poll(blob_tx_t *tx, int64_t now_us)
+{
+    if (!blob_tx_busy(tx)) return INT64_MAX;
+
+    // Slots left unused while waiting are not banked beyond one burst
+    int64_t bank = (int64_t)tx->gap_us * BLOB_BURST;
+    if (tx->next_us < now_us - bank) tx->next_us = now_us - bank;
+
+    int sent = 0;
+    while (sent < BLOB_BURST && tx->next_us <= now_us && blob_tx_busy(tx)) {
+        step_t s;
+        if (tx->phase != BLOB_TX_OFFER && reoffer_due(tx, now_us)) {
+            s = step_reoffer(tx, now_us);
+        } else {
+            switch (tx->phase) {
+                case BLOB_TX_OFFER:  s = step_offer(tx, now_us);  break;
+                case BLOB_TX_DATA:   s = step_data(tx, now_us);   break;
+                case BLOB_TX_POLL:   s = step_poll(tx, now_us);   break;
+                case BLOB_TX_REPAIR: s = step_repair(tx, now_us); break;
+                default:             s = STEP_WAIT;               break;
+            }
+        }
+        if (s == STEP_SENT) {
+            tx->next_us += tx->gap_us;
+            sent++;
+        } else if (s == STEP_REFUSED) {
+            tx->next_us = now_us + tx->gap_us;
+            break;
+        } else if (s == STEP_WAIT) {
+            int64_t wake = tx->wait_us;
+            if (tx->phase != BLOB_TX_OFFER && any_peer(tx, peer_unoffered) && tx->offer_us < wake) {
+                wake = tx->offer_us;
+            }
+            return wake > tx->next_us ? wake : tx->next_us;
+        }
+    }
+    return blob_tx_busy(tx) ? tx->next_us : INT64_MAX;
+}
+
+// ----------------------
+// Receiver
+// ----------------------
+
+void blob_rx_init(blob_rx_t *rx, const blob_sink_t *sink, blob_send_fn send, void *ctx)
+{
+    memset(rx, 0, sizeof(*rx));
+    rx->sink = sink;
+    rx->send = send;
+    rx->ctx  = ctx;
+}
+
+static void send_status(blob_rx_t *rx)
+{
+    uint16_t base = 0;
+    if (rx->state == BLOB_RX_RECEIVING) {
+        while (base < rx->n_chunks && bit_get(rx->held, base)) base++;
+    } else {
+        base = rx->n_chunks;
+    }
+    uint16_t nbits = rx->n_chunks - base;
+    if (nbits > BLOB_STATUS_BITS) nbits = BLOB_STATUS_BITS;
+    uint8_t missing[BLOB_STATUS_BITS / 8] = {0};
+    for (uint16_t i = 0; i < nbits; ++i) {
+        if (!bit_get(rx->held, base + i)) bit_set(missing, i);
+    }
+
+    uint8_t buf[WIRE_MAX_PAYLOAD];
+    wire_writer_t w;
+    wire_writer_init(&w, buf, sizeof(buf));
+    wire_put_u16(&w, rx->id);
+    wire_put_u8(&w, (uint8_t)rx->state);
+    wire_put_u16(&w, rx->have);
+    wire_put_u16(&w, base);
+    wire_put_u16(&w, nbits);
+    wire_put_bytes(&w, missing, (nbits + 7u) / 8u);
+    // A lost STATUS is recovered by the next POLL, so no retry here
+    if (w.ok) (void)rx->send(rx->ctx, rx->src, WIRE_T_BLOB + BLOB_MSG_STATUS, w.buf, w.pos);
+}
+
+static void fail(blob_rx_t *rx)
+{
+    rx->state = BLOB_RX_FAILED;
+    rx->sink->abort(rx->ctx);
+}
+
+// Every chunk is held: hash what was stored, commit or start over
+static void complete(blob_rx_t *rx)
+{
+    uint8_t buf[BLOB_CHUNK_MAX];
+    uint64_t h = BLOB_FNV_INIT;
+    for (uint16_t i = 0; i < rx->n_chunks; ++i) {
+        uint32_t n = chunk_len(rx->len, rx->chunk, i);
+        if (!rx->sink->read(rx->ctx, (uint32_t)i * rx->chunk, buf, n)) {
+            fail(rx);
+            return;
+        }
+        h = blob_fnv1a64(h, buf, n);
+    }
+    if (h != rx->hash) {
+        // Start over on fresh storage (flash cannot be rewritten in place)
+        if (++rx->hash_fails >= BLOB_HASH_TRIES || !rx->sink->begin(rx->ctx, rx->kind, rx->len)) {
+            fail(rx);
+        } else {
+            memset(rx->held, 0, sizeof(rx->held));
+            rx->have = 0;
+        }
+        return;
+    }
+    if (rx->sink->commit(rx->ctx, rx->kind, rx->len)) {
+        rx->state = BLOB_RX_DONE;
+    } else {
+        fail(rx);
+    }
+}
+
+static void handle_offer(blob_rx_t *rx, const uint8_t mac[6], wire_reader_t *r, int64_t now_us)
+{
+    uint16_t id       = wire_get_u16(r);
+    uint8_t  kind     = wire_get_u8(r);
+    uint32_t len      = wire_get_u32(r);
+    uint16_t chunk    = wire_get_u16(r);
+    uint16_t n_chunks = wire_get_u16(r);
+    uint64_t hash     = wire_get_u64(r);
+    if (!r->ok) return;
+
+    // A repeated OFFER: our STATUS was lost, answer again
+    if (rx->state != BLOB_RX_IDLE && id == rx->id && memcmp(mac, rx->src, 6) == 0) {
+        rx->last_us = now_us;
+        send_status(rx);
+        return;
+    }
+    // A new transfer replaces the one in progress
+    if (rx->state == BLOB_RX_RECEIVING) rx->sink->abort(rx->ctx);
+
+    memcpy(rx->src, mac, 6);
+    rx->id         = id;
+    rx->kind       = kind;
+    rx->len        = len;
+    rx->hash       = hash;
+    rx->chunk      = chunk;
+    rx->n_chunks   = n_chunks;
+    rx->have       = 0;
+    rx->hash_fails = 0;
+    rx->first_us   = now_us;
+    rx->last_us    = now_us;
+    memset(rx->held, 0, sizeof(rx->held));
+
+    bool sane = len && chunk && chunk <= BLOB_CHUNK_MAX && n_chunks <= BLOB_MAX_CHUNKS
+             && n_chunks == (len + chunk - 1u) / chunk;
+    if (sane && rx->sink->begin(rx->ctx, kind, len)) {
+        rx->state = BLOB_RX_RECEIVING;
+    } else {
+        // Tell the sender straight away rather than have it time out
+        rx->state = BLOB_RX_FAILED;
+    }
+    send_status(rx);
+}
+
+static void handle_data(blob_rx_t *rx, wire_reader_t *r, const wire_frame_t *f, int64_t now_us)
+{
+    uint16_t id  = wire_get_u16(r);
+    uint16_t idx = wire_get_u16(r);
+    uint16_t crc = wire_get_u16(r);
+    if (!r->ok || rx->state != BLOB_RX_RECEIVING || id != rx->id || idx >= rx->n_chunks) return;
+    rx->last_us = now_us;
+
+    uint32_t n = chunk_len(rx->len, rx->chunk, idx);
+    if (f->len < BLOB_DATA_HDR + n) return;
+    if (bit_get(rx->held, idx)) {
+        rx->dups++;
+        return;
+    }
+    const uint8_t *data = f->payload + BLOB_DATA_HDR;
+    uint32_t off = (uint32_t)idx * rx->chunk;
+    if (wire_crc16(data, n) != crc) {
+        rx->bad_chunks++;
+        return;
+    }
+    if (!rx->sink->write(rx->ctx, off, data, n)) {
+        fail(rx);
+        send_status(rx);
+        return;
+    }
+    // Read back: a chunk the storage did not keep is asked for again
+    uint8_t back[BLOB_CHUNK_MAX];
+    if (!rx->sink->read(rx->ctx, off, back, n) || wire_crc16(back, n) != crc) {
+        rx->bad_chunks++;
+        return;
+    }
+    bit_set(rx->held, idx);
+    if (++rx->have == rx->n_chunks) {
+        complete(rx);
+        send_status(rx);
+    }
+}
+
+void blob_rx_handle(blob_rx_t *rx, const uint8_t mac[6], const wire_frame_t *f, int64_t now_us)
+{
+    wire_reader_t r;
+    wire_reader_init(&r, f);
+    switch (f->type - WIRE_T_BLOB) {
+        case BLOB_MSG_OFFER:
+            handle_offer(rx, mac, &r, now_us);
+            break;
+        case BLOB_MSG_DATA:
+            handle_data(rx, &r, f, now_us);
+            break;
+        case BLOB_MSG_POLL: {
+            uint16_t id = wire_get_u16(&r);
+            if (r.ok && rx->state != BLOB_RX_IDLE && id == rx->id && memcmp(mac, rx->src, 6) == 0) {
+                rx->last_us = now_us;
+                send_status(rx);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void blob_rx_poll(blob_rx_t *rx, int64_t now_us)
+{
+    if (rx->state == BLOB_RX_RECEIVING && now_us - rx->last_us > BLOB_RX_IDLE_US) {
+        rx->sink->abort(rx->ctx);
+        rx->state = BLOB_RX_IDLE;
+    }
+}
@@ -0,0 +1,163 @@
+// src/clock_sync.c — offset/drift estimation from request/response exchanges
+#include <string.h>
+
+#include "clock_sync.h"
+
+void clock_sync_init(clock_sync_t *cs)
+{
+    memset(cs, 0, sizeof(*cs));
+}
+
+static int64_t drift_us(int64_t dt_us, int32_t drift_ppb)
+{
+    return dt_us * drift_ppb / 1000000000LL;
+}
+
+static bool accepted(const clock_sync_sample_t *s, uint32_t min_rtt)
+{
+    return s->rtt_us <= min_rtt + CLOCK_SYNC_RTT_SLACK_US;
+}
+
+// A sample's offset is off by at most half its RTT; what is above the
+// window minimum is the part that is likely asymmetric
+static double weight(const clock_sync_sample_t *s, uint32_t min_rtt)
+{
+    double sigma = CLOCK_SYNC_SIGMA_US + (double)(s->rtt_us - min_rtt) / 2.0;
+    return 1.0 / (sigma * sigma);
+}
+
+// Weighted least-squares line through the accepted samples (offset vs local time).
+// Falls back to the lowest-RTT sample with zero drift if the window is too
+// short to say anything about drift.
+static void refit(clock_sync_t *cs)
+{
+    const clock_sync_sample_t *best = NULL;
+    const clock_sync_sample_t *newest = NULL;
+    int64_t t_min = INT64_MAX, t_max = INT64_MIN;
+    unsigned n = 0;
+
+    for (unsigned i = 0; i < cs->count; ++i) {
+        const clock_sync_sample_t *s = &cs->samples[i];
+        if (!accepted(s, cs->min_rtt_us)) continue;
+        if (!best || s->rtt_us < best->rtt_us) best = s;
+        if (!newest || s->local_us > newest->local_us) newest = s;
+        if (s->local_us < t_min) t_min = s->local_us;
+        if (s->local_us > t_max) t_max = s->local_us;
+        n++;
+    }
+    if (!best) return;
+
+    cs->valid         = true;
+    cs->fitted        = false;
+    cs->drift_ppb     = 0;
+    cs->ref_local_us  = best->local_us;
+    cs->ref_offset_us = best->offset_us;
+    cs->base_err_us   = best->rtt_us / 2;
+
+    if (n < CLOCK_SYNC_FIT_MIN || t_max - t_min < CLOCK_SYNC_FIT_SPAN_US) return;
+
+    // Centre on the means so the sums stay small; doubles are fine here,
+    // this runs once per exchange, not per query.
+    double sw = 0.0, mt = 0.0, mo = 0.0;
+    for (unsigned i = 0; i < cs->count; ++i) {
+        const clock_sync_sample_t *s = &cs->samples[i];
+        if (!accepted(s, cs->min_rtt_us)) continue;
+        double w = weight(s, cs->min_rtt_us);
+        sw += w;
+        mt += w * (double)(s->local_us - t_min);
+        mo += w * (double)(s->offset_us - best->offset_us);
+    }
+    mt /= sw;
+    mo /= sw;
+
+    double stt = 0.0, sto = 0.0;
+    for (unsigned i = 0; i < cs->count; ++i) {
+        const clock_sync_sample_t *s = &cs->samples[i];
+        if (!accepted(s, cs->min_rtt_us)) continue;
+        double w  = weight(s, cs->min_rtt_us);
+        double dt = (double)(s->local_us - t_min) - mt;
+        double d0 = (double)(s->offset_us - best->offset_us) - mo;
+        stt += w * dt * dt;
+        sto += w * dt * d0;
+    }
+    double slope = sto / stt;   // us per us
+    if (slope * 1e9 > CLOCK_SYNC_MAX_DRIFT_PPB || slope * 1e9 < -CLOCK_SYNC_MAX_DRIFT_PPB) return;
+
+    // Anchor the line at the newest sample so extrapolation stays short
+    int64_t ref   = newest->local_us;
+    double  at_ref = mo + slope * ((double)(ref - t_min) - mt);
+    cs->fitted        = true;
+    cs->drift_ppb     = (int32_t)(slope * 1e9);
+    cs->ref_local_us  = ref;
+    cs->ref_offset_us = best->offset_us + (int64_t)at_ref;
+
+    // Bound: half the best RTT plus the worst distance of a sample from the line
+    double worst = 0.0;
+    for (unsigned i = 0; i < cs->count; ++i) {
+        const clock_sync_sample_t *s = &cs->samples[i];
+        if (!accepted(s, cs->min_rtt_us)) continue;
+        double dt = (double)(s->local_us - t_min) - mt;
+        double r  = (double)(s->offset_us - best->offset_us) - mo - slope * dt;
+        if (r < 0) r = -r;
+        if (r > worst) worst = r;
+    }
+    cs->base_err_us = best->rtt_us / 2 + (uint32_t)worst;
+}
+
+bool clock_sync_add(clock_sync_t *cs, int64_t t1, int64_t t2, int64_t t3, int64_t t4)
+{
+    int64_t rtt = (t4 - t1) - (t3 - t2);
+    if (rtt < 0 || t4 < t1) return false;
+
+    clock_sync_sample_t s = {
+        .local_us  = t1 + (t4 - t1) / 2,
+        .offset_us = ((t2 - t1) + (t3 - t4)) / 2,
+        .rtt_us    = rtt > UINT32_MAX ? UINT32_MAX : (uint32_t)rtt,
+    };
+
+    cs->samples[cs->head] = s;
+    cs->head = (uint8_t)((cs->head + 1) % CLOCK_SYNC_WINDOW);
+    if (cs->count < CLOCK_SYNC_WINDOW) cs->count++;
+
+    cs->min_rtt_us = UINT32_MAX;
+    for (unsigned i = 0; i < cs->count; ++i) {
+        if (cs->samples[i].rtt_us < cs->min_rtt_us) cs->min_rtt_us = cs->samples[i].rtt_us;
+    }
+
+    refit(cs);
+    return accepted(&s, cs->min_rtt_us);
+}
+
+bool clock_sync_to_remote(const clock_sync_t *cs, int64_t local_us,
+                          int64_t *remote_us, uint32_t *err_bound_us)
+{
+    if (!cs->valid) {
+        if (remote_us) *remote_us = local_us;
+        if (err_bound_us) *err_bound_us = UINT32_MAX;
+        return false;
+    }
+
+    int64_t dt = local_us - cs->ref_local_us;
+    if (remote_us) *remote_us = local_us + cs->ref_offset_us + drift_us(dt, cs->drift_ppb);
+    if (err_bound_us) {
+        // Extrapolation error grows with distance from the reference point
+        int64_t adt   = dt < 0 ? -dt : dt;
+        int64_t grow  = adt * (cs->fitted ? CLOCK_SYNC_FIT_PPM : CLOCK_SYNC_UNFIT_PPM) / 1000000;
+        int64_t bound = (int64_t)cs->base_err_us + grow;
+        *err_bound_us = bound > UINT32_MAX ? UINT32_MAX : (uint32_t)bound;
+    }
+    return true;
+}
+
+int64_t clock_sync_to_local(const clock_sync_t *cs, int64_t remote_us)
+{
+    if (!cs->valid) return remote_us;
+    // One fixed-point step is plenty: drift moves the offset by ns per ms
+    int64_t local = remote_us - cs->ref_offset_us;
+    return remote_us - (cs->ref_offset_us + drift_us(local - cs->ref_local_us, cs->drift_ppb));
+}
+
+bool clock_sync_wants_fast(const clock_sync_t *cs)
+{
+    return !cs->fitted && cs->count < CLOCK_SYNC_WINDOW;
+}
@@ -206,8 +206,10 @@ esp_err_t device_config_init(config_method_t method)
             break;
 
         case CONFIG_METHOD_AUTO_ASSIGN:
-            s_role = ROLE_UNKNOWN; // set later by discovery/control flow
-            ESP_LOGI(TAG, "Auto-assign: waiting for assignment");
+            // Keep the role held before a firmware update to a role-neutral
+            // build; otherwise it is set later by discovery/control flow
+            s_role = read_nvs_role();
+            if (s_role == ROLE_UNKNOWN) ESP_LOGI(TAG, "Auto-assign: waiting for assignment");
             break;
 
         default:
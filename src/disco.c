@@ -0,0 +1,199 @@
+// src/disco.c — peer table and role handshake, see disco.h
+#include <string.h>
+
+#include "disco.h"
+
+#define MAC_LEN  6
+
+static disco_peer_t *find_peer(disco_t *d, const uint8_t *mac)
+{
+    for (int i = 0; i < d->n_peers; ++i) {
+        if (memcmp(d->peers[i].mac, mac, MAC_LEN) == 0) return &d->peers[i];
+    }
+    return NULL;
+}
+
+static void add_or_update_peer(disco_t *d, const wire_disco_t *p, int64_t now_us)
+{
+    disco_peer_t *peer = find_peer(d, p->mac);
+    if (!peer && d->n_peers < DISCO_MAX_PEERS) {
+        peer = &d->peers[d->n_peers++];
+        memset(peer, 0, sizeof(*peer));
+        memcpy(peer->mac, p->mac, MAC_LEN);
+        if (d->hooks->peer_added) d->hooks->peer_added(d->ctx, p->mac);
+    }
+    if (!peer) return;
+
+    peer->role         = p->role;
+    peer->online       = true;
+    peer->last_seen_us = now_us;
+    if (p->name[0]) {
+        strncpy(peer->name, p->name, sizeof(peer->name) - 1);
+        peer->name[sizeof(peer->name) - 1] = '\0';
+    }
+}
+
+static bool send_frame(disco_t *d, const uint8_t *dst, discovery_msg_type_t type,
+                       uint8_t role, const char *name, int64_t now_us)
+{
+    wire_disco_t p = {0};
+    p.role      = role;
+    p.timestamp = (uint32_t)(now_us / 1000);   // us -> ms
+    memcpy(p.mac, d->mac, MAC_LEN);
+    if (name) strncpy(p.name, name, sizeof(p.name) - 1);
+
+    uint8_t buf[WIRE_MAX_FRAME];
+    wire_writer_t w;
+    wire_begin(&w, buf, sizeof(buf), (uint8_t)(WIRE_T_DISCO + type), WIRE_F_NONE, d->sender,
+               d->hooks->next_seq(d->ctx));
+    wire_put_disco(&w, &p);
+    size_t len = wire_finish(&w);
+    return len && d->hooks->send(d->ctx, dst, buf, len);
+}
+
+// First part no known peer plays yet
+static void assign_free_part(disco_t *d, const uint8_t mac[6], int64_t now_us)
+{
+    for (uint8_t r = DISCO_ROLE_PART_1; r <= DISCO_ROLE_PART_4; ++r) {
+        bool taken = false;
+        for (int i = 0; i < d->n_peers; ++i) {
+            if (d->peers[i].role == r) { taken = true; break; }
+        }
+        if (taken) continue;
+        disco_assign(d, mac, r, now_us);
+        if (d->hooks->assigned) d->hooks->assigned(d->ctx, mac, r);
+        return;
+    }
+}
+
+void disco_init(disco_t *d, const disco_hooks_t *hooks, void *ctx, uint8_t sender,
+                const uint8_t mac[6], uint8_t role, const char *name)
+{
+    memset(d, 0, sizeof(*d));
+    d->hooks  = hooks;
+    d->ctx    = ctx;
+    d->sender = sender;
+    d->role   = role;
+    memcpy(d->mac, mac, MAC_LEN);
+    if (name) strncpy(d->name, name, sizeof(d->name) - 1);
+    d->announce_us = INT64_MAX;
+    d->request_us  = INT64_MAX;
+}
+
+void disco_start(disco_t *d, int64_t now_us)
+{
+    disco_send(d, NULL, DISCO_MSG_ANNOUNCE, now_us);
+    d->announce_us = now_us + DISCO_ANNOUNCE_MS * 1000LL;
+    if (d->role == DISCO_ROLE_UNKNOWN) d->request_us = now_us + DISCO_ROLE_REQUEST_MS * 1000LL;
+}
+
+bool disco_handle(disco_t *d, const uint8_t src[6], const wire_frame_t *f, int64_t now_us)
+{
+    wire_disco_t p;
+    if (!WIRE_T_IS_DISCO(f->type) || !wire_get_disco(f, &p)) return false;
+    if (memcmp(src, d->mac, MAC_LEN) == 0) return false;   // our own
+
+    bool conductor = (d->role == DISCO_ROLE_CONDUCTOR);
+    switch ((discovery_msg_type_t)(f->type - WIRE_T_DISCO)) {
+    case DISCO_MSG_ANNOUNCE:
+        add_or_update_peer(d, &p, now_us);
+        // The conductor assigns a part to a device that has none
+        if (conductor && p.role == DISCO_ROLE_UNKNOWN) assign_free_part(d, p.mac, now_us);
+        break;
+
+    case DISCO_MSG_ROLE_REQUEST:
+        if (conductor) assign_free_part(d, p.mac, now_us);
+        break;
+
+    case DISCO_MSG_ROLE_ASSIGN:
+        // Only a device without a role takes one, then re-announces
+        if (d->role == DISCO_ROLE_UNKNOWN) {
+            d->role       = p.role;
+            d->request_us = INT64_MAX;
+            if (d->hooks->role_set) d->hooks->role_set(d->ctx, p.role);
+            disco_send(d, NULL, DISCO_MSG_ANNOUNCE, now_us);
+        }
+        break;
+
+    case DISCO_MSG_ROLL_CALL:
+        // Answer the sender only (src comes from the radio, not the payload)
+        disco_send(d, src, DISCO_MSG_PRESENT, now_us);
+        break;
+
+    case DISCO_MSG_PRESENT:
+    case DISCO_MSG_READY:
+        add_or_update_peer(d, &p, now_us);
+        break;
+
+    default:
+        break;
+    }
+    return true;
+}
+
+int64_t disco_poll(disco_t *d, int64_t now_us)
+{
+    if (now_us >= d->request_us) {
+        d->request_us = INT64_MAX;
+        if (d->role == DISCO_ROLE_UNKNOWN) disco_send(d, NULL, DISCO_MSG_ROLE_REQUEST, now_us);
+    }
+    if (now_us >= d->announce_us) {
+        disco_send(d, NULL, DISCO_MSG_ANNOUNCE, now_us);
+        d->announce_us = now_us + DISCO_ANNOUNCE_MS * 1000LL;
+
+        for (int i = 0; i < d->n_peers; ++i) {
+            if (now_us - d->peers[i].last_seen_us > DISCO_PEER_TIMEOUT_MS * 1000LL) d->peers[i].online = false;
+        }
+    }
+    return d->request_us < d->announce_us ? d->request_us : d->announce_us;
+}
+
+bool disco_send(disco_t *d, const uint8_t *dst, discovery_msg_type_t type, int64_t now_us)
+{
+    return send_frame(d, dst, type, d->role, d->name, now_us);
+}
+
+bool disco_assign(disco_t *d, const uint8_t mac[6], uint8_t role, int64_t now_us)
+{
+    return send_frame(d, mac, DISCO_MSG_ROLE_ASSIGN, role, NULL, now_us);
+}
+
+uint8_t disco_online_count(const disco_t *d)
+{
+    uint8_t n = 0;
+    for (int i = 0; i < d->n_peers; ++i) {
+        if (d->peers[i].online) ++n;
+    }
+    return n;
+}
+
+static bool is_performer(const disco_peer_t *p)
+{
+    return p->online && p->role >= DISCO_ROLE_PART_1 && p->role <= DISCO_ROLE_PART_4;
+}
+
+uint8_t disco_online_part_mask(const disco_t *d)
+{
+    uint8_t mask = 0;
+    for (int i = 0; i < d->n_peers; ++i) {
+        if (is_performer(&d->peers[i])) mask |= (uint8_t)(1u << (d->peers[i].role - DISCO_ROLE_PART_1));
+    }
+    return mask;
+}
+
+size_t disco_online_performers(const disco_t *d, uint8_t (*macs)[6], size_t max)
+{
+    size_t n = 0;
+    for (int i = 0; i < d->n_peers && n < max; ++i) {
+        if (is_performer(&d->peers[i])) memcpy(macs[n++], d->peers[i].mac, MAC_LEN);
+    }
+    return n;
+}
+
+uint8_t disco_peer_role(const disco_t *d, const uint8_t mac[6])
+{
+    for (int i = 0; i < d->n_peers; ++i) {
+        if (memcmp(d->peers[i].mac, mac, MAC_LEN) == 0) return d->peers[i].role;
+    }
+    return DISCO_ROLE_UNKNOWN;
+}
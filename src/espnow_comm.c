@@ -1,4 +1,9 @@
 // src/espnow_comm.c — conductor is silent (no local audio), performers play
+//
+// Device glue for orch_ctl.h: the protocol itself (clock sync, ACKs and
+// retries, heartbeats, following the state vector) is orch_ctl.c, run on
+// espnow_task. This file feeds it frames and timers and carries out the
+// playback it asks for.
 
 #include <string.h>
 #include <stdint.h>
@@ -7,166 +12,528 @@
 #include "freertos/task.h"
 #include "freertos/queue.h"
 
-#include "esp_now.h"
-#include "esp_wifi.h"
-#include "esp_event.h"
-#include "esp_netif.h"
 #include "esp_log.h"
-#include "esp_mac.h"
 #include "nvs_flash.h"
 #include "esp_timer.h"
+#include "esp_random.h"
 
 #include "device_config.h"       // device_config_get_role(), ROLE_CONDUCTOR / ROLE_PART_x
-#include "espnow_discovery.h"    // espnow_discovery_recv_cb(...)
-#include "orchestra.h"           // orchestra_play_song(), orchestra_stop()
+#include "espnow_discovery.h"    // espnow_discovery_handle_frame(...), online performers
+#include "orchestra.h"           // orchestra_play_song_at(), orchestra_stop()
 #include "espnow_comm.h"         // espnow_msg_t, msg_type_t, prototypes
+#include "orch_ctl.h"            // control protocol (clock sync, ACKs, state vector)
+#include "wire_proto.h"          // frame header, CRC, payload codecs
+#include "reliable.h"            // delivery stats
+#include "orch_state.h"          // replicated state vector
+#include "synth.h"               // synth_gain_q15(), synth_gain_from_q15()
+#include "audio.h"               // audio_sync_timeline()
+#include "song_sync.h"           // song library transfer frames
+#include "transport.h"           // the link frames travel on (ESP-NOW, UDP)
 
 static const char *TAG = "ESPNOW";
 
 // Broadcast MAC address (FF:FF:FF:FF:FF:FF)
-static const uint8_t s_broadcast_mac[ESP_NOW_ETH_ALEN] =
+static const uint8_t s_broadcast_mac[TRANSPORT_ADDR_LEN] =
     { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
 
-// Queue for receiving ESP-NOW control messages
+// Queue item kinds for espnow_task
+enum {
+    ITEM_FRAME = 0,     // control / clock / ACK frame, copied from the receive callback
+    ITEM_POLL,          // s_poll_timer fired: orch_ctl_poll() is due
+    ITEM_START_DUE,     // s_start_timer fired: a scheduled start is due
+    ITEM_COMMAND,       // espnow_broadcast() from another task
+    ITEM_VOLUME,        // espnow_state_set_volume() from another task
+};
+
+// Queue item. Frames carry their receive time, taken in the WiFi callback
+// before any queueing delay.
+typedef struct {
+    uint8_t kind;
+    union {
+        struct {
+            wire_frame_t f;          // payload re-pointed at data on the task
+            uint8_t      src_mac[TRANSPORT_ADDR_LEN];
+            uint8_t      data[ORCH_CTL_MAX_FRAME];
+        } rx;
+        struct {
+            uint8_t  song_id;
+            uint32_t gen;
+            int64_t  target_us;
+        } due;
+        struct {
+            uint8_t type;            // msg_type_t
+            uint8_t song_id;
+        } cmd;
+        uint16_t volume_q15;
+    };
+    int64_t rx_us;
+} espnow_item_t;
+
+// Queue for espnow_task: frames, timers and requests from other tasks
 static QueueHandle_t s_espnow_queue = NULL;
 
+// The link everything is sent and received on; ESP-NOW unless set before init
+static transport_t *s_tp = NULL;
+
 // Device ID (optional; use however you like)
 static uint8_t s_device_id = 0;
 
-// Clock offset in microseconds: offset = conductor_time - local_time
-// Updated by HEARTBEAT messages. Use int64_t for signed offset.
-static int64_t s_clock_offset_us = 0;
-static TaskHandle_t s_heartbeat_task = NULL;
+// Protocol state, owned by espnow_task. Other tasks read the snapshots
+// below, refreshed by the task after every item under s_pub_lock.
+static orch_ctl_t   s_ctl;
+static bool         s_is_conductor = false;
+static orch_state_t s_state_pub;
+static orch_clock_t s_clock_pub;
+static reliable_peer_stats_t s_rtx_pub[RELIABLE_MAX_PEERS];
+static uint8_t      s_rtx_pub_n = 0;
+static portMUX_TYPE s_pub_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// One-shot timer armed for the time orch_ctl_poll() asked to be called
+// again (heartbeats and retries need better than the 10 ms tick)
+static esp_timer_handle_t s_poll_timer = NULL;
+
+// Receive callback -> espnow_task delay (written by espnow_task only)
+static espnow_rx_latency_t s_rx_lat;
+static const uint32_t      s_rx_lat_edges[ESPNOW_RX_LAT_BUCKETS - 1] = ESPNOW_RX_LAT_EDGES_US;
+#define RX_LAT_LOG_EVERY   200
+
+// Outgoing frame counter, shared by every sender task
+static uint16_t s_tx_seq = 0;
+// Frames dropped by wire_parse(), per wire_err_t
+static uint32_t s_rx_bad[WIRE_ERR_CRC + 1];
+
+// Scheduled start: a one-shot esp_timer fires at the converted local start
+// time and posts ITEM_START_DUE, so espnow_task never blocks waiting for it
+// and starts playback itself. A STOP cancels a pending START by stopping the
+// timer and bumping s_start_gen, which also voids a due item already queued.
+static esp_timer_handle_t s_start_timer = NULL;
+static volatile uint8_t   s_start_song_id = 0;
+static volatile int64_t   s_start_target_us = 0;   // local esp_timer time
+static volatile uint32_t  s_start_gen = 0;         // written by espnow_task only
 
 // ------------------- Callbacks -------------------
 
-static void espnow_send_cb(const wifi_tx_info_t *info, esp_now_send_status_t status)
+static void espnow_tx_done_cb(void *ctx, const uint8_t *dst, bool ok)
 {
-    if (info) {
-        const uint8_t *addr = info->des_addr;
-        ESP_LOGD(TAG, "Send -> %02X:%02X:%02X:%02X:%02X:%02X status=%d",
-                 addr[0], addr[1], addr[2], addr[3], addr[4], addr[5], status);
-    } else {
-        ESP_LOGD(TAG, "Send status=%d", status);
-    }
+    (void)ctx;
+    ESP_LOGD(TAG, "Send -> %02X:%02X:%02X:%02X:%02X:%02X %s",
+             dst[0], dst[1], dst[2], dst[3], dst[4], dst[5], ok ? "ok" : "failed");
 }
 
-// Receive callback: hand to discovery first; if it matches our control
-// struct size, push to queue for playback handling
-static void espnow_recv_cb(const esp_now_recv_info_t *recv_info,
-                           const uint8_t *data, int len)
+// Receive callback: validate the frame header/CRC once, then route by type —
+// discovery frames to discovery, control and clock frames to espnow_task.
+// rx_us was stamped by the transport on arrival, before any queueing.
+static void espnow_recv_cb(void *ctx, const uint8_t *src_mac, const uint8_t *data, size_t len, int64_t rx_us)
 {
+    (void)ctx;
+
     // Basic logging to help trace messages on the radio
-    if (recv_info && recv_info->src_addr) {
-        ESP_LOGD(TAG, "Recv from %02X:%02X:%02X:%02X:%02X:%02X len=%d",
-                 recv_info->src_addr[0], recv_info->src_addr[1], recv_info->src_addr[2],
-                 recv_info->src_addr[3], recv_info->src_addr[4], recv_info->src_addr[5], len);
+    ESP_LOGD(TAG, "Recv from %02X:%02X:%02X:%02X:%02X:%02X len=%u",
+             src_mac[0], src_mac[1], src_mac[2], src_mac[3], src_mac[4], src_mac[5], (unsigned)len);
+
+    wire_frame_t f;
+    wire_err_t err = wire_parse(data, len, &f);
+    if (err != WIRE_OK) {
+        s_rx_bad[err]++;
+        ESP_LOGD(TAG, "Dropped frame len=%u: %s (first byte 0x%02X)", (unsigned)len, wire_err_str(err),
+                 len > 0 ? data[0] : 0);
+        return;
     }
 
-    // Let discovery parse/consume its own frames (role assign, announce, etc.)
-    espnow_discovery_recv_cb(recv_info, data, len);
-
-    if (len != (int)sizeof(espnow_msg_t)) {
-        // Not one of our control frames — log first byte for diagnostics
-        if (len > 0) {
-            ESP_LOGD(TAG, "Non-control espnow frame first byte=0x%02X len=%d", data[0], len);
-        } else {
-            ESP_LOGD(TAG, "Empty espnow frame len=0");
-        }
+    // One dispatcher: the header type decides who gets the frame
+    if (WIRE_T_IS_DISCO(f.type)) {
+        espnow_discovery_handle_frame(src_mac, &f, rx_us);
         return;
     }
 
-    espnow_msg_t msg;
-    memcpy(&msg, data, sizeof(msg));
-
     // Ignore messages that we ourselves sent. This prevents the conductor
     // (which broadcasts control messages) from acting on its own broadcasts
     // and ensures only other devices (performers) react.
-    if (msg.sender_id == s_device_id) {
-        ESP_LOGD(TAG, "Ignoring self-sent message (type=%d sender=%u)", (int)msg.type, (unsigned)msg.sender_id);
+    if (f.sender == s_device_id) {
+        ESP_LOGD(TAG, "Ignoring self-sent message (type=%u sender=%u)", (unsigned)f.type, (unsigned)f.sender);
         return;
     }
 
-    if (s_espnow_queue && xQueueSend(s_espnow_queue, &msg, 0) != pdTRUE) {
-        ESP_LOGW(TAG, "Control queue full, dropping message (type=%d sender=%u)", (int)msg.type, (unsigned)msg.sender_id);
+    // Song library transfer frames are bulk traffic with their own task
+    if (WIRE_T_IS_BLOB(f.type)) {
+        song_sync_handle_frame(src_mac, &f, rx_us);
+        return;
+    }
+
+    if (f.type >= WIRE_T_DISCO || f.len > ORCH_CTL_MAX_FRAME) {
+        // Newer firmware in the field: unknown types are skipped, not fatal
+        ESP_LOGD(TAG, "Unknown frame type %u len %u from %u", (unsigned)f.type, (unsigned)f.len,
+                 (unsigned)f.sender);
+        return;
+    }
+
+    espnow_item_t item = { .kind = ITEM_FRAME, .rx = { .f = f }, .rx_us = rx_us };
+    memcpy(item.rx.src_mac, src_mac, TRANSPORT_ADDR_LEN);
+    memcpy(item.rx.data, f.payload, f.len);
+    if (s_espnow_queue && xQueueSend(s_espnow_queue, &item, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Control queue full, dropping message (type=%u sender=%u)", (unsigned)f.type, (unsigned)f.sender);
+    }
+}
+
+// ------------------- RX latency -------------------
+
+static void rx_latency_record(int64_t rx_us)
+{
+    int64_t d = esp_timer_get_time() - rx_us;
+    int b = 0;
+    while (b < ESPNOW_RX_LAT_BUCKETS - 1 && d >= (int64_t)s_rx_lat_edges[b]) b++;
+
+    s_rx_lat.bucket[b]++;
+    s_rx_lat.count++;
+    s_rx_lat.last_us = d;
+    s_rx_lat.sum_us += d;
+    if (d > s_rx_lat.max_us) s_rx_lat.max_us = d;
+
+    if (s_rx_lat.count % RX_LAT_LOG_EVERY == 0) {
+        const uint32_t *h = s_rx_lat.bucket;
+        ESP_LOGI(TAG, "RX cb->task latency: avg %lld us, max %lld us | <50:%u <100:%u <200:%u "
+                 "<500:%u <1ms:%u <2ms:%u <5ms:%u >=5ms:%u",
+                 (long long)(s_rx_lat.sum_us / s_rx_lat.count), (long long)s_rx_lat.max_us,
+                 (unsigned)h[0], (unsigned)h[1], (unsigned)h[2], (unsigned)h[3],
+                 (unsigned)h[4], (unsigned)h[5], (unsigned)h[6], (unsigned)h[7]);
+        ESP_LOGI(TAG, "Dropped frames: short %u, magic %u, version %u, len %u, crc %u",
+                 (unsigned)s_rx_bad[WIRE_ERR_SHORT], (unsigned)s_rx_bad[WIRE_ERR_MAGIC],
+                 (unsigned)s_rx_bad[WIRE_ERR_VERSION], (unsigned)s_rx_bad[WIRE_ERR_LEN],
+                 (unsigned)s_rx_bad[WIRE_ERR_CRC]);
+    }
+}
+
+// ------------------- Sends -------------------
+
+void espnow_ensure_peer(const uint8_t *mac)
+{
+    transport_add_peer(s_tp, mac);
+}
+
+esp_err_t espnow_send(const uint8_t *mac, const uint8_t *frame, size_t len)
+{
+    if (mac) espnow_ensure_peer(mac);
+    return transport_send(s_tp, mac ? mac : s_broadcast_mac, frame, len) == 0 ? ESP_OK : ESP_FAIL;
+}
+
+uint16_t espnow_next_seq(void)
+{
+    return __atomic_add_fetch(&s_tx_seq, 1, __ATOMIC_RELAXED);
+}
+
+uint8_t espnow_device_id(void)
+{
+    return s_device_id;
+}
+
+// ------------------- Scheduled start -------------------
+
+// esp_timer task context: only hand the start to espnow_task. Starting
+// playback takes the orchestra mutex, waits for audio_stop() and touches the
+// display, none of which belongs on the shared timer task.
+static void start_timer_cb(void *arg)
+{
+    (void)arg;
+    espnow_item_t item = {
+        .kind  = ITEM_START_DUE,
+        .due   = { .song_id = s_start_song_id, .gen = s_start_gen, .target_us = s_start_target_us },
+        .rx_us = esp_timer_get_time(),
+    };
+    if (xQueueSend(s_espnow_queue, &item, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Control queue full, START song %u lost", (unsigned)item.due.song_id);
     }
 }
 
+// espnow_task: the start timer fired
+static void start_due(const espnow_item_t *item)
+{
+    if (item->due.gen != s_start_gen) {
+        ESP_LOGI(TAG, "Performer: START song %u cancelled after it fired", (unsigned)item->due.song_id);
+        return;
+    }
+    // Anchored to the target, so a late dispatch skips ahead instead of lagging
+    orchestra_play_song_at(item->due.song_id, item->due.target_us);
+    ESP_LOGI(TAG, "Performer: START song %u fired, error %+lld us vs target (%lld us to the task)",
+             (unsigned)item->due.song_id, (long long)(item->rx_us - item->due.target_us),
+             (long long)(esp_timer_get_time() - item->rx_us));
+}
+
+static void cancel_scheduled_start(void)
+{
+    s_start_gen++;
+    if (s_start_timer && esp_timer_is_active(s_start_timer)) {
+        esp_timer_stop(s_start_timer);
+        ESP_LOGI(TAG, "Performer: pending START for song %u cancelled", (unsigned)s_start_song_id);
+    }
+}
+
+static void schedule_start(uint8_t song_id, int64_t local_start_us, int64_t rx_us)
+{
+    // A newer START replaces any pending one
+    cancel_scheduled_start();
+
+    int64_t wait_us = local_start_us - esp_timer_get_time();
+    if (wait_us <= 0 || !s_start_timer) {
+        ESP_LOGI(TAG, "Performer: START song %u immediately (late by %lld us, %lld us already at RX)",
+                 (unsigned)song_id, (long long)(-wait_us), (long long)(rx_us - local_start_us));
+        orchestra_play_song_at(song_id, local_start_us);
+        return;
+    }
+
+    s_start_song_id   = song_id;
+    s_start_target_us = local_start_us;
+    esp_err_t err = esp_timer_start_once(s_start_timer, (uint64_t)wait_us);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to arm start timer (err=%d), starting now", (int)err);
+        orchestra_play_song_at(song_id, local_start_us);
+        return;
+    }
+    ESP_LOGI(TAG, "Performer: scheduling START song %u in %lld us (lead at RX %lld us)",
+             (unsigned)song_id, (long long)wait_us, (long long)(local_start_us - rx_us));
+}
+
+// ------------------- orch_ctl hooks (espnow_task) -------------------
+
+static bool ctl_send(void *ctx, const uint8_t *dst, const uint8_t *frame, size_t len)
+{
+    (void)ctx;
+    esp_err_t res = espnow_send(dst, frame, len);
+    if (res != ESP_OK && dst) {
+        ESP_LOGD(TAG, "Send to %02X:%02X:%02X:%02X:%02X:%02X failed (type=%u)",
+                 dst[0], dst[1], dst[2], dst[3], dst[4], dst[5], (unsigned)frame[2]);
+    }
+    return res == ESP_OK;
+}
+
+static uint16_t ctl_next_seq(void *ctx)
+{
+    (void)ctx;
+    return espnow_next_seq();
+}
+
+static int64_t ctl_now(void *ctx)
+{
+    (void)ctx;
+    return esp_timer_get_time();
+}
+
+static size_t ctl_performers(void *ctx, uint8_t (*macs)[6], size_t max)
+{
+    (void)ctx;
+    return espnow_discovery_get_online_performers(macs, max);
+}
+
+// Delivery report for one finished message
+static void ctl_delivered(void *ctx, const reliable_tx_t *tx, const reliable_msg_t *m)
+{
+    (void)ctx;
+    int n_want = 0, n_ok = 0;
+    for (int i = 0; i < tx->n_peers; ++i) {
+        if (!(m->want & (1u << i))) continue;
+        n_want++;
+        const uint8_t *mac = tx->peers[i].mac;
+        const char *role = device_config_get_role_name(espnow_discovery_get_peer_role(mac));
+        if (m->acked & (1u << i)) {
+            n_ok++;
+            ESP_LOGI(TAG, "  type=%u seq=%u -> %s: acked after %u tx, %lld us", (unsigned)m->type,
+                     (unsigned)m->seq, role, (unsigned)m->ack_tries[i],
+                     (long long)(m->ack_us[i] - m->first_us));
+        } else {
+            ESP_LOGW(TAG, "  type=%u seq=%u -> %s (%02X:%02X:%02X:%02X:%02X:%02X): NOT delivered",
+                     (unsigned)m->type, (unsigned)m->seq, role,
+                     mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+        }
+    }
+    ESP_LOGI(TAG, "Delivery type=%u seq=%u: %d/%d peers, %u transmissions",
+             (unsigned)m->type, (unsigned)m->seq, n_ok, n_want, (unsigned)m->tries);
+}
+
+static void ctl_schedule(void *ctx, uint8_t song_id, int64_t epoch_us, int64_t rx_us)
+{
+    (void)ctx;
+    uint32_t bound;
+    orch_clock_to_remote(&s_ctl.clock, rx_us, &bound);
+    if (bound == UINT32_MAX) {
+        ESP_LOGW(TAG, "Performer: clock not synced yet, START uses coarse offset");
+    } else {
+        ESP_LOGI(TAG, "Performer: clock error bound +-%u us", (unsigned)bound);
+    }
+    schedule_start(song_id, epoch_us, rx_us);
+}
+
+// Missed the START (lost frames, reboot): come in where the others are.
+// The engine takes the position itself when it starts rendering.
+static void ctl_play(void *ctx, uint8_t song_id, int64_t epoch_us, uint32_t join_ms)
+{
+    (void)ctx;
+    cancel_scheduled_start();
+    ESP_LOGW(TAG, "Performer: joining song %u in progress, ~%u ms in (state v%u)",
+             (unsigned)song_id, (unsigned)join_ms, (unsigned)s_ctl.follow.state.version);
+    orchestra_play_song_at(song_id, epoch_us);
+}
+
+static void ctl_stop(void *ctx)
+{
+    (void)ctx;
+    ESP_LOGI(TAG, "Performer: STOP (state v%u)", (unsigned)s_ctl.follow.state.version);
+    cancel_scheduled_start();
+    orchestra_stop();
+}
+
+static void ctl_prepare(void *ctx, uint8_t song_id)
+{
+    (void)ctx;
+    ESP_LOGI(TAG, "Song SELECT %u", (unsigned)song_id);
+    orchestra_prepare_song(song_id);
+}
+
+static void ctl_params(void *ctx, const orch_state_t *st)
+{
+    (void)ctx;
+    orchestra_set_volume(synth_gain_from_q15(st->volume_q15));
+    if (st->tempo_pct != ORCH_TEMPO_NOMINAL) {
+        ESP_LOGW(TAG, "State tempo %u%% not supported, playing as written", (unsigned)st->tempo_pct);
+    }
+}
+
+// Heartbeat while following a song: let the audio engine slip samples
+// against I2S clock drift
+static void ctl_timeline(void *ctx, int64_t song_us, int64_t at_us)
+{
+    (void)ctx;
+    if (audio_is_playing()) audio_sync_timeline(song_us, at_us);
+}
+
+static const orch_ctl_hooks_t s_ctl_hooks = {
+    .send       = ctl_send,
+    .next_seq   = ctl_next_seq,
+    .now        = ctl_now,
+    .performers = ctl_performers,
+    .delivered  = ctl_delivered,
+    .schedule   = ctl_schedule,
+    .play       = ctl_play,
+    .stop       = ctl_stop,
+    .prepare    = ctl_prepare,
+    .params     = ctl_params,
+    .timeline   = ctl_timeline,
+};
+
 // ------------------- Worker task -------------------
 
+static void poll_timer_cb(void *arg)
+{
+    (void)arg;
+    espnow_item_t item = { .kind = ITEM_POLL, .rx_us = esp_timer_get_time() };
+    // A full queue is fine: the task polls after every item anyway
+    xQueueSend(s_espnow_queue, &item, 0);
+}
+
+// Snapshot what other tasks read
+static void publish(void)
+{
+    portENTER_CRITICAL(&s_pub_lock);
+    s_state_pub = *orch_ctl_state(&s_ctl);
+    s_clock_pub = s_ctl.clock;
+    s_rtx_pub_n = s_ctl.rtx.n_peers;
+    memcpy(s_rtx_pub, s_ctl.rtx.peers, sizeof(s_rtx_pub[0]) * s_rtx_pub_n);
+    portEXIT_CRITICAL(&s_pub_lock);
+}
+
+static void handle_frame(espnow_item_t *item)
+{
+    wire_frame_t *f = &item->rx.f;
+    f->payload = item->rx.data;
+    rx_latency_record(item->rx_us);
+
+    if (f->type != MSG_CLOCK_REQ && f->type != MSG_CLOCK_RESP && f->type != MSG_ACK) {
+        ESP_LOGI(TAG, "RX: type=%u seq=%u sender=%u (conductor=%d)", (unsigned)f->type,
+                 (unsigned)f->seq, (unsigned)f->sender, (int)s_is_conductor);
+    }
+
+    uint32_t clock_n = s_ctl.sync_accepted + s_ctl.sync_rejected;
+    uint32_t dups    = s_ctl.dups;
+    if (!orch_ctl_handle(&s_ctl, item->rx.src_mac, f, item->rx_us)) {
+        ESP_LOGD(TAG, "Frame type=%u from %u not handled", (unsigned)f->type, (unsigned)f->sender);
+        return;
+    }
+    if (s_ctl.dups != dups) {
+        ESP_LOGD(TAG, "Duplicate type=%u seq=%u ignored", (unsigned)f->type, (unsigned)f->seq);
+    }
+
+    // Performer: a clock response was folded into the estimate
+    uint32_t n = s_ctl.sync_accepted + s_ctl.sync_rejected;
+    if (n != clock_n && n % 10 == 1) {
+        const clock_sync_t *cs = &s_ctl.clock.sync;
+        uint32_t bound = 0;
+        clock_sync_to_remote(cs, item->rx_us, NULL, &bound);
+        ESP_LOGI(TAG, "Clock sync: offset %lld us, drift %+.2f ppm%s, bound +-%u us "
+                 "(min rtt %u us, %u ok / %u outliers)",
+                 (long long)cs->ref_offset_us, (double)cs->drift_ppb / 1000.0,
+                 cs->fitted ? "" : " (unfitted)", (unsigned)bound,
+                 (unsigned)cs->min_rtt_us, (unsigned)s_ctl.sync_accepted, (unsigned)s_ctl.sync_rejected);
+    }
+}
+
 static void espnow_task(void *pvParameters)
 {
-    espnow_msg_t msg;
+    (void)pvParameters;
+    espnow_item_t item;
 
     for (;;) {
-        if (xQueueReceive(s_espnow_queue, &msg, portMAX_DELAY) == pdTRUE) {
-                device_role_t role = device_config_get_role();
-                ESP_LOGI(TAG, "RX: type=%d song=%u sender=%u (role=%d)",
-                     (int)msg.type, (unsigned)msg.song_id, (unsigned)msg.sender_id, (int)role);
-
-            switch (msg.type) {
-            case MSG_SYNC_START:
-                if (role == ROLE_CONDUCTOR) {
-                    // Conductor stays silent; UI only if desired.
-                    ESP_LOGI(TAG, "Conductor: START received (no local audio)");
-                } else {
-                    // Performers schedule playback to conductor timestamp (msg.timestamp is microseconds)
-                    int64_t local_now_us = esp_timer_get_time();
-                    int64_t conductor_ts_us = (int64_t)msg.timestamp;
-                    // Convert conductor_ts to local clock using offset: local_start = conductor_ts - offset
-                    int64_t local_start_us = conductor_ts_us - s_clock_offset_us;
-                    int64_t wait_us = local_start_us - local_now_us;
-                    if (wait_us > 0) {
-                        ESP_LOGI(TAG, "Performer: scheduling START song %u in %lld us", (unsigned)msg.song_id, (long long)wait_us);
-                        /* Use esp_rom_delay_us instead of ets_delay_us to avoid implicit declaration
-                           and use the public ROM API for microsecond delays. */
-                        esp_rom_delay_us((uint32_t)wait_us);
-                    } else {
-                        ESP_LOGI(TAG, "Performer: START song %u immediately (late by %lld us)", (unsigned)msg.song_id, (long long)(-wait_us));
-                    }
-                    orchestra_play_song(msg.song_id);
-                }
-                break;
-
-            case MSG_SYNC_STOP:
-                if (role == ROLE_CONDUCTOR) {
-                    ESP_LOGI(TAG, "Conductor: STOP received (no local audio)");
-                } else {
-                    ESP_LOGI(TAG, "Performer: STOP");
-                    orchestra_stop();
-                }
-                break;
-
-            case MSG_SONG_SELECT:
-                // Optional: preload/update UI
-                ESP_LOGI(TAG, "Song SELECT %u", (unsigned)msg.song_id);
-                break;
-
-            case MSG_HEARTBEAT: {
-                // Heartbeat carries the conductor's esp_timer_get_time() (us). Use it to compute offset.
-                if (role != ROLE_CONDUCTOR) {
-                    uint64_t conductor_now = (uint64_t)msg.timestamp;
-                    uint64_t local_now = (uint64_t)esp_timer_get_time();
-                    int64_t offset = (int64_t)conductor_now - (int64_t)local_now;
-                    // Simple low-pass filter for jitter
-                    s_clock_offset_us = (s_clock_offset_us == 0) ? offset : (s_clock_offset_us * 7 + offset) / 8;
-                    ESP_LOGI(TAG, "Clock offset updated: %lld us", (long long)s_clock_offset_us);
-                }
-                break;
-            }
-
-            default:
-                ESP_LOGW(TAG, "Unknown msg type %d", (int)msg.type);
-                break;
-            }
+        // Everything orch_ctl needs next is due by this time
+        int64_t next = orch_ctl_poll(&s_ctl);
+        publish();
+        esp_timer_stop(s_poll_timer);
+        if (next != INT64_MAX) {
+            int64_t now = esp_timer_get_time();
+            esp_timer_start_once(s_poll_timer, next > now ? (uint64_t)(next - now) : 1);
+        }
+
+        if (xQueueReceive(s_espnow_queue, &item, portMAX_DELAY) != pdTRUE) continue;
+
+        switch (item.kind) {
+        case ITEM_FRAME:
+            handle_frame(&item);
+            break;
+
+        case ITEM_START_DUE:
+            start_due(&item);
+            break;
+
+        case ITEM_COMMAND: {
+            uint64_t ts_us;
+            size_t n = orch_ctl_command(&s_ctl, item.cmd.type, item.cmd.song_id, &ts_us);
+            ESP_LOGI(TAG, "Broadcasted msg type=%d song=%u ts=%llu, %u peers to ACK",
+                     (int)item.cmd.type, (unsigned)item.cmd.song_id, (unsigned long long)ts_us, (unsigned)n);
+            break;
+        }
+
+        case ITEM_VOLUME:
+            orch_ctl_set_volume(&s_ctl, item.volume_q15);
+            break;
+
+        case ITEM_POLL:
+            break;
         }
     }
 }
 
 // ------------------- Public API -------------------
 
+void espnow_set_transport(transport_t *t)
+{
+    s_tp = t;
+}
+
+void espnow_own_mac(uint8_t *mac)
+{
+    transport_own_addr(s_tp, mac);
+}
+
 esp_err_t espnow_init(uint8_t id)
 {
+    if (!s_tp) s_tp = transport_espnow();
+
     // Use the id provided by the caller (caller should pass role-based id).
     // Two-mode behavior when id == 0:
     //  - If the device already has a configured role (device_config_get_role() != ROLE_UNKNOWN),
@@ -179,8 +546,8 @@ esp_err_t espnow_init(uint8_t id)
             s_device_id = (uint8_t)cfg_role;
             ESP_LOGI(TAG, "espnow_init: id==0, using configured role as device id=%u (role=%d)", (unsigned)s_device_id, (int)cfg_role);
         } else {
-            uint8_t mac[6];
-            esp_read_mac(mac, ESP_MAC_WIFI_STA);
+            uint8_t mac[TRANSPORT_ADDR_LEN];
+            transport_own_addr(s_tp, mac);
             // Use last MAC byte to derive a stable but simple id in 1..4
             uint8_t derived = (mac[5] % 4) + 1u;
             s_device_id = derived;
@@ -199,91 +566,158 @@ esp_err_t espnow_init(uint8_t id)
     }
     ESP_ERROR_CHECK(err);
 
-    // WiFi (STA), no AP connection needed
-    ESP_ERROR_CHECK(esp_netif_init());
-    // If the default loop already exists, this will return INVALID_STATE — ignore it.
-    if (esp_event_loop_create_default() != ESP_OK) {
-        // already created, fine
+    // Radio up; every frame from here on comes through espnow_recv_cb
+    transport_set_rx(s_tp, espnow_recv_cb, NULL);
+    transport_set_tx_done(s_tp, espnow_tx_done_cb, NULL);
+    err = transport_start(s_tp);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Transport '%s' failed to start (%d)", s_tp->name, (int)err);
+        return err;
     }
 
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
-    ESP_ERROR_CHECK(esp_wifi_set_storage(WIFI_STORAGE_RAM));
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_start());
-
-    // ESP-NOW core
-    ESP_ERROR_CHECK(esp_now_init());
-    ESP_ERROR_CHECK(esp_now_register_send_cb(espnow_send_cb));
-    ESP_ERROR_CHECK(esp_now_register_recv_cb(espnow_recv_cb));
-
-    // Add broadcast peer
-    esp_now_peer_info_t peer = {0};
-    memcpy(peer.peer_addr, s_broadcast_mac, ESP_NOW_ETH_ALEN);
-    peer.ifidx   = WIFI_IF_STA;
-    peer.channel = 0;
-    peer.encrypt = false;
-    esp_err_t add_peer_res = esp_now_add_peer(&peer);
-    if (add_peer_res != ESP_OK && add_peer_res != ESP_ERR_ESPNOW_EXIST) {
-        ESP_ERROR_CHECK(add_peer_res);
-    }
+
+    // One-shot timers for scheduled starts and protocol polls (dispatched
+    // from the esp_timer task, which only posts to espnow_task)
+    const esp_timer_create_args_t start_timer_args = {
+        .callback = start_timer_cb,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "sync_start",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&start_timer_args, &s_start_timer));
+    const esp_timer_create_args_t poll_timer_args = {
+        .callback = poll_timer_cb,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "ctrl_poll",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&poll_timer_args, &s_poll_timer));
+
+    // Random first seq so a rebooted sender does not collide with what
+    // receivers remember for de-dup
+    s_tx_seq = (uint16_t)esp_random();
+
+    // Conductor: heartbeats, retries and clock answers; performers: clock
+    // polls and following the state
+    s_is_conductor = (device_config_get_role() == ROLE_CONDUCTOR);
+    orch_ctl_init(&s_ctl, &s_ctl_hooks, NULL, s_device_id, s_is_conductor, (uint16_t)esp_random(),
+                  (uint16_t)synth_gain_q15(ORCHESTRA_DEFAULT_VOLUME));
+    publish();
 
     // Control queue + task
-    s_espnow_queue = xQueueCreate(10, sizeof(espnow_msg_t));
+    s_espnow_queue = xQueueCreate(10, sizeof(espnow_item_t));
     if (!s_espnow_queue) {
         ESP_LOGE(TAG, "Failed to create ESP-NOW control queue");
         return ESP_FAIL;
     }
     xTaskCreate(espnow_task, "espnow_task", 4096, NULL, 10, NULL);
 
-    // If this device is the conductor, start a heartbeat task to broadcast clock
-    if (device_config_get_role() == ROLE_CONDUCTOR) {
-        // Heartbeat task: send conductor timestamp every 500 ms
-        extern void espnow_heartbeat_task(void *pv);
-        xTaskCreate(espnow_heartbeat_task, "esp_heartbeat", 2048, NULL, 5, &s_heartbeat_task);
-    }
+    // Peer discovery: tracks which performers are online (and assigns roles)
+    ESP_ERROR_CHECK(espnow_discovery_init());
+    (void)espnow_discovery_start();
 
-    ESP_LOGI(TAG, "ESP-NOW ready (device_id=%u)", (unsigned)s_device_id);
+    // Song library distribution (conductor pushes, performers store)
+    ESP_ERROR_CHECK(song_sync_init());
+
+    ESP_LOGI(TAG, "ESP-NOW ready (device_id=%u, transport %s)", (unsigned)s_device_id, s_tp->name);
     return ESP_OK;
 }
 
-esp_err_t espnow_broadcast(msg_type_t type, uint8_t song_id)
+uint16_t espnow_frame_begin(wire_writer_t *w, uint8_t *buf, size_t cap, uint8_t type)
 {
-    // Use microsecond timestamps (esp_timer) for higher precision sync.
-    uint64_t ts_us = esp_timer_get_time();
-    if (type == MSG_SYNC_START) {
-        const uint64_t SYNC_LEAD_US = 200000; // 200 ms lead
-        ts_us += SYNC_LEAD_US;
+    uint16_t seq = espnow_next_seq();
+    wire_begin(w, buf, cap, type, WIRE_F_NONE, s_device_id, seq);
+    return seq;
+}
+
+esp_err_t espnow_frame_send(const uint8_t *mac, wire_writer_t *w)
+{
+    size_t len = wire_finish(w);
+    if (len == 0) {
+        ESP_LOGE(TAG, "Frame overflow (type=%u)", (unsigned)w->buf[2]);
+        return ESP_ERR_INVALID_SIZE;
     }
+    return transport_send(s_tp, mac, w->buf, len) == 0 ? ESP_OK : ESP_FAIL;
+}
 
-    espnow_msg_t msg = {
-        .type      = type,
-        .song_id   = song_id,
-        .timestamp = ts_us,
-        .sender_id = s_device_id
+// The command is built and sent on espnow_task, so the START lead is
+// counted from there and the state only ever changes on one task
+esp_err_t espnow_broadcast(msg_type_t type, uint8_t song_id)
+{
+    if (!s_espnow_queue) return ESP_ERR_INVALID_STATE;
+    espnow_item_t item = {
+        .kind  = ITEM_COMMAND,
+        .cmd   = { .type = (uint8_t)type, .song_id = song_id },
+        .rx_us = esp_timer_get_time(),
     };
+    if (xQueueSend(s_espnow_queue, &item, pdMS_TO_TICKS(50)) != pdTRUE) {
+        ESP_LOGW(TAG, "Control queue full, msg type=%d song=%u not sent", (int)type, (unsigned)song_id);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
 
-    esp_err_t res = esp_now_send(s_broadcast_mac, (const uint8_t *)&msg, sizeof(msg));
-    if (res == ESP_OK) {
-        ESP_LOGI(TAG, "Broadcasted msg type=%d song=%u (sender=%u) OK", (int)type, (unsigned)song_id, (unsigned)msg.sender_id);
-    } else {
-        ESP_LOGW(TAG, "Broadcast failed msg type=%d song=%u (err=%d)", (int)type, (unsigned)song_id, (int)res);
+size_t espnow_get_delivery_report(reliable_peer_stats_t *out, size_t max)
+{
+    size_t n = 0;
+    portENTER_CRITICAL(&s_pub_lock);
+    for (; n < s_rtx_pub_n && n < max; ++n) out[n] = s_rtx_pub[n];
+    portEXIT_CRITICAL(&s_pub_lock);
+    return n;
+}
+
+void espnow_log_delivery_report(void)
+{
+    reliable_peer_stats_t st[RELIABLE_MAX_PEERS];
+    size_t n = espnow_get_delivery_report(st, RELIABLE_MAX_PEERS);
+    ESP_LOGI(TAG, "Control delivery report (%u peers):", (unsigned)n);
+    for (size_t i = 0; i < n; ++i) {
+        const reliable_peer_stats_t *p = &st[i];
+        ESP_LOGI(TAG, "  %-8s %u/%u delivered (%.1f%%), %u missed, %u retries, latency avg %lld us max %lld us",
+                 device_config_get_role_name(espnow_discovery_get_peer_role(p->mac)),
+                 (unsigned)p->delivered, (unsigned)p->sent,
+                 p->sent ? 100.0 * p->delivered / p->sent : 0.0, (unsigned)p->missed,
+                 (unsigned)p->retries,
+                 (long long)(p->delivered ? p->lat_sum_us / p->delivered : 0), (long long)p->lat_max_us);
     }
-    return res;
-}
-
-// Heartbeat task implementation (runs only on conductor)
-void espnow_heartbeat_task(void *pv)
-{
-    (void)pv;
-    const TickType_t interval = pdMS_TO_TICKS(500);
-    while (1) {
-        espnow_msg_t hb = {0};
-        hb.type = MSG_HEARTBEAT;
-        hb.song_id = 0;
-        hb.timestamp = (uint64_t)esp_timer_get_time();
-        hb.sender_id = s_device_id;
-        esp_now_send(s_broadcast_mac, (const uint8_t *)&hb, sizeof(hb));
-        vTaskDelay(interval);
+}
+
+void espnow_state_set_volume(float volume)
+{
+    if (!s_is_conductor || !s_espnow_queue) return;
+    espnow_item_t item = {
+        .kind       = ITEM_VOLUME,
+        .volume_q15 = (uint16_t)synth_gain_q15(volume),
+        .rx_us      = esp_timer_get_time(),
+    };
+    if (xQueueSend(s_espnow_queue, &item, pdMS_TO_TICKS(50)) != pdTRUE) {
+        ESP_LOGW(TAG, "Control queue full, volume change not sent");
     }
 }
+
+void espnow_get_state(orch_state_t *out)
+{
+    portENTER_CRITICAL(&s_pub_lock);
+    *out = s_state_pub;
+    portEXIT_CRITICAL(&s_pub_lock);
+}
+
+void espnow_get_rx_latency(espnow_rx_latency_t *out)
+{
+    *out = s_rx_lat;
+}
+
+int64_t conductor_time_now(uint32_t *err_bound_us)
+{
+    int64_t local = esp_timer_get_time();
+
+    if (s_is_conductor) {
+        if (err_bound_us) *err_bound_us = 0;
+        return local;
+    }
+
+    portENTER_CRITICAL(&s_pub_lock);
+    orch_clock_t ck = s_clock_pub;
+    portEXIT_CRITICAL(&s_pub_lock);
+
+    // Two-way estimate, or the coarse heartbeat offset (bound UINT32_MAX)
+    return orch_clock_to_remote(&ck, local, err_bound_us);
+}
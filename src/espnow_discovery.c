@@ -1,214 +1,109 @@
-// src/espnow_discovery.c
+// src/espnow_discovery.c — device glue for disco.h
 #include <string.h>
 #include <stdio.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "freertos/semphr.h"
-#include "esp_now.h"
-#include "esp_wifi.h"
 #include "esp_log.h"
-#include "esp_mac.h"
 #include "esp_timer.h"
 
 #include "espnow_discovery.h"
+#include "espnow_comm.h"      // espnow_send, espnow_next_seq, espnow_ensure_peer
 #include "device_config.h"
 
 static const char *TAG = "ESPNOW_DISCO";
 
-#define MAX_PEERS               5
-#define HEARTBEAT_INTERVAL_MS   2000
-#define PEER_TIMEOUT_MS         10000
+// Largest discovery payload (wire_disco_t with a full name)
+#define DISCO_MAX_PAYLOAD   48
 
-// Broadcast MAC
-static const uint8_t kBroadcastMac[ESP_NOW_ETH_ALEN] =
-        {0xFF,0xFF,0xFF,0xFF,0xFF,0xFF};
+// Queue item: a discovery frame copied out of the receive callback
+typedef struct {
+    wire_frame_t f;               // payload re-pointed at data on the task
+    uint8_t      src_mac[TRANSPORT_ADDR_LEN];
+    int64_t      rx_us;
+    uint8_t      data[DISCO_MAX_PAYLOAD];
+} disco_rx_t;
 
-// Peer devices list
-static peer_device_t peers[MAX_PEERS];
-static uint8_t       peer_count   = 0;
-static SemaphoreHandle_t peers_mutex;
+// Peer table and handshake. Owned by discovery_task; every access, from
+// the task or the public API, holds s_disco_mutex.
+static disco_t           s_disco;
+static SemaphoreHandle_t s_disco_mutex;
 
-// Our role
-static bool          s_is_conductor = false;
-
-// Queue of discovery messages (fed by espnow_discovery_recv_cb, serviced here)
+// Queue of discovery frames (fed by espnow_discovery_handle_frame, serviced here)
 static QueueHandle_t s_discovery_queue = NULL;
 
+// ────────────────────────────────────────────────────────────────────────────
+// disco.h hooks (called with s_disco_mutex held)
 // ────────────────────────────────────────────────────────────────────────────
 
-static void get_own_mac(uint8_t *mac)
+static bool hook_send(void *ctx, const uint8_t *dst, const uint8_t *frame, size_t len)
 {
-    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    (void)ctx;
+    return espnow_send(dst, frame, len) == ESP_OK;
 }
 
-static peer_device_t* find_peer_by_mac(const uint8_t *mac)
+static uint16_t hook_next_seq(void *ctx)
 {
-    for (int i = 0; i < peer_count; i++) {
-        if (memcmp(peers[i].mac_address, mac, ESP_NOW_ETH_ALEN) == 0) {
-            return &peers[i];
-        }
-    }
-    return NULL;
+    (void)ctx;
+    return espnow_next_seq();
 }
 
-static esp_err_t add_or_update_peer(const uint8_t *mac, device_role_t role, const char *name)
+static void hook_peer_added(void *ctx, const uint8_t mac[6])
 {
-    xSemaphoreTake(peers_mutex, portMAX_DELAY);
-
-    peer_device_t *peer = find_peer_by_mac(mac);
-
-    if (!peer && peer_count < MAX_PEERS) {
-        // Add to our local table
-        peer = &peers[peer_count++];
-        memcpy(peer->mac_address, mac, ESP_NOW_ETH_ALEN);
-
-        // Ensure the peer exists in ESP-NOW peer list, ignore EXIST
-        esp_now_peer_info_t pi = {0};
-        memcpy(pi.peer_addr, mac, ESP_NOW_ETH_ALEN);
-        pi.channel = 0;         // keep current channel
-        pi.encrypt = false;
-        (void)esp_now_add_peer(&pi);
-
-        ESP_LOGI(TAG, "Peer added: %02X:%02X:%02X:%02X:%02X:%02X",
-                 mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
-    }
-
-    if (peer) {
-        peer->role = role;
-        peer->is_online = true;
-        peer->last_seen = xTaskGetTickCount();
-        if (name) {
-            strncpy(peer->name, name, sizeof(peer->name) - 1);
-            peer->name[sizeof(peer->name) - 1] = '\0';
-        }
-    }
-
-    xSemaphoreGive(peers_mutex);
-    return ESP_OK;
+    (void)ctx;
+    // Ensure the peer exists in the ESP-NOW peer list so unicast works
+    espnow_ensure_peer(mac);
+    ESP_LOGI(TAG, "Peer added: %02X:%02X:%02X:%02X:%02X:%02X",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
 }
 
-static esp_err_t send_discovery_msg(const uint8_t *dest_mac, discovery_msg_type_t type)
+static void set_name(device_role_t role)
 {
-    discovery_msg_t msg = {0};
-    msg.type = type;
-    msg.role = device_config_get_role();
-    msg.timestamp = (uint32_t)(esp_timer_get_time() / 1000ULL);  // μs → ms
-    get_own_mac(msg.mac_address);
-    snprintf(msg.device_name, sizeof(msg.device_name), "M5GO-%s",
-             device_config_get_role_name(msg.role));
-
-    return esp_now_send(dest_mac, (const uint8_t *)&msg, sizeof(msg));
+    snprintf(s_disco.name, sizeof(s_disco.name), "M5GO-%s", device_config_get_role_name(role));
 }
 
-static void handle_discovery_msg(const uint8_t *src_mac, const discovery_msg_t *msg)
+static void hook_role_set(void *ctx, uint8_t role)
 {
-    uint8_t own_mac[6];
-    get_own_mac(own_mac);
-    if (memcmp(src_mac, own_mac, ESP_NOW_ETH_ALEN) == 0) {
-        return; // ignore own messages
-    }
+    (void)ctx;
+    device_config_set_role((device_role_t)role);
+    set_name((device_role_t)role);
+    ESP_LOGI(TAG, "Role assigned: %s", device_config_get_role_name((device_role_t)role));
+}
 
-    ESP_LOGI(TAG, "DISC: type=%d from %02X:%02X:%02X:%02X:%02X:%02X role=%d",
-             msg->type, src_mac[0], src_mac[1], src_mac[2],
-             src_mac[3], src_mac[4], src_mac[5], (int)msg->role);
-
-    switch (msg->type) {
-        case DISCO_MSG_ANNOUNCE:
-            // add/update peer
-            add_or_update_peer(msg->mac_address, msg->role, msg->device_name);
-
-            // Conductor assigns role to unknowns
-            if (s_is_conductor && msg->role == ROLE_UNKNOWN) {
-                device_role_t assign = ROLE_UNKNOWN;
-                for (int r = ROLE_PART_1; r <= ROLE_PART_4; ++r) {
-                    bool taken = false;
-                    for (int i = 0; i < peer_count; ++i) {
-                        if (peers[i].role == (device_role_t)r) { taken = true; break; }
-                    }
-                    if (!taken) { assign = (device_role_t)r; break; }
-                }
-                if (assign != ROLE_UNKNOWN) {
-                    (void)espnow_discovery_assign_role(msg->mac_address, assign);
-                    ESP_LOGI(TAG, "Assigned role %s to %02X:%02X:%02X:%02X:%02X:%02X",
-                             device_config_get_role_name(assign),
-                             msg->mac_address[0], msg->mac_address[1], msg->mac_address[2],
-                             msg->mac_address[3], msg->mac_address[4], msg->mac_address[5]);
-                }
-            }
-            break;
-
-        case DISCO_MSG_ROLE_REQUEST:
-            if (s_is_conductor) {
-                // same assignment policy as above
-                device_role_t assign = ROLE_UNKNOWN;
-                for (int r = ROLE_PART_1; r <= ROLE_PART_4; ++r) {
-                    bool taken = false;
-                    for (int i = 0; i < peer_count; ++i) {
-                        if (peers[i].role == (device_role_t)r) { taken = true; break; }
-                    }
-                    if (!taken) { assign = (device_role_t)r; break; }
-                }
-                if (assign != ROLE_UNKNOWN) {
-                    (void)espnow_discovery_assign_role(msg->mac_address, assign);
-                }
-            }
-            break;
-
-        case DISCO_MSG_ROLE_ASSIGN:
-            // If we’re unknown, accept assigned role & re-announce
-            if (device_config_get_role() == ROLE_UNKNOWN) {
-                device_config_set_role(msg->role);
-                (void)send_discovery_msg(kBroadcastMac, DISCO_MSG_ANNOUNCE);
-            }
-            break;
-
-        case DISCO_MSG_ROLL_CALL:
-            // Respond only to sender (unicast reply)
-            (void)send_discovery_msg(src_mac, DISCO_MSG_PRESENT);
-            break;
-
-        case DISCO_MSG_PRESENT:
-            // mark as online
-            add_or_update_peer(msg->mac_address, msg->role, msg->device_name);
-            break;
-
-        case DISCO_MSG_READY:
-            // optional “ready” state
-            add_or_update_peer(msg->mac_address, msg->role, msg->device_name);
-            break;
-
-        default:
-            break;
-    }
+static void hook_assigned(void *ctx, const uint8_t mac[6], uint8_t role)
+{
+    (void)ctx;
+    ESP_LOGI(TAG, "Assigned role %s to %02X:%02X:%02X:%02X:%02X:%02X",
+             device_config_get_role_name((device_role_t)role),
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
 }
 
+static const disco_hooks_t s_hooks = {
+    .send       = hook_send,
+    .next_seq   = hook_next_seq,
+    .peer_added = hook_peer_added,
+    .role_set   = hook_role_set,
+    .assigned   = hook_assigned,
+};
+
 // ────────────────────────────────────────────────────────────────────────────
 // Public recv hook (called from the unified recv cb in espnow_comm.c)
 // ────────────────────────────────────────────────────────────────────────────
-void espnow_discovery_recv_cb(const esp_now_recv_info_t *recv_info,
-                              const uint8_t *data, int len)
+void espnow_discovery_handle_frame(const uint8_t *src_mac, const wire_frame_t *frame, int64_t rx_us)
 {
-    if (len != (int)sizeof(discovery_msg_t)) return;
-
-    discovery_msg_t msg;
-    memcpy(&msg, data, sizeof(msg));
-
-    // feed queue; src MAC is in recv_info->src_addr
-    if (s_discovery_queue) {
-        // Pack both src MAC and message into one struct to pass via queue
-        typedef struct {
-            uint8_t src_mac[ESP_NOW_ETH_ALEN];
-            discovery_msg_t msg;
-        } disco_q_t;
-
-        disco_q_t q = {0};
-        memcpy(q.src_mac, recv_info->src_addr, ESP_NOW_ETH_ALEN);
-        q.msg = msg;
+    if (!s_discovery_queue) return;
+    if (frame->len > DISCO_MAX_PAYLOAD) {
+        ESP_LOGW(TAG, "oversized discovery frame type=0x%02X len=%u", frame->type, (unsigned)frame->len);
+        return;
+    }
 
-        if (xQueueSend(s_discovery_queue, &q, 0) != pdTRUE) {
-            ESP_LOGW(TAG, "discovery queue full");
-        }
+    // src MAC comes from the radio, not the payload
+    disco_rx_t item = { .f = *frame, .rx_us = rx_us };
+    memcpy(item.src_mac, src_mac, TRANSPORT_ADDR_LEN);
+    memcpy(item.data, frame->payload, frame->len);
+    if (xQueueSend(s_discovery_queue, &item, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "discovery queue full");
     }
 }
 
@@ -217,37 +112,29 @@ void espnow_discovery_recv_cb(const esp_now_recv_info_t *recv_info,
 // ────────────────────────────────────────────────────────────────────────────
 static void discovery_task(void *arg)
 {
-    typedef struct {
-        uint8_t src_mac[ESP_NOW_ETH_ALEN];
-        discovery_msg_t msg;
-    } disco_q_t;
-
-    disco_q_t item;
-
-    TickType_t last_hb = xTaskGetTickCount();
+    (void)arg;
+    disco_rx_t item;
+    int64_t next = 0;
 
     while (1) {
-        // Receive with heartbeat timeout
-        if (xQueueReceive(s_discovery_queue, &item,
-                          pdMS_TO_TICKS(HEARTBEAT_INTERVAL_MS)) == pdTRUE) {
-            handle_discovery_msg(item.src_mac, &item.msg);
+        // Receive until the next announce / role request is due
+        int64_t    now  = esp_timer_get_time();
+        TickType_t wait = next > now ? pdMS_TO_TICKS((next - now) / 1000) + 1 : 0;
+        if (xQueueReceive(s_discovery_queue, &item, wait) == pdTRUE) {
+            item.f.payload = item.data;
+            ESP_LOGI(TAG, "DISC: type=%d from %02X:%02X:%02X:%02X:%02X:%02X",
+                     (int)(item.f.type - WIRE_T_DISCO), item.src_mac[0], item.src_mac[1],
+                     item.src_mac[2], item.src_mac[3], item.src_mac[4], item.src_mac[5]);
+
+            xSemaphoreTake(s_disco_mutex, portMAX_DELAY);
+            bool ok = disco_handle(&s_disco, item.src_mac, &item.f, item.rx_us);
+            xSemaphoreGive(s_disco_mutex);
+            if (!ok) ESP_LOGD(TAG, "discovery frame type=0x%02X not handled", item.f.type);
         }
 
-        // Periodic announce/heartbeat
-        TickType_t now = xTaskGetTickCount();
-        if (now - last_hb >= pdMS_TO_TICKS(HEARTBEAT_INTERVAL_MS)) {
-            (void)send_discovery_msg(kBroadcastMac, DISCO_MSG_ANNOUNCE);
-            last_hb = now;
-
-            // Cull timeouts
-            xSemaphoreTake(peers_mutex, portMAX_DELAY);
-            for (int i = 0; i < peer_count; ++i) {
-                if (now - peers[i].last_seen > pdMS_TO_TICKS(PEER_TIMEOUT_MS)) {
-                    peers[i].is_online = false;
-                }
-            }
-            xSemaphoreGive(peers_mutex);
-        }
+        xSemaphoreTake(s_disco_mutex, portMAX_DELAY);
+        next = disco_poll(&s_disco, esp_timer_get_time());
+        xSemaphoreGive(s_disco_mutex);
     }
 }
 
@@ -257,80 +144,104 @@ static void discovery_task(void *arg)
 
 esp_err_t espnow_discovery_init(void)
 {
-    peers_mutex = xSemaphoreCreateMutex();
-    if (!peers_mutex) {
+    s_disco_mutex = xSemaphoreCreateMutex();
+    if (!s_disco_mutex) {
         ESP_LOGE(TAG, "mutex create failed");
         return ESP_FAIL;
     }
 
-    s_discovery_queue = xQueueCreate(16, sizeof(struct {
-        uint8_t src_mac[ESP_NOW_ETH_ALEN];
-        discovery_msg_t msg;
-    }));
+    s_discovery_queue = xQueueCreate(16, sizeof(disco_rx_t));
     if (!s_discovery_queue) {
         ESP_LOGE(TAG, "queue create failed");
         return ESP_FAIL;
     }
 
-    s_is_conductor = (device_config_get_role() == ROLE_CONDUCTOR);
+    uint8_t mac[TRANSPORT_ADDR_LEN];
+    espnow_own_mac(mac);
+    device_role_t role = device_config_get_role();
+    disco_init(&s_disco, &s_hooks, NULL, espnow_device_id(), mac, (uint8_t)role, NULL);
+    set_name(role);
 
-    xTaskCreate(discovery_task, "discovery_task", 4096, NULL, 9, NULL);
-
-    ESP_LOGI(TAG, "Discovery ready (conductor=%d)", (int)s_is_conductor);
+    ESP_LOGI(TAG, "Discovery ready (conductor=%d)", (int)(role == ROLE_CONDUCTOR));
     return ESP_OK;
 }
 
 esp_err_t espnow_discovery_start(void)
 {
-    // Kick things off
-    (void)send_discovery_msg(kBroadcastMac, DISCO_MSG_ANNOUNCE);
+    // Kick things off; the task requests a role shortly after if we need one
+    xSemaphoreTake(s_disco_mutex, portMAX_DELAY);
+    disco_start(&s_disco, esp_timer_get_time());
+    xSemaphoreGive(s_disco_mutex);
 
-    // If we need a role, request one
-    if (device_config_get_role() == ROLE_UNKNOWN) {
-        vTaskDelay(pdMS_TO_TICKS(100));
-        (void)send_discovery_msg(kBroadcastMac, DISCO_MSG_ROLE_REQUEST);
-    }
+    xTaskCreate(discovery_task, "discovery_task", 4096, NULL, 9, NULL);
 
     ESP_LOGI(TAG, "Discovery started");
     return ESP_OK;
 }
 
+static esp_err_t send_msg(const uint8_t *dst, discovery_msg_type_t type)
+{
+    xSemaphoreTake(s_disco_mutex, portMAX_DELAY);
+    bool ok = disco_send(&s_disco, dst, type, esp_timer_get_time());
+    xSemaphoreGive(s_disco_mutex);
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
 esp_err_t espnow_discovery_announce(void)
 {
-    return send_discovery_msg(kBroadcastMac, DISCO_MSG_ANNOUNCE);
+    return send_msg(NULL, DISCO_MSG_ANNOUNCE);
 }
 
 esp_err_t espnow_discovery_request_role(void)
 {
-    return send_discovery_msg(kBroadcastMac, DISCO_MSG_ROLE_REQUEST);
+    return send_msg(NULL, DISCO_MSG_ROLE_REQUEST);
 }
 
 esp_err_t espnow_discovery_assign_role(const uint8_t *mac, device_role_t role)
 {
-    discovery_msg_t msg = {0};
-    msg.type = DISCO_MSG_ROLE_ASSIGN;
-    msg.role = role;
-    msg.timestamp = (uint32_t)(esp_timer_get_time() / 1000ULL);
-    get_own_mac(msg.mac_address);
-    return esp_now_send(mac, (const uint8_t *)&msg, sizeof(msg));
+    xSemaphoreTake(s_disco_mutex, portMAX_DELAY);
+    bool ok = disco_assign(&s_disco, mac, (uint8_t)role, esp_timer_get_time());
+    xSemaphoreGive(s_disco_mutex);
+    return ok ? ESP_OK : ESP_FAIL;
 }
 
 esp_err_t espnow_discovery_roll_call(void)
 {
-    return send_discovery_msg(kBroadcastMac, DISCO_MSG_ROLL_CALL);
+    return send_msg(NULL, DISCO_MSG_ROLL_CALL);
 }
 
 uint8_t espnow_discovery_get_online_count(void)
 {
-    uint8_t cnt = 0;
-    xSemaphoreTake(peers_mutex, portMAX_DELAY);
-    for (int i = 0; i < peer_count; ++i) {
-        if (peers[i].is_online) ++cnt;
-    }
-    xSemaphoreGive(peers_mutex);
+    xSemaphoreTake(s_disco_mutex, portMAX_DELAY);
+    uint8_t cnt = disco_online_count(&s_disco);
+    xSemaphoreGive(s_disco_mutex);
     return cnt;
 }
 
+uint8_t espnow_discovery_get_online_part_mask(void)
+{
+    xSemaphoreTake(s_disco_mutex, portMAX_DELAY);
+    uint8_t mask = disco_online_part_mask(&s_disco);
+    xSemaphoreGive(s_disco_mutex);
+    return mask;
+}
+
+size_t espnow_discovery_get_online_performers(uint8_t (*macs)[6], size_t max)
+{
+    xSemaphoreTake(s_disco_mutex, portMAX_DELAY);
+    size_t n = disco_online_performers(&s_disco, macs, max);
+    xSemaphoreGive(s_disco_mutex);
+    return n;
+}
+
+device_role_t espnow_discovery_get_peer_role(const uint8_t *mac)
+{
+    xSemaphoreTake(s_disco_mutex, portMAX_DELAY);
+    device_role_t role = (device_role_t)disco_peer_role(&s_disco, mac);
+    xSemaphoreGive(s_disco_mutex);
+    return role;
+}
+
 // For a 5-device orchestra (1 conductor + 4 performers), we consider “ready”
 // when we see at least 4 peers online (others) — tweak if you prefer exact roles.
 bool espnow_discovery_all_devices_ready(void)
@@ -338,7 +249,11 @@ bool espnow_discovery_all_devices_ready(void)
     return espnow_discovery_get_online_count() >= 4;
 }
 
-const peer_device_t* espnow_discovery_get_peers(void)
+size_t espnow_discovery_get_peers(peer_device_t *out, size_t max)
 {
-    return peers;
+    xSemaphoreTake(s_disco_mutex, portMAX_DELAY);
+    size_t n = s_disco.n_peers < max ? s_disco.n_peers : max;
+    memcpy(out, s_disco.peers, n * sizeof(*out));
+    xSemaphoreGive(s_disco_mutex);
+    return n;
 }
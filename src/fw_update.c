@@ -0,0 +1,196 @@
+// src/fw_update.c — firmware into the inactive OTA slot, sent and received over ESP-NOW
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_app_desc.h"
+#include "esp_image_format.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+
+#include "fw_update.h"
+#include "song_sync.h"
+
+static const char *TAG = "FW_UPDATE";
+
+#define FW_RESTART_DELAY_US  1500000   // let the DONE STATUS reach the conductor first
+
+static const esp_partition_t *s_part = NULL;   // performer: slot being written
+static esp_ota_handle_t       s_ota;
+static bool                   s_open = false;
+static esp_timer_handle_t     s_restart = NULL;
+
+static const uint8_t         *s_staged = NULL; // conductor: mapping of the staged image
+static size_t                 s_staged_len = 0;
+static esp_partition_mmap_handle_t s_staged_map;
+
+// ----------------------
+// Performer: blob sink
+// ----------------------
+static void restart_cb(void *arg)
+{
+    (void)arg;
+    esp_restart();
+}
+
+static bool sink_begin(void *ctx, uint8_t kind, uint32_t len)
+{
+    (void)ctx;
+    (void)kind;
+    if (s_open) {
+        esp_ota_abort(s_ota);   // the hash failed: start over on a fresh erase
+        s_open = false;
+    }
+    s_part = esp_ota_get_next_update_partition(NULL);
+    if (!s_part || len > s_part->size) {
+        ESP_LOGW(TAG, "No OTA slot for a %u KB image", (unsigned)(len / 1024));
+        return false;
+    }
+    // Erases the image's length of the slot up front, so chunks can land in any order
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = esp_ota_begin(s_part, len, &s_ota);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_ota_begin on '%s' failed (%s)", s_part->label, esp_err_to_name(err));
+        return false;
+    }
+    s_open = true;
+    ESP_LOGI(TAG, "Receiving %u KB firmware into '%s' (erased in %lld ms)", (unsigned)(len / 1024),
+             s_part->label, (long long)((esp_timer_get_time() - t0) / 1000));
+    return true;
+}
+
+static bool sink_write(void *ctx, uint32_t off, const uint8_t *data, size_t len)
+{
+    (void)ctx;
+    return s_open && esp_ota_write_with_offset(s_ota, data, len, off) == ESP_OK;
+}
+
+static bool sink_read(void *ctx, uint32_t off, uint8_t *data, size_t len)
+{
+    (void)ctx;
+    return s_open && esp_partition_read(s_part, off, data, len) == ESP_OK;
+}
+
+static void sink_abort(void *ctx)
+{
+    (void)ctx;
+    if (!s_open) return;
+    esp_ota_abort(s_ota);
+    s_open = false;
+}
+
+static bool sink_commit(void *ctx, uint8_t kind, uint32_t len)
+{
+    (void)ctx;
+    (void)kind;
+    // The hash matched; esp_ota_end() also checks the image format and digest
+    s_open = false;
+    esp_err_t err = esp_ota_end(s_ota);
+    if (err == ESP_OK) err = esp_ota_set_boot_partition(s_part);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Firmware not installed (%s)", esp_err_to_name(err));
+        return false;
+    }
+
+    esp_app_desc_t desc;
+    if (esp_ota_get_partition_description(s_part, &desc) == ESP_OK) {
+        ESP_LOGI(TAG, "Firmware %s (%u KB) installed in '%s', restarting", desc.version,
+                 (unsigned)(len / 1024), s_part->label);
+    }
+    if (!s_restart) {
+        const esp_timer_create_args_t args = { .callback = restart_cb, .name = "fw_restart" };
+        if (esp_timer_create(&args, &s_restart) != ESP_OK) esp_restart();
+    }
+    esp_timer_start_once(s_restart, FW_RESTART_DELAY_US);
+    return true;
+}
+
+static const blob_sink_t k_sink = {
+    .begin  = sink_begin,
+    .write  = sink_write,
+    .read   = sink_read,
+    .commit = sink_commit,
+    .abort  = sink_abort,
+};
+
+const blob_sink_t *fw_update_sink(void)
+{
+    return &k_sink;
+}
+
+// ----------------------
+// Conductor: staged image
+// ----------------------
+bool fw_update_staged_image(const uint8_t **img, size_t *len)
+{
+    if (!s_staged) {
+        const esp_partition_t *part = esp_ota_get_next_update_partition(NULL);
+        if (!part) return false;
+
+        // A complete, checked image; its length includes the appended digest
+        esp_partition_pos_t pos = { .offset = part->address, .size = part->size };
+        esp_image_metadata_t meta;
+        if (esp_image_verify(ESP_IMAGE_VERIFY_SILENT, &pos, &meta) != ESP_OK) return false;
+
+        esp_app_desc_t desc;
+        if (esp_ota_get_partition_description(part, &desc) != ESP_OK
+            || strncmp(desc.project_name, esp_app_get_description()->project_name,
+                       sizeof(desc.project_name)) != 0) {
+            ESP_LOGW(TAG, "'%s' holds an image of another project", part->label);
+            return false;
+        }
+
+        const void *p = NULL;
+        esp_err_t err = esp_partition_mmap(part, 0, meta.image_len, ESP_PARTITION_MMAP_DATA, &p, &s_staged_map);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "mmap of '%s' failed (%s)", part->label, esp_err_to_name(err));
+            return false;
+        }
+        s_staged     = p;
+        s_staged_len = meta.image_len;
+    }
+    *img = s_staged;
+    *len = s_staged_len;
+    return true;
+}
+
+esp_err_t fw_update_push(void)
+{
+    const uint8_t *img;
+    size_t len;
+    if (!fw_update_staged_image(&img, &len)) {
+        ESP_LOGW(TAG, "No firmware staged in the inactive OTA slot");
+        return ESP_ERR_NOT_FOUND;
+    }
+#ifdef FW_PUSH_SEQUENTIAL
+    return song_sync_send(BLOB_KIND_FIRMWARE, img, len, true);
+#else
+    return song_sync_send(BLOB_KIND_FIRMWARE, img, len, false);
+#endif
+}
+
+// ----------------------
+// Boot
+// ----------------------
+void fw_update_init(void)
+{
+    const esp_partition_t *run = esp_ota_get_running_partition();
+    ESP_LOGI(TAG, "Running %s from '%s'", esp_app_get_description()->version, run->label);
+
+    const esp_partition_t *next = esp_ota_get_next_update_partition(NULL);
+    esp_app_desc_t desc;
+    if (next && esp_ota_get_partition_description(next, &desc) == ESP_OK) {
+        ESP_LOGI(TAG, "'%s' holds %s %s", next->label, desc.project_name, desc.version);
+    }
+}
+
+void fw_update_confirm(void)
+{
+    esp_ota_img_states_t state;
+    const esp_partition_t *run = esp_ota_get_running_partition();
+    if (esp_ota_get_state_partition(run, &state) == ESP_OK && state == ESP_OTA_IMG_PENDING_VERIFY) {
+        esp_ota_mark_app_valid_cancel_rollback();
+        ESP_LOGI(TAG, "New firmware confirmed, rollback cancelled");
+    }
+}
@@ -10,7 +10,11 @@
 #include "device_config.h"        // device_config_* , ROLE_*
 #include "orchestra.h"            // orchestra_init(), orchestra_stop() (and your message hooks)
 #include "display_animations.h"   // display_animations_* (idle blue / EQ during playback)
-#include "songs.h"                // total_songs
+#include "songs.h"                // song_count()
+#include "song_store.h"           // song_store_init()
+#include "song_sync.h"            // song_sync_push()
+#include "fw_update.h"            // fw_update_push(), fw_update_confirm()
+#include "audio.h"                // audio_run_latency_benchmark(), audio_autotune_profile()
 
 static const char *TAG = "MAIN";
 
@@ -25,6 +29,11 @@ static const char *TAG = "MAIN";
 #define BTN_MID_GPIO     38   // Button B
 #define BTN_RIGHT_GPIO   37   // Button C
 
+// Holding A this long (while stopped) pushes the song library to the performers
+#define SONG_PUSH_HOLD_MS  2000
+// Holding C this long (while stopped) pushes the staged firmware to the performers
+#define FW_PUSH_HOLD_MS    5000
+
 static inline bool btn_read(int gpio) { return gpio_get_level(gpio) == 0; } // pressed = LOW
 
 static void buttons_init(void) {
@@ -69,11 +78,19 @@ void app_main(void)
     device_config_set_role((device_role_t)DEVICE_ROLE);
 #endif
 
+    fw_update_init();
+
+    // Songs from the flash library partition when one has been written,
+    // otherwise the built-in ones
+    song_store_init();
+
     device_role_t role = device_config_get_role();
     ESP_LOGI(TAG, "Resolved device role: %s (%d)", device_config_get_role_name(role), (int)role);
 
     // Bring up the app subsystems (your implementation should start display + esp-now stacks)
     orchestra_init();
+    // Got this far with the radio up: keep this firmware (no rollback)
+    fw_update_confirm();
 
     // Start the animation engine and show idle blue screen immediately
     display_animations_init();
@@ -88,8 +105,10 @@ void app_main(void)
         int  song_index = 0;
         bool playing    = false;
         bool prev_left = false, prev_mid = false, prev_right = false;
+        int  left_held_ms = 0, right_held_ms = 0;
 
-        ESP_LOGI(TAG, "Conductor ready. A=STOP, B=Start/Stop, C=Next song");
+        ESP_LOGI(TAG, "Conductor ready. A=STOP (hold: push song library), B=Start/Stop, "
+                      "C=Next song (hold 5 s: push firmware)");
 
         while (1) {
             bool left  = btn_read(BTN_LEFT_GPIO);
@@ -98,6 +117,7 @@ void app_main(void)
 
             // A (left): STOP
             if (left && !prev_left) {
+                espnow_log_delivery_report();
                 if (playing) {
                     ESP_LOGI(TAG, "Broadcast STOP");
                     espnow_broadcast(MSG_SYNC_STOP, 0);
@@ -108,6 +128,29 @@ void app_main(void)
                 }
             }
 
+            // A held: send this conductor's song library to the performers
+            int held_ms = left ? left_held_ms + 15 : 0;
+            if (held_ms >= SONG_PUSH_HOLD_MS && left_held_ms < SONG_PUSH_HOLD_MS) {
+                if (playing) {
+                    ESP_LOGW(TAG, "Stop the song before pushing the library");
+                } else {
+                    song_sync_push();
+                }
+            }
+            left_held_ms = held_ms;
+
+            // C held: send the firmware staged in the inactive OTA slot
+            int right_press_ms = right_held_ms;   // how long C was down before this scan
+            held_ms = right ? right_held_ms + 15 : 0;
+            if (held_ms >= FW_PUSH_HOLD_MS && right_held_ms < FW_PUSH_HOLD_MS) {
+                if (playing) {
+                    ESP_LOGW(TAG, "Stop the song before pushing firmware");
+                } else {
+                    fw_update_push();
+                }
+            }
+            right_held_ms = held_ms;
+
             // B (middle): toggle start/stop
             if (mid && !prev_mid) {
                 if (!playing) {
@@ -123,9 +166,10 @@ void app_main(void)
                 }
             }
 
-            // C (right): next song (wrap)
-            if (right && !prev_right) {
-                song_index = (song_index + 1) % total_songs;
+            // C (right): next song (wrap), on release so a firmware-push hold
+            // doesn't also change the song and trigger a pre-render
+            if (!right && prev_right && right_press_ms < FW_PUSH_HOLD_MS) {
+                song_index = (song_index + 1) % song_count();
                 ESP_LOGI(TAG, "Selected song %d", song_index);
                 // If currently playing, restart new selection
                 if (playing) {
@@ -133,6 +177,9 @@ void app_main(void)
                     vTaskDelay(pdMS_TO_TICKS(30));
                     ESP_LOGI(TAG, "Broadcast START, song=%d", song_index);
                     espnow_broadcast(MSG_SYNC_START, (uint8_t)song_index);
+                } else {
+                    // Performers pre-render their part while we wait for B
+                    espnow_broadcast(MSG_SONG_SELECT, (uint8_t)song_index);
                 }
             }
 
@@ -147,6 +194,16 @@ void app_main(void)
     // Performers: no buttons here; all behavior should be triggered by your
     // ESPNOW message handlers (inside espnow_comm/orchestra code), which will
     // call audio_play_song(song_id) on START and audio_stop() on STOP.
+#ifdef AUDIO_PROFILE_AUTOTUNE
+    // Build with -DAUDIO_PROFILE_AUTOTUNE to pick the smallest buffer
+    // depth that plays all parts without underruns (about 2 s per profile)
+    audio_autotune_profile(SONG_JUPITER_HYMN, 2000);
+#endif
+#ifdef AUDIO_LATENCY_BENCH
+    // Build with -DAUDIO_LATENCY_BENCH to measure PLAY/STOP latency at boot
+    audio_run_latency_benchmark(SONG_JUPITER_HYMN, (uint8_t)role, 20);
+#endif
+
     ESP_LOGI(TAG, "Performer mode: waiting for ESPNOW messages");
     while (1) {
         vTaskDelay(pdMS_TO_TICKS(1000));
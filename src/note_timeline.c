@@ -0,0 +1,129 @@
+// src/note_timeline.c — drift-free note boundaries on an absolute sample clock
+#include "note_timeline.h"
+
+void note_clock_init(note_clock_t *c, uint32_t rate)
+{
+    c->rate = rate;
+    c->rem  = 0;
+    c->end  = 0;
+}
+
+uint64_t note_clock_add(note_clock_t *c, uint16_t dur_ms)
+{
+    // (dur_ms * rate + rem) split into whole samples and a remainder in
+    // 1/1000ths of a sample; summing remainders keeps end == floor(ms*rate/1000)
+    uint64_t acc = (uint64_t)dur_ms * c->rate + c->rem;
+    c->end += acc / 1000u;
+    c->rem  = (uint32_t)(acc % 1000u);
+    return c->end;
+}
+
+// Step past notes that end at or before pos
+static void skip_finished(note_seq_t *s)
+{
+    while (s->index < s->count && s->clk.end <= s->pos) {
+        s->note_start = s->clk.end;
+        if (++s->index < s->count && song_pack_next(&s->it, &s->cur)) {
+            note_clock_add(&s->clk, s->cur.duration_ms);
+        }
+    }
+}
+
+void note_index_build(uint32_t *cum_ms, const song_pack_tables_t *t,
+                      const uint8_t *notes, uint16_t count)
+{
+    song_pack_iter_t it;
+    note_t n;
+    uint32_t ms = 0;
+    song_pack_iter_init(&it, t, notes, count);
+    for (uint16_t i = 0; i < count && song_pack_next(&it, &n); ++i) {
+        cum_ms[i] = ms;
+        ms += n.duration_ms;
+    }
+    cum_ms[count] = ms;
+}
+
+void note_seq_start(note_seq_t *s, const song_pack_tables_t *t,
+                    const uint8_t *notes, uint16_t count, uint32_t rate)
+{
+    song_pack_iter_init(&s->it, t, notes, count);
+    s->cum_ms     = NULL;
+    s->count      = s->it.count;
+    s->index      = 0;
+    s->pos        = 0;
+    s->note_start = 0;
+    note_clock_init(&s->clk, rate);
+    if (song_pack_next(&s->it, &s->cur)) {
+        note_clock_add(&s->clk, s->cur.duration_ms);
+        skip_finished(s);
+    }
+}
+
+// Decode note i into cur. Forward seeks continue from the current note;
+// backward ones rewind the iterator, skipping is one byte read per note.
+static void load_note(note_seq_t *s, uint16_t i)
+{
+    if (i + 1 == s->it.index) return;   // already in cur
+    if (i < s->it.index) {
+        song_pack_iter_init(&s->it, s->it.t, s->it.base, s->it.count);
+    }
+    song_pack_skip(&s->it, (uint16_t)(i - s->it.index));
+    song_pack_next(&s->it, &s->cur);
+}
+
+// Set the clock to the boundary at cum_ms, exactly as note_clock_add()
+// would have left it after summing the durations up to there
+static void clock_at(note_clock_t *c, uint32_t cum_ms)
+{
+    uint64_t acc = (uint64_t)cum_ms * c->rate;
+    c->end = acc / 1000u;
+    c->rem = (uint32_t)(acc % 1000u);
+}
+
+bool note_seq_seek(note_seq_t *s, uint64_t sample)
+{
+    const uint32_t *cum = s->cum_ms;
+    if (!cum) {
+        note_seq_start(s, s->it.t, s->it.base, s->count, s->clk.rate);
+        s->pos = sample;
+        skip_finished(s);
+        return !note_seq_done(s);
+    }
+
+    // First note whose end boundary lies after sample (zero-length notes
+    // never qualify, matching skip_finished())
+    uint32_t rate = s->clk.rate;
+    uint16_t lo = 0, hi = s->count;
+    while (lo < hi) {
+        uint16_t mid = (uint16_t)(lo + (hi - lo) / 2);
+        if (note_timeline_ms_to_sample(cum[mid + 1], rate) <= sample) lo = (uint16_t)(mid + 1);
+        else hi = mid;
+    }
+
+    s->index = lo;
+    s->pos   = sample;
+    if (lo >= s->count) {
+        clock_at(&s->clk, cum[s->count]);
+        s->note_start = s->clk.end;
+        return false;
+    }
+    load_note(s, lo);
+    s->note_start = note_timeline_ms_to_sample(cum[lo], rate);
+    clock_at(&s->clk, cum[lo + 1]);
+    return true;
+}
+
+uint32_t note_seq_run(const note_seq_t *s)
+{
+    if (note_seq_done(s)) return 0;
+    uint64_t left = s->clk.end - s->pos;
+    return left > UINT32_MAX ? UINT32_MAX : (uint32_t)left;
+}
+
+bool note_seq_advance(note_seq_t *s, uint32_t n)
+{
+    uint16_t before = s->index;
+    s->pos += n;
+    skip_finished(s);
+    return s->index != before && !note_seq_done(s);
+}
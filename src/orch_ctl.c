@@ -0,0 +1,360 @@
+// src/orch_ctl.c — conductor/performer control protocol, see orch_ctl.h
+#include <string.h>
+
+#include "orch_ctl.h"
+#include "orchestra.h"   // msg_type_t
+#include "songs.h"       // song_duration_ms()
+
+// ----------------------
+// Clock
+// ----------------------
+int64_t orch_clock_to_remote(const orch_clock_t *ck, int64_t local_us, uint32_t *bound_us)
+{
+    int64_t remote;
+    if (clock_sync_to_remote(&ck->sync, local_us, &remote, bound_us)) return remote;
+    if (bound_us) *bound_us = UINT32_MAX;
+    return ck->coarse_valid ? local_us + ck->coarse_offset_us : local_us;
+}
+
+int64_t orch_clock_to_local(const orch_clock_t *ck, int64_t conductor_us)
+{
+    if (ck->sync.valid) return clock_sync_to_local(&ck->sync, conductor_us);
+    return conductor_us - ck->coarse_offset_us;
+}
+
+// ----------------------
+// Frames
+// ----------------------
+static uint16_t frame_begin(orch_ctl_t *c, wire_writer_t *w, uint8_t *buf, uint8_t type)
+{
+    uint16_t seq = c->hooks->next_seq(c->ctx);
+    wire_begin(w, buf, ORCH_CTL_MAX_FRAME, type, WIRE_F_NONE, c->id, seq);
+    return seq;
+}
+
+static bool frame_send(orch_ctl_t *c, const uint8_t *dst, wire_writer_t *w)
+{
+    size_t len = wire_finish(w);
+    return len && c->hooks->send(c->ctx, dst, w->buf, len);
+}
+
+// ----------------------
+// Conductor
+// ----------------------
+static void rtx_send(void *ctx, const uint8_t mac[6], const uint8_t *frame, size_t len)
+{
+    orch_ctl_t *c = ctx;
+    c->hooks->send(c->ctx, mac, frame, len);
+}
+
+static void rtx_done(void *ctx, const reliable_tx_t *tx, const reliable_msg_t *m)
+{
+    orch_ctl_t *c = ctx;
+    if (c->hooks->delivered) c->hooks->delivered(c->ctx, tx, m);
+}
+
+// Answer a request, echoing t1 and adding t2 (arrival) and t3 (as late as
+// possible)
+static void clock_answer(orch_ctl_t *c, const wire_frame_t *f, int64_t rx_us)
+{
+    wire_clock_t req;
+    if (!wire_get_clock(f, false, &req)) return;
+
+    uint8_t buf[ORCH_CTL_MAX_FRAME];
+    wire_writer_t w;
+    frame_begin(c, &w, buf, MSG_CLOCK_RESP);
+    wire_clock_t resp = {
+        .target  = f->sender,
+        .req_seq = f->seq,
+        .t1      = req.t1,
+        .t2      = (uint64_t)rx_us,
+    };
+    resp.t3 = (uint64_t)c->hooks->now(c->ctx);
+    wire_put_clock(&w, true, &resp);
+    frame_send(c, NULL, &w);
+}
+
+static void send_heartbeat(orch_ctl_t *c, int64_t now)
+{
+    uint8_t buf[ORCH_CTL_MAX_FRAME];
+    wire_writer_t w;
+    frame_begin(c, &w, buf, MSG_HEARTBEAT);
+    wire_ctrl_t hb = { .song_id = 0, .timestamp = (uint64_t)now, .has_state = true, .state = c->state };
+    wire_put_ctrl(&w, &hb);
+    frame_send(c, NULL, &w);
+}
+
+size_t orch_ctl_command(orch_ctl_t *c, uint8_t type, uint8_t song_id, uint64_t *ts_us)
+{
+    int64_t  now = c->hooks->now(c->ctx);
+    uint64_t ts  = (uint64_t)now;
+    if (type == MSG_SYNC_START) ts += ORCH_START_LEAD_US;
+    if (ts_us) *ts_us = ts;
+
+    if (type == MSG_SYNC_START || type == MSG_SYNC_STOP) {
+        c->state.version++;
+        c->state.playing = (type == MSG_SYNC_START);
+        if (c->state.playing) {
+            c->state.song_id        = song_id;
+            c->state.start_epoch_us = ts;
+        }
+    }
+
+    // Commands that change what performers do are acknowledged
+    bool reliable = (type == MSG_SYNC_START || type == MSG_SYNC_STOP || type == MSG_SONG_SELECT);
+
+    uint8_t buf[ORCH_CTL_MAX_FRAME];
+    wire_writer_t w;
+    uint16_t seq = frame_begin(c, &w, buf, type);
+    if (reliable) wire_set_flags(&w, WIRE_F_ACK_REQ);
+    wire_ctrl_t msg = { .song_id = song_id, .timestamp = ts, .has_state = true, .state = c->state };
+    wire_put_ctrl(&w, &msg);
+    size_t len = wire_finish(&w);
+    if (!len) return 0;
+
+    c->hooks->send(c->ctx, NULL, buf, len);
+    if (!reliable) return 0;
+
+    uint8_t macs[RELIABLE_MAX_PEERS][6];
+    size_t n = c->hooks->performers ? c->hooks->performers(c->ctx, macs, RELIABLE_MAX_PEERS) : 0;
+    reliable_tx_set_peers(&c->rtx, (const uint8_t (*)[6])macs, n);
+    if (!reliable_tx_submit(&c->rtx, buf, len, type, seq, now, now + ORCH_RETRY_WINDOW_US, rtx_done, c)) {
+        return 0;
+    }
+    c->rtx_next_us = reliable_tx_poll(&c->rtx, now, rtx_send, rtx_done, c);
+    return n;
+}
+
+void orch_ctl_set_volume(orch_ctl_t *c, uint16_t volume_q15)
+{
+    if (c->state.volume_q15 == volume_q15) return;
+    c->state.volume_q15 = volume_q15;
+    c->state.version++;
+}
+
+// ----------------------
+// Performer
+// ----------------------
+static void clock_request(orch_ctl_t *c, int64_t now)
+{
+    uint8_t buf[ORCH_CTL_MAX_FRAME];
+    wire_writer_t w;
+    c->sync_seq = frame_begin(c, &w, buf, MSG_CLOCK_REQ);
+    wire_clock_t req = { .t1 = (uint64_t)c->hooks->now(c->ctx) };
+    wire_put_clock(&w, false, &req);
+    frame_send(c, NULL, &w);
+    c->sync_next_us = now + 1000LL * (clock_sync_wants_fast(&c->clock.sync) ? ORCH_CLOCK_SYNC_FAST_MS
+                                                                           : ORCH_CLOCK_SYNC_POLL_MS);
+}
+
+static void clock_response(orch_ctl_t *c, const wire_frame_t *f, int64_t rx_us)
+{
+    wire_clock_t resp;
+    if (!wire_get_clock(f, true, &resp)) return;
+    if (resp.target != c->id || resp.req_seq != c->sync_seq) return;   // not ours, or stale
+
+    if (clock_sync_add(&c->clock.sync, (int64_t)resp.t1, (int64_t)resp.t2, (int64_t)resp.t3, rx_us)) {
+        c->sync_accepted++;
+    } else {
+        c->sync_rejected++;
+    }
+}
+
+// ACK straight back to the sender; if the unicast fails a broadcast ACK
+// still reaches it
+static void send_ack(orch_ctl_t *c, const uint8_t *src, const wire_frame_t *f)
+{
+    uint8_t buf[ORCH_CTL_MAX_FRAME];
+    wire_writer_t w;
+    frame_begin(c, &w, buf, MSG_ACK);
+    wire_ack_t ack = { .seq = f->seq, .type = f->type };
+    wire_put_ack(&w, &ack);
+    size_t len = wire_finish(&w);
+    if (len && !c->hooks->send(c->ctx, src, buf, len)) c->hooks->send(c->ctx, NULL, buf, len);
+}
+
+// Converge to the conductor's state. Safe to call with the same state any
+// number of times; only a change (or a missed change) acts.
+static void apply_state(orch_ctl_t *c, const orch_state_t *st, int64_t rx_us)
+{
+    const orch_ctl_hooks_t *h = c->hooks;
+    if (!orch_state_is_current(&c->follow, st)) {
+        c->stale++;
+        return;
+    }
+    bool params = !c->follow.have || c->follow.state.volume_q15 != st->volume_q15 ||
+                  c->follow.state.tempo_pct != st->tempo_pct;
+
+    uint32_t join_ms = 0;
+    int64_t now = orch_clock_to_remote(&c->clock, h->now(c->ctx), NULL);
+    orch_action_t act = orch_follow(&c->follow, st, now, song_duration_ms(st->song_id), &join_ms);
+
+    if (params && h->params) h->params(c->ctx, st);
+
+    int64_t epoch = orch_clock_to_local(&c->clock, (int64_t)st->start_epoch_us);
+    switch (act) {
+    case ORCH_ACT_START_AT:
+        if (h->schedule) h->schedule(c->ctx, st->song_id, epoch, rx_us);
+        break;
+    case ORCH_ACT_JOIN:
+        // Missed the START (lost frames, reboot): come in where the others are
+        if (h->play) h->play(c->ctx, st->song_id, epoch, join_ms);
+        break;
+    case ORCH_ACT_STOP:
+        if (h->stop) h->stop(c->ctx);
+        break;
+    case ORCH_ACT_NONE:
+        break;
+    }
+}
+
+// Where the song should be now, so playback can slip against the DAC
+// clock's drift. Only with a two-way estimate; the coarse offset is too
+// noisy.
+static void sync_timeline(orch_ctl_t *c)
+{
+    if (!c->hooks->timeline || !c->follow.started || !c->follow.state.playing) return;
+    int64_t local = c->hooks->now(c->ctx);
+    int64_t remote;
+    if (!clock_sync_to_remote(&c->clock.sync, local, &remote, NULL)) return;
+    c->hooks->timeline(c->ctx, remote - (int64_t)c->follow.started_epoch_us, local);
+}
+
+static void handle_ctrl(orch_ctl_t *c, const wire_frame_t *f, const wire_ctrl_t *m, int64_t rx_us)
+{
+    const orch_ctl_hooks_t *h = c->hooks;
+    switch (f->type) {
+    case MSG_SYNC_START:
+        if (m->has_state) {
+            apply_state(c, &m->state, rx_us);
+        } else if (h->schedule) {
+            // Conductor without a state vector: the timestamp is the epoch
+            h->schedule(c->ctx, m->song_id, orch_clock_to_local(&c->clock, (int64_t)m->timestamp), rx_us);
+        }
+        break;
+
+    case MSG_SYNC_STOP:
+        if (m->has_state) {
+            apply_state(c, &m->state, rx_us);
+        } else if (h->stop) {
+            h->stop(c->ctx);
+        }
+        break;
+
+    case MSG_SONG_SELECT:
+        if (h->prepare) h->prepare(c->ctx, m->song_id);
+        break;
+
+    case MSG_HEARTBEAT:
+        // One-way estimate (ignores air and queue delay): only a fallback
+        // until the two-way exchange has produced a result
+        if (!c->clock.sync.valid) {
+            int64_t offset = (int64_t)m->timestamp - rx_us;
+            c->clock.coarse_offset_us = c->clock.coarse_valid ? (c->clock.coarse_offset_us * 7 + offset) / 8
+                                                              : offset;
+            c->clock.coarse_valid = true;
+        }
+        // The repeated state is what heals missed commands and reboots
+        if (m->has_state) {
+            apply_state(c, &m->state, rx_us);
+            sync_timeline(c);
+        }
+        break;
+    }
+}
+
+// ----------------------
+// Common
+// ----------------------
+void orch_ctl_init(orch_ctl_t *c, const orch_ctl_hooks_t *hooks, void *ctx,
+                   uint8_t id, bool conductor, uint16_t boot_id, uint16_t volume_q15)
+{
+    memset(c, 0, sizeof(*c));
+    c->hooks     = hooks;
+    c->ctx       = ctx;
+    c->id        = id;
+    c->conductor = conductor;
+
+    int64_t now = hooks->now(ctx);
+    if (conductor) {
+        c->state = (orch_state_t){
+            .boot_id    = boot_id,
+            .version    = 1,
+            .tempo_pct  = ORCH_TEMPO_NOMINAL,
+            .volume_q15 = volume_q15,
+        };
+        reliable_tx_init(&c->rtx);
+        c->rtx_next_us = INT64_MAX;
+        c->hb_next_us  = now;
+    } else {
+        clock_sync_init(&c->clock.sync);
+        reliable_rx_init(&c->rrx);
+        orch_follower_init(&c->follow);
+        c->sync_next_us = now;
+    }
+}
+
+bool orch_ctl_handle(orch_ctl_t *c, const uint8_t src[6], const wire_frame_t *f, int64_t rx_us)
+{
+    if (f->sender == c->id) return false;   // our own broadcast
+
+    if (c->conductor) {
+        wire_ack_t ack;
+        switch (f->type) {
+        case MSG_CLOCK_REQ:
+            clock_answer(c, f, rx_us);
+            return true;
+        case MSG_ACK:
+            if (!wire_get_ack(f, &ack)) return false;
+            if (reliable_tx_ack(&c->rtx, src, ack.seq, rx_us)) {
+                // Report as soon as the last peer acks
+                c->rtx_next_us = reliable_tx_poll(&c->rtx, rx_us, rtx_send, rtx_done, c);
+            }
+            return true;
+        default:
+            return false;   // no local audio: control frames are the performers'
+        }
+    }
+
+    wire_ctrl_t m;
+    switch (f->type) {
+    case MSG_CLOCK_RESP:
+        clock_response(c, f, rx_us);
+        break;
+    case MSG_SYNC_START:
+    case MSG_SYNC_STOP:
+    case MSG_SONG_SELECT:
+    case MSG_HEARTBEAT:
+        if (!wire_get_ctrl(f, &m)) return false;
+        if (f->flags & WIRE_F_ACK_REQ) {
+            // ACK every copy, act on the first one only
+            send_ack(c, src, f);
+            if (reliable_rx_seen(&c->rrx, src, f->seq)) {
+                c->dups++;
+                break;
+            }
+        }
+        handle_ctrl(c, f, &m, rx_us);
+        break;
+    default:
+        return false;   // CLOCK_REQ from other performers, ACKs, newer types
+    }
+    if (f->sender == ORCH_CTL_CONDUCTOR_ID) c->heard_us = rx_us;
+    return true;
+}
+
+int64_t orch_ctl_poll(orch_ctl_t *c)
+{
+    int64_t now = c->hooks->now(c->ctx);
+    if (!c->conductor) {
+        if (now >= c->sync_next_us) clock_request(c, now);
+        return c->sync_next_us;
+    }
+
+    if (now >= c->hb_next_us) {
+        send_heartbeat(c, now);
+        c->hb_next_us = now + ORCH_HEARTBEAT_MS * 1000LL;
+    }
+    if (now >= c->rtx_next_us) c->rtx_next_us = reliable_tx_poll(&c->rtx, now, rtx_send, rtx_done, c);
+    return c->rtx_next_us < c->hb_next_us ? c->rtx_next_us : c->hb_next_us;
+}
@@ -0,0 +1,47 @@
+// src/orch_state.c — idempotent convergence to the conductor's state vector
+#include <string.h>
+
+#include "orch_state.h"
+
+void orch_follower_init(orch_follower_t *f)
+{
+    memset(f, 0, sizeof(*f));
+}
+
+bool orch_state_is_current(const orch_follower_t *f, const orch_state_t *in)
+{
+    if (!f->have || in->boot_id != f->state.boot_id) return true;
+    // Serial number arithmetic: survives the 16-bit wrap
+    return (int16_t)(in->version - f->state.version) >= 0;
+}
+
+orch_action_t orch_follow(orch_follower_t *f, const orch_state_t *in,
+                          int64_t conductor_now_us, uint32_t song_len_ms,
+                          uint32_t *join_ms)
+{
+    if (!orch_state_is_current(f, in)) return ORCH_ACT_NONE;
+    f->state = *in;
+    f->have  = true;
+
+    if (!in->playing) {
+        if (!f->started) return ORCH_ACT_NONE;
+        f->started = false;
+        return ORCH_ACT_STOP;
+    }
+
+    // Already acted on this start (playing it, or it finished on its own)
+    if (f->started && f->started_song == in->song_id && f->started_epoch_us == in->start_epoch_us) {
+        return ORCH_ACT_NONE;
+    }
+    f->started          = true;
+    f->started_song     = in->song_id;
+    f->started_epoch_us = in->start_epoch_us;
+
+    int64_t elapsed_us = conductor_now_us - (int64_t)in->start_epoch_us;
+    if (elapsed_us < 0) return ORCH_ACT_START_AT;
+
+    int64_t elapsed_ms = elapsed_us / 1000;
+    if (elapsed_ms >= (int64_t)song_len_ms) return ORCH_ACT_NONE;   // missed it entirely
+    if (join_ms) *join_ms = (uint32_t)elapsed_ms;
+    return ORCH_ACT_JOIN;
+}
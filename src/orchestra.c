@@ -6,6 +6,7 @@
 #include "esp_log.h"
 
 #include "orchestra.h"
+#include "audio.h"
 #include "songs.h"
 #include "espnow_discovery.h"
 
@@ -14,14 +15,6 @@
 static const char *TAG = "ORCHESTRA";
 
 // External function declarations
-extern void audio_init(void);
-extern void audio_play_song(uint8_t song_id);
-// New role-aware playback (implemented in audio.c)
-extern void audio_play_song_for_role(uint8_t song_id, uint8_t role);
-extern void audio_stop(void);
-extern void audio_set_volume(float vol);
-extern bool audio_is_playing(void);
-
 extern void rgb_init(void);
 extern void rgb_set_all_color(uint32_t color);
 extern void rgb_breathing_effect(uint32_t color, uint32_t duration_ms);
@@ -35,6 +28,13 @@ extern void display_animations_update_beat(float intensity);
 
 extern esp_err_t espnow_init(uint8_t id);
 extern esp_err_t espnow_broadcast(msg_type_t type, uint8_t song_id);
+extern void espnow_state_set_volume(float volume);
+
+// When a performer is offline, the lowest-numbered online performer mixes
+// its part in so quintet pieces stay complete. Set to 0 to disable.
+#ifndef ORCHESTRA_COVER_MISSING_PARTS
+#define ORCHESTRA_COVER_MISSING_PARTS 1
+#endif
 
 // Button GPIO pins (M5Stack Core)
 #define BUTTON_A_PIN    39
@@ -118,7 +118,35 @@ static void init_buttons(void) {
     ESP_LOGI(TAG, "Buttons initialized (conductor)");
 }
 
+// Parts (PART_1..PART_4 bits) this device should mix in on top of its own
+static uint8_t extra_parts_for_song(const song_t *song) {
+#if ORCHESTRA_COVER_MISSING_PARTS
+    if (song->type != SONG_TYPE_QUINTET) return 0;
+    if (s_role < ROLE_PART_1 || s_role > ROLE_PART_4) return 0;
+
+    uint8_t own     = (uint8_t)(1u << (s_role - ROLE_PART_1));
+    uint8_t online  = espnow_discovery_get_online_part_mask() | own;
+    uint8_t missing = (PART_1 | PART_2 | PART_3 | PART_4) & (uint8_t)~online;
+
+    // Only the lowest online performer covers, so no part is doubled
+    if (online & (own - 1)) return 0;
+    return missing;
+#else
+    (void)song;
+    return 0;
+#endif
+}
+
 // ------------- Public API -------------
+// Conductor is silent. Performers play every QUINTET; SOLO and DUET respect
+// the song's parts_mask, which lets the conductor trigger specific parts on
+// different devices.
+static bool performer_should_play(const song_t *song) {
+    if (s_is_conductor) return false;
+    if (song->type == SONG_TYPE_QUINTET) return true;
+    return device_config_should_play_part(s_role, song->parts_mask);
+}
+
 void orchestra_init(void) {
     ESP_LOGI(TAG, "Initializing Orchestra…");
 
@@ -144,9 +172,8 @@ void orchestra_init(void) {
         init_buttons();
     }
 
-    // Default volume
     // Default volume (kept in sync with audio.c default)
-    audio_set_volume(0.08f);
+    orchestra_set_volume(ORCHESTRA_DEFAULT_VOLUME);
 
     // Idle visuals
     display_animations_start_idle();
@@ -156,7 +183,12 @@ void orchestra_init(void) {
 }
 
 void orchestra_play_song(uint8_t song_id) {
-    if (song_id >= total_songs) {
+    orchestra_play_song_at(song_id, 0);
+}
+
+void orchestra_play_song_at(uint8_t song_id, int64_t epoch_us) {
+    const song_t *song = song_get(song_id);
+    if (!song) {
         ESP_LOGW(TAG, "Invalid song ID: %u", song_id);
         return;
     }
@@ -168,7 +200,6 @@ void orchestra_play_song(uint8_t song_id) {
         is_playing = false;
     }
 
-    const song_t *song = &songs[song_id];
     ESP_LOGI(TAG, "Play request: %s (type=%d) role=%d",
              song->name, song->type, (int)s_role);
 
@@ -193,29 +224,19 @@ void orchestra_play_song(uint8_t song_id) {
     // Ensure animations know our role so they pick the right colors
     display_animations_update_beat(0.0f);
 
-    bool should_play = false;
-
+    bool should_play = performer_should_play(song);
     if (s_is_conductor) {
-        // Conductor is silent. Never call audio_play_song() here.
-        should_play = false;
         ESP_LOGI(TAG, "Conductor: visual-only, no audio output.");
-    } else {
-        // Performer: decide by song type / parts mask
-        if (song->type == SONG_TYPE_QUINTET) {
-            // All parts play
-            should_play = true;
-        } else {
-            // SOLO and DUET respect the song's parts_mask. This lets the
-            // conductor trigger specific parts on different devices.
-            if (device_config_should_play_part(s_role, song->parts_mask)) {
-                should_play = true;
-            }
-        }
     }
 
     if (should_play) {
-        // Use role-aware playback so each performer produces a different part
-        audio_play_song_for_role(song_id, (uint8_t)s_role);
+        // Use role-aware playback so each performer produces a different part,
+        // plus any parts of offline performers we have been elected to cover
+        uint8_t extra = extra_parts_for_song(song);
+        if (extra) {
+            ESP_LOGI(TAG, "Covering offline parts mask 0x%02X", extra);
+        }
+        audio_play_song_parts_at(song_id, (uint8_t)s_role, extra, epoch_us);
         is_playing = true;
     }
 
@@ -224,6 +245,13 @@ void orchestra_play_song(uint8_t song_id) {
     xSemaphoreGive(orchestra_mutex);
 }
 
+void orchestra_prepare_song(uint8_t song_id) {
+    const song_t *song = song_get(song_id);
+    if (!song || !performer_should_play(song)) return;
+    // Same part selection as the START will use, so the cache key matches
+    audio_prerender(song_id, (uint8_t)s_role, extra_parts_for_song(song));
+}
+
 void orchestra_stop(void) {
     xSemaphoreTake(orchestra_mutex, portMAX_DELAY);
 
@@ -245,6 +273,8 @@ void orchestra_stop(void) {
 
 void orchestra_set_volume(float volume) {
     audio_set_volume(volume);
+    // Performers follow the conductor's volume via the replicated state
+    if (s_is_conductor) espnow_state_set_volume(volume);
 }
 
 // -------- Button handlers (conductor only) --------
@@ -259,8 +289,8 @@ void orchestra_handle_button_a(void) {
     espnow_broadcast(MSG_SYNC_START, song_id);
 
     // Optional: update visuals locally to reflect the selection/start
-    const song_t *song = &songs[song_id];
-    display_animations_start_playback(song->type);
+    const song_t *song = song_get(song_id);
+    if (song) display_animations_start_playback(song->type);
 }
 
 void orchestra_handle_button_b(void) {
@@ -272,8 +302,8 @@ void orchestra_handle_button_b(void) {
 
     espnow_broadcast(MSG_SYNC_START, song_id);
 
-    const song_t *song = &songs[song_id];
-    display_animations_start_playback(song->type);
+    const song_t *song = song_get(song_id);
+    if (song) display_animations_start_playback(song->type);
 }
 
 void orchestra_handle_button_c(void) {
@@ -285,6 +315,6 @@ void orchestra_handle_button_c(void) {
 
     espnow_broadcast(MSG_SYNC_START, song_id);
 
-    const song_t *song = &songs[song_id];
-    display_animations_start_playback(song->type);
+    const song_t *song = song_get(song_id);
+    if (song) display_animations_start_playback(song->type);
 }
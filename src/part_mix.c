@@ -0,0 +1,170 @@
+// src/part_mix.c — per-part voices on the sample-accurate timeline, mixed with headroom
+#include <string.h>
+
+#include "part_mix.h"
+#include "songs.h"
+
+// Parts are numbered like the performer roles, ROLE_PART_1..4 (device_config.h
+// pulls in ESP-IDF, so the numbers are repeated here)
+enum { ROLE_1 = 1, ROLE_2, ROLE_3, ROLE_4 };
+
+// ----------------------
+// Role part selection / transform
+// ----------------------
+static void select_melody_for_role(const song_t *song, uint8_t role,
+                                   const uint8_t **out_notes, uint16_t *out_count)
+{
+    // Prefer explicit part if present
+    if (role >= ROLE_1 && role <= ROLE_4) {
+        int part_idx = (int)role; // ROLE_PART_1 = 1
+        if (song->parts[part_idx].notes && song->parts[part_idx].note_count) {
+            *out_notes = song->parts[part_idx].notes;
+            *out_count = song->parts[part_idx].note_count;
+            return;
+        }
+    }
+    // Fallback to lead
+    *out_notes = song->notes;
+    *out_count = song->note_count;
+}
+
+// Simple transform when we fell back to the lead melody (to create harmonies)
+static uint16_t transform_freq_for_role(uint16_t base_freq, uint8_t role) {
+    if (base_freq == 0) return 0;
+    switch (role) {
+        case ROLE_1: return base_freq;                 // lead
+        case ROLE_2: {                                  // down an octave (if too low, revert)
+            uint16_t f = (uint16_t)(base_freq / 2);
+            return (f < 50) ? base_freq : f;
+        }
+        case ROLE_3: return (uint16_t)(base_freq * 2); // up an octave
+        case ROLE_4: return (uint16_t)((base_freq * 3) / 2); // perfect fifth
+        default:          return base_freq;
+    }
+}
+
+// ----------------------
+// Voices
+// ----------------------
+
+// Latch the sequencer's current note into the voice's oscillator
+static void voice_load_note(part_voice_t *v, uint32_t rate) {
+    const note_t *n = note_seq_note(&v->seq);
+    uint16_t freq = n->frequency;
+    if (v->using_lead) {
+        freq = transform_freq_for_role(freq, v->role);
+    }
+    v->freq = freq;
+    // Phase increment is computed once per note, not per sample
+    v->inc = synth_phase_inc(freq, rate);
+    // With an envelope the note starts and ends silent, so phase can restart
+    // at 0 on every note: it is then a function of the position alone and a
+    // voice that seeked in is phase-aligned with one that played from the
+    // top. Without one, phase stays continuous to avoid clicks.
+    if (v->shape) {
+        v->phase = note_seq_note_elapsed(&v->seq) * v->inc;
+    }
+    // Envelope spans the note exactly (a seek may land inside it)
+    synth_env_note_on(&v->env, v->shape, note_seq_note_len(&v->seq),
+                      note_seq_note_elapsed(&v->seq), rate);
+}
+
+static bool voice_start(part_voice_t *v, uint8_t song_id, const song_t *song, uint8_t role,
+                        uint8_t default_env, uint32_t rate) {
+    const uint8_t *mel = NULL;
+    uint16_t count = 0;
+
+    memset(v, 0, sizeof(*v));
+    v->role = role;
+    select_melody_for_role(song, role, &mel, &count);
+    v->using_lead = (mel == song->notes);
+
+    // Part envelope overrides the song's; DEFAULT falls through to the engine's
+    uint8_t env = song->envelope;
+    if (!v->using_lead && song->parts[role].envelope != SYNTH_ENV_DEFAULT) {
+        env = song->parts[role].envelope;
+    }
+    if (env == SYNTH_ENV_DEFAULT) env = default_env;
+    v->preset = env;
+    v->shape  = synth_env_preset(env);
+    note_seq_start(&v->seq, song->tables, mel, count, rate);
+    note_seq_set_index(&v->seq, song_melody_index(song_id, mel));
+    return !note_seq_done(&v->seq);
+}
+
+// Run len samples of one voice through its notes, synthesizing into acc
+// unless it is NULL; true if its note changed
+static bool voice_run(part_voice_t *v, int32_t *acc, size_t len, uint32_t rate) {
+    size_t done = 0;
+    bool edge = false;
+    while (done < len && !note_seq_done(&v->seq)) {
+        size_t n = note_seq_run(&v->seq);
+        if (n > len - done) n = len - done;
+        if (acc) synth_mix_tone_env(&acc[done], n, &v->phase, v->inc, &v->env);
+        done += n;
+        if (note_seq_advance(&v->seq, (uint32_t)n)) {
+            voice_load_note(v, rate);
+            edge = true;
+        }
+    }
+    return edge;
+}
+
+// ----------------------
+// Cursor
+// ----------------------
+bool part_mix_start(part_mix_t *m, uint8_t song_id, uint8_t role, uint8_t parts,
+                    uint8_t default_env, uint32_t rate) {
+    memset(m, 0, sizeof(*m));
+    m->song = song_get(song_id);
+    m->rate = rate;
+    if (!m->song) return false;
+
+    if (voice_start(&m->voices[0], song_id, m->song, role, default_env, rate)) {
+        m->n_voices = 1;
+    }
+    for (uint8_t r = ROLE_1; r <= ROLE_4 && m->n_voices < PART_MIX_MAX_VOICES; ++r) {
+        if (r == role || !(parts & (1u << (r - ROLE_1)))) continue;
+        if (voice_start(&m->voices[m->n_voices], song_id, m->song, r, default_env, rate)) {
+            m->n_voices++;
+        }
+    }
+    if (m->n_voices == 0) return false;
+
+    for (uint8_t i = 0; i < m->n_voices; ++i) {
+        voice_load_note(&m->voices[i], rate);
+    }
+    m->headroom_q15 = synth_headroom_q15(m->n_voices);
+    return true;
+}
+
+bool part_mix_seek(part_mix_t *m, uint64_t sample) {
+    bool any = false;
+    for (uint8_t i = 0; i < m->n_voices; ++i) {
+        if (note_seq_seek(&m->voices[i].seq, sample)) {
+            voice_load_note(&m->voices[i], m->rate);
+            any = true;
+        }
+    }
+    return any;
+}
+
+bool part_mix_done(const part_mix_t *m) {
+    for (uint8_t i = 0; i < m->n_voices; ++i) {
+        if (!note_seq_done(&m->voices[i].seq)) return false;
+    }
+    return true;
+}
+
+bool part_mix_block(part_mix_t *m, int32_t *acc, size_t len) {
+    bool edge = false;
+    for (uint8_t i = 0; i < m->n_voices; ++i) {
+        bool e = voice_run(&m->voices[i], acc, len, m->rate);
+        if (i == 0) edge = e;
+    }
+    return edge;
+}
+
+bool part_mix_skip(part_mix_t *m, size_t len) {
+    return m->n_voices && voice_run(&m->voices[0], NULL, len, m->rate);
+}
@@ -0,0 +1,62 @@
+// src/pcm_ring.c — lock-free SPSC ring of PCM blocks
+#include <stddef.h>
+
+#include "pcm_ring.h"
+
+// Indices are free-running 32-bit counters; fill = head - tail (mod 2^32).
+// The owner of an index stores it with release semantics after touching the
+// block, the other side loads it with acquire semantics before touching it.
+#define LOAD_ACQ(p)      __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STORE_REL(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+void pcm_ring_init(pcm_ring_t *r, int16_t *storage, uint16_t n_blocks, uint16_t block_len)
+{
+    r->storage   = storage;
+    r->block_len = block_len;
+    r->n_blocks  = n_blocks;
+    r->head      = 0;
+    r->tail      = 0;
+}
+
+static inline int16_t *block_at(const pcm_ring_t *r, uint32_t idx)
+{
+    return &r->storage[(size_t)(idx & (uint32_t)(r->n_blocks - 1)) * r->block_len];
+}
+
+int16_t *pcm_ring_write_slot(pcm_ring_t *r)
+{
+    uint32_t head = r->head;
+    uint32_t tail = LOAD_ACQ(&r->tail);
+    if (head - tail >= r->n_blocks) return NULL;   // full
+    return block_at(r, head);
+}
+
+void pcm_ring_commit(pcm_ring_t *r)
+{
+    STORE_REL(&r->head, r->head + 1);
+}
+
+const int16_t *pcm_ring_read_slot(pcm_ring_t *r)
+{
+    uint32_t tail = r->tail;
+    uint32_t head = LOAD_ACQ(&r->head);
+    if (head == tail) return NULL;                 // empty
+    return block_at(r, tail);
+}
+
+void pcm_ring_release(pcm_ring_t *r)
+{
+    STORE_REL(&r->tail, r->tail + 1);
+}
+
+void pcm_ring_drop_all(pcm_ring_t *r)
+{
+    STORE_REL(&r->tail, LOAD_ACQ(&r->head));
+}
+
+uint32_t pcm_ring_fill(const pcm_ring_t *r)
+{
+    uint32_t head = LOAD_ACQ(&r->head);
+    uint32_t tail = LOAD_ACQ(&r->tail);
+    return head - tail;
+}
@@ -0,0 +1,162 @@
+// src/reliable.c — ACK tracking, bounded retransmission, receiver de-dup
+#include <string.h>
+
+#include "reliable.h"
+
+void reliable_tx_init(reliable_tx_t *tx)
+{
+    memset(tx, 0, sizeof(*tx));
+}
+
+static int peer_index(const reliable_tx_t *tx, const uint8_t mac[6])
+{
+    for (int i = 0; i < tx->n_peers; ++i) {
+        if (memcmp(tx->peers[i].mac, mac, 6) == 0) return i;
+    }
+    return -1;
+}
+
+void reliable_tx_set_peers(reliable_tx_t *tx, const uint8_t (*macs)[6], size_t n)
+{
+    // Stats entries are kept for peers that go offline; only the online
+    // flags change, so a peer keeps its history across dropouts
+    memset(tx->online, 0, sizeof(tx->online));
+    for (size_t k = 0; k < n; ++k) {
+        int i = peer_index(tx, macs[k]);
+        if (i < 0) {
+            if (tx->n_peers >= RELIABLE_MAX_PEERS) continue;
+            i = tx->n_peers++;
+            memset(&tx->peers[i], 0, sizeof(tx->peers[i]));
+            memcpy(tx->peers[i].mac, macs[k], 6);
+        }
+        tx->online[i] = true;
+    }
+}
+
+// Fold a finished message into the per-peer stats, report it, free the slot
+static void retire(reliable_tx_t *tx, reliable_msg_t *m, reliable_done_fn done, void *ctx)
+{
+    for (int i = 0; i < tx->n_peers; ++i) {
+        if (!(m->want & (1u << i))) continue;
+        reliable_peer_stats_t *p = &tx->peers[i];
+        p->sent++;
+        if (m->acked & (1u << i)) {
+            int64_t lat = m->ack_us[i] - m->first_us;
+            p->delivered++;
+            p->retries += m->ack_tries[i] - 1u;
+            p->lat_sum_us += lat;
+            if (lat > p->lat_max_us) p->lat_max_us = lat;
+        } else {
+            p->missed++;
+        }
+    }
+    if (done) done(ctx, tx, m);
+    m->active = false;
+}
+
+bool reliable_tx_submit(reliable_tx_t *tx, const uint8_t *frame, size_t len,
+                        uint8_t type, uint16_t seq, int64_t now_us, int64_t deadline_us,
+                        reliable_done_fn done, void *ctx)
+{
+    // A newer command replaces whatever was still being retried
+    if (tx->msg.active) retire(tx, &tx->msg, done, ctx);
+
+    uint16_t want = 0;
+    for (int i = 0; i < tx->n_peers; ++i) {
+        if (tx->online[i]) want |= (uint16_t)(1u << i);
+    }
+    if (!want || len > RELIABLE_MAX_FRAME) return false;
+
+    reliable_msg_t *m = &tx->msg;
+    memset(m, 0, sizeof(*m));
+    m->active      = true;
+    m->type        = type;
+    m->seq         = seq;
+    m->len         = (uint8_t)len;
+    m->tries       = 1;
+    m->first_us    = now_us;
+    m->retry_us    = RELIABLE_RETRY_US;
+    m->next_us     = now_us + RELIABLE_RETRY_US;
+    m->deadline_us = deadline_us;
+    m->want        = want;
+    memcpy(m->frame, frame, len);
+    return true;
+}
+
+bool reliable_tx_ack(reliable_tx_t *tx, const uint8_t mac[6], uint16_t seq, int64_t now_us)
+{
+    int i = peer_index(tx, mac);
+    if (i < 0) return false;
+    reliable_msg_t *m = &tx->msg;
+    if (!m->active || m->seq != seq || !(m->want & (1u << i))) return false;
+    if (!(m->acked & (1u << i))) {
+        m->acked |= (uint16_t)(1u << i);
+        m->ack_us[i] = now_us;
+        m->ack_tries[i] = m->tries;
+    }
+    return true;
+}
+
+int64_t reliable_tx_poll(reliable_tx_t *tx, int64_t now_us,
+                         reliable_send_fn send, reliable_done_fn done, void *ctx)
+{
+    reliable_msg_t *m = &tx->msg;
+    if (!m->active) return INT64_MAX;
+
+    uint16_t missing = m->want & (uint16_t)~m->acked;
+    if (!missing || now_us >= m->deadline_us ||
+        (m->tries >= RELIABLE_MAX_TRIES && now_us >= m->next_us)) {
+        retire(tx, m, done, ctx);
+        return INT64_MAX;
+    }
+
+    if (now_us >= m->next_us) {
+        for (int i = 0; i < tx->n_peers; ++i) {
+            if (missing & (1u << i)) send(ctx, tx->peers[i].mac, m->frame, m->len);
+        }
+        m->tries++;
+        m->retry_us += m->retry_us / 2;
+        m->next_us = now_us + m->retry_us;
+    }
+    return m->next_us < m->deadline_us ? m->next_us : m->deadline_us;
+}
+
+// ----------------------
+// Receiver de-duplication
+// ----------------------
+void reliable_rx_init(reliable_rx_t *rx)
+{
+    memset(rx, 0, sizeof(*rx));
+}
+
+bool reliable_rx_seen(reliable_rx_t *rx, const uint8_t mac[6], uint16_t seq)
+{
+    int slot = -1;
+    for (int i = 0; i < RELIABLE_MAX_PEERS; ++i) {
+        if (rx->senders[i].used && memcmp(rx->senders[i].mac, mac, 6) == 0) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        for (int i = 0; i < RELIABLE_MAX_PEERS && slot < 0; ++i) {
+            if (!rx->senders[i].used) slot = i;
+        }
+        if (slot < 0) {
+            slot = rx->next;
+            rx->next = (uint8_t)((rx->next + 1) % RELIABLE_MAX_PEERS);
+        }
+        memset(&rx->senders[slot], 0, sizeof(rx->senders[slot]));
+        rx->senders[slot].used = true;
+        memcpy(rx->senders[slot].mac, mac, 6);
+    }
+
+    reliable_rx_sender_t *s = &rx->senders[slot];
+    for (int i = 0; i < s->n; ++i) {
+        if (s->seqs[i] == seq) return true;
+    }
+    s->seqs[s->head] = seq;
+    s->head = (uint8_t)((s->head + 1) % RELIABLE_DEDUP_DEPTH);
+    if (s->n < RELIABLE_DEDUP_DEPTH) s->n++;
+    return false;
+}
@@ -0,0 +1,61 @@
+// src/slip.c — single-sample slips to track the conductor timeline
+#include <stdlib.h>
+#include <string.h>
+
+#include "slip.h"
+
+void slip_init(slip_ctl_t *s)
+{
+    memset(s, 0, sizeof(*s));
+}
+
+int32_t slip_measure(slip_ctl_t *s, int32_t err, int32_t in_flight)
+{
+    // First reading includes the start error; only later ones count as
+    // steady-state tracking error
+    if (s->n_meas++ && abs(err) > s->max_err) s->max_err = abs(err);
+    s->last_err = err;
+
+    // Error once everything already rendered has been heard
+    int32_t due = err + in_flight;
+
+    if (abs(due) > SLIP_HARD_SAMPLES) {
+        s->pending = 0;
+        s->cum -= due;
+        s->jumps++;
+        return -due;
+    }
+    // Half the error per measurement: clock-sync noise does not turn into
+    // back-and-forth slips, real drift is still followed within a few periods
+    s->pending = abs(due) <= SLIP_DEADBAND ? 0 : -due / 2;
+    return 0;
+}
+
+int slip_next(slip_ctl_t *s)
+{
+    if (s->pending > 0) {
+        s->pending--;
+        s->cum++;
+        s->skipped++;
+        return 1;
+    }
+    if (s->pending < 0) {
+        s->pending++;
+        s->cum--;
+        s->repeated++;
+        return -1;
+    }
+    return 0;
+}
+
+void slip_apply_block(int32_t *acc, size_t block_len, int d)
+{
+    size_t mid = block_len / 2;
+    if (d > 0) {
+        // block_len + 1 rendered: drop acc[mid]
+        memmove(&acc[mid], &acc[mid + 1], (block_len - mid) * sizeof(*acc));
+    } else if (d < 0) {
+        // block_len - 1 rendered: play acc[mid] twice
+        memmove(&acc[mid + 1], &acc[mid], (block_len - 1 - mid) * sizeof(*acc));
+    }
+}
@@ -0,0 +1,116 @@
+// src/song_lib.c — check and read a song library image in place
+#include <string.h>
+
+#include "song_lib.h"
+
+// CRC-32 (IEEE, reflected poly 0xEDB88320), nibble table. Pass 0 to start.
+uint32_t song_lib_crc32(uint32_t crc, const uint8_t *data, size_t len)
+{
+    static const uint32_t k_nibble[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+    crc = ~crc;
+    for (size_t i = 0; i < len; ++i) {
+        crc = (crc >> 4) ^ k_nibble[(crc ^ data[i]) & 0x0F];
+        crc = (crc >> 4) ^ k_nibble[(crc ^ (data[i] >> 4)) & 0x0F];
+    }
+    return ~crc;
+}
+
+// A section of n bytes at off lies inside the image and is 4-byte aligned
+static bool in_image(const song_lib_hdr_t *h, uint32_t off, uint32_t n)
+{
+    return (off & 3u) == 0 && off >= sizeof(*h) && off <= h->total_len && n <= h->total_len - off;
+}
+
+// The melody's count notes all end inside the image
+static bool melody_ok(const song_lib_hdr_t *h, const uint8_t *img, const song_lib_mel_t *m)
+{
+    if (!m->off) return m->count == 0;
+    if (m->off < sizeof(*h) || m->off >= h->total_len) return false;
+    uint32_t pos = m->off;
+    for (uint16_t i = 0; i < m->count; ++i) {
+        if (pos >= h->total_len) return false;
+        pos += (uint32_t)song_pack_note_size(img[pos]);
+    }
+    return pos <= h->total_len;
+}
+
+song_lib_err_t song_lib_open(song_lib_t *lib, const uint8_t *img, size_t len)
+{
+    const song_lib_hdr_t *h = (const song_lib_hdr_t *)img;
+    if (len < sizeof(*h)) return SONG_LIB_ERR_SHORT;
+    if (h->magic != SONG_LIB_MAGIC) return SONG_LIB_ERR_MAGIC;
+    if (h->version != SONG_LIB_VERSION) return SONG_LIB_ERR_VERSION;
+    if (h->total_len < sizeof(*h) || h->total_len > len) return SONG_LIB_ERR_SHORT;
+    if (song_lib_crc32(0, img + sizeof(*h), h->total_len - sizeof(*h)) != h->crc32) {
+        return SONG_LIB_ERR_CRC;
+    }
+
+    if (h->n_pitch > SONG_PACK_MAX_PITCHES || h->n_dur > SONG_PACK_MAX_DURS ||
+        h->song_count > SONG_LIB_MAX_SONGS ||
+        !in_image(h, h->tables_off, 2u * (h->n_pitch + h->n_dur)) ||
+        !in_image(h, h->index_off, 4u * h->song_count)) {
+        return SONG_LIB_ERR_LAYOUT;
+    }
+    const uint32_t *index = (const uint32_t *)(img + h->index_off);
+    for (uint16_t i = 0; i < h->song_count; ++i) {
+        if (!in_image(h, index[i], sizeof(song_lib_rec_t))) return SONG_LIB_ERR_LAYOUT;
+        const song_lib_rec_t *r = (const song_lib_rec_t *)(img + index[i]);
+        if (!memchr(r->name, 0, sizeof(r->name)) || !melody_ok(h, img, &r->lead)) {
+            return SONG_LIB_ERR_LAYOUT;
+        }
+        for (int p = 0; p < 5; ++p) {
+            if (!melody_ok(h, img, &r->parts[p])) return SONG_LIB_ERR_LAYOUT;
+        }
+    }
+
+    const uint16_t *tables = (const uint16_t *)(img + h->tables_off);
+    lib->img    = img;
+    lib->hdr    = h;
+    lib->index  = index;
+    lib->tables = (song_pack_tables_t){
+        .pitch_hz = tables,
+        .dur_ms   = tables + h->n_pitch,
+        .n_pitch  = h->n_pitch,
+        .n_dur    = h->n_dur,
+    };
+    return SONG_LIB_OK;
+}
+
+const char *song_lib_err_str(song_lib_err_t err)
+{
+    switch (err) {
+        case SONG_LIB_OK:          return "ok";
+        case SONG_LIB_ERR_SHORT:   return "short";
+        case SONG_LIB_ERR_MAGIC:   return "no library";
+        case SONG_LIB_ERR_VERSION: return "version";
+        case SONG_LIB_ERR_CRC:     return "bad crc";
+        case SONG_LIB_ERR_LAYOUT:  return "bad layout";
+        default:                   return "?";
+    }
+}
+
+static const uint8_t *mel_ptr(const song_lib_t *lib, const song_lib_mel_t *m)
+{
+    return m->off ? lib->img + m->off : NULL;
+}
+
+void song_lib_song(const song_lib_t *lib, uint16_t id, song_t *out)
+{
+    const song_lib_rec_t *r = song_lib_rec(lib, id);
+    memset(out, 0, sizeof(*out));
+    out->name       = r->name;
+    out->type       = (song_type_t)r->type;
+    out->notes      = mel_ptr(lib, &r->lead);
+    out->note_count = r->lead.count;
+    out->tables     = &lib->tables;
+    out->parts_mask = r->parts_mask;
+    out->envelope   = r->envelope;
+    for (int p = 0; p < 5; ++p) {
+        out->parts[p].notes      = mel_ptr(lib, &r->parts[p]);
+        out->parts[p].note_count = r->parts[p].count;
+        out->parts[p].envelope   = r->parts[p].envelope;
+    }
+}
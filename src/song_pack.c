@@ -0,0 +1,81 @@
+// src/song_pack.c — one-byte note coding and its streaming decoder
+#include "song_pack.h"
+
+static inline uint16_t rd16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+void song_pack_iter_init(song_pack_iter_t *it, const song_pack_tables_t *t,
+                         const uint8_t *notes, uint16_t count)
+{
+    it->t     = t;
+    it->base  = notes;
+    it->p     = notes;
+    it->count = notes ? count : 0;
+    it->index = 0;
+}
+
+bool song_pack_next(song_pack_iter_t *it, note_t *out)
+{
+    if (it->index >= it->count) return false;
+    uint8_t b  = *it->p++;
+    uint8_t pi = b >> 3, di = b & 7u;
+
+    if (pi == SONG_PACK_PITCH_ESC) {
+        out->frequency = rd16(it->p);
+        it->p += 2;
+    } else {
+        // Out-of-table indexes only come from a corrupt blob: play a rest
+        out->frequency = pi < it->t->n_pitch ? it->t->pitch_hz[pi] : 0;
+    }
+    if (di == SONG_PACK_DUR_ESC) {
+        out->duration_ms = rd16(it->p);
+        it->p += 2;
+    } else {
+        out->duration_ms = di < it->t->n_dur ? it->t->dur_ms[di] : 0;
+    }
+    it->index++;
+    return true;
+}
+
+void song_pack_skip(song_pack_iter_t *it, uint16_t n)
+{
+    uint16_t left = (uint16_t)(it->count - it->index);
+    if (n > left) n = left;
+    for (uint16_t i = 0; i < n; ++i) it->p += song_pack_note_size(*it->p);
+    it->index = (uint16_t)(it->index + n);
+}
+
+static uint8_t find16(const uint16_t *tab, uint8_t n, uint16_t v, uint8_t esc)
+{
+    for (uint8_t i = 0; i < n && i < esc; ++i) {
+        if (tab[i] == v) return i;
+    }
+    return esc;
+}
+
+size_t song_pack_encode(const song_pack_tables_t *t, const note_t *notes, uint16_t count,
+                        uint8_t *out, size_t cap)
+{
+    size_t len = 0;
+    for (uint16_t i = 0; i < count; ++i) {
+        uint8_t pi = find16(t->pitch_hz, t->n_pitch, notes[i].frequency, SONG_PACK_PITCH_ESC);
+        uint8_t di = find16(t->dur_ms, t->n_dur, notes[i].duration_ms, SONG_PACK_DUR_ESC);
+        uint8_t note[SONG_PACK_MAX_NOTE];
+        size_t n = 0;
+        note[n++] = SONG_PACK_NOTE(pi, di);
+        if (pi == SONG_PACK_PITCH_ESC) {
+            note[n++] = (uint8_t)notes[i].frequency;
+            note[n++] = (uint8_t)(notes[i].frequency >> 8);
+        }
+        if (di == SONG_PACK_DUR_ESC) {
+            note[n++] = (uint8_t)notes[i].duration_ms;
+            note[n++] = (uint8_t)(notes[i].duration_ms >> 8);
+        }
+        for (size_t k = 0; k < n; ++k, ++len) {
+            if (out && len < cap) out[len] = note[k];
+        }
+    }
+    return len;
+}
@@ -0,0 +1,110 @@
+// src/song_store.c — song library read in place from the "songs" partition
+#include <stdlib.h>
+
+#include "esp_log.h"
+#include "esp_partition.h"
+
+#include "song_store.h"
+#include "song_lib.h"
+#include "songs.h"
+
+static const char *TAG = "SONG_STORE";
+
+static const esp_partition_t *s_part = NULL;
+static esp_partition_mmap_handle_t s_map;
+static song_lib_t s_lib;
+static song_t    *s_songs = NULL;   // one view per song, pointing into the mapping
+
+// Map the partition and make its library the active one; false (built-in
+// songs stay active) if it holds none
+static bool mount(void)
+{
+    const void *img = NULL;
+    esp_err_t err = esp_partition_mmap(s_part, 0, s_part->size, ESP_PARTITION_MMAP_DATA, &img, &s_map);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "mmap of '%s' failed (%s), using built-in songs", s_part->label, esp_err_to_name(err));
+        return false;
+    }
+
+    // Checks the CRC and every offset once; after that lookups trust the image
+    song_lib_err_t lerr = song_lib_open(&s_lib, img, s_part->size);
+    if (lerr != SONG_LIB_OK || song_lib_count(&s_lib) == 0) {
+        ESP_LOGI(TAG, "Partition '%s': %s, using %u built-in songs", s_part->label,
+                 lerr != SONG_LIB_OK ? song_lib_err_str(lerr) : "empty library", total_songs);
+        esp_partition_munmap(s_map);
+        return false;
+    }
+
+    uint16_t count = song_lib_count(&s_lib);
+    s_songs = calloc(count, sizeof(*s_songs));
+    if (!s_songs) {
+        ESP_LOGE(TAG, "No memory for %u song views", count);
+        esp_partition_munmap(s_map);
+        return false;
+    }
+    for (uint16_t i = 0; i < count; ++i) song_lib_song(&s_lib, i, &s_songs[i]);
+    songs_use_library(s_songs, (uint8_t)count);
+
+    ESP_LOGI(TAG, "%u songs from partition '%s' (%u of %u KB used, %u B RAM)",
+             count, s_part->label, (unsigned)(s_lib.hdr->total_len / 1024),
+             (unsigned)(s_part->size / 1024), (unsigned)(count * sizeof(*s_songs)));
+    return true;
+}
+
+// Back to the built-in songs and release the mapping
+static void unmount(void)
+{
+    if (!s_songs) return;
+    songs_use_library(NULL, 0);
+    free(s_songs);
+    s_songs = NULL;
+    esp_partition_munmap(s_map);
+}
+
+void song_store_init(void)
+{
+    s_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, SONG_STORE_SUBTYPE, SONG_STORE_LABEL);
+    if (!s_part) {
+        ESP_LOGI(TAG, "No '%s' partition, using %u built-in songs", SONG_STORE_LABEL, total_songs);
+        return;
+    }
+    mount();
+}
+
+bool song_store_active(void)
+{
+    return s_songs != NULL;
+}
+
+bool song_store_image(const uint8_t **img, size_t *len)
+{
+    if (!s_songs) return false;
+    *img = s_lib.img;
+    *len = s_lib.hdr->total_len;
+    return true;
+}
+
+esp_err_t song_store_install(const uint8_t *img, size_t len)
+{
+    if (!s_part) return ESP_ERR_NOT_FOUND;
+    if (len > s_part->size) return ESP_ERR_INVALID_SIZE;
+
+    // Check the new image before the old one is erased
+    song_lib_t lib;
+    song_lib_err_t lerr = song_lib_open(&lib, img, len);
+    if (lerr != SONG_LIB_OK) {
+        ESP_LOGW(TAG, "Refusing library image: %s", song_lib_err_str(lerr));
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    unmount();
+    size_t erase = (len + s_part->erase_size - 1) / s_part->erase_size * s_part->erase_size;
+    esp_err_t err = esp_partition_erase_range(s_part, 0, erase);
+    if (err == ESP_OK) err = esp_partition_write(s_part, 0, img, len);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Writing '%s' failed (%s), using built-in songs", s_part->label, esp_err_to_name(err));
+        return err;
+    }
+    ESP_LOGI(TAG, "Wrote %u B library to '%s'", (unsigned)len, s_part->label);
+    return mount() ? ESP_OK : ESP_FAIL;
+}
@@ -0,0 +1,404 @@
+// src/song_sync.c — conductor pushes the song library or firmware, performers store it
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+
+#include "song_sync.h"
+#include "blob_xfer.h"
+#include "song_store.h"
+#include "espnow_comm.h"         // espnow_frame_begin/send, espnow_ensure_peer
+#include "espnow_discovery.h"    // online performers
+#include "device_config.h"
+#include "orchestra.h"           // orchestra_stop()
+#include "audio.h"               // audio_cache_drop()
+#include "fw_update.h"           // fw_update_sink()
+
+static const char *TAG = "SONG_SYNC";
+
+static const uint8_t s_broadcast_mac[TRANSPORT_ADDR_LEN] =
+    { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+#define SYNC_QUEUE_LEN     16
+#define SYNC_IDLE_POLL_MS  1000   // receiver timeout check while a transfer is open
+
+// Queue item: one blob frame's header fields and payload (len 0 = wake up)
+typedef struct {
+    uint8_t src_mac[TRANSPORT_ADDR_LEN];
+    uint8_t type;
+    uint8_t len;
+    int64_t rx_us;
+    uint8_t payload[WIRE_MAX_PAYLOAD];
+} sync_rx_t;
+
+static QueueHandle_t     s_queue = NULL;
+static SemaphoreHandle_t s_tx_lock = NULL;
+static blob_tx_t         s_tx;
+static bool              s_tx_reported = true;
+static blob_rx_t         s_rx;
+static const blob_sink_t *s_sink = NULL;    // performer: where the current blob goes
+static uint8_t          *s_buf = NULL;      // performer: the library being received
+static uint32_t          s_buf_len = 0;
+
+// Conductor: one push to the fleet, as one transfer or one per performer
+static struct {
+    uint8_t        kind;
+    const uint8_t *data;
+    uint32_t       len;
+    uint8_t        macs[BLOB_MAX_PEERS][6];
+    size_t         n;
+    size_t         next;        // first performer not yet started
+    bool           one_by_one;
+    int            ok;          // performers that reported DONE
+    int64_t        start_us;
+} s_fleet;
+static const uint8_t    *s_unicast_to = NULL;   // one_by_one: the performer being updated
+
+// ----------------------
+// Radio
+// ----------------------
+static bool sync_send(void *ctx, const uint8_t *mac, uint8_t type, const uint8_t *payload, size_t len)
+{
+    (void)ctx;
+    uint8_t buf[WIRE_MAX_FRAME];
+    wire_writer_t w;
+    if (!mac) mac = s_unicast_to;   // one after another: nobody else listens
+    espnow_frame_begin(&w, buf, sizeof(buf), type);
+    wire_put_bytes(&w, payload, len);
+    if (mac) espnow_ensure_peer(mac);
+    // NO_MEM: the ESP-NOW queue is full, blob_xfer offers the frame again
+    return espnow_frame_send(mac ? mac : s_broadcast_mac, &w) == ESP_OK;
+}
+
+// ----------------------
+// Performer: song library, received into RAM and installed on commit
+// ----------------------
+static bool songs_begin(void *ctx, uint8_t kind, uint32_t len)
+{
+    (void)ctx;
+    (void)kind;
+    if (len > SONG_SYNC_MAX_LEN) {
+        ESP_LOGW(TAG, "Refusing a %u B library", (unsigned)len);
+        return false;
+    }
+    free(s_buf);
+    s_buf     = malloc(len);
+    s_buf_len = s_buf ? len : 0;
+    if (!s_buf) {
+        ESP_LOGE(TAG, "No memory for a %u B library", (unsigned)len);
+        return false;
+    }
+    ESP_LOGI(TAG, "Receiving a %u B song library", (unsigned)len);
+    return true;
+}
+
+static bool songs_write(void *ctx, uint32_t off, const uint8_t *data, size_t len)
+{
+    (void)ctx;
+    if (!s_buf || off + len > s_buf_len) return false;
+    memcpy(s_buf + off, data, len);
+    return true;
+}
+
+static bool songs_read(void *ctx, uint32_t off, uint8_t *data, size_t len)
+{
+    (void)ctx;
+    if (!s_buf || off + len > s_buf_len) return false;
+    memcpy(data, s_buf + off, len);
+    return true;
+}
+
+static void songs_abort(void *ctx)
+{
+    (void)ctx;
+    free(s_buf);
+    s_buf     = NULL;
+    s_buf_len = 0;
+}
+
+static bool songs_commit(void *ctx, uint8_t kind, uint32_t len)
+{
+    (void)kind;
+    // Song ids are about to mean other songs: nothing may still be playing
+    // or pre-rendering from the old library
+    orchestra_stop();
+    audio_cache_drop();
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = song_store_install(s_buf, len);
+    int64_t t_flash = esp_timer_get_time() - t0;
+    songs_abort(ctx);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Library not installed (%s)", esp_err_to_name(err));
+        return false;
+    }
+    ESP_LOGI(TAG, "Library installed, flash write %lld ms", (long long)(t_flash / 1000));
+    return true;
+}
+
+static const blob_sink_t k_songs_sink = {
+    .begin  = songs_begin,
+    .write  = songs_write,
+    .read   = songs_read,
+    .commit = songs_commit,
+    .abort  = songs_abort,
+};
+
+// ----------------------
+// Performer: sink by blob kind
+// ----------------------
+static bool sink_begin(void *ctx, uint8_t kind, uint32_t len)
+{
+    switch (kind) {
+        case BLOB_KIND_SONGS:    s_sink = &k_songs_sink;    break;
+        case BLOB_KIND_FIRMWARE: s_sink = fw_update_sink(); break;
+        default:
+            ESP_LOGW(TAG, "Refusing blob kind %u", (unsigned)kind);
+            s_sink = NULL;
+            return false;
+    }
+    return s_sink->begin(ctx, kind, len);
+}
+
+static bool sink_write(void *ctx, uint32_t off, const uint8_t *data, size_t len)
+{
+    return s_sink && s_sink->write(ctx, off, data, len);
+}
+
+static bool sink_read(void *ctx, uint32_t off, uint8_t *data, size_t len)
+{
+    return s_sink && s_sink->read(ctx, off, data, len);
+}
+
+static void sink_abort(void *ctx)
+{
+    if (s_sink) s_sink->abort(ctx);
+}
+
+static bool sink_commit(void *ctx, uint8_t kind, uint32_t len)
+{
+    int64_t t_rx = esp_timer_get_time() - s_rx.first_us;
+    ESP_LOGI(TAG, "Blob kind %u: %u B received in %lld ms (%.1f KB/s), %u dup, %u bad chunks",
+             (unsigned)kind, (unsigned)len, (long long)(t_rx / 1000),
+             t_rx > 0 ? len * 1e6 / 1024.0 / t_rx : 0.0, (unsigned)s_rx.dups,
+             (unsigned)s_rx.bad_chunks);
+    return s_sink && s_sink->commit(ctx, kind, len);
+}
+
+static const blob_sink_t k_sink = {
+    .begin  = sink_begin,
+    .write  = sink_write,
+    .read   = sink_read,
+    .commit = sink_commit,
+    .abort  = sink_abort,
+};
+
+// ----------------------
+// Conductor: report
+// ----------------------
+static const char *peer_state_str(uint8_t st)
+{
+    switch (st) {
+        case BLOB_RX_DONE:      return "updated";
+        case BLOB_RX_FAILED:    return "FAILED";
+        case BLOB_RX_RECEIVING: return "receiving";
+        default:                return "no answer";
+    }
+}
+
+// One transfer's result per performer; returns how many got the blob
+static int log_report(const blob_tx_t *tx)
+{
+    int64_t all_us = 0;
+    int n_ok = 0;
+    for (int i = 0; i < tx->n_peers; ++i) {
+        const blob_tx_peer_t *p = &tx->peers[i];
+        int64_t t = p->done_us ? p->done_us - tx->start_us : 0;
+        if (p->state == BLOB_RX_DONE) {
+            n_ok++;
+            if (t > all_us) all_us = t;
+        }
+        ESP_LOGI(TAG, "  %-8s %s after %lld ms, %u unicast repairs",
+                 device_config_get_role_name(espnow_discovery_get_peer_role(p->mac)),
+                 peer_state_str(p->state), (long long)(t / 1000), (unsigned)p->unicast);
+    }
+    ESP_LOGI(TAG, "Push: %u B to %d/%u performers in %lld ms (%.1f KB/s), %u frames "
+             "(%u data, %u repairs broadcast, %u unicast, %u rounds)",
+             (unsigned)tx->len, n_ok, (unsigned)tx->n_peers, (long long)(all_us / 1000),
+             all_us > 0 ? tx->len * 1e6 / 1024.0 / all_us : 0.0, (unsigned)tx->frames,
+             (unsigned)tx->data_frames, (unsigned)tx->repairs_bcast, (unsigned)tx->repairs_ucast,
+             (unsigned)tx->rounds);
+    return n_ok;
+}
+
+// Start the next transfer of the fleet push: everyone, or the next
+// performer alone (call with s_tx_lock held)
+static bool fleet_start_next(int64_t now_us)
+{
+    size_t first = s_fleet.next;
+    size_t n = s_fleet.one_by_one ? 1 : s_fleet.n - first;
+    s_unicast_to = s_fleet.one_by_one ? s_fleet.macs[first] : NULL;
+    if (!blob_tx_start(&s_tx, s_fleet.data, s_fleet.len, s_fleet.kind, (uint16_t)esp_random(),
+                       (const uint8_t (*)[6])s_fleet.macs[first], n, now_us)) {
+        s_unicast_to = NULL;
+        return false;
+    }
+    s_fleet.next += n;
+    s_tx_reported = false;
+    return true;
+}
+
+// A transfer finished: next performer, or the fleet total
+static void fleet_done(int64_t now_us)
+{
+    s_fleet.ok += log_report(&s_tx);
+    if (s_fleet.next < s_fleet.n) {
+        if (fleet_start_next(now_us)) return;
+        s_fleet.n = s_fleet.next;
+    }
+    s_unicast_to = NULL;
+    int64_t t = now_us - s_fleet.start_us;
+    ESP_LOGI(TAG, "Fleet update (%s): %d/%u performers have the %u B blob after %lld ms, "
+             "aggregate %.1f KB/s", s_fleet.one_by_one ? "one after another" : "all at once",
+             s_fleet.ok, (unsigned)s_fleet.n, (unsigned)s_fleet.len, (long long)(t / 1000),
+             t > 0 ? (double)s_fleet.ok * s_fleet.len * 1e6 / 1024.0 / t : 0.0);
+}
+
+// ----------------------
+// Task
+// ----------------------
+static void sync_task(void *pv)
+{
+    (void)pv;
+    sync_rx_t item;
+    for (;;) {
+        int64_t now = esp_timer_get_time();
+        xSemaphoreTake(s_tx_lock, portMAX_DELAY);
+        int64_t next = blob_tx_poll(&s_tx, now);
+        if (s_tx.phase == BLOB_TX_DONE && !s_tx_reported) {
+            s_tx_reported = true;
+            fleet_done(now);
+            if (blob_tx_busy(&s_tx)) next = blob_tx_poll(&s_tx, now);
+        }
+        xSemaphoreGive(s_tx_lock);
+
+        TickType_t wait = portMAX_DELAY;
+        if (next != INT64_MAX) {
+            wait = next > now ? pdMS_TO_TICKS((next - now) / 1000) : 0;
+            if (wait == 0) wait = 1;   // paced sends: at most a tick late, sent as a burst
+        } else if (s_rx.state == BLOB_RX_RECEIVING) {
+            wait = pdMS_TO_TICKS(SYNC_IDLE_POLL_MS);
+        }
+
+        if (xQueueReceive(s_queue, &item, wait) == pdTRUE && item.len) {
+            wire_frame_t f = { .type = item.type, .len = item.len, .payload = item.payload };
+            if (item.type == WIRE_T_BLOB + BLOB_MSG_STATUS) {
+                xSemaphoreTake(s_tx_lock, portMAX_DELAY);
+                blob_tx_handle(&s_tx, item.src_mac, &f, item.rx_us);
+                xSemaphoreGive(s_tx_lock);
+            } else if (device_config_get_role() != ROLE_CONDUCTOR) {
+                blob_rx_handle(&s_rx, item.src_mac, &f, item.rx_us);
+            }
+        }
+        if (s_rx.state == BLOB_RX_RECEIVING) {
+            blob_rx_poll(&s_rx, esp_timer_get_time());
+            if (s_rx.state == BLOB_RX_IDLE) ESP_LOGW(TAG, "Library transfer abandoned (sender silent)");
+        }
+    }
+}
+
+// ----------------------
+// Public API
+// ----------------------
+esp_err_t song_sync_init(void)
+{
+    blob_tx_init(&s_tx, sync_send, NULL);
+    blob_rx_init(&s_rx, &k_sink, sync_send, NULL);
+    s_tx_lock = xSemaphoreCreateMutex();
+    s_queue   = xQueueCreate(SYNC_QUEUE_LEN, sizeof(sync_rx_t));
+    if (!s_tx_lock || !s_queue) {
+        ESP_LOGE(TAG, "Failed to create song sync queue");
+        return ESP_ERR_NO_MEM;
+    }
+    // Below control traffic: a transfer never delays START/STOP handling
+    xTaskCreate(sync_task, "song_sync", 4096, NULL, 6, NULL);   // OTA image checks need the room
+    return ESP_OK;
+}
+
+void song_sync_handle_frame(const uint8_t *src_mac, const wire_frame_t *f, int64_t rx_us)
+{
+    if (!s_queue || !f->len) return;
+    sync_rx_t item = { .type = f->type, .len = f->len, .rx_us = rx_us };
+    memcpy(item.src_mac, src_mac, TRANSPORT_ADDR_LEN);
+    memcpy(item.payload, f->payload, f->len);
+    // Full queue: the frame counts as lost and is repaired like one
+    (void)xQueueSend(s_queue, &item, 0);
+}
+
+esp_err_t song_sync_send(uint8_t kind, const uint8_t *data, size_t len, bool one_by_one)
+{
+    uint8_t macs[BLOB_MAX_PEERS][6];
+    size_t n = espnow_discovery_get_online_performers(macs, BLOB_MAX_PEERS);
+    if (!n) {
+        ESP_LOGW(TAG, "No performers online");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    xSemaphoreTake(s_tx_lock, portMAX_DELAY);
+    bool busy = blob_tx_busy(&s_tx) || s_fleet.next < s_fleet.n;
+    bool ok = false;
+    if (!busy) {
+        s_fleet.kind       = kind;
+        s_fleet.data       = data;
+        s_fleet.len        = (uint32_t)len;
+        s_fleet.n          = n;
+        s_fleet.next       = 0;
+        s_fleet.one_by_one = one_by_one;
+        s_fleet.ok         = 0;
+        s_fleet.start_us   = esp_timer_get_time();
+        memcpy(s_fleet.macs, macs, sizeof(macs));
+        s_tx.max_silent = kind == BLOB_KIND_FIRMWARE ? BLOB_FW_MAX_SILENT : BLOB_MAX_SILENT;
+        ok = fleet_start_next(s_fleet.start_us);
+        if (!ok) s_fleet.n = 0;
+    }
+    xSemaphoreGive(s_tx_lock);
+    if (!ok) {
+        ESP_LOGW(TAG, "Push not started (%s)", busy ? "push in progress" : "blob too large");
+        return busy ? ESP_ERR_INVALID_STATE : ESP_ERR_INVALID_SIZE;
+    }
+    ESP_LOGI(TAG, "Sending %u B (kind %u) to %u performers%s", (unsigned)len, (unsigned)kind,
+             (unsigned)n, one_by_one ? ", one after another" : "");
+
+    // Wake the task so the OFFER goes out now
+    sync_rx_t wake = { .len = 0 };
+    xQueueSend(s_queue, &wake, 0);
+    return ESP_OK;
+}
+
+esp_err_t song_sync_push(void)
+{
+    const uint8_t *img;
+    size_t len;
+    if (!song_store_image(&img, &len)) {
+        ESP_LOGW(TAG, "Built-in songs active: no library image to push");
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (len > SONG_SYNC_MAX_LEN) {
+        ESP_LOGW(TAG, "Library is %u B, performers take at most %u B", (unsigned)len,
+                 (unsigned)SONG_SYNC_MAX_LEN);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return song_sync_send(BLOB_KIND_SONGS, img, len, false);
+}
+
+bool song_sync_busy(void)
+{
+    return blob_tx_busy(&s_tx) || s_fleet.next < s_fleet.n || s_rx.state == BLOB_RX_RECEIVING;
+}
@@ -1,90 +1,107 @@
+#include <stdlib.h>
+
 #include "songs.h"
+#include "synth.h"   // SYNTH_ENV_* presets
+#include "note_timeline.h"   // note_index_build()
+
+// Tables every built-in melody is packed against (song_pack.h)
+#define SONG_PITCH_HZ(n) NOTE_##n,
+#define SONG_DUR_MS(n)   n##_NOTE,
+static const uint16_t k_pitch_hz[] = { SONG_PITCHES(SONG_PITCH_HZ) };
+static const uint16_t k_dur_ms[]   = { SONG_DURATIONS(SONG_DUR_MS) };
+
+const song_pack_tables_t song_tables = {
+    .pitch_hz = k_pitch_hz,
+    .dur_ms   = k_dur_ms,
+    .n_pitch  = PITCH_COUNT,
+    .n_dur    = DUR_COUNT,
+};
 
 // Blue Bells of Scotland - Solo for Part 1
-const note_t blue_bells_notes[] = {
-    {NOTE_C5, QUARTER_NOTE}, {NOTE_F5, HALF_NOTE}, {NOTE_E5, QUARTER_NOTE},
-    {NOTE_D5, QUARTER_NOTE}, {NOTE_C5, HALF_NOTE}, {NOTE_D5, QUARTER_NOTE},
-    {NOTE_E5, EIGHTH_NOTE}, {NOTE_F5, EIGHTH_NOTE}, {NOTE_A4, QUARTER_NOTE},
-    {REST, QUARTER_NOTE}, {NOTE_A4, QUARTER_NOTE}, {NOTE_AS4, QUARTER_NOTE},
-    {NOTE_G4, QUARTER_NOTE}, {NOTE_F4, HALF_NOTE}, {NOTE_C5, QUARTER_NOTE},
-    {NOTE_F5, HALF_NOTE}, {NOTE_E5, QUARTER_NOTE}, {NOTE_D5, QUARTER_NOTE},
-    {NOTE_C5, HALF_NOTE}, {NOTE_D5, QUARTER_NOTE}, {NOTE_E5, EIGHTH_NOTE},
-    {NOTE_F5, EIGHTH_NOTE}, {NOTE_A4, QUARTER_NOTE}, {REST, QUARTER_NOTE},
-    {NOTE_A4, QUARTER_NOTE}, {NOTE_C5, SIXTEENTH_NOTE}, {NOTE_AS4, SIXTEENTH_NOTE},
-    {NOTE_AS4, EIGHTH_NOTE}, {NOTE_G4, QUARTER_NOTE}, {NOTE_F4, HALF_NOTE}
+const uint8_t blue_bells_notes[] = {
+    NOTE(C5, QUARTER), NOTE(F5, HALF), NOTE(E5, QUARTER),
+    NOTE(D5, QUARTER), NOTE(C5, HALF), NOTE(D5, QUARTER),
+    NOTE(E5, EIGHTH), NOTE(F5, EIGHTH), NOTE(A4, QUARTER),
+    NOTE(REST, QUARTER), NOTE(A4, QUARTER), NOTE(AS4, QUARTER),
+    NOTE(G4, QUARTER), NOTE(F4, HALF), NOTE(C5, QUARTER),
+    NOTE(F5, HALF), NOTE(E5, QUARTER), NOTE(D5, QUARTER),
+    NOTE(C5, HALF), NOTE(D5, QUARTER), NOTE(E5, EIGHTH),
+    NOTE(F5, EIGHTH), NOTE(A4, QUARTER), NOTE(REST, QUARTER),
+    NOTE(A4, QUARTER), NOTE(C5, SIXTEENTH), NOTE(AS4, SIXTEENTH),
+    NOTE(AS4, EIGHTH), NOTE(G4, QUARTER), NOTE(F4, HALF)
 };
 
 // Carnival of Venice Theme - Solo for Part 3
-const note_t carnival_theme_notes[] = {
-    {NOTE_C5, EIGHTH_NOTE}, {NOTE_AS4, EIGHTH_NOTE}, {NOTE_A4, QUARTER_NOTE},
-    {NOTE_F4, QUARTER_NOTE}, {NOTE_A4, QUARTER_NOTE}, {NOTE_C5, QUARTER_NOTE},
-    {NOTE_F5, HALF_NOTE}, {NOTE_D5, QUARTER_NOTE}, {NOTE_E5, EIGHTH_NOTE},
-    {NOTE_F5, EIGHTH_NOTE}, {NOTE_E5, QUARTER_NOTE}, {NOTE_C5, QUARTER_NOTE},
-    {NOTE_D5, QUARTER_NOTE}, {NOTE_B4, QUARTER_NOTE}, {NOTE_C5, HALF_NOTE},
-    {NOTE_D5, QUARTER_NOTE}, {NOTE_E5, QUARTER_NOTE}, {NOTE_F5, HALF_NOTE},
-    {NOTE_E5, QUARTER_NOTE}, {NOTE_D5, QUARTER_NOTE}, {NOTE_C5, HALF_NOTE},
-    {NOTE_D5, QUARTER_NOTE}, {NOTE_E5, EIGHTH_NOTE}, {NOTE_F5, EIGHTH_NOTE},
-    {NOTE_A4, QUARTER_NOTE}, {REST, QUARTER_NOTE}, {NOTE_A4, QUARTER_NOTE},
-    {NOTE_AS4, QUARTER_NOTE}, {NOTE_G4, QUARTER_NOTE}, {NOTE_F4, HALF_NOTE}
+const uint8_t carnival_theme_notes[] = {
+    NOTE(C5, EIGHTH), NOTE(AS4, EIGHTH), NOTE(A4, QUARTER),
+    NOTE(F4, QUARTER), NOTE(A4, QUARTER), NOTE(C5, QUARTER),
+    NOTE(F5, HALF), NOTE(D5, QUARTER), NOTE(E5, EIGHTH),
+    NOTE(F5, EIGHTH), NOTE(E5, QUARTER), NOTE(C5, QUARTER),
+    NOTE(D5, QUARTER), NOTE(B4, QUARTER), NOTE(C5, HALF),
+    NOTE(D5, QUARTER), NOTE(E5, QUARTER), NOTE(F5, HALF),
+    NOTE(E5, QUARTER), NOTE(D5, QUARTER), NOTE(C5, HALF),
+    NOTE(D5, QUARTER), NOTE(E5, EIGHTH), NOTE(F5, EIGHTH),
+    NOTE(A4, QUARTER), NOTE(REST, QUARTER), NOTE(A4, QUARTER),
+    NOTE(AS4, QUARTER), NOTE(G4, QUARTER), NOTE(F4, HALF)
 };
 
 // Carnival of Venice Variation 1 - Solo for Part 2
-const note_t carnival_var1_notes[] = {
-    {NOTE_C5, SIXTEENTH_NOTE}, {NOTE_D5, SIXTEENTH_NOTE}, {NOTE_E5, SIXTEENTH_NOTE}, {NOTE_F5, SIXTEENTH_NOTE},
-    {NOTE_G5, SIXTEENTH_NOTE}, {NOTE_A5, SIXTEENTH_NOTE}, {NOTE_F5, SIXTEENTH_NOTE}, {NOTE_E5, SIXTEENTH_NOTE},
-    {NOTE_D5, EIGHTH_NOTE}, {NOTE_C5, EIGHTH_NOTE}, {NOTE_F5, QUARTER_NOTE},
-    {NOTE_E5, SIXTEENTH_NOTE}, {NOTE_F5, SIXTEENTH_NOTE}, {NOTE_G5, SIXTEENTH_NOTE}, {NOTE_A5, SIXTEENTH_NOTE},
-    {NOTE_F5, EIGHTH_NOTE}, {NOTE_E5, EIGHTH_NOTE}, {NOTE_D5, EIGHTH_NOTE},
-    {NOTE_C5, QUARTER_NOTE}, {NOTE_AS4, EIGHTH_NOTE}, {NOTE_A4, EIGHTH_NOTE},
-    {NOTE_G4, QUARTER_NOTE}, {NOTE_F4, HALF_NOTE}
+const uint8_t carnival_var1_notes[] = {
+    NOTE(C5, SIXTEENTH), NOTE(D5, SIXTEENTH), NOTE(E5, SIXTEENTH), NOTE(F5, SIXTEENTH),
+    NOTE(G5, SIXTEENTH), NOTE(A5, SIXTEENTH), NOTE(F5, SIXTEENTH), NOTE(E5, SIXTEENTH),
+    NOTE(D5, EIGHTH), NOTE(C5, EIGHTH), NOTE(F5, QUARTER),
+    NOTE(E5, SIXTEENTH), NOTE(F5, SIXTEENTH), NOTE(G5, SIXTEENTH), NOTE(A5, SIXTEENTH),
+    NOTE(F5, EIGHTH), NOTE(E5, EIGHTH), NOTE(D5, EIGHTH),
+    NOTE(C5, QUARTER), NOTE(AS4, EIGHTH), NOTE(A4, EIGHTH),
+    NOTE(G4, QUARTER), NOTE(F4, HALF)
 };
 
 // Medallion Calls - Solo for Part 4
-const note_t medallion_calls_notes[] = {
-    {NOTE_C5, QUARTER_NOTE}, {NOTE_F5, QUARTER_NOTE}, {NOTE_F5, EIGHTH_NOTE},
-    {NOTE_F5, EIGHTH_NOTE}, {NOTE_E5, EIGHTH_NOTE}, {NOTE_D5, EIGHTH_NOTE},
-    {NOTE_C5, QUARTER_NOTE}, {NOTE_D5, QUARTER_NOTE}, {NOTE_E5, QUARTER_NOTE},
-    {NOTE_F5, HALF_NOTE}, {NOTE_G5, QUARTER_NOTE}, {NOTE_A5, QUARTER_NOTE},
-    {NOTE_F5, QUARTER_NOTE}, {NOTE_E5, EIGHTH_NOTE}, {NOTE_D5, EIGHTH_NOTE},
-    {NOTE_C5, HALF_NOTE}, {REST, QUARTER_NOTE}, {NOTE_C5, EIGHTH_NOTE},
-    {NOTE_D5, EIGHTH_NOTE}, {NOTE_E5, EIGHTH_NOTE}, {NOTE_F5, EIGHTH_NOTE},
-    {NOTE_G5, QUARTER_NOTE}, {NOTE_F5, QUARTER_NOTE}, {NOTE_E5, QUARTER_NOTE},
-    {NOTE_D5, QUARTER_NOTE}, {NOTE_C5, WHOLE_NOTE}
+const uint8_t medallion_calls_notes[] = {
+    NOTE(C5, QUARTER), NOTE(F5, QUARTER), NOTE(F5, EIGHTH),
+    NOTE(F5, EIGHTH), NOTE(E5, EIGHTH), NOTE(D5, EIGHTH),
+    NOTE(C5, QUARTER), NOTE(D5, QUARTER), NOTE(E5, QUARTER),
+    NOTE(F5, HALF), NOTE(G5, QUARTER), NOTE(A5, QUARTER),
+    NOTE(F5, QUARTER), NOTE(E5, EIGHTH), NOTE(D5, EIGHTH),
+    NOTE(C5, HALF), NOTE(REST, QUARTER), NOTE(C5, EIGHTH),
+    NOTE(D5, EIGHTH), NOTE(E5, EIGHTH), NOTE(F5, EIGHTH),
+    NOTE(G5, QUARTER), NOTE(F5, QUARTER), NOTE(E5, QUARTER),
+    NOTE(D5, QUARTER), NOTE(C5, WHOLE)
 };
 
 // TV Time - Solo for Part 5
-const note_t tv_time_notes[] = {
-    {NOTE_E5, SIXTEENTH_NOTE}, {NOTE_D5, SIXTEENTH_NOTE}, {NOTE_C5, SIXTEENTH_NOTE}, {NOTE_B4, SIXTEENTH_NOTE},
-    {NOTE_C5, EIGHTH_NOTE}, {NOTE_D5, EIGHTH_NOTE}, {NOTE_E5, EIGHTH_NOTE},
-    {NOTE_G5, QUARTER_NOTE}, {NOTE_F5, EIGHTH_NOTE}, {NOTE_E5, EIGHTH_NOTE},
-    {NOTE_D5, QUARTER_NOTE}, {NOTE_C5, QUARTER_NOTE}, {NOTE_E5, SIXTEENTH_NOTE},
-    {NOTE_D5, SIXTEENTH_NOTE}, {NOTE_C5, SIXTEENTH_NOTE}, {NOTE_B4, SIXTEENTH_NOTE},
-    {NOTE_A4, EIGHTH_NOTE}, {NOTE_B4, EIGHTH_NOTE}, {NOTE_C5, QUARTER_NOTE},
-    {NOTE_D5, QUARTER_NOTE}, {NOTE_E5, HALF_NOTE}
+const uint8_t tv_time_notes[] = {
+    NOTE(E5, SIXTEENTH), NOTE(D5, SIXTEENTH), NOTE(C5, SIXTEENTH), NOTE(B4, SIXTEENTH),
+    NOTE(C5, EIGHTH), NOTE(D5, EIGHTH), NOTE(E5, EIGHTH),
+    NOTE(G5, QUARTER), NOTE(F5, EIGHTH), NOTE(E5, EIGHTH),
+    NOTE(D5, QUARTER), NOTE(C5, QUARTER), NOTE(E5, SIXTEENTH),
+    NOTE(D5, SIXTEENTH), NOTE(C5, SIXTEENTH), NOTE(B4, SIXTEENTH),
+    NOTE(A4, EIGHTH), NOTE(B4, EIGHTH), NOTE(C5, QUARTER),
+    NOTE(D5, QUARTER), NOTE(E5, HALF)
 };
 
 // Jupiter Hymn - Quintet (simplified, all parts play same melody in harmony)
-const note_t jupiter_hymn_notes[] = {
-    {NOTE_D5, HALF_NOTE}, {NOTE_G5, HALF_NOTE}, {NOTE_F5, QUARTER_NOTE},
-    {NOTE_E5, QUARTER_NOTE}, {NOTE_F5, HALF_NOTE}, {NOTE_D5, QUARTER_NOTE},
-    {NOTE_E5, QUARTER_NOTE}, {NOTE_F5, QUARTER_NOTE}, {NOTE_G5, QUARTER_NOTE},
-    {NOTE_E5, HALF_NOTE}, {NOTE_D5, HALF_NOTE}, {NOTE_C5, WHOLE_NOTE},
-    {NOTE_D5, HALF_NOTE}, {NOTE_G5, HALF_NOTE}, {NOTE_F5, QUARTER_NOTE},
-    {NOTE_E5, QUARTER_NOTE}, {NOTE_F5, HALF_NOTE}, {NOTE_D5, QUARTER_NOTE},
-    {NOTE_E5, QUARTER_NOTE}, {NOTE_F5, QUARTER_NOTE}, {NOTE_G5, QUARTER_NOTE},
-    {NOTE_A5, HALF_NOTE}, {NOTE_G5, HALF_NOTE}, {NOTE_F5, WHOLE_NOTE}
+const uint8_t jupiter_hymn_notes[] = {
+    NOTE(D5, HALF), NOTE(G5, HALF), NOTE(F5, QUARTER),
+    NOTE(E5, QUARTER), NOTE(F5, HALF), NOTE(D5, QUARTER),
+    NOTE(E5, QUARTER), NOTE(F5, QUARTER), NOTE(G5, QUARTER),
+    NOTE(E5, HALF), NOTE(D5, HALF), NOTE(C5, WHOLE),
+    NOTE(D5, HALF), NOTE(G5, HALF), NOTE(F5, QUARTER),
+    NOTE(E5, QUARTER), NOTE(F5, HALF), NOTE(D5, QUARTER),
+    NOTE(E5, QUARTER), NOTE(F5, QUARTER), NOTE(G5, QUARTER),
+    NOTE(A5, HALF), NOTE(G5, HALF), NOTE(F5, WHOLE)
 };
 
 // Canon in D - Duet (Parts 1&5, then 2&4 play)
-const note_t canon_notes[] = {
-    {NOTE_D5, QUARTER_NOTE}, {NOTE_A4, QUARTER_NOTE}, {NOTE_B4, QUARTER_NOTE},
-    {NOTE_F4, QUARTER_NOTE}, {NOTE_G4, QUARTER_NOTE}, {NOTE_D4, QUARTER_NOTE},
-    {NOTE_G4, QUARTER_NOTE}, {NOTE_A4, QUARTER_NOTE}, {NOTE_D5, QUARTER_NOTE},
-    {NOTE_A4, QUARTER_NOTE}, {NOTE_B4, QUARTER_NOTE}, {NOTE_F4, QUARTER_NOTE},
-    {NOTE_G4, QUARTER_NOTE}, {NOTE_D4, QUARTER_NOTE}, {NOTE_G4, QUARTER_NOTE},
-    {NOTE_A4, QUARTER_NOTE}, {NOTE_B4, HALF_NOTE}, {NOTE_A4, HALF_NOTE},
-    {NOTE_G4, HALF_NOTE}, {NOTE_F4, HALF_NOTE}, {NOTE_E4, WHOLE_NOTE},
-    {NOTE_D4, WHOLE_NOTE}
+const uint8_t canon_notes[] = {
+    NOTE(D5, QUARTER), NOTE(A4, QUARTER), NOTE(B4, QUARTER),
+    NOTE(F4, QUARTER), NOTE(G4, QUARTER), NOTE(D4, QUARTER),
+    NOTE(G4, QUARTER), NOTE(A4, QUARTER), NOTE(D5, QUARTER),
+    NOTE(A4, QUARTER), NOTE(B4, QUARTER), NOTE(F4, QUARTER),
+    NOTE(G4, QUARTER), NOTE(D4, QUARTER), NOTE(G4, QUARTER),
+    NOTE(A4, QUARTER), NOTE(B4, HALF), NOTE(A4, HALF),
+    NOTE(G4, HALF), NOTE(F4, HALF), NOTE(E4, WHOLE),
+    NOTE(D4, WHOLE)
 };
 
 // Song definitions
@@ -93,51 +110,170 @@ const song_t songs[] = {
         .name = "Jupiter Hymn",
         .type = SONG_TYPE_QUINTET,
         .notes = jupiter_hymn_notes,
-        .note_count = sizeof(jupiter_hymn_notes) / sizeof(note_t),
+        .note_count = sizeof(jupiter_hymn_notes),     // NOTE() is one byte per note
+        .tables = &song_tables,
         .parts_mask = ALL_PARTS
     },
     [SONG_CANON_IN_D] = {
         .name = "Canon in D",
         .type = SONG_TYPE_DUET,
         .notes = canon_notes,
-        .note_count = sizeof(canon_notes) / sizeof(note_t),
-        .parts_mask = PART_1 | PART_2 | PART_4 | PART_5
+        .note_count = sizeof(canon_notes),     // NOTE() is one byte per note
+        .tables = &song_tables,
+        .parts_mask = PART_1 | PART_2 | PART_4 | PART_5,
+        .envelope = SYNTH_ENV_PAD     // sustained, string-like
     },
     [SONG_CARNIVAL_THEME] = {
         .name = "Carnival Theme",
         .type = SONG_TYPE_SOLO,
         .notes = carnival_theme_notes,
-        .note_count = sizeof(carnival_theme_notes) / sizeof(note_t),
+        .note_count = sizeof(carnival_theme_notes),     // NOTE() is one byte per note
+        .tables = &song_tables,
         .parts_mask = ALL_PARTS
     },
     [SONG_CARNIVAL_VAR1] = {
         .name = "Carnival Variation",
         .type = SONG_TYPE_SOLO,
         .notes = carnival_var1_notes,
-        .note_count = sizeof(carnival_var1_notes) / sizeof(note_t),
+        .note_count = sizeof(carnival_var1_notes),     // NOTE() is one byte per note
+        .tables = &song_tables,
         .parts_mask = ALL_PARTS
     },
     [SONG_BLUE_BELLS] = {
         .name = "Blue Bells",
         .type = SONG_TYPE_SOLO,
         .notes = blue_bells_notes,
-        .note_count = sizeof(blue_bells_notes) / sizeof(note_t),
+        .note_count = sizeof(blue_bells_notes),     // NOTE() is one byte per note
+        .tables = &song_tables,
         .parts_mask = ALL_PARTS
     },
     [SONG_MEDALLION_CALLS] = {
         .name = "Medallion Calls",
         .type = SONG_TYPE_SOLO,
         .notes = medallion_calls_notes,
-        .note_count = sizeof(medallion_calls_notes) / sizeof(note_t),
+        .note_count = sizeof(medallion_calls_notes),     // NOTE() is one byte per note
+        .tables = &song_tables,
         .parts_mask = ALL_PARTS
     },
     [SONG_TV_TIME] = {
         .name = "TV Time",
         .type = SONG_TYPE_SOLO,
         .notes = tv_time_notes,
-        .note_count = sizeof(tv_time_notes) / sizeof(note_t),
+        .note_count = sizeof(tv_time_notes),     // NOTE() is one byte per note
+        .tables = &song_tables,
         .parts_mask = ALL_PARTS
     }
 };
 
-const uint8_t total_songs = sizeof(songs) / sizeof(song_t);
\ No newline at end of file
+const uint8_t total_songs = sizeof(songs) / sizeof(song_t);
+
+// ----------------------
+// Active library
+// ----------------------
+// Built-in songs[] until songs_use_library() installs another table
+static const song_t *s_lib = NULL;
+static uint8_t       s_lib_count = 0;
+
+static void index_free(void);
+
+void songs_use_library(const song_t *table, uint8_t count)
+{
+    bool indexed = song_melody_index_ready();
+    index_free();
+    s_lib       = table;
+    s_lib_count = table ? count : 0;
+    if (indexed) songs_index_init();
+}
+
+uint8_t song_count(void)
+{
+    return s_lib ? s_lib_count : total_songs;
+}
+
+const song_t *song_get(uint8_t song_id)
+{
+    if (song_id >= song_count()) return NULL;
+    return s_lib ? &s_lib[song_id] : &songs[song_id];
+}
+
+static uint32_t notes_ms(const song_pack_tables_t *t, const uint8_t *notes, uint16_t count)
+{
+    song_pack_iter_t it;
+    note_t n;
+    uint32_t ms = 0;
+    song_pack_iter_init(&it, t, notes, count);
+    while (song_pack_next(&it, &n)) ms += n.duration_ms;
+    return ms;
+}
+
+uint32_t song_duration_ms(uint8_t song_id)
+{
+    const song_t *song = song_get(song_id);
+    if (!song) return 0;
+    uint32_t ms = notes_ms(song->tables, song->notes, song->note_count);
+    for (int p = 0; p < 5; ++p) {
+        uint32_t part = notes_ms(song->tables, song->parts[p].notes, song->parts[p].note_count);
+        if (part > ms) ms = part;
+    }
+    return ms;
+}
+
+// ----------------------
+// Seek indexes
+// ----------------------
+// One cumulative index per melody: slot 0 is the lead, 1..5 the parts
+#define MELODIES_PER_SONG  6
+
+static uint32_t **s_index = NULL;
+static uint8_t    s_index_count = 0;
+
+static uint32_t *build_one(const song_pack_tables_t *t, const uint8_t *notes, uint16_t count)
+{
+    if (!notes || !count) return NULL;
+    uint32_t *cum = malloc(((size_t)count + 1) * sizeof(*cum));
+    if (cum) note_index_build(cum, t, notes, count);
+    return cum;
+}
+
+static void index_free(void)
+{
+    if (!s_index) return;
+    for (size_t i = 0; i < (size_t)s_index_count * MELODIES_PER_SONG; ++i) free(s_index[i]);
+    free(s_index);
+    s_index = NULL;
+    s_index_count = 0;
+}
+
+bool song_melody_index_ready(void)
+{
+    return s_index != NULL;
+}
+
+void songs_index_init(void)
+{
+    if (s_index) return;
+    uint8_t count = song_count();
+    uint32_t **idx = calloc((size_t)count * MELODIES_PER_SONG, sizeof(*idx));
+    if (!idx) return;
+    for (uint8_t i = 0; i < count; ++i) {
+        const song_t *song = song_get(i);
+        idx[i * MELODIES_PER_SONG] = build_one(song->tables, song->notes, song->note_count);
+        for (int p = 0; p < 5; ++p) {
+            idx[i * MELODIES_PER_SONG + 1 + p] = build_one(song->tables, song->parts[p].notes,
+                                                             song->parts[p].note_count);
+        }
+    }
+    s_index = idx;
+    s_index_count = count;
+}
+
+const uint32_t *song_melody_index(uint8_t song_id, const uint8_t *melody)
+{
+    const song_t *song = song_get(song_id);
+    if (!s_index || !song || song_id >= s_index_count || !melody) return NULL;
+    if (melody == song->notes) return s_index[song_id * MELODIES_PER_SONG];
+    for (int p = 0; p < 5; ++p) {
+        if (melody == song->parts[p].notes) return s_index[song_id * MELODIES_PER_SONG + 1 + p];
+    }
+    return NULL;
+}
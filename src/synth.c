@@ -0,0 +1,359 @@
+// src/synth.c — DDS wavetable oscillator (Q15, 32-bit phase accumulator)
+#include <math.h>
+#include <string.h>
+
+#include "synth.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Fractional bits taken from the phase below the table index (Q15 weight)
+#define FRAC_SHIFT   (32 - SYNTH_LUT_BITS - 15)
+
+// Envelope rise curve 0..1 (ease-out, 1 - (1 - x)^2), plus a guard entry
+#define ENV_CURVE_BITS  6
+#define ENV_CURVE_SIZE  (1u << ENV_CURVE_BITS)
+
+// Presets whose sustain is below full level get the sine table pre-scaled
+// to that level, so sustaining costs what the bare oscillator does
+#define ENV_SUSTAIN_LUTS  2
+
+static int16_t sine_lut[SYNTH_LUT_SIZE + 1];
+static int16_t env_curve[ENV_CURVE_SIZE + 1];
+static int16_t sustain_lut[ENV_SUSTAIN_LUTS][SYNTH_LUT_SIZE + 1];
+static const int16_t *preset_lut[SYNTH_ENV_COUNT];
+static int     s_lut_ready = 0;
+
+static const synth_adsr_t k_env_presets[SYNTH_ENV_COUNT] = {
+    [SYNTH_ENV_SOFT]  = { .attack_ms = 8,  .decay_ms = 0,   .sustain_q15 = SYNTH_Q15_ONE, .release_ms = 25 },
+    [SYNTH_ENV_PLUCK] = { .attack_ms = 3,  .decay_ms = 250, .sustain_q15 = 11469,         .release_ms = 40 },
+    [SYNTH_ENV_PAD]   = { .attack_ms = 60, .decay_ms = 100, .sustain_q15 = 26214,         .release_ms = 80 },
+};
+
+void synth_init(void)
+{
+    if (s_lut_ready) return;
+    for (uint32_t i = 0; i <= SYNTH_LUT_SIZE; ++i) {
+        float s = sinf(2.0f * (float)M_PI * (float)i / (float)SYNTH_LUT_SIZE);
+        sine_lut[i] = (int16_t)lrintf(s * (float)SYNTH_Q15_ONE);
+    }
+    for (uint32_t i = 0; i <= ENV_CURVE_SIZE; ++i) {
+        float x = 1.0f - (float)i / (float)ENV_CURVE_SIZE;
+        env_curve[i] = (int16_t)lrintf((1.0f - x * x) * (float)SYNTH_Q15_ONE);
+    }
+    unsigned n = 0;
+    for (unsigned p = 0; p < SYNTH_ENV_COUNT; ++p) {
+        int32_t g = k_env_presets[p].sustain_q15;
+        if (g <= 0 || g >= SYNTH_Q15_ONE || n == ENV_SUSTAIN_LUTS) continue;
+        // Same rounding as scaling osc_sample() by g, so ramps meet it exactly
+        for (uint32_t i = 0; i <= SYNTH_LUT_SIZE; ++i) {
+            sustain_lut[n][i] = (int16_t)((sine_lut[i] * g) >> 15);
+        }
+        preset_lut[p] = sustain_lut[n++];
+    }
+    s_lut_ready = 1;
+}
+
+uint32_t synth_phase_inc(uint16_t freq_hz, uint32_t sample_rate)
+{
+    if (freq_hz == 0 || sample_rate == 0) return 0;
+    // Round to nearest so the pitch error stays below 0.5 LSB of 2^-32 cycles
+    return (uint32_t)((((uint64_t)freq_hz << 32) + sample_rate / 2) / sample_rate);
+}
+
+int16_t synth_gain_q15(float vol)
+{
+    if (vol <= 0.0f) return 0;
+    if (vol >= 1.0f) return SYNTH_Q15_ONE;
+    return (int16_t)lrintf(vol * (float)SYNTH_Q15_ONE);
+}
+
+float synth_gain_from_q15(int32_t gain_q15)
+{
+    if (gain_q15 <= 0) return 0.0f;
+    if (gain_q15 >= SYNTH_Q15_ONE) return 1.0f;
+    return (float)gain_q15 / (float)SYNTH_Q15_ONE;
+}
+
+// One interpolated wavetable lookup (Q15)
+static inline int32_t osc_lookup(const int16_t *lut, uint32_t phase)
+{
+    uint32_t idx  = phase >> (32 - SYNTH_LUT_BITS);
+    int32_t  frac = (int32_t)((phase >> FRAC_SHIFT) & 0x7FFF);
+    int32_t  s0   = lut[idx];
+    int32_t  s1   = lut[idx + 1];
+    return s0 + (((s1 - s0) * frac) >> 15);
+}
+
+static inline int32_t osc_sample(uint32_t phase)
+{
+    return osc_lookup(sine_lut, phase);
+}
+
+void synth_render_tone(int16_t *buf, size_t n, uint32_t *phase_io,
+                       uint32_t inc, int16_t gain_q15)
+{
+    if (inc == 0 || gain_q15 == 0) {
+        // Silence (rest); keep phase so the next note starts where we left off
+        memset(buf, 0, n * sizeof(int16_t));
+        return;
+    }
+
+    uint32_t phase = *phase_io;
+    const int32_t g = gain_q15;
+
+    for (size_t i = 0; i < n; ++i) {
+        buf[i] = (int16_t)((osc_sample(phase) * g) >> 15);
+        phase += inc;   // wraps naturally at 2^32
+    }
+    *phase_io = phase;
+}
+
+void synth_mix_tone(int32_t *acc, size_t n, uint32_t *phase_io, uint32_t inc)
+{
+    if (inc == 0) return;   // rest: contributes nothing, phase held
+
+    uint32_t phase = *phase_io;
+    for (size_t i = 0; i < n; ++i) {
+        acc[i] += osc_sample(phase);
+        phase += inc;
+    }
+    *phase_io = phase;
+}
+
+int32_t synth_headroom_q15(unsigned n_voices)
+{
+    // round(32767 / sqrt(n)); uncorrelated voices rarely peak together, and
+    // synth_mix_out() saturates whatever does get through
+    static const int16_t k_headroom[] = {
+        32767, 32767, 23170, 18918, 16384, 14654, 13377, 12385, 11585
+    };
+    if (n_voices >= sizeof(k_headroom) / sizeof(k_headroom[0])) {
+        n_voices = sizeof(k_headroom) / sizeof(k_headroom[0]) - 1;
+    }
+    return k_headroom[n_voices];
+}
+
+void synth_mix_out(int16_t *out, const int32_t *acc, size_t n, int32_t gain_q15)
+{
+    for (size_t i = 0; i < n; ++i) {
+        int32_t v = (int32_t)(((int64_t)acc[i] * gain_q15) >> 15);
+        if (v >  32767) v =  32767;
+        if (v < -32768) v = -32768;
+        out[i] = (int16_t)v;
+    }
+}
+
+// ----------------------
+// ADSR envelopes
+// ----------------------
+const synth_adsr_t *synth_env_preset(uint8_t preset)
+{
+    if (preset <= SYNTH_ENV_NONE || preset >= SYNTH_ENV_COUNT) return NULL;
+    return &k_env_presets[preset];
+}
+
+// Rise curve at pos/len (Q15), interpolated between table entries
+static int32_t env_rise(uint32_t pos, uint32_t len)
+{
+    if (pos >= len) return SYNTH_Q15_ONE;
+    uint32_t x    = (uint32_t)(((uint64_t)pos << 16) / len);   // Q16
+    uint32_t idx  = x >> (16 - ENV_CURVE_BITS);
+    int32_t  frac = (int32_t)(x & ((1u << (16 - ENV_CURVE_BITS)) - 1));
+    int32_t  c0   = env_curve[idx];
+    int32_t  c1   = env_curve[idx + 1];
+    return c0 + (((c1 - c0) * frac) >> (16 - ENV_CURVE_BITS));
+}
+
+// Level before the release stage (attack, decay, sustain)
+static int32_t env_level_gated(const synth_env_t *e, uint32_t t)
+{
+    if (t < e->a_end) return env_rise(t, e->a_end);
+    if (t < e->d_end) {
+        return SYNTH_Q15_ONE -
+               (((SYNTH_Q15_ONE - e->sustain) * env_rise(t - e->a_end, e->d_end - e->a_end)) >> 15);
+    }
+    return e->sustain;
+}
+
+static int32_t env_level(const synth_env_t *e, uint32_t t)
+{
+    if (t < e->r_start) return env_level_gated(e, t);
+    if (t < e->r_end) {
+        return (e->r_level * (SYNTH_Q15_ONE - env_rise(t - e->r_start, e->r_end - e->r_start))) >> 15;
+    }
+    return 0;
+}
+
+static uint32_t ms_to_samples(uint16_t ms, uint32_t rate)
+{
+    return (uint32_t)(((uint64_t)ms * rate) / 1000u);
+}
+
+// Curved stage containing t (t < r_end and not sustaining): attack, decay
+// or release, with its first sample and end
+enum { ENV_ATTACK, ENV_DECAY, ENV_RELEASE };
+
+static int env_stage(const synth_env_t *e, uint32_t t, uint32_t *s0, uint32_t *end)
+{
+    if (t < e->a_end)   { *s0 = 0;          *end = e->a_end; return ENV_ATTACK; }
+    if (t < e->d_end)   { *s0 = e->a_end;   *end = e->d_end; return ENV_DECAY; }
+    *s0 = e->r_start;
+    *end = e->r_end;
+    return ENV_RELEASE;
+}
+
+// Level at rise-curve point k of a stage, same formulas as env_level()
+static int32_t env_knee_level(const synth_env_t *e, int stage, uint32_t k)
+{
+    int32_t c = env_curve[k];
+    if (stage == ENV_ATTACK) return c;
+    if (stage == ENV_DECAY)  return SYNTH_Q15_ONE - (((SYNTH_Q15_ONE - e->sustain) * c) >> 15);
+    return (e->r_level * (SYNTH_Q15_ONE - c)) >> 15;
+}
+
+// Aim the running ramp from level g0 at sample t to curve point k of the
+// stage, or a later point so a ramp covers at least SYNTH_ENV_SEG samples
+// unless the stage ends first. One division per ramp.
+static void env_aim(synth_env_t *e, uint32_t t, int32_t g0, uint32_t k)
+{
+    uint32_t s0, end;
+    int      stage = env_stage(e, t, &s0, &end);
+    uint64_t len   = end - s0;
+    uint32_t at    = s0 + (uint32_t)((k * len + ENV_CURVE_SIZE - 1) >> ENV_CURVE_BITS);
+    while (k < ENV_CURVE_SIZE && at - t < SYNTH_ENV_SEG) {
+        ++k;
+        at = s0 + (uint32_t)((k * len + ENV_CURVE_SIZE - 1) >> ENV_CURVE_BITS);
+    }
+
+    e->knee     = (uint8_t)k;
+    e->ramp_end = at;
+    e->g_t      = t;
+    e->g        = g0 << 16;
+    e->dg       = ((env_knee_level(e, stage, k) - g0) * 65536) / (int32_t)(at - t);
+}
+
+// Start a ramp anywhere inside a curved stage (note-on, seek, stage change)
+static void env_seek(synth_env_t *e, uint32_t t)
+{
+    uint32_t s0, end;
+    env_stage(e, t, &s0, &end);
+    uint32_t k = (uint32_t)(((uint64_t)(t - s0) << ENV_CURVE_BITS) / (end - s0)) + 1;
+    env_aim(e, t, env_level(e, t), k);
+}
+
+void synth_env_note_on(synth_env_t *e, const synth_adsr_t *shape,
+                       uint32_t note_len, uint32_t t0, uint32_t sample_rate)
+{
+    e->shape = shape;
+    e->lut = NULL;
+    e->t = t0;
+    e->ramp_end = 0;
+    e->g_t = UINT32_MAX;
+    if (!shape) return;
+
+    uint32_t a = ms_to_samples(shape->attack_ms, sample_rate);
+    uint32_t d = ms_to_samples(shape->decay_ms, sample_rate);
+    uint32_t r = ms_to_samples(shape->release_ms, sample_rate);
+
+    // Short notes: give attack and release at most half the note each
+    if (a > note_len / 2) a = note_len / 2;
+    if (r > note_len / 2) r = note_len / 2;
+    if (a + d > note_len - r) d = note_len - r - a;
+
+    e->a_end   = a;
+    e->d_end   = a + d;
+    e->r_end   = note_len;
+    e->r_start = note_len - r;
+    e->sustain = shape->sustain_q15;
+    for (unsigned p = 0; p < SYNTH_ENV_COUNT; ++p) {
+        if (shape == &k_env_presets[p]) e->lut = preset_lut[p];
+    }
+    e->r_level = env_level_gated(e, e->r_start);
+}
+
+void synth_mix_tone_env(int32_t *acc, size_t n, uint32_t *phase_io,
+                        uint32_t inc, synth_env_t *e)
+{
+    if (!e->shape) {
+        synth_mix_tone(acc, n, phase_io, inc);
+        return;
+    }
+    if (inc == 0) {
+        e->t += (uint32_t)n;
+        return;
+    }
+
+    uint32_t phase = *phase_io;
+    while (n > 0) {
+        uint32_t t = e->t;
+        size_t seg = n;
+
+        if (t >= e->r_end) {
+            // Envelope finished: nothing left to add for this note
+            e->t += (uint32_t)n;
+            break;
+        }
+
+        if (t >= e->d_end && t < e->r_start) {
+            // Sustain: constant level up to gate off
+            if (seg > e->r_start - t) seg = e->r_start - t;
+            if (e->sustain == SYNTH_Q15_ONE) {
+                for (size_t i = 0; i < seg; ++i) {
+                    acc[i] += osc_sample(phase);
+                    phase += inc;
+                }
+            } else if (e->lut) {
+                const int16_t *lut = e->lut;
+                for (size_t i = 0; i < seg; ++i) {
+                    acc[i] += osc_lookup(lut, phase);
+                    phase += inc;
+                }
+            } else {
+                const int32_t g = e->sustain;
+                for (size_t i = 0; i < seg; ++i) {
+                    acc[i] += (osc_sample(phase) * g) >> 15;
+                    phase += inc;
+                }
+            }
+        } else {
+            // Curved stage: the rise curve is linear between its table
+            // points, so ramp from one to the next. The ramp lives in the
+            // envelope and carries over between calls; a new one is set up
+            // when it runs out (next point, or a new stage) or when the
+            // note was (re)started somewhere else.
+            if (t != e->g_t || t >= e->ramp_end) {
+                uint32_t s0, end;
+                if (t == e->g_t && e->knee < ENV_CURVE_SIZE) {
+                    int stage = env_stage(e, t, &s0, &end);
+                    env_aim(e, t, env_knee_level(e, stage, e->knee), e->knee + 1u);
+                } else {
+                    env_seek(e, t);
+                }
+            }
+            if (seg > e->ramp_end - t) seg = e->ramp_end - t;
+
+            // The level is held for SYNTH_ENV_STEP samples at a time, at
+            // its value mid-step, so the inner loop is the sustain one
+            int32_t g = e->g;
+            const int32_t dg = e->dg;
+            for (size_t i = 0; i < seg;) {
+                size_t  m  = seg - i < SYNTH_ENV_STEP ? seg - i : SYNTH_ENV_STEP;
+                int32_t gs = (int32_t)((g + (int64_t)dg * (int64_t)(m / 2)) >> 16);
+                for (size_t end = i + m; i < end; ++i) {
+                    acc[i] += (osc_sample(phase) * gs) >> 15;
+                    phase += inc;
+                }
+                g += (int32_t)((int64_t)dg * (int64_t)m);
+            }
+            e->g   = g;
+            e->g_t = t + (uint32_t)seg;
+        }
+
+        e->t += (uint32_t)seg;
+        acc  += seg;
+        n    -= seg;
+    }
+    *phase_io = phase;
+}
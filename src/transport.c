@@ -0,0 +1,33 @@
+// src/transport.c — callback plumbing shared by the transport backends
+#include <string.h>
+
+#include "transport.h"
+
+const uint8_t TRANSPORT_BROADCAST[TRANSPORT_ADDR_LEN] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+void transport_set_rx(transport_t *t, transport_rx_fn fn, void *ctx)
+{
+    t->rx_ctx = ctx;
+    t->rx     = fn;
+}
+
+void transport_set_tx_done(transport_t *t, transport_tx_done_fn fn, void *ctx)
+{
+    t->tx_done_ctx = ctx;
+    t->tx_done     = fn;
+}
+
+bool transport_is_broadcast(const uint8_t *addr)
+{
+    return !addr || memcmp(addr, TRANSPORT_BROADCAST, TRANSPORT_ADDR_LEN) == 0;
+}
+
+void transport_deliver(transport_t *t, const uint8_t *src, const uint8_t *frame, size_t len, int64_t rx_us)
+{
+    if (t->rx) t->rx(t->rx_ctx, src, frame, len, rx_us);
+}
+
+void transport_report_tx(transport_t *t, const uint8_t *dst, bool ok)
+{
+    if (t->tx_done) t->tx_done(t->tx_done_ctx, dst, ok);
+}
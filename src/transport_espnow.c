@@ -0,0 +1,104 @@
+// src/transport_espnow.c — transport.h backend on ESP-NOW (WiFi STA, no AP)
+#include <string.h>
+
+#include "esp_now.h"
+#include "esp_wifi.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_mac.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "transport.h"
+
+static const char *TAG = "TRANSPORT";
+
+static transport_t s_tp;
+
+// ----------------------
+// ESP-NOW callbacks
+// ----------------------
+static void send_cb(const wifi_tx_info_t *info, esp_now_send_status_t status)
+{
+    if (!info) return;
+    transport_report_tx(&s_tp, info->des_addr, status == ESP_NOW_SEND_SUCCESS);
+}
+
+static void recv_cb(const esp_now_recv_info_t *info, const uint8_t *data, int len)
+{
+    // Stamp arrival first; queueing and task latency must not count as air time
+    int64_t rx_us = esp_timer_get_time();
+    if (!info || !info->src_addr || len <= 0) return;
+    transport_deliver(&s_tp, info->src_addr, data, (size_t)len, rx_us);
+}
+
+// ----------------------
+// Operations
+// ----------------------
+static void tp_add_peer(transport_t *t, const uint8_t *addr)
+{
+    (void)t;
+    if (esp_now_is_peer_exist(addr)) return;
+    esp_now_peer_info_t pi = {0};
+    memcpy(pi.peer_addr, addr, ESP_NOW_ETH_ALEN);
+    pi.ifidx   = WIFI_IF_STA;
+    pi.channel = 0;             // keep current channel
+    pi.encrypt = false;
+    (void)esp_now_add_peer(&pi);
+}
+
+static int tp_start(transport_t *t)
+{
+    ESP_ERROR_CHECK(esp_netif_init());
+    // If the default loop already exists, this will return INVALID_STATE — ignore it.
+    (void)esp_event_loop_create_default();
+
+    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
+    ESP_ERROR_CHECK(esp_wifi_set_storage(WIFI_STORAGE_RAM));
+    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+    ESP_ERROR_CHECK(esp_wifi_start());
+
+    esp_err_t err = esp_now_init();
+    if (err == ESP_OK) err = esp_now_register_send_cb(send_cb);
+    if (err == ESP_OK) err = esp_now_register_recv_cb(recv_cb);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "ESP-NOW init failed (%s)", esp_err_to_name(err));
+        return err;
+    }
+    tp_add_peer(t, TRANSPORT_BROADCAST);
+    return ESP_OK;
+}
+
+static int tp_send(transport_t *t, const uint8_t *dst, const uint8_t *frame, size_t len)
+{
+    (void)t;
+    return esp_now_send(transport_is_broadcast(dst) ? TRANSPORT_BROADCAST : dst, frame, len);
+}
+
+static void tp_own_addr(transport_t *t, uint8_t *addr)
+{
+    (void)t;
+    esp_read_mac(addr, ESP_MAC_WIFI_STA);
+}
+
+static int64_t tp_now_us(transport_t *t)
+{
+    (void)t;
+    return esp_timer_get_time();
+}
+
+transport_t *transport_espnow(void)
+{
+    if (!s_tp.name) {
+        s_tp = (transport_t){
+            .name     = "espnow",
+            .start    = tp_start,
+            .send     = tp_send,
+            .add_peer = tp_add_peer,
+            .own_addr = tp_own_addr,
+            .now_us   = tp_now_us,
+        };
+    }
+    return &s_tp;
+}
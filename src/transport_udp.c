@@ -0,0 +1,148 @@
+// src/transport_udp.c — transport.h backend on UDP multicast, for Linux hosts
+//
+// Every node sends to and listens on one multicast group. A datagram is the
+// destination address, the source address and the wire frame; nodes drop
+// datagrams addressed to someone else and their own (multicast loops them
+// back). Not part of the firmware: the device build defines ESP_PLATFORM.
+#ifndef ESP_PLATFORM
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "transport.h"
+
+#define UDP_HDR_LEN  (2 * TRANSPORT_ADDR_LEN)
+
+typedef struct {
+    int                fd;
+    struct sockaddr_in group;
+    uint8_t            addr[TRANSPORT_ADDR_LEN];
+} udp_priv_t;
+
+// ----------------------
+// Operations
+// ----------------------
+static int udp_send(transport_t *t, const uint8_t *dst, const uint8_t *frame, size_t len)
+{
+    udp_priv_t *p = t->priv;
+    if (len > TRANSPORT_MAX_FRAME) return EMSGSIZE;
+
+    uint8_t dg[UDP_HDR_LEN + TRANSPORT_MAX_FRAME];
+    memcpy(dg, transport_is_broadcast(dst) ? TRANSPORT_BROADCAST : dst, TRANSPORT_ADDR_LEN);
+    memcpy(dg + TRANSPORT_ADDR_LEN, p->addr, TRANSPORT_ADDR_LEN);
+    memcpy(dg + UDP_HDR_LEN, frame, len);
+
+    ssize_t n = sendto(p->fd, dg, UDP_HDR_LEN + len, 0, (const struct sockaddr *)&p->group, sizeof(p->group));
+    int err = n < 0 ? errno : 0;
+    transport_report_tx(t, dst ? dst : TRANSPORT_BROADCAST, err == 0);
+    return err;
+}
+
+static int udp_poll(transport_t *t, int timeout_ms)
+{
+    udp_priv_t *p = t->priv;
+    struct pollfd pfd = { .fd = p->fd, .events = POLLIN };
+    if (poll(&pfd, 1, timeout_ms) <= 0) return 0;
+
+    int delivered = 0;
+    uint8_t dg[UDP_HDR_LEN + TRANSPORT_MAX_FRAME];
+    for (;;) {
+        ssize_t n = recv(p->fd, dg, sizeof(dg), MSG_DONTWAIT);
+        if (n < 0) break;
+        int64_t rx_us = t->now_us(t);
+        if (n <= UDP_HDR_LEN) continue;
+
+        const uint8_t *dst = dg, *src = dg + TRANSPORT_ADDR_LEN;
+        if (memcmp(src, p->addr, TRANSPORT_ADDR_LEN) == 0) continue;
+        if (!transport_is_broadcast(dst) && memcmp(dst, p->addr, TRANSPORT_ADDR_LEN) != 0) continue;
+        transport_deliver(t, src, dg + UDP_HDR_LEN, (size_t)n - UDP_HDR_LEN, rx_us);
+        delivered++;
+    }
+    return delivered;
+}
+
+static void udp_own_addr(transport_t *t, uint8_t *addr)
+{
+    memcpy(addr, ((udp_priv_t *)t->priv)->addr, TRANSPORT_ADDR_LEN);
+}
+
+static int64_t udp_now_us(transport_t *t)
+{
+    (void)t;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// ----------------------
+// Open / close
+// ----------------------
+transport_t *transport_udp_open(uint16_t node, const char *group, uint16_t port, const char *iface_addr)
+{
+    transport_t *t = calloc(1, sizeof(*t));
+    udp_priv_t  *p = calloc(1, sizeof(*p));
+    if (!t || !p) goto fail;
+    p->fd = -1;
+
+    struct in_addr iface;
+    if (!inet_aton(iface_addr ? iface_addr : "127.0.0.1", &iface)) goto fail;
+    p->group.sin_family = AF_INET;
+    p->group.sin_port   = htons(port);
+    if (!inet_aton(group, &p->group.sin_addr)) goto fail;
+
+    p->fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (p->fd < 0) goto fail;
+
+    // Every node on the machine binds the same port
+    int one = 1;
+    setsockopt(p->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(p->fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+    struct sockaddr_in bind_addr = { .sin_family = AF_INET, .sin_port = htons(port),
+                                     .sin_addr.s_addr = htonl(INADDR_ANY) };
+    if (bind(p->fd, (struct sockaddr *)&bind_addr, sizeof(bind_addr)) < 0) goto fail;
+
+    struct ip_mreq mreq = { .imr_multiaddr = p->group.sin_addr, .imr_interface = iface };
+    unsigned char loop = 1, ttl = 1;
+    if (setsockopt(p->fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0
+        || setsockopt(p->fd, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface)) < 0
+        || setsockopt(p->fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) < 0
+        || setsockopt(p->fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) < 0) goto fail;
+
+    // Locally administered, so it cannot clash with a board's MAC
+    const uint8_t addr[TRANSPORT_ADDR_LEN] = { 0x02, 'O', 'R', 'C', (uint8_t)(node >> 8), (uint8_t)node };
+    memcpy(p->addr, addr, sizeof(addr));
+
+    *t = (transport_t){
+        .name     = "udp",
+        .send     = udp_send,
+        .own_addr = udp_own_addr,
+        .poll     = udp_poll,
+        .now_us   = udp_now_us,
+        .priv     = p,
+    };
+    return t;
+
+fail:
+    if (p && p->fd >= 0) close(p->fd);
+    free(p);
+    free(t);
+    return NULL;
+}
+
+void transport_udp_close(transport_t *t)
+{
+    if (!t) return;
+    udp_priv_t *p = t->priv;
+    close(p->fd);
+    free(p);
+    free(t);
+}
+
+#endif // ESP_PLATFORM
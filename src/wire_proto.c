@@ -0,0 +1,289 @@
+// src/wire_proto.c — packed little-endian frame encode/parse
+#include <string.h>
+
+#include "wire_proto.h"
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), nibble table
+uint16_t wire_crc16(const uint8_t *data, size_t len)
+{
+    static const uint16_t k_nibble[16] = {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    };
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; ++i) {
+        crc = (uint16_t)((crc << 4) ^ k_nibble[(crc >> 12) ^ (data[i] >> 4)]);
+        crc = (uint16_t)((crc << 4) ^ k_nibble[(crc >> 12) ^ (data[i] & 0x0F)]);
+    }
+    return crc;
+}
+
+wire_err_t wire_parse(const uint8_t *buf, size_t len, wire_frame_t *out)
+{
+    if (len < WIRE_HDR_LEN + WIRE_CRC_LEN) return WIRE_ERR_SHORT;
+    if (buf[0] != WIRE_MAGIC) return WIRE_ERR_MAGIC;
+    if ((buf[1] >> 4) != WIRE_VERSION_MAJOR) return WIRE_ERR_VERSION;
+
+    uint8_t plen = buf[7];
+    if ((size_t)WIRE_HDR_LEN + plen + WIRE_CRC_LEN != len) return WIRE_ERR_LEN;
+
+    uint16_t crc = (uint16_t)(buf[len - 2] | (buf[len - 1] << 8));
+    if (wire_crc16(buf, len - WIRE_CRC_LEN) != crc) return WIRE_ERR_CRC;
+
+    out->version = buf[1];
+    out->type    = buf[2];
+    out->flags   = buf[3];
+    out->sender  = buf[4];
+    out->seq     = (uint16_t)(buf[5] | (buf[6] << 8));
+    out->len     = plen;
+    out->payload = buf + WIRE_HDR_LEN;
+    return WIRE_OK;
+}
+
+const char *wire_err_str(wire_err_t err)
+{
+    switch (err) {
+        case WIRE_OK:          return "ok";
+        case WIRE_ERR_SHORT:   return "short";
+        case WIRE_ERR_MAGIC:   return "bad magic";
+        case WIRE_ERR_VERSION: return "version";
+        case WIRE_ERR_LEN:     return "bad length";
+        case WIRE_ERR_CRC:     return "bad crc";
+        default:               return "?";
+    }
+}
+
+// ----------------------
+// Payload cursors
+// ----------------------
+void wire_writer_init(wire_writer_t *w, uint8_t *buf, size_t cap)
+{
+    w->buf = buf;
+    w->cap = cap;
+    w->pos = 0;
+    w->ok  = true;
+}
+
+void wire_put_bytes(wire_writer_t *w, const void *p, size_t n)
+{
+    if (!w->ok || w->cap - w->pos < n) {
+        w->ok = false;
+        return;
+    }
+    memcpy(w->buf + w->pos, p, n);
+    w->pos += n;
+}
+
+void wire_put_u8(wire_writer_t *w, uint8_t v)
+{
+    wire_put_bytes(w, &v, 1);
+}
+
+void wire_put_u16(wire_writer_t *w, uint16_t v)
+{
+    uint8_t b[2] = { (uint8_t)v, (uint8_t)(v >> 8) };
+    wire_put_bytes(w, b, sizeof(b));
+}
+
+void wire_put_u32(wire_writer_t *w, uint32_t v)
+{
+    uint8_t b[4];
+    for (int i = 0; i < 4; ++i) b[i] = (uint8_t)(v >> (8 * i));
+    wire_put_bytes(w, b, sizeof(b));
+}
+
+void wire_put_u64(wire_writer_t *w, uint64_t v)
+{
+    uint8_t b[8];
+    for (int i = 0; i < 8; ++i) b[i] = (uint8_t)(v >> (8 * i));
+    wire_put_bytes(w, b, sizeof(b));
+}
+
+void wire_reader_init(wire_reader_t *r, const wire_frame_t *f)
+{
+    r->buf = f->payload;
+    r->len = f->len;
+    r->pos = 0;
+    r->ok  = true;
+}
+
+void wire_get_bytes(wire_reader_t *r, void *p, size_t n)
+{
+    if (!r->ok || r->len - r->pos < n) {
+        r->ok = false;
+        memset(p, 0, n);
+        return;
+    }
+    memcpy(p, r->buf + r->pos, n);
+    r->pos += n;
+}
+
+uint8_t wire_get_u8(wire_reader_t *r)
+{
+    uint8_t v;
+    wire_get_bytes(r, &v, 1);
+    return v;
+}
+
+uint16_t wire_get_u16(wire_reader_t *r)
+{
+    uint8_t b[2];
+    wire_get_bytes(r, b, sizeof(b));
+    return (uint16_t)(b[0] | (b[1] << 8));
+}
+
+uint32_t wire_get_u32(wire_reader_t *r)
+{
+    uint8_t b[4];
+    wire_get_bytes(r, b, sizeof(b));
+    return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+uint64_t wire_get_u64(wire_reader_t *r)
+{
+    uint8_t b[8];
+    wire_get_bytes(r, b, sizeof(b));
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) v = (v << 8) | b[i];
+    return v;
+}
+
+void wire_begin(wire_writer_t *w, uint8_t *buf, size_t cap,
+                uint8_t type, uint8_t flags, uint8_t sender, uint16_t seq)
+{
+    wire_writer_init(w, buf, cap);
+    wire_put_u8(w, WIRE_MAGIC);
+    wire_put_u8(w, WIRE_VERSION);
+    wire_put_u8(w, type);
+    wire_put_u8(w, flags);
+    wire_put_u8(w, sender);
+    wire_put_u16(w, seq);
+    wire_put_u8(w, 0);   // len, patched in wire_finish()
+}
+
+void wire_set_flags(wire_writer_t *w, uint8_t flags)
+{
+    if (w->cap > 3) w->buf[3] = flags;
+}
+
+size_t wire_finish(wire_writer_t *w)
+{
+    if (!w->ok || w->pos - WIRE_HDR_LEN > WIRE_MAX_PAYLOAD) return 0;
+    w->buf[7] = (uint8_t)(w->pos - WIRE_HDR_LEN);
+    wire_put_u16(w, wire_crc16(w->buf, w->pos));
+    return w->ok ? w->pos : 0;
+}
+
+// ----------------------
+// Payloads
+// ----------------------
+void wire_put_ctrl(wire_writer_t *w, const wire_ctrl_t *p)
+{
+    wire_put_u8(w, p->song_id);
+    wire_put_u64(w, p->timestamp);
+    if (p->has_state) {
+        const orch_state_t *s = &p->state;
+        wire_put_u16(w, s->boot_id);
+        wire_put_u16(w, s->version);
+        wire_put_u8(w, s->playing ? 0x01 : 0x00);
+        wire_put_u8(w, s->song_id);
+        wire_put_u64(w, s->start_epoch_us);
+        wire_put_u16(w, s->tempo_pct);
+        wire_put_u16(w, s->volume_q15);
+    }
+}
+
+bool wire_get_ctrl(const wire_frame_t *f, wire_ctrl_t *p)
+{
+    wire_reader_t r;
+    wire_reader_init(&r, f);
+    p->song_id   = wire_get_u8(&r);
+    p->timestamp = wire_get_u64(&r);
+    p->has_state = false;
+    memset(&p->state, 0, sizeof(p->state));
+    if (!r.ok) return false;
+    p->has_state = r.pos < r.len;
+    if (p->has_state) {
+        orch_state_t *s = &p->state;
+        s->boot_id        = wire_get_u16(&r);
+        s->version        = wire_get_u16(&r);
+        s->playing        = (wire_get_u8(&r) & 0x01) != 0;
+        s->song_id        = wire_get_u8(&r);
+        s->start_epoch_us = wire_get_u64(&r);
+        s->tempo_pct      = wire_get_u16(&r);
+        s->volume_q15     = wire_get_u16(&r);
+        // A cut-short state is dropped; the base fields are still good
+        if (!r.ok) memset(s, 0, sizeof(*s));
+        p->has_state = r.ok;
+    }
+    return true;
+}
+
+void wire_put_clock(wire_writer_t *w, bool response, const wire_clock_t *p)
+{
+    if (response) {
+        wire_put_u8(w, p->target);
+        wire_put_u16(w, p->req_seq);
+    }
+    wire_put_u64(w, p->t1);
+    if (response) {
+        wire_put_u64(w, p->t2);
+        wire_put_u64(w, p->t3);
+    }
+}
+
+bool wire_get_clock(const wire_frame_t *f, bool response, wire_clock_t *p)
+{
+    wire_reader_t r;
+    wire_reader_init(&r, f);
+    memset(p, 0, sizeof(*p));
+    if (response) {
+        p->target  = wire_get_u8(&r);
+        p->req_seq = wire_get_u16(&r);
+    }
+    p->t1 = wire_get_u64(&r);
+    if (response) {
+        p->t2 = wire_get_u64(&r);
+        p->t3 = wire_get_u64(&r);
+    }
+    return r.ok;
+}
+
+void wire_put_disco(wire_writer_t *w, const wire_disco_t *p)
+{
+    size_t n = strnlen(p->name, sizeof(p->name) - 1);
+    wire_put_u8(w, p->role);
+    wire_put_bytes(w, p->mac, sizeof(p->mac));
+    wire_put_u32(w, p->timestamp);
+    wire_put_u8(w, (uint8_t)n);
+    wire_put_bytes(w, p->name, n);
+}
+
+bool wire_get_disco(const wire_frame_t *f, wire_disco_t *p)
+{
+    wire_reader_t r;
+    wire_reader_init(&r, f);
+    p->role      = wire_get_u8(&r);
+    wire_get_bytes(&r, p->mac, sizeof(p->mac));
+    p->timestamp = wire_get_u32(&r);
+    uint8_t n    = wire_get_u8(&r);
+    if (n > sizeof(p->name) - 1) n = sizeof(p->name) - 1;
+    wire_get_bytes(&r, p->name, n);
+    p->name[r.ok ? n : 0] = '\0';
+    return r.ok;
+}
+
+void wire_put_ack(wire_writer_t *w, const wire_ack_t *p)
+{
+    wire_put_u16(w, p->seq);
+    wire_put_u8(w, p->type);
+}
+
+bool wire_get_ack(const wire_frame_t *f, wire_ack_t *p)
+{
+    wire_reader_t r;
+    wire_reader_init(&r, f);
+    p->seq  = wire_get_u16(&r);
+    p->type = wire_get_u8(&r);
+    return r.ok;
+}
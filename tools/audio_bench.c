@@ -0,0 +1,317 @@
+// tools/audio_bench.c — host-side microbenchmark for the tone renderers
+//
+// Compares the legacy per-sample sinf() renderer against the DDS wavetable
+// oscillator in src/synth.c: throughput (samples/s), cost (cycles/sample) and
+// a spectral check (SINAD of a pure tone) so quality regressions show up.
+// Also measures the polyphonic mixer's cost per voice and the ADSR envelope
+// overhead on a real melody from songs.c (best of several runs).
+//
+// Build & run from the repository root:
+//   cc -O2 -Iinclude tools/audio_bench.c src/synth.c src/note_timeline.c src/songs.c src/song_pack.c -lm -o audio_bench
+//   ./audio_bench
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#include "synth.h"
+#include "note_timeline.h"
+#include "songs.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define SAMPLE_RATE       44100
+#define SAMPLES_PER_TICK  441
+#define VOLUME            0.08f
+#define BENCH_SAMPLES     (SAMPLE_RATE * 200)   // 200 s of audio per renderer
+
+static int16_t tick_buf[SAMPLES_PER_TICK];
+
+// ----------------------
+// Renderers under test
+// ----------------------
+
+// The original render_tick() from src/audio.c, kept verbatim for comparison
+static void legacy_render_tick(int16_t *buf, size_t n, uint16_t freq, float *phase_io)
+{
+    float phase = *phase_io;
+    float step  = (freq == 0) ? 0.f : (2.0f * (float)M_PI * (float)freq / (float)SAMPLE_RATE);
+
+    if (freq == 0) {
+        memset(buf, 0, n * sizeof(int16_t));
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            float s = sinf(phase) * VOLUME;
+            buf[i] = (int16_t)(s * 32767.0f);
+            phase += step;
+            if (phase >= 2.0f * (float)M_PI) phase -= 2.0f * (float)M_PI;
+        }
+    }
+    *phase_io = phase;
+}
+
+static void dds_render_tick(int16_t *buf, size_t n, uint32_t inc, uint32_t *phase_io)
+{
+    synth_render_tone(buf, n, phase_io, inc, synth_gain_q15(VOLUME));
+}
+
+// ----------------------
+// Timing helpers
+// ----------------------
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t cycles(void)
+{
+#ifdef HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static volatile int32_t sink;
+
+static void report(const char *name, double secs, uint64_t cyc, size_t samples)
+{
+    printf("  %-8s %10.2f Msamples/s", name, (double)samples / secs / 1e6);
+    if (cyc) {
+        printf("  %7.2f cycles/sample", (double)cyc / (double)samples);
+    } else {
+        printf("  %7.2f ns/sample", secs * 1e9 / (double)samples);
+    }
+    printf("  (%.1fx real-time per core)\n", (double)samples / secs / SAMPLE_RATE);
+}
+
+static void bench(uint16_t freq)
+{
+    const size_t ticks = BENCH_SAMPLES / SAMPLES_PER_TICK;
+    printf("%u Hz, %zu ticks of %d samples:\n", (unsigned)freq, ticks, SAMPLES_PER_TICK);
+
+    float fphase = 0.0f;
+    double t0 = now_s();
+    uint64_t c0 = cycles();
+    for (size_t t = 0; t < ticks; ++t) {
+        legacy_render_tick(tick_buf, SAMPLES_PER_TICK, freq, &fphase);
+        sink += tick_buf[t % SAMPLES_PER_TICK];
+    }
+    uint64_t c1 = cycles();
+    double t1 = now_s();
+    report("sinf", t1 - t0, c1 - c0, ticks * SAMPLES_PER_TICK);
+
+    uint32_t phase = 0;
+    uint32_t inc = synth_phase_inc(freq, SAMPLE_RATE);
+    t0 = now_s();
+    c0 = cycles();
+    for (size_t t = 0; t < ticks; ++t) {
+        dds_render_tick(tick_buf, SAMPLES_PER_TICK, inc, &phase);
+        sink += tick_buf[t % SAMPLES_PER_TICK];
+    }
+    c1 = cycles();
+    t1 = now_s();
+    report("dds", t1 - t0, c1 - c0, ticks * SAMPLES_PER_TICK);
+}
+
+// ----------------------
+// Voice mixer
+// ----------------------
+static int32_t mix_acc[SAMPLES_PER_TICK];
+
+static void bench_mixer(void)
+{
+    static const uint16_t chord[] = { 262, 330, 392, 523, 659, 784, 988, 1175 };
+    const size_t ticks = BENCH_SAMPLES / SAMPLES_PER_TICK / 4;
+    const size_t samples = ticks * SAMPLES_PER_TICK;
+    double base = 0.0;
+
+    printf("%-7s %14s %16s %14s\n", "voices", "cycles/sample", "per voice", "vs 1 voice");
+    for (unsigned nv = 1; nv <= 8; ++nv) {
+        uint32_t phase[8] = {0}, inc[8];
+        for (unsigned v = 0; v < nv; ++v) inc[v] = synth_phase_inc(chord[v], SAMPLE_RATE);
+        int32_t gain = (synth_gain_q15(VOLUME) * synth_headroom_q15(nv)) >> 15;
+
+        double t0 = now_s();
+        uint64_t c0 = cycles();
+        for (size_t t = 0; t < ticks; ++t) {
+            memset(mix_acc, 0, sizeof(mix_acc));
+            for (unsigned v = 0; v < nv; ++v) {
+                synth_mix_tone(mix_acc, SAMPLES_PER_TICK, &phase[v], inc[v]);
+            }
+            synth_mix_out(tick_buf, mix_acc, SAMPLES_PER_TICK, gain);
+            sink += tick_buf[t % SAMPLES_PER_TICK];
+        }
+        uint64_t c1 = cycles();
+        double t1 = now_s();
+
+        double per = c1 != c0 ? (double)(c1 - c0) / (double)samples
+                              : (t1 - t0) * 1e9 / (double)samples;
+        if (nv == 1) base = per;
+        printf("%-7u %14.2f %16.2f %13.2fx\n", nv, per, per / nv, per / base);
+    }
+}
+
+// ----------------------
+// Envelope overhead
+// ----------------------
+// Same block loop as voice_mix_block() in src/audio.c, over a whole song.
+static double render_song_cost(const song_t *song, const synth_adsr_t *shape, int repeats)
+{
+    uint64_t c0 = cycles();
+    double t0 = now_s();
+    size_t samples = 0;
+
+    for (int r = 0; r < repeats; ++r) {
+        note_seq_t seq;
+        synth_env_t env;
+        uint32_t phase = 0, inc = 0;
+        note_seq_start(&seq, song->tables, song->notes, song->note_count, SAMPLE_RATE);
+
+        #define LOAD_NOTE()                                                          \
+            do {                                                                     \
+                inc = synth_phase_inc(note_seq_note(&seq)->frequency, SAMPLE_RATE);  \
+                synth_env_note_on(&env, shape, note_seq_note_len(&seq),              \
+                                  note_seq_note_elapsed(&seq), SAMPLE_RATE);         \
+            } while (0)
+
+        LOAD_NOTE();
+        while (!note_seq_done(&seq)) {
+            memset(mix_acc, 0, sizeof(mix_acc));
+            size_t filled = 0;
+            while (filled < SAMPLES_PER_TICK && !note_seq_done(&seq)) {
+                size_t n = note_seq_run(&seq);
+                if (n > SAMPLES_PER_TICK - filled) n = SAMPLES_PER_TICK - filled;
+                synth_mix_tone_env(&mix_acc[filled], n, &phase, inc, &env);
+                filled += n;
+                if (note_seq_advance(&seq, (uint32_t)n)) LOAD_NOTE();
+            }
+            synth_mix_out(tick_buf, mix_acc, SAMPLES_PER_TICK, synth_gain_q15(VOLUME));
+            sink += tick_buf[0];
+            samples += SAMPLES_PER_TICK;
+        }
+        #undef LOAD_NOTE
+    }
+
+    uint64_t c1 = cycles();
+    double t1 = now_s();
+    return c1 != c0 ? (double)(c1 - c0) / (double)samples : (t1 - t0) * 1e9 / (double)samples;
+}
+
+// Best of several runs: interrupts, migrations and frequency changes only
+// ever add time, so the minimum is the stable figure to compare. The presets
+// take turns within each run so a slow stretch doesn't favour one of them.
+#define ENV_RUNS  15
+
+static void bench_envelopes(void)
+{
+    static const struct { const char *name; uint8_t preset; } k[] = {
+        { "none",  SYNTH_ENV_NONE  },
+        { "soft",  SYNTH_ENV_SOFT  },
+        { "pluck", SYNTH_ENV_PLUCK },
+        { "pad",   SYNTH_ENV_PAD   },
+    };
+    const size_t nk = sizeof(k) / sizeof(k[0]);
+    const int repeats = 8;
+
+    for (uint8_t sid = 0; sid < total_songs; ++sid) {
+        const song_t *song = &songs[sid];
+        double best[sizeof(k) / sizeof(k[0])];
+        for (int r = 0; r < ENV_RUNS; ++r) {
+            // The baseline runs at both ends of the round
+            for (size_t j = 0; j <= nk; ++j) {
+                size_t i = j % nk;
+                double c = render_song_cost(song, synth_env_preset(k[i].preset), repeats);
+                if ((r == 0 && j < nk) || c < best[i]) best[i] = c;
+            }
+        }
+        printf("  %-18s", song->name);
+        for (size_t i = 0; i < nk; ++i) {
+            printf("  %s %5.2f (%+5.1f%%)", k[i].name, best[i], (best[i] / best[0] - 1.0) * 100.0);
+        }
+        printf("\n");
+    }
+}
+
+// ----------------------
+// Spectral check
+// ----------------------
+// One second of an integer-Hz tone holds a whole number of cycles, so the
+// fundamental is exactly one DFT bin. SINAD = fundamental power over the
+// power of everything else (harmonics, spurs and quantisation noise).
+static int16_t one_second[SAMPLE_RATE];
+
+static double sinad_db(const int16_t *x, size_t n, uint16_t freq)
+{
+    double re = 0.0, im = 0.0, total = 0.0, mean = 0.0;
+    for (size_t i = 0; i < n; ++i) mean += x[i];
+    mean /= (double)n;
+    for (size_t i = 0; i < n; ++i) {
+        double v = (double)x[i] - mean;
+        double w = 2.0 * M_PI * (double)freq * (double)i / (double)SAMPLE_RATE;
+        re += v * cos(w);
+        im += v * sin(w);
+        total += v * v;
+    }
+    double fund = 2.0 * (re * re + im * im) / (double)n;
+    double rest = total - fund;
+    if (rest <= 0.0) rest = 1e-12;
+    return 10.0 * log10(fund / rest);
+}
+
+static int spectral_check(uint16_t freq)
+{
+    float fphase = 0.0f;
+    for (size_t i = 0; i < SAMPLE_RATE; i += SAMPLES_PER_TICK) {
+        legacy_render_tick(&one_second[i], SAMPLES_PER_TICK, freq, &fphase);
+    }
+    double legacy = sinad_db(one_second, SAMPLE_RATE, freq);
+
+    uint32_t phase = 0;
+    uint32_t inc = synth_phase_inc(freq, SAMPLE_RATE);
+    for (size_t i = 0; i < SAMPLE_RATE; i += SAMPLES_PER_TICK) {
+        dds_render_tick(&one_second[i], SAMPLES_PER_TICK, inc, &phase);
+    }
+    double dds = sinad_db(one_second, SAMPLE_RATE, freq);
+
+    // The DDS path must not be worse than the float path by more than 1 dB
+    int ok = dds >= legacy - 1.0;
+    printf("  %5u Hz  SINAD sinf=%6.1f dB  dds=%6.1f dB  %s\n",
+           (unsigned)freq, legacy, dds, ok ? "ok" : "REGRESSED");
+    return ok;
+}
+
+int main(void)
+{
+    synth_init();
+
+    printf("== Throughput ==\n");
+    bench(440);
+    bench(1760);
+
+    printf("\n== Voice mixer (%s) ==\n", cycles() ? "TSC cycles" : "ns");
+    bench_mixer();
+
+    printf("\n== Envelope overhead per sample (%s, best of %d, vs. bare oscillator) ==\n",
+           cycles() ? "TSC cycles" : "ns", ENV_RUNS);
+    bench_envelopes();
+
+    printf("\n== Spectral check (volume %.2f) ==\n", (double)VOLUME);
+    static const uint16_t freqs[] = { 131, 262, 440, 523, 988, 1760 };
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(freqs) / sizeof(freqs[0]); ++i) {
+        ok &= spectral_check(freqs[i]);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,474 @@
+// tools/blob_sim.c — song library and firmware distribution over a lossy stand-in radio
+//
+// Runs src/blob_xfer.c (the same code song_sync.c uses) end to end: one
+// conductor sends a blob to four performers through an in-process radio
+// that loses every frame to every receiver independently with probability
+// p. Frames are real wire_proto frames. The radio is one shared 1 Mbit/s
+// channel (ESP-NOW's default rate): each frame takes its airtime, a node
+// whose own queue is more than QUEUE_US deep is refused (as esp_now_send()
+// refuses when its queue is full), and unicast gets UNICAST_TRIES MAC-level
+// attempts. Performers store into RAM through a blob_sink_t.
+//
+// For each blob size and loss rate it reports the time until all four
+// performers have the blob committed, throughput (blob KB/s to all four),
+// frames on air per chunk and how the repairs split between broadcast and
+// unicast. Also: a performer whose storage corrupts some writes (caught by
+// the read-back CRC), and one that is switched off (given up, the others
+// still finish).
+//
+// Firmware: an 800 KB image into flash-timed sinks. A performer's receive
+// task is busy for the flash work each frame causes (erasing the slot on
+// OFFER, a page program per chunk, the image check on commit), frames
+// queue behind it (RX_QUEUE deep, as in song_sync.c) and the rest are
+// dropped. Compares fleet update time and aggregate throughput (image
+// bytes delivered to all performers per second) of one broadcast transfer
+// to all four with updating them one after another by unicast.
+//
+// Every committed copy is compared with the original. Exits non-zero if
+// any online performer fails to commit an exact copy.
+//
+// Build & run from the repository root:
+//   cc -O2 -Iinclude tools/blob_sim.c src/blob_xfer.c src/wire_proto.c -o blob_sim
+//   ./blob_sim
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "blob_xfer.h"
+#include "wire_proto.h"
+
+#define N_PERF          4
+#define N_NODES         (N_PERF + 1)      // node 0 is the conductor
+#define TRIALS          20
+#define FW_TRIALS       5
+#define FW_LEN          (800 * 1024)
+#define MAX_BLOB        FW_LEN
+#define MAX_EVENTS      4096
+#define QUEUE_US        10000             // radio queue depth before refusing
+#define STACK_US        300               // receive path after the air
+#define UNICAST_TRIES   4
+#define RX_QUEUE        16                // frames waiting for a busy receive task
+#define SIM_LIMIT_US    (600LL * 1000000)
+
+// Flash timing, typical figures for ESP32 QSPI flash: 64 KB block erase,
+// page program per chunk, read (+ FNV) for the read-back and hash, and the
+// esp_ota_end() + esp_ota_set_boot_partition() image checks per byte
+#define ERASE_64K_US        180000
+#define WRITE_US            250
+#define WRITE_US_PER_BYTE   3
+#define READ_US             40
+#define READ_NS_PER_BYTE    200
+#define VERIFY_NS_PER_BYTE  1000
+
+typedef struct {
+    int64_t t;
+    uint8_t dst;
+    uint8_t src;
+    uint8_t len;
+    bool    deferred;       // waited for a busy receive task
+    uint8_t frame[WIRE_MAX_FRAME];
+} event_t;
+
+typedef struct {
+    uint8_t  store[MAX_BLOB];
+    uint32_t len;
+    int      commits;
+    bool     exact;         // last commit matched the original
+    bool     offline;
+    int      flaky_pct;     // writes that silently corrupt a byte
+    uint32_t corrupted;
+    int64_t  busy_until;    // receive task working on a frame
+    int      backlog;       // frames queued behind it
+    uint32_t rx_dropped;    // receive queue full
+    blob_rx_t rx;
+} perf_t;
+
+typedef struct {
+    double   loss;
+    uint32_t len;
+    bool     flaky;         // performer 1 has bad storage
+    bool     offline;       // performer 4 is switched off
+    bool     fw;            // firmware: flash-timed sinks, firmware pacing
+    bool     seq;           // one performer after another, by unicast
+} scenario_t;
+
+typedef struct {
+    int64_t  all_us;        // start -> last online performer committed
+    int64_t  fleet_us;      // start -> last transfer finished (the sender's view)
+    uint32_t rx_dropped;
+    uint32_t frames;
+    uint32_t repairs_bcast;
+    uint32_t repairs_ucast;
+    uint32_t dups;
+    uint32_t bad_chunks;
+    int      committed;     // online performers with an exact copy
+    int      failed_peers;  // reported failed/given up by the sender
+} result_t;
+
+static event_t   s_ev[MAX_EVENTS];
+static int       s_n_ev;
+static perf_t    s_perf[N_PERF];
+static uint8_t   s_blob[MAX_BLOB];
+static double    s_loss;
+static uint64_t  s_rng = 88172645463325252ull;
+static int64_t   s_now;
+static int64_t   s_air_free;      // shared channel busy until
+static int64_t   s_queued[N_NODES];   // each node's last frame leaves the air
+static uint16_t  s_seq[N_NODES];
+static uint32_t  s_overflow;
+static bool      s_flash;         // sinks cost flash time
+static int64_t   s_cost;          // receive task time of the frame being handled
+static uint8_t   s_unicast_to;    // seq: the conductor's "broadcasts" go to this node
+
+static uint32_t rnd(void)
+{
+    // xorshift64
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 7;
+    s_rng ^= s_rng << 17;
+    return (uint32_t)(s_rng >> 32);
+}
+
+static bool lost(void) { return rnd() < (uint32_t)(s_loss * 4294967295.0); }
+
+// 1 Mbit/s DSSS: long preamble, MAC + vendor action headers, channel access
+static int64_t air_us(size_t len) { return 300 + (int64_t)(len + 43) * 8; }
+
+static void mac_of(uint8_t node, uint8_t mac[6])
+{
+    static const uint8_t base[6] = { 0x24, 0x0A, 0xC4, 0x12, 0x34, 0x00 };
+    memcpy(mac, base, 6);
+    mac[5] = node;
+}
+
+static event_t *push(int64_t t, uint8_t dst, uint8_t src, const uint8_t *frame, size_t len)
+{
+    if (s_n_ev >= MAX_EVENTS) {
+        s_overflow++;
+        return NULL;
+    }
+    event_t *e = &s_ev[s_n_ev++];
+    e->t   = t;
+    e->dst = dst;
+    e->src = src;
+    e->len = (uint8_t)len;
+    e->deferred = false;
+    memcpy(e->frame, frame, len);
+    return e;
+}
+
+// The stand-in radio: node src puts a frame on the shared channel
+static bool radio_send(void *ctx, const uint8_t *mac, uint8_t type, const uint8_t *payload, size_t len)
+{
+    uint8_t src = (uint8_t)(uintptr_t)ctx;
+    if (s_queued[src] - s_now > QUEUE_US) return false;
+    uint8_t to[6];
+    if (!mac && src == 0 && s_unicast_to) {
+        mac_of(s_unicast_to, to);
+        mac = to;
+    }
+
+    uint8_t buf[WIRE_MAX_FRAME];
+    wire_writer_t w;
+    wire_begin(&w, buf, sizeof(buf), type, WIRE_F_NONE, src, ++s_seq[src]);
+    wire_put_bytes(&w, payload, len);
+    size_t n = wire_finish(&w);
+    if (!n) return false;
+
+    // A performer answers once the frame's flash work is done; that frame is
+    // not yet on the channel, so it does not hold up the others meanwhile
+    int64_t ready = src ? s_now + s_cost : s_now;
+    int64_t t = s_air_free > ready ? s_air_free : ready;
+    int64_t air_free = s_air_free;
+    if (!mac) {
+        t += air_us(n);
+        for (uint8_t d = 0; d < N_NODES; ++d) {
+            if (d == src || (d > 0 && s_perf[d - 1].offline) || lost()) continue;
+            push(t + STACK_US, d, src, buf, n);
+        }
+    } else {
+        uint8_t d = mac[5];
+        bool off = d > 0 && s_perf[d - 1].offline;
+        for (int k = 0; k < UNICAST_TRIES; ++k) {
+            t += air_us(n);
+            if (!off && !lost()) {
+                push(t + STACK_US, d, src, buf, n);
+                break;
+            }
+        }
+    }
+    s_air_free    = ready > s_now ? air_free : t;
+    s_queued[src] = t;
+    return true;
+}
+
+// ----------------------
+// Performer storage (RAM, or timed like flash)
+// ----------------------
+static bool sink_begin(void *ctx, uint8_t kind, uint32_t len)
+{
+    perf_t *p = &s_perf[(uintptr_t)ctx - 1];
+    (void)kind;
+    if (len > MAX_BLOB) return false;
+    p->len = len;
+    memset(p->store, 0xFF, len);
+    if (s_flash) s_cost += (int64_t)(len + 65535) / 65536 * ERASE_64K_US;
+    return true;
+}
+
+static bool sink_write(void *ctx, uint32_t off, const uint8_t *data, size_t len)
+{
+    perf_t *p = &s_perf[(uintptr_t)ctx - 1];
+    if (s_flash) s_cost += WRITE_US + (int64_t)len * WRITE_US_PER_BYTE;
+    memcpy(p->store + off, data, len);
+    if (p->flaky_pct && (int)(rnd() % 100) < p->flaky_pct) {
+        p->store[off + rnd() % len] ^= 0x10;
+        p->corrupted++;
+    }
+    return true;
+}
+
+static bool sink_read(void *ctx, uint32_t off, uint8_t *data, size_t len)
+{
+    if (s_flash) s_cost += READ_US + (int64_t)len * READ_NS_PER_BYTE / 1000;
+    memcpy(data, s_perf[(uintptr_t)ctx - 1].store + off, len);
+    return true;
+}
+
+static bool sink_commit(void *ctx, uint8_t kind, uint32_t len)
+{
+    perf_t *p = &s_perf[(uintptr_t)ctx - 1];
+    (void)kind;
+    if (s_flash) s_cost += (int64_t)len * VERIFY_NS_PER_BYTE / 1000;
+    p->commits++;
+    p->exact = len == p->len && memcmp(p->store, s_blob, len) == 0;
+    return true;
+}
+
+static void sink_abort(void *ctx) { (void)ctx; }
+
+static const blob_sink_t k_sink = {
+    .begin = sink_begin, .write = sink_write, .read = sink_read,
+    .commit = sink_commit, .abort = sink_abort,
+};
+
+// ----------------------
+// One transfer
+// ----------------------
+
+// From the conductor to performers first .. first+n-1, starting now
+static void transfer(const scenario_t *sc, blob_tx_t *tx, int first, int n)
+{
+    uint8_t macs[N_PERF][6];
+    for (int i = 0; i < n; ++i) mac_of((uint8_t)(first + i + 1), macs[i]);
+    s_unicast_to = sc->seq ? (uint8_t)(first + 1) : 0;
+
+    blob_tx_init(tx, radio_send, (void *)(uintptr_t)0);
+    if (sc->fw) tx->max_silent = BLOB_FW_MAX_SILENT;
+    blob_tx_start(tx, s_blob, sc->len, sc->fw ? BLOB_KIND_FIRMWARE : BLOB_KIND_SONGS, (uint16_t)rnd(),
+                  (const uint8_t (*)[6])macs, (size_t)n, s_now);
+    int64_t tx_next = blob_tx_poll(tx, s_now);
+
+    while ((blob_tx_busy(tx) || s_n_ev) && s_now < SIM_LIMIT_US) {
+        int first_ev = -1;
+        for (int i = 0; i < s_n_ev; ++i) {
+            if (first_ev < 0 || s_ev[i].t < s_ev[first_ev].t) first_ev = i;
+        }
+        if (first_ev >= 0 && s_ev[first_ev].t <= tx_next) {
+            event_t e = s_ev[first_ev];
+            s_ev[first_ev] = s_ev[--s_n_ev];
+            s_now = e.t;
+
+            wire_frame_t f;
+            uint8_t mac[6];
+            mac_of(e.src, mac);
+            if (wire_parse(e.frame, e.len, &f) != WIRE_OK) continue;
+            if (e.dst == 0) {
+                blob_tx_handle(tx, mac, &f, s_now);
+                tx_next = blob_tx_poll(tx, s_now);
+                continue;
+            }
+            perf_t *p = &s_perf[e.dst - 1];
+            if (s_now < p->busy_until) {
+                // The receive task is still on an earlier frame: queue or drop
+                if (!e.deferred) {
+                    if (p->backlog >= RX_QUEUE) {
+                        p->rx_dropped++;
+                        continue;
+                    }
+                    p->backlog++;
+                }
+                event_t *q = push(p->busy_until, e.dst, e.src, e.frame, e.len);
+                if (q) q->deferred = true;
+                continue;
+            }
+            if (e.deferred) p->backlog--;
+            s_cost = 0;
+            blob_rx_handle(&p->rx, mac, &f, s_now);
+            p->busy_until = s_now + s_cost;
+            s_cost = 0;
+        } else if (tx_next != INT64_MAX) {
+            s_now   = tx_next;
+            tx_next = blob_tx_poll(tx, s_now);
+        } else {
+            break;
+        }
+        for (int i = 0; i < N_PERF; ++i) blob_rx_poll(&s_perf[i].rx, s_now);
+    }
+    s_unicast_to = 0;
+}
+
+static void run(const scenario_t *sc, result_t *res)
+{
+    static blob_tx_t tx;
+    blob_tx_peer_t peers[N_PERF];
+
+    s_loss     = sc->loss;
+    s_flash    = sc->fw;
+    s_now      = 0;
+    s_air_free = 0;
+    s_n_ev     = 0;
+    memset(s_queued, 0, sizeof(s_queued));
+    for (uint32_t i = 0; i < sc->len; ++i) s_blob[i] = (uint8_t)rnd();
+    for (int i = 0; i < N_PERF; ++i) {
+        perf_t *p = &s_perf[i];
+        memset(p, 0, offsetof(perf_t, rx));
+        p->offline   = sc->offline && i == N_PERF - 1;
+        p->flaky_pct = sc->flaky && i == 0 ? 5 : 0;
+        blob_rx_init(&p->rx, &k_sink, radio_send, (void *)(uintptr_t)(i + 1));
+    }
+
+    memset(res, 0, sizeof(*res));
+    if (sc->seq) {
+        for (int i = 0; i < N_PERF; ++i) {
+            transfer(sc, &tx, i, 1);
+            peers[i] = tx.peers[0];
+            res->fleet_us      = tx.end_us;
+            res->frames        += tx.frames;
+            res->repairs_bcast += tx.repairs_bcast;
+            res->repairs_ucast += tx.repairs_ucast;
+        }
+    } else {
+        transfer(sc, &tx, 0, N_PERF);
+        memcpy(peers, tx.peers, sizeof(peers));
+        res->fleet_us      = tx.end_us;
+        res->frames        = tx.frames;
+        res->repairs_bcast = tx.repairs_bcast;
+        res->repairs_ucast = tx.repairs_ucast;
+    }
+
+    for (int i = 0; i < N_PERF; ++i) {
+        const perf_t *p = &s_perf[i];
+        res->dups       += p->rx.dups;
+        res->bad_chunks += p->rx.bad_chunks;
+        res->rx_dropped += p->rx_dropped;
+        if (peers[i].state != BLOB_RX_DONE) res->failed_peers++;
+        if (p->offline) continue;
+        if (p->commits == 1 && p->exact) res->committed++;
+        if (peers[i].done_us > res->all_us) res->all_us = peers[i].done_us;
+    }
+}
+
+static int report(const char *label, const scenario_t *sc, int want_committed)
+{
+    int64_t sum_us = 0, max_us = 0;
+    double frames = 0;
+    uint32_t bcast = 0, ucast = 0, dups = 0, bad = 0;
+    int fails = 0, given_up = 0;
+    for (int t = 0; t < TRIALS; ++t) {
+        result_t r;
+        run(sc, &r);
+        sum_us += r.all_us;
+        if (r.all_us > max_us) max_us = r.all_us;
+        frames += r.frames;
+        bcast  += r.repairs_bcast;
+        ucast  += r.repairs_ucast;
+        dups   += r.dups;
+        bad    += r.bad_chunks;
+        if (r.committed != want_committed) fails++;
+        given_up += r.failed_peers;
+    }
+    uint32_t chunks = (sc->len + BLOB_CHUNK_MAX - 1) / BLOB_CHUNK_MAX;
+    double avg_ms = sum_us / 1000.0 / TRIALS;
+    printf("%-10s %7u %5.0f%% %9.1f %9.1f %8.1f %8.2f %7.1f %7.1f %6u %5u  %d/%d\n",
+           label, (unsigned)sc->len, sc->loss * 100, avg_ms, max_us / 1000.0,
+           sc->len / 1024.0 / (avg_ms / 1000.0), frames / TRIALS / chunks,
+           (double)bcast / TRIALS, (double)ucast / TRIALS, (unsigned)(dups / TRIALS),
+           (unsigned)(bad / TRIALS), TRIALS - fails, TRIALS);
+    if (sc->offline && given_up != TRIALS) {
+        printf("  switched-off performer not given up in every trial (%d/%d)\n", given_up, TRIALS);
+        fails++;
+    }
+    return fails;
+}
+
+// Firmware to the fleet: all at once vs. one after another
+static int report_fw(double loss, int64_t *avg_us)
+{
+    static const char *mode[2] = { "all at once", "one by one" };
+    int fails = 0;
+    for (int m = 0; m < 2; ++m) {
+        scenario_t sc = { .loss = loss, .len = FW_LEN, .fw = true, .seq = m == 1 };
+        int64_t sum_us = 0, max_us = 0;
+        double frames = 0;
+        uint32_t ucast = 0, dropped = 0;
+        int bad = 0;
+        for (int t = 0; t < FW_TRIALS; ++t) {
+            result_t r;
+            run(&sc, &r);
+            sum_us += r.fleet_us;
+            if (r.fleet_us > max_us) max_us = r.fleet_us;
+            frames  += r.frames;
+            ucast   += r.repairs_ucast;
+            dropped += r.rx_dropped;
+            if (r.committed != N_PERF) bad++;
+        }
+        int64_t avg = sum_us / FW_TRIALS;
+        avg_us[m] = avg;
+        printf("%-12s %5.0f%% %9.2f %9.2f %9.1f %8.2f %7.1f %8u  %d/%d\n", mode[m], loss * 100,
+               avg / 1e6, max_us / 1e6, (double)N_PERF * FW_LEN / 1024.0 / (avg / 1e6),
+               frames / FW_TRIALS / ((FW_LEN + BLOB_CHUNK_MAX - 1) / BLOB_CHUNK_MAX),
+               (double)ucast / FW_TRIALS, (unsigned)(dropped / FW_TRIALS), FW_TRIALS - bad, FW_TRIALS);
+        fails += bad;
+    }
+    return fails;
+}
+
+int main(void)
+{
+    static const uint32_t sizes[] = { 952, 16 * 1024, 128 * 1024 };   // today's library, a big one, worst
+    static const double   losses[] = { 0.0, 0.05, 0.10, 0.20, 0.30 };
+    int fails = 0;
+
+    printf("Blob transfer to %d performers, %d trials each, %d B chunks, %u us frame gap\n",
+           N_PERF, TRIALS, BLOB_CHUNK_MAX, (unsigned)BLOB_FRAME_GAP_US);
+    printf("%-10s %7s %6s %9s %9s %8s %8s %7s %7s %6s %5s  %s\n", "case", "bytes", "loss",
+           "avg ms", "max ms", "KB/s", "tx/chnk", "rep-bc", "rep-uc", "dups", "bad", "exact");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        for (size_t l = 0; l < sizeof(losses) / sizeof(losses[0]); ++l) {
+            scenario_t sc = { .loss = losses[l], .len = sizes[s] };
+            fails += report("all 4", &sc, N_PERF);
+        }
+    }
+    scenario_t flaky = { .loss = 0.10, .len = 16 * 1024, .flaky = true };
+    fails += report("bad flash", &flaky, N_PERF);
+    scenario_t off = { .loss = 0.10, .len = 16 * 1024, .offline = true };
+    fails += report("1 off", &off, N_PERF - 1);
+
+    static const double fw_losses[] = { 0.0, 0.10, 0.20 };
+    printf("\nFirmware %u KB to %d performers (flash-timed), %d trials each\n",
+           (unsigned)(FW_LEN / 1024), N_PERF, FW_TRIALS);
+    printf("%-12s %6s %9s %9s %9s %8s %7s %8s  %s\n", "fleet", "loss", "avg s", "max s",
+           "agg KB/s", "tx/chnk", "rep-uc", "rx-drop", "exact");
+    for (size_t l = 0; l < sizeof(fw_losses) / sizeof(fw_losses[0]); ++l) {
+        int64_t avg_us[2];
+        fails += report_fw(fw_losses[l], avg_us);
+        printf("  -> all at once is %.1fx faster\n", (double)avg_us[1] / avg_us[0]);
+    }
+
+    if (s_overflow) printf("event queue overflowed %u times\n", (unsigned)s_overflow);
+    printf("%s\n", fails ? "FAIL" : "OK");
+    return fails ? 1 : 0;
+}
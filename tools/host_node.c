@@ -0,0 +1,290 @@
+// tools/host_node.c — see host_node.h
+#include <stdio.h>
+#include <string.h>
+
+#include "host_node.h"
+#include "orchestra.h"   // msg_type_t, ORCHESTRA_DEFAULT_VOLUME
+
+static void emit(host_node_t *n, host_ev_type_t type, uint64_t sample, int32_t err)
+{
+    if (!n->ev) return;
+    host_ev_t ev = {
+        .type     = type,
+        .song_id  = n->song_id,
+        .epoch_us = n->epoch_us,
+        .sample   = sample,
+        .local_us = host_node_sample_us(sample),
+        .err      = err,
+        .join     = n->join,
+    };
+    n->ev(n->ctx, &ev);
+}
+
+// ----------------------
+// Link hooks (orch_ctl and disco)
+// ----------------------
+static bool hook_send(void *ctx, const uint8_t *dst, const uint8_t *frame, size_t len)
+{
+    host_node_t *n = ctx;
+    if (dst) transport_add_peer(n->tp, dst);
+    return transport_send(n->tp, dst, frame, len) == 0;
+}
+
+static uint16_t hook_next_seq(void *ctx)
+{
+    host_node_t *n = ctx;
+    return ++n->tx_seq;
+}
+
+static int64_t hook_now(void *ctx)
+{
+    host_node_t *n = ctx;
+    return transport_now_us(n->tp);
+}
+
+static size_t hook_performers(void *ctx, uint8_t (*macs)[6], size_t max)
+{
+    host_node_t *n = ctx;
+    return disco_online_performers(&n->disco, macs, max);
+}
+
+static void hook_peer_added(void *ctx, const uint8_t mac[6])
+{
+    host_node_t *n = ctx;
+    transport_add_peer(n->tp, mac);
+}
+
+// ----------------------
+// Performer: playback
+// ----------------------
+static void play_stop(host_node_t *n, host_ev_type_t why, uint64_t at)
+{
+    if (!n->playing) return;
+    n->playing = false;
+    emit(n, why, at, 0);
+}
+
+// Place song sample 0 on the DAC sample local time epoch_us falls on.
+// Already past: enter mid-song, the way the engine seeks a late PLAY.
+static void play_at(host_node_t *n, uint8_t song_id, int64_t epoch_us, bool join)
+{
+    play_stop(n, HOST_EV_STOP, n->dac_pos);
+    if (!part_mix_start(&n->mix, song_id, n->id, 0, AUDIO_DEFAULT_ENVELOPE, HOST_NODE_RATE)) return;
+
+    n->song_id      = song_id;
+    n->epoch_us     = n->ctl.follow.state.start_epoch_us;
+    n->start_sample = (epoch_us * HOST_NODE_RATE + 500000) / 1000000;
+    n->join         = join;
+    n->song_pos     = 0;
+    slip_init(&n->slip);
+    if (n->start_sample < (int64_t)n->dac_pos) {
+        n->song_pos = n->dac_pos - (uint64_t)n->start_sample;
+        if (!part_mix_seek(&n->mix, n->song_pos)) return;
+    }
+    n->playing = true;
+    emit(n, HOST_EV_START, (uint64_t)n->start_sample, 0);
+}
+
+// orch_ctl: a START for later. It fires one block ahead, so song sample 0
+// is placed before the block holding it is rendered, as the engine places
+// a scheduled start ahead of its DMA backlog; a late one plays at once.
+static void hook_schedule(void *ctx, uint8_t song_id, int64_t epoch_us, int64_t rx_us)
+{
+    host_node_t *n = ctx;
+    (void)rx_us;
+    n->pending        = true;
+    n->pending_song   = song_id;
+    n->pending_epoch  = epoch_us;
+    n->pending_due_us = epoch_us - host_node_sample_us(HOST_NODE_BLOCK);
+}
+
+static void hook_play(void *ctx, uint8_t song_id, int64_t epoch_us, uint32_t join_ms)
+{
+    host_node_t *n = ctx;
+    (void)join_ms;
+    n->pending = false;
+    play_at(n, song_id, epoch_us, true);
+}
+
+static void hook_stop(void *ctx)
+{
+    host_node_t *n = ctx;
+    n->pending = false;
+    play_stop(n, HOST_EV_STOP, n->dac_pos);
+}
+
+static void hook_params(void *ctx, const orch_state_t *st)
+{
+    host_node_t *n = ctx;
+    n->volume_q15 = st->volume_q15 > INT16_MAX ? INT16_MAX : (int16_t)st->volume_q15;
+}
+
+// audio_sync_timeline() at the render head: the song should be at song_us
+// at local time at_us, and everything up to dac_pos is rendered, so no
+// slip is in flight
+static void hook_timeline(void *ctx, int64_t song_us, int64_t at_us)
+{
+    host_node_t *n = ctx;
+    if (!n->playing || n->start_sample > (int64_t)n->dac_pos) return;
+
+    int64_t head_us  = song_us + (host_node_sample_us(n->dac_pos) - at_us);
+    int64_t expected = head_us * HOST_NODE_RATE / 1000000;
+    int64_t err = (int64_t)n->song_pos - expected;
+    if (err > INT32_MAX / 2) err = INT32_MAX / 2;
+    if (err < -INT32_MAX / 2) err = -INT32_MAX / 2;
+    emit(n, HOST_EV_TIMELINE, n->dac_pos, (int32_t)err);
+
+    int32_t jump = slip_measure(&n->slip, (int32_t)err, 0);
+    if (jump) {
+        int64_t to = (int64_t)n->song_pos + jump;
+        n->song_pos = to > 0 ? (uint64_t)to : 0;
+        if (!part_mix_seek(&n->mix, n->song_pos)) play_stop(n, HOST_EV_END, n->dac_pos);
+    }
+}
+
+// SELECT (prepare) has no hook: the virtual DAC renders on demand, there
+// is nothing to cache ahead
+static const orch_ctl_hooks_t s_ctl_hooks = {
+    .send       = hook_send,
+    .next_seq   = hook_next_seq,
+    .now        = hook_now,
+    .performers = hook_performers,
+    .schedule   = hook_schedule,
+    .play       = hook_play,
+    .stop       = hook_stop,
+    .params     = hook_params,
+    .timeline   = hook_timeline,
+};
+
+static const disco_hooks_t s_disco_hooks = {
+    .send       = hook_send,
+    .next_seq   = hook_next_seq,
+    .peer_added = hook_peer_added,
+};
+
+// One block at dac_pos. Until song sample 0 the block is silence (the
+// first song block may start inside it); after that it consumes
+// HOST_NODE_BLOCK +- one song samples as the slip controller asks.
+static void render_block(host_node_t *n)
+{
+    memset(n->acc, 0, sizeof(n->acc));
+    if (n->playing) {
+        if (n->start_sample > (int64_t)n->dac_pos) {
+            int64_t pre = n->start_sample - (int64_t)n->dac_pos;
+            if (pre < HOST_NODE_BLOCK) {
+                part_mix_block(&n->mix, n->acc + pre, (size_t)(HOST_NODE_BLOCK - pre));
+                n->song_pos += (uint64_t)(HOST_NODE_BLOCK - pre);
+            }
+        } else {
+            int d = slip_next(&n->slip);
+            part_mix_block(&n->mix, n->acc, (size_t)(HOST_NODE_BLOCK + d));
+            slip_apply_block(n->acc, HOST_NODE_BLOCK, d);
+            n->song_pos += (uint64_t)(HOST_NODE_BLOCK + d);
+        }
+    }
+    int32_t gain = (int32_t)(((int64_t)n->volume_q15 * n->mix.headroom_q15) >> 15);
+    synth_mix_out(n->out, n->acc, HOST_NODE_BLOCK, gain);
+    if (n->pcm) n->pcm(n->ctx, n->dac_pos, n->out, HOST_NODE_BLOCK);
+    n->dac_pos += HOST_NODE_BLOCK;
+
+    if (n->playing && part_mix_done(&n->mix)) play_stop(n, HOST_EV_END, n->dac_pos);
+}
+
+void host_node_render(host_node_t *n, int64_t until_us)
+{
+    if (n->id == HOST_NODE_CONDUCTOR) return;
+    while (host_node_sample_us(n->dac_pos) <= until_us) render_block(n);
+}
+
+// ----------------------
+// Receive
+// ----------------------
+static void on_rx(void *ctx, const uint8_t *src, const uint8_t *frame, size_t len, int64_t rx_us)
+{
+    host_node_t *n = ctx;
+    wire_frame_t f;
+    if (wire_parse(frame, len, &f) != WIRE_OK) {
+        n->rx_bad++;
+        return;
+    }
+    if (WIRE_T_IS_DISCO(f.type)) {
+        disco_handle(&n->disco, src, &f, rx_us);
+    } else {
+        orch_ctl_handle(&n->ctl, src, &f, rx_us);
+    }
+}
+
+// ----------------------
+// Public API
+// ----------------------
+void host_node_init(host_node_t *n, transport_t *tp, uint8_t id, uint16_t boot_id,
+                    host_node_pcm_fn pcm, host_node_ev_fn ev, void *ctx)
+{
+    memset(n, 0, sizeof(*n));
+    n->tp     = tp;
+    n->id     = id;
+    n->tx_seq = (uint16_t)(boot_id * 31u + id * 997u);
+    n->pcm    = pcm;
+    n->ev     = ev;
+    n->ctx    = ctx;
+    transport_set_rx(tp, on_rx, n);
+
+    bool conductor = (id == HOST_NODE_CONDUCTOR);
+    orch_ctl_init(&n->ctl, &s_ctl_hooks, n, id, conductor, boot_id,
+                  (uint16_t)synth_gain_q15(ORCHESTRA_DEFAULT_VOLUME));
+
+    uint8_t mac[TRANSPORT_ADDR_LEN];
+    char name[DISCO_NAME_LEN];
+    transport_own_addr(tp, mac);
+    snprintf(name, sizeof(name), "host-%u", (unsigned)id);
+    disco_init(&n->disco, &s_disco_hooks, n, id, mac, conductor ? DISCO_ROLE_CONDUCTOR : id, name);
+
+    int64_t now = transport_now_us(tp);
+    if (!conductor) {
+        synth_init();
+        slip_init(&n->slip);
+        n->volume_q15 = synth_gain_q15(ORCHESTRA_DEFAULT_VOLUME);
+        n->dac_pos    = host_node_sample_at(now);
+    }
+    disco_start(&n->disco, now);
+    n->ctl_next_us   = now;
+    n->disco_next_us = n->disco.announce_us;
+}
+
+void host_node_poll(host_node_t *n)
+{
+    if (n->pending && transport_now_us(n->tp) >= n->pending_due_us) {
+        n->pending = false;
+        play_at(n, n->pending_song, n->pending_epoch, false);
+    }
+    n->ctl_next_us   = orch_ctl_poll(&n->ctl);
+    n->disco_next_us = disco_poll(&n->disco, transport_now_us(n->tp));
+}
+
+int64_t host_node_next_us(const host_node_t *n)
+{
+    int64_t next = n->ctl_next_us < n->disco_next_us ? n->ctl_next_us : n->disco_next_us;
+    if (n->id == HOST_NODE_CONDUCTOR) return next;
+    if (n->pending && n->pending_due_us < next) next = n->pending_due_us;
+    int64_t block = host_node_sample_us(n->dac_pos);
+    return block < next ? block : next;
+}
+
+uint64_t host_node_start(host_node_t *n, uint8_t song_id)
+{
+    uint64_t epoch;
+    n->acks        = orch_ctl_command(&n->ctl, MSG_SYNC_START, song_id, &epoch);
+    n->ctl_next_us = orch_ctl_poll(&n->ctl);
+    return epoch;
+}
+
+void host_node_stop(host_node_t *n)
+{
+    n->acks        = orch_ctl_command(&n->ctl, MSG_SYNC_STOP, 0, NULL);
+    n->ctl_next_us = orch_ctl_poll(&n->ctl);
+}
+
+const reliable_tx_t *host_node_delivery(const host_node_t *n)
+{
+    return &n->ctl.rtx;
+}
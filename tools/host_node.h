@@ -0,0 +1,125 @@
+// tools/host_node.h — a conductor or performer on a transport, for host runs
+#pragma once
+
+// A node built from the same portable modules as the device: orch_ctl.c
+// runs the control protocol (clock sync, ACK/retry and de-dup, heartbeats,
+// following the state vector) exactly as espnow_comm.c runs it on
+// espnow_task, and disco.c the discovery handshake, so the conductor
+// expects ACKs from the performers it has discovered. This file only
+// carries out the playback orch_ctl asks for, the way the device does:
+// a START is scheduled and fires at its epoch, a JOIN enters mid-song, a
+// STOP drops a pending start, heartbeats steer the song with slips.
+//
+// Time is whatever the node's transport says (transport_now_us()): the
+// monotonic clock on the UDP transport, a drifting simulated clock in
+// tools/orch_sim.c. A performer plays through a virtual DAC on that clock:
+// global sample g sounds at local time g * 1e6 / rate, so a song lands on
+// the exact sample its epoch falls on, and heartbeats steer it with
+// single-sample slips like the audio engine does.
+//
+// Nothing here blocks or sleeps: the caller pumps the transport, calls
+// host_node_poll() and host_node_render(), and sleeps (or advances
+// simulated time) until host_node_next_us().
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "transport.h"
+#include "wire_proto.h"
+#include "orch_ctl.h"
+#include "disco.h"
+#include "part_mix.h"
+#include "slip.h"
+
+#define HOST_NODE_RATE       44100
+#define HOST_NODE_BLOCK      441     // 10 ms, the engine's balanced profile
+#define HOST_NODE_CONDUCTOR  0       // device id; performers are 1..4 (their part)
+
+typedef enum {
+    HOST_EV_START,       // song sample 0 placed at 'sample' (joins: where it would have been)
+    HOST_EV_STOP,        // playback cut at 'sample'
+    HOST_EV_END,         // song played out, last sample before 'sample'
+    HOST_EV_TIMELINE,    // heartbeat check: err (samples, + = ahead) at 'sample'
+} host_ev_type_t;
+
+typedef struct {
+    host_ev_type_t type;
+    uint8_t  song_id;
+    uint64_t epoch_us;   // conductor clock at song sample 0 (START/JOIN)
+    uint64_t sample;     // global DAC sample on the node's clock
+    int64_t  local_us;   // that sample's local time
+    int32_t  err;        // TIMELINE
+    bool     join;       // START came as a join, mid-song
+} host_ev_t;
+
+// Rendered output, in order and without gaps: n samples from global sample 'first'
+typedef void (*host_node_pcm_fn)(void *ctx, uint64_t first, const int16_t *pcm, size_t n);
+typedef void (*host_node_ev_fn)(void *ctx, const host_ev_t *ev);
+
+typedef struct {
+    transport_t *tp;
+    uint8_t      id;            // HOST_NODE_CONDUCTOR or the part, 1..4
+    uint16_t     tx_seq;
+    uint32_t     rx_bad;        // frames wire_parse() refused
+    orch_ctl_t   ctl;           // the device's control protocol
+    disco_t      disco;         // and its discovery
+    int64_t      ctl_next_us;
+    int64_t      disco_next_us;
+    size_t       acks;          // conductor: performers expected to ACK the last command
+
+    // Performer: START scheduled by orch_ctl, fired HOST_NODE_BLOCK ahead
+    // of its epoch (the virtual DAC's render-ahead)
+    bool       pending;
+    uint8_t    pending_song;
+    int64_t    pending_epoch;   // local time of song sample 0
+    int64_t    pending_due_us;
+
+    // Performer: playback through the virtual DAC
+    bool       playing;
+    uint8_t    song_id;
+    uint64_t   epoch_us;        // conductor clock of song sample 0 (from the followed state)
+    int64_t    start_sample;    // global sample that song sample 0 falls on
+    bool       join;
+    part_mix_t mix;
+    uint64_t   song_pos;        // next song sample to render
+    slip_ctl_t slip;
+    int16_t    volume_q15;
+    uint64_t   dac_pos;         // next global sample to render
+    int32_t    acc[HOST_NODE_BLOCK + 1];
+    int16_t    out[HOST_NODE_BLOCK];
+
+    host_node_pcm_fn pcm;
+    host_node_ev_fn  ev;
+    void            *ctx;
+} host_node_t;
+
+// id HOST_NODE_CONDUCTOR or 1..4; takes over the transport's callbacks.
+// boot_id makes the conductor's state vector unique per run (the device
+// uses a random one). A performer's DAC starts at the current local time.
+void host_node_init(host_node_t *n, transport_t *tp, uint8_t id, uint16_t boot_id,
+                    host_node_pcm_fn pcm, host_node_ev_fn ev, void *ctx);
+// Timers: clock sync requests, heartbeats, control retries, discovery,
+// a scheduled start
+void host_node_poll(host_node_t *n);
+// Performer: render every block that starts at or before local time until_us
+void host_node_render(host_node_t *n, int64_t until_us);
+// Local time of the next timer or block that is due
+int64_t host_node_next_us(const host_node_t *n);
+
+// Conductor: START song_id ORCH_START_LEAD_US from now, or STOP; acknowledged
+// by every performer discovered so far (n->acks). Returns the START epoch.
+uint64_t host_node_start(host_node_t *n, uint8_t song_id);
+void     host_node_stop(host_node_t *n);
+// Conductor: delivery stats of the acknowledged commands, per performer
+const reliable_tx_t *host_node_delivery(const host_node_t *n);
+
+// Global DAC sample at/after a local time, and back
+static inline uint64_t host_node_sample_at(int64_t local_us)
+{
+    return (uint64_t)((local_us * HOST_NODE_RATE + 999999) / 1000000);
+}
+static inline int64_t host_node_sample_us(uint64_t sample)
+{
+    return (int64_t)(sample * 1000000 / HOST_NODE_RATE);
+}
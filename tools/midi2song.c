@@ -0,0 +1,543 @@
+// tools/midi2song.c — compile a multi-track MIDI file into per-part melodies
+//
+// Reads a Standard MIDI File (format 0 or 1), applies its tempo map and
+// turns up to four voices (a track, or a channel of a format-0 file) into
+// monophonic melodies for ROLE_PART_1..4. Overlapping notes in a voice are
+// cut at the next onset (chords keep the top note); gaps become rests. Note
+// times are rounded to whole ms on the absolute timeline, so the rounding
+// never accumulates and parts that end on the same tick end on the same ms.
+//
+// All parts must have the same total duration; otherwise the tool lists the
+// lengths and exits non-zero, so a misaligned arrangement fails the build.
+// -p pads shorter parts with a trailing rest instead.
+//
+// Output is either C for songs.c (packed NOTE() bytes, escaped values where
+// a pitch or duration is not in the library tables, and a songs[] entry to
+// paste in), or with -b a binary song record (below) for the song library.
+//
+// Build & run from the repository root:
+//   cc -O2 -Iinclude tools/midi2song.c src/song_pack.c src/songs.c src/note_timeline.c -lm -o midi2song
+//   ./midi2song [-n name] [-v 0,2,3,5] [-T solo|duet|quintet] [-p] [-b out.song] file.mid
+//
+//   -n  C identifier and song name (default: file name)
+//   -v  voices to use for parts 1..4, by the index listed on stderr
+//       (default: the first four voices that have notes)
+//   -T  song type (default: from the number of parts)
+//   -p  pad parts to the longest instead of failing
+//   -b  write a binary song record instead of C source
+//
+// Binary song record, little-endian:
+//   0   "OSNG"
+//   4   u8  version (1)
+//   5   u8  song_type_t
+//   6   u8  parts_mask
+//   7   u8  envelope (SYNTH_ENV_*, 0 = engine default)
+//   8   char name[24], NUL padded
+//   32  u8  n_pitch, u8 n_dur, u16 pitch_hz[n_pitch], u16 dur_ms[n_dur]
+//       (the tables the melodies below are packed against)
+//   then 6 slots (lead, parts[0..4]): u16 notes, u16 bytes, u8 envelope,
+//       u8 alias (0xFF, or the slot whose bytes this one shares)
+//   then the packed bytes of every non-aliased slot, in slot order
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "song_pack.h"
+#include "songs.h"
+
+#define MAX_VOICES   32
+#define MAX_PARTS    4
+#define SLOTS        6
+#define REC_NAME_LEN 24
+#define REC_VERSION  1
+
+// ----------------------
+// SMF parsing
+// ----------------------
+typedef struct {
+    uint32_t on, off;   // ticks
+    uint8_t  key;
+} midi_note_t;
+
+typedef struct {
+    int          track, channel;
+    char         name[32];
+    midi_note_t *notes;
+    size_t       count, cap;
+} voice_t;
+
+typedef struct {
+    uint32_t tick;
+    uint32_t us_per_qn;
+} tempo_t;
+
+static voice_t  s_voices[MAX_VOICES];
+static int      s_n_voices;
+static tempo_t *s_tempo;
+static size_t   s_n_tempo, s_cap_tempo;
+static int      s_division;         // ticks per quarter, or <0 for SMPTE
+
+static void die(const char *msg)
+{
+    fprintf(stderr, "midi2song: %s\n", msg);
+    exit(1);
+}
+
+static void *grow(void *p, size_t *cap, size_t elem)
+{
+    *cap = *cap ? *cap * 2 : 64;
+    p = realloc(p, *cap * elem);
+    if (!p) die("out of memory");
+    return p;
+}
+
+static uint32_t be(const uint8_t *p, int n)
+{
+    uint32_t v = 0;
+    while (n--) v = (v << 8) | *p++;
+    return v;
+}
+
+static uint32_t varlen(const uint8_t **p, const uint8_t *end)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < 4 && *p < end; ++i) {
+        uint8_t b = *(*p)++;
+        v = (v << 7) | (b & 0x7F);
+        if (!(b & 0x80)) return v;
+    }
+    die("bad variable-length quantity");
+    return 0;
+}
+
+static voice_t *voice_for(int track, int channel)
+{
+    for (int i = 0; i < s_n_voices; ++i) {
+        if (s_voices[i].track == track && s_voices[i].channel == channel) return &s_voices[i];
+    }
+    if (s_n_voices == MAX_VOICES) die("too many voices");
+    voice_t *v = &s_voices[s_n_voices++];
+    memset(v, 0, sizeof(*v));
+    v->track = track;
+    v->channel = channel;
+    return v;
+}
+
+static void parse_track(int track, const uint8_t *p, const uint8_t *end)
+{
+    // Sounding note per channel/key: index into the voice's notes, or -1
+    static long open_note[16][128];
+    memset(open_note, 0xFF, sizeof(open_note));
+    char name[32] = "";
+    uint32_t tick = 0;
+    uint8_t status = 0;
+
+    while (p < end) {
+        tick += varlen(&p, end);
+        if (p >= end) break;
+        if (*p & 0x80) status = *p++;
+        else if (!status) die("running status without a status byte");
+
+        if (status == 0xFF) {                       // meta
+            if (p >= end) break;
+            uint8_t type = *p++;
+            uint32_t len = varlen(&p, end);
+            if (p + len > end) die("truncated meta event");
+            if (type == 0x51 && len == 3) {
+                if (s_n_tempo == s_cap_tempo) s_tempo = grow(s_tempo, &s_cap_tempo, sizeof(*s_tempo));
+                s_tempo[s_n_tempo++] = (tempo_t){ tick, be(p, 3) };
+            } else if (type == 0x03) {
+                size_t n = len < sizeof(name) - 1 ? len : sizeof(name) - 1;
+                memcpy(name, p, n);
+                name[n] = 0;
+            } else if (type == 0x2F) {
+                break;
+            }
+            p += len;
+            status = 0;
+        } else if (status == 0xF0 || status == 0xF7) {   // sysex
+            uint32_t len = varlen(&p, end);
+            p += len;
+            status = 0;
+        } else {
+            int ch = status & 0x0F, kind = status & 0xF0;
+            int nbytes = (kind == 0xC0 || kind == 0xD0) ? 1 : 2;
+            if (p + nbytes > end) die("truncated channel event");
+            uint8_t key = p[0] & 0x7F, vel = nbytes > 1 ? p[1] : 0;
+            p += nbytes;
+
+            if (kind == 0x90 && vel) {
+                voice_t *v = voice_for(track, ch);
+                if (open_note[ch][key] >= 0) v->notes[open_note[ch][key]].off = tick;   // re-struck
+                if (v->count == v->cap) v->notes = grow(v->notes, &v->cap, sizeof(*v->notes));
+                v->notes[v->count] = (midi_note_t){ tick, tick, key };
+                open_note[ch][key] = (long)v->count++;
+            } else if (kind == 0x80 || kind == 0x90) {
+                if (open_note[ch][key] >= 0) {
+                    voice_for(track, ch)->notes[open_note[ch][key]].off = tick;
+                    open_note[ch][key] = -1;
+                }
+            }
+        }
+    }
+    // Notes still sounding at the end of the track stop there
+    for (int ch = 0; ch < 16; ++ch) {
+        for (int k = 0; k < 128; ++k) {
+            if (open_note[ch][k] >= 0) voice_for(track, ch)->notes[open_note[ch][k]].off = tick;
+        }
+    }
+    for (int i = 0; i < s_n_voices; ++i) {
+        if (s_voices[i].track == track && !s_voices[i].name[0]) strcpy(s_voices[i].name, name);
+    }
+}
+
+static void parse_smf(const uint8_t *buf, size_t len)
+{
+    if (len < 14 || memcmp(buf, "MThd", 4) || be(buf + 4, 4) < 6) die("not a MIDI file");
+    uint32_t hlen = be(buf + 4, 4);
+    int format = (int)be(buf + 8, 2), ntrk = (int)be(buf + 10, 2);
+    s_division = (int16_t)be(buf + 12, 2);
+    if (format > 1) die("format 2 MIDI files are not supported");
+
+    const uint8_t *p = buf + 8 + hlen, *end = buf + len;
+    for (int t = 0; t < ntrk && p + 8 <= end; ++t) {
+        uint32_t tlen = be(p + 4, 4);
+        if (p + 8 + tlen > end) die("truncated track");
+        if (!memcmp(p, "MTrk", 4)) parse_track(t, p + 8, p + 8 + tlen);
+        p += 8 + tlen;
+    }
+}
+
+// ----------------------
+// Tempo map
+// ----------------------
+static int cmp_tempo(const void *a, const void *b)
+{
+    const tempo_t *x = a, *y = b;
+    return x->tick < y->tick ? -1 : x->tick > y->tick;
+}
+
+// Microseconds from song start to a tick, through every tempo change
+static double tick_us(uint32_t tick)
+{
+    if (s_division < 0) {
+        // SMPTE: -frames per second in the high byte, ticks per frame in the low
+        int fps = -(int8_t)(s_division >> 8), tpf = s_division & 0xFF;
+        return (double)tick * 1e6 / ((fps == 29 ? 29.97 : fps) * tpf);
+    }
+    double us = 0;
+    uint32_t at = 0, us_per_qn = 500000;   // 120 bpm until the first change
+    for (size_t i = 0; i < s_n_tempo && s_tempo[i].tick < tick; ++i) {
+        us += (double)(s_tempo[i].tick - at) * us_per_qn / s_division;
+        at = s_tempo[i].tick;
+        us_per_qn = s_tempo[i].us_per_qn;
+    }
+    return us + (double)(tick - at) * us_per_qn / s_division;
+}
+
+static uint32_t tick_ms(uint32_t tick)
+{
+    return (uint32_t)llround(tick_us(tick) / 1000.0);
+}
+
+// ----------------------
+// Voices -> melodies
+// ----------------------
+typedef struct {
+    note_t  *notes;
+    size_t   count, cap;
+    uint32_t end_ms;
+    unsigned cut, dropped;
+} melody_t;
+
+static void push(melody_t *m, uint16_t hz, uint32_t ms)
+{
+    // A note_t holds up to 65535 ms; longer ones are split
+    while (ms) {
+        uint16_t d = ms > 65535u ? 65535u : (uint16_t)ms;
+        if (m->count == m->cap) m->notes = grow(m->notes, &m->cap, sizeof(*m->notes));
+        m->notes[m->count++] = (note_t){ hz, d };
+        ms -= d;
+    }
+}
+
+static int cmp_onset(const void *a, const void *b)
+{
+    const midi_note_t *x = a, *y = b;
+    if (x->on != y->on) return x->on < y->on ? -1 : 1;
+    return (int)y->key - (int)x->key;       // highest key first within a chord
+}
+
+static uint16_t key_hz(uint8_t key)
+{
+    return (uint16_t)lround(440.0 * pow(2.0, (key - 69) / 12.0));
+}
+
+static void voice_to_melody(voice_t *v, melody_t *m)
+{
+    memset(m, 0, sizeof(*m));
+    qsort(v->notes, v->count, sizeof(*v->notes), cmp_onset);
+
+    uint32_t cursor = 0;    // ms already covered
+    for (size_t i = 0; i < v->count; ++i) {
+        midi_note_t n = v->notes[i];
+        if (i && n.on == v->notes[i - 1].on) {  // lower note of a chord
+            m->dropped++;
+            continue;
+        }
+        // Monophonic: the next onset ends this note
+        size_t j = i + 1;
+        while (j < v->count && v->notes[j].on == n.on) j++;
+        if (j < v->count && v->notes[j].on < n.off) {
+            n.off = v->notes[j].on;
+            m->cut++;
+        }
+        uint32_t on = tick_ms(n.on), off = tick_ms(n.off);
+        if (on < cursor) on = cursor;
+        if (off <= on) {
+            m->dropped++;
+            continue;
+        }
+        if (on > cursor) push(m, REST, on - cursor);
+        push(m, key_hz(n.key), off - on);
+        cursor = off;
+    }
+    m->end_ms = cursor;
+}
+
+// ----------------------
+// Output
+// ----------------------
+#define SONG_PITCH_NAME(n) #n,
+#define SONG_DUR_NAME(n)   #n,
+static const char *const k_pitch_names[] = { SONG_PITCHES(SONG_PITCH_NAME) };
+static const char *const k_dur_names[]   = { SONG_DURATIONS(SONG_DUR_NAME) };
+
+static int table_index(const uint16_t *tab, uint8_t n, uint16_t v)
+{
+    for (uint8_t i = 0; i < n; ++i) if (tab[i] == v) return i;
+    return -1;
+}
+
+// One note as C source into buf
+static void c_note(char *buf, size_t cap, const note_t *n)
+{
+    const song_pack_tables_t *t = &song_tables;
+    int pi = table_index(t->pitch_hz, t->n_pitch, n->frequency);
+    int di = table_index(t->dur_ms, t->n_dur, n->duration_ms);
+    if (pi >= 0 && di >= 0) {
+        snprintf(buf, cap, "NOTE(%s, %s)", k_pitch_names[pi], k_dur_names[di]);
+        return;
+    }
+    char p[32], d[32], pv[32] = "", dv[32] = "";
+    if (pi >= 0) snprintf(p, sizeof(p), "PITCH_%s", k_pitch_names[pi]);
+    else { snprintf(p, sizeof(p), "SONG_PACK_PITCH_ESC"); snprintf(pv, sizeof(pv), ", SONG_PACK_U16(%u)", n->frequency); }
+    if (di >= 0) snprintf(d, sizeof(d), "DUR_%s", k_dur_names[di]);
+    else { snprintf(d, sizeof(d), "SONG_PACK_DUR_ESC"); snprintf(dv, sizeof(dv), ", SONG_PACK_U16(%u)", n->duration_ms); }
+    snprintf(buf, cap, "SONG_PACK_NOTE(%s, %s)%s%s", p, d, pv, dv);
+}
+
+static const char *const k_type_names[] = { "SONG_TYPE_SOLO", "SONG_TYPE_DUET", "SONG_TYPE_QUINTET" };
+
+static void emit_c(const char *src, const char *ident, song_type_t type,
+                   melody_t *parts, int n_parts)
+{
+    printf("// Generated by tools/midi2song.c from %s: %d part(s), %u ms\n",
+           src, n_parts, (unsigned)parts[0].end_ms);
+    for (int p = 0; p < n_parts; ++p) {
+        printf("const uint8_t %s_p%d_notes[] = {", ident, p + 1);
+        size_t col = 100;
+        for (size_t i = 0; i < parts[p].count; ++i) {
+            char note[128];
+            c_note(note, sizeof(note), &parts[p].notes[i]);
+            size_t len = strlen(note) + 2;
+            if (col + len > 100) {
+                printf("\n   ");
+                col = 3;
+            }
+            printf(" %s%s", note, i + 1 < parts[p].count ? "," : "");
+            col += len;
+        }
+        printf("\n};\n\n");
+    }
+
+    printf("    [SONG_%s] = {\n", ident);
+    printf("        .name = \"%s\",\n", ident);
+    printf("        .type = %s,\n", k_type_names[type]);
+    printf("        .notes = %s_p1_notes,\n", ident);
+    printf("        .note_count = %zu,\n", parts[0].count);
+    printf("        .tables = &song_tables,\n");
+    printf("        .parts_mask = ");
+    for (int p = 0; p < n_parts; ++p) printf("%sPART_%d", p ? " | " : "", p + 1);
+    printf(",\n        .parts = {\n");
+    for (int p = 0; p < n_parts; ++p) {
+        printf("            [%d] = { %s_p%d_notes, %zu },\n", p + 1, ident, p + 1, parts[p].count);
+    }
+    printf("        }\n    },\n");
+}
+
+static void put16(FILE *f, uint16_t v)
+{
+    fputc(v & 0xFF, f);
+    fputc(v >> 8, f);
+}
+
+static void emit_bin(const char *path, const char *name, song_type_t type,
+                     melody_t *parts, int n_parts)
+{
+    const song_pack_tables_t *t = &song_tables;
+    uint8_t *data[SLOTS] = { 0 };
+    size_t   len[SLOTS] = { 0 };
+    uint8_t  mask = 0;
+
+    for (int p = 0; p < n_parts; ++p) {
+        int slot = 2 + p;                       // lead, parts[0], parts[1..4]
+        len[slot] = song_pack_encode(t, parts[p].notes, (uint16_t)parts[p].count, NULL, 0);
+        data[slot] = malloc(len[slot] ? len[slot] : 1);
+        if (!data[slot]) die("out of memory");
+        song_pack_encode(t, parts[p].notes, (uint16_t)parts[p].count, data[slot], len[slot]);
+        mask |= (uint8_t)(1u << p);
+    }
+
+    FILE *f = fopen(path, "wb");
+    if (!f) die("cannot write the output file");
+    char rec_name[REC_NAME_LEN] = { 0 };
+    size_t nlen = strlen(name);
+    memcpy(rec_name, name, nlen < REC_NAME_LEN - 1 ? nlen : REC_NAME_LEN - 1);
+    fwrite("OSNG", 1, 4, f);
+    fputc(REC_VERSION, f);
+    fputc(type, f);
+    fputc(mask, f);
+    fputc(0, f);
+    fwrite(rec_name, 1, REC_NAME_LEN, f);
+    fputc(t->n_pitch, f);
+    fputc(t->n_dur, f);
+    for (uint8_t i = 0; i < t->n_pitch; ++i) put16(f, t->pitch_hz[i]);
+    for (uint8_t i = 0; i < t->n_dur; ++i) put16(f, t->dur_ms[i]);
+    for (int s = 0; s < SLOTS; ++s) {
+        // The lead shares part 1's bytes
+        int alias = (s == 0) ? 2 : -1;
+        uint16_t count = (uint16_t)(s == 0 ? parts[0].count : (s >= 2 && s - 2 < n_parts ? parts[s - 2].count : 0));
+        put16(f, count);
+        put16(f, (uint16_t)(alias >= 0 ? 0 : len[s]));
+        fputc(0, f);
+        fputc(alias >= 0 ? alias : 0xFF, f);
+    }
+    for (int s = 0; s < SLOTS; ++s) {
+        if (len[s]) fwrite(data[s], 1, len[s], f);
+        free(data[s]);
+    }
+    if (fclose(f)) die("write failed");
+}
+
+// ----------------------
+// Main
+// ----------------------
+static void usage(void)
+{
+    fprintf(stderr, "usage: midi2song [-n name] [-v 0,2,3,5] [-T solo|duet|quintet] [-p] [-b out.song] file.mid\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    const char *name = NULL, *voices_arg = NULL, *bin = NULL, *path = NULL;
+    int type = -1, pad = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) name = argv[++i];
+        else if (!strcmp(argv[i], "-v") && i + 1 < argc) voices_arg = argv[++i];
+        else if (!strcmp(argv[i], "-b") && i + 1 < argc) bin = argv[++i];
+        else if (!strcmp(argv[i], "-p")) pad = 1;
+        else if (!strcmp(argv[i], "-T") && i + 1 < argc) {
+            ++i;
+            if (!strcmp(argv[i], "solo")) type = SONG_TYPE_SOLO;
+            else if (!strcmp(argv[i], "duet")) type = SONG_TYPE_DUET;
+            else if (!strcmp(argv[i], "quintet")) type = SONG_TYPE_QUINTET;
+            else usage();
+        } else if (argv[i][0] != '-' && !path) path = argv[i];
+        else usage();
+    }
+    if (!path) usage();
+
+    FILE *f = fopen(path, "rb");
+    if (!f) die("cannot open the input file");
+    fseek(f, 0, SEEK_END);
+    long flen = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = malloc(flen > 0 ? (size_t)flen : 1);
+    if (!buf || fread(buf, 1, (size_t)flen, f) != (size_t)flen) die("cannot read the input file");
+    fclose(f);
+    parse_smf(buf, (size_t)flen);
+    free(buf);
+    if (s_n_tempo) qsort(s_tempo, s_n_tempo, sizeof(*s_tempo), cmp_tempo);
+
+    // Default name: file name without directory and extension, as a C identifier
+    char ident[64];
+    const char *base = strrchr(path, '/');
+    snprintf(ident, sizeof(ident), "%s", name ? name : (base ? base + 1 : path));
+    if (!name) { char *dot = strrchr(ident, '.'); if (dot) *dot = 0; }
+    for (char *c = ident; *c; ++c) {
+        int ok = (*c >= '0' && *c <= '9') || (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z');
+        if (!ok) *c = '_';
+    }
+
+    fprintf(stderr, "%d voice(s), %zu tempo change(s)\n", s_n_voices, s_n_tempo);
+    for (int i = 0; i < s_n_voices; ++i) {
+        fprintf(stderr, "  voice %d: track %d channel %d, %zu notes %s\n", i, s_voices[i].track,
+                s_voices[i].channel + 1, s_voices[i].count, s_voices[i].name);
+    }
+
+    int pick[MAX_PARTS], n_parts = 0;
+    if (voices_arg) {
+        for (const char *c = voices_arg; *c && n_parts < MAX_PARTS; ) {
+            char *e;
+            long v = strtol(c, &e, 10);
+            if (e == c || v < 0 || v >= s_n_voices) die("bad voice index in -v");
+            pick[n_parts++] = (int)v;
+            c = (*e == ',') ? e + 1 : e;
+        }
+    } else {
+        for (int i = 0; i < s_n_voices && n_parts < MAX_PARTS; ++i) {
+            if (s_voices[i].count) pick[n_parts++] = i;
+        }
+    }
+    if (!n_parts) die("no notes found");
+
+    melody_t parts[MAX_PARTS];
+    uint32_t longest = 0;
+    for (int p = 0; p < n_parts; ++p) {
+        voice_to_melody(&s_voices[pick[p]], &parts[p]);
+        if (parts[p].end_ms > longest) longest = parts[p].end_ms;
+        if (parts[p].count > UINT16_MAX) die("a part has more than 65535 notes");
+        if (parts[p].cut || parts[p].dropped) {
+            fprintf(stderr, "  part %d: %u overlapping note(s) shortened, %u chord/zero-length note(s) dropped\n",
+                    p + 1, parts[p].cut, parts[p].dropped);
+        }
+    }
+
+    int misaligned = 0;
+    for (int p = 0; p < n_parts; ++p) {
+        if (parts[p].end_ms == longest) continue;
+        if (pad) push(&parts[p], REST, longest - parts[p].end_ms);
+        else misaligned = 1;
+    }
+    if (misaligned) {
+        fprintf(stderr, "midi2song: parts differ in length:\n");
+        for (int p = 0; p < n_parts; ++p) {
+            fprintf(stderr, "  part %d (voice %d): %u ms\n", p + 1, pick[p], (unsigned)parts[p].end_ms);
+        }
+        fprintf(stderr, "fix the arrangement or pass -p to pad with rests\n");
+        return 1;
+    }
+    for (int p = 0; p < n_parts; ++p) parts[p].end_ms = longest;
+
+    if (type < 0) type = n_parts == 1 ? SONG_TYPE_SOLO : n_parts == 2 ? SONG_TYPE_DUET : SONG_TYPE_QUINTET;
+    if (bin) emit_bin(bin, ident, (song_type_t)type, parts, n_parts);
+    else emit_c(path, ident, (song_type_t)type, parts, n_parts);
+    fprintf(stderr, "%d part(s), %u ms each\n", n_parts, (unsigned)longest);
+    return 0;
+}
@@ -0,0 +1,501 @@
+// tools/orch_sim.c — deterministic orchestra simulation: loss, latency, clock drift
+//
+// One conductor and N performers, each a tools/host_node.c node (the
+// device's control path: wire frames, clock sync, ACK/retry, replicated
+// state, timeline slips, the engine's play cursor), on a simulated radio
+// driven by a discrete-event loop. Every node has its own clock: a random
+// boot offset plus a drift in ppm, which the performer's virtual DAC runs
+// on too, as an I2S clock on the same crystal would. Every frame, broadcast
+// or unicast, is lost per link with its own probability and delayed by
+// base + uniform jitter, plus now and then an exponential spike (WiFi
+// retries, queueing). Unicast gets no MAC-level retries here, so loss is
+// modelled pessimistically.
+//
+// The conductor waits -w seconds for clock sync, then plays -S songs for
+// -T seconds each and stops them, 1 s apart. Reported, on true (simulated)
+// time:
+//   start spread      per song, first to last performer's sample 0, and
+//                     the worst start against the conductor's epoch
+//   stop propagation  conductor STOP -> each performer's output cut
+//   clock error       performer estimate of the conductor clock vs the
+//                     real one, at every heartbeat arrival
+//   playback error    where each performer's song actually is vs where it
+//                     should be, at every heartbeat timeline check
+// plus slips per performer and the conductor's delivery report. Everything
+// comes from one xorshift generator seeded with -s, so a seed replays
+// exactly; the trace hash (frames and events) tells two runs apart. Exits
+// non-zero if a performer misses a song altogether.
+//
+// Build & run from the repository root:
+//   cc -O2 -Iinclude -Itools tools/orch_sim.c tools/host_node.c src/transport.c src/wire_proto.c src/clock_sync.c src/reliable.c src/orch_state.c src/orch_ctl.c src/disco.c src/part_mix.c src/slip.c src/note_timeline.c src/synth.c src/songs.c src/song_lib.c src/song_pack.c -lm -o orch_sim
+//   ./orch_sim [-n performers (4)] [-s seed] [-l loss %] [-d delay us] [-j jitter us]
+//              [-x spike %] [-X spike mean us] [-p drift ppm] [-S songs] [-T secs] [-w secs]
+//              [-L from:to:loss%] [-P node:ppm]
+// Nodes are numbered 0 (conductor) to n; -L and -P may repeat.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_node.h"
+#include "songs.h"
+
+#define MAX_NODES     (1 + RELIABLE_MAX_PEERS)
+#define MAX_SONGS     64
+#define MAX_SAMPLES   200000
+#define SONG_GAP_US   1000000
+
+// ----------------------
+// Random numbers
+// ----------------------
+static uint64_t s_rng;
+
+static uint64_t rnd(void)
+{
+    // xorshift64
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 7;
+    s_rng ^= s_rng << 17;
+    return s_rng;
+}
+
+static double urand(void) { return (double)(rnd() >> 11) / 9007199254740992.0; }   // [0, 1)
+
+// FNV-1a 64 over everything that happens, to compare runs
+static uint64_t s_trace = 0xcbf29ce484222325ull;
+
+static void trace(int64_t a, int64_t b)
+{
+    int64_t v[2] = { a, b };
+    const uint8_t *p = (const uint8_t *)v;
+    for (size_t i = 0; i < sizeof(v); ++i) s_trace = (s_trace ^ p[i]) * 0x100000001b3ull;
+}
+
+// ----------------------
+// Simulated radio
+// ----------------------
+typedef struct {
+    transport_t tp;
+    host_node_t node;
+    int         idx;
+    uint8_t     addr[TRANSPORT_ADDR_LEN];
+    int64_t     offset_us;    // local clock at true time 0
+    double      ppm;
+    uint32_t    slips, jumps; // over all songs (slip.c restarts per song)
+} sim_node_t;
+
+typedef struct {
+    int64_t t;                // true arrival time
+    uint64_t order;           // FIFO among equal times
+    int     to;
+    int     from;
+    uint8_t len;
+    uint8_t frame[TRANSPORT_MAX_FRAME];
+} flight_t;
+
+static sim_node_t s_nodes[MAX_NODES];
+static int        s_n_nodes;
+static int64_t    s_now;                 // true time, us
+static flight_t  *s_heap;
+static size_t     s_heap_n, s_heap_cap;
+static uint64_t   s_order;
+
+// Link model
+static double  s_loss[MAX_NODES][MAX_NODES];
+static int64_t s_delay_us = 1000, s_jitter_us = 2000, s_spike_us = 8000;
+static double  s_spike_p = 0.02;
+static uint64_t s_frames_sent, s_frames_lost;
+
+static int64_t local_at(const sim_node_t *s, int64_t true_us)
+{
+    return s->offset_us + true_us + (int64_t)floor((double)true_us * s->ppm * 1e-6);
+}
+
+// Earliest true time at which the node's clock reads local_us
+static int64_t true_at(const sim_node_t *s, int64_t local_us)
+{
+    int64_t t = (int64_t)ceil((double)(local_us - s->offset_us) / (1.0 + s->ppm * 1e-6));
+    while (local_at(s, t) < local_us) t++;
+    while (t > 0 && local_at(s, t - 1) >= local_us) t--;
+    return t;
+}
+
+static bool flight_before(const flight_t *a, const flight_t *b)
+{
+    return a->t < b->t || (a->t == b->t && a->order < b->order);
+}
+
+static void heap_push(const flight_t *f)
+{
+    if (s_heap_n == s_heap_cap) {
+        s_heap_cap = s_heap_cap ? 2 * s_heap_cap : 256;
+        s_heap = realloc(s_heap, s_heap_cap * sizeof(*s_heap));
+        if (!s_heap) exit(1);
+    }
+    size_t i = s_heap_n++;
+    while (i && flight_before(f, &s_heap[(i - 1) / 2])) {
+        s_heap[i] = s_heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    s_heap[i] = *f;
+}
+
+static void heap_pop(flight_t *out)
+{
+    *out = s_heap[0];
+    flight_t last = s_heap[--s_heap_n];
+    size_t i = 0;
+    for (;;) {
+        size_t c = 2 * i + 1;
+        if (c >= s_heap_n) break;
+        if (c + 1 < s_heap_n && flight_before(&s_heap[c + 1], &s_heap[c])) c++;
+        if (!flight_before(&s_heap[c], &last)) break;
+        s_heap[i] = s_heap[c];
+        i = c;
+    }
+    if (s_heap_n) s_heap[i] = last;
+}
+
+static int64_t link_delay(void)
+{
+    int64_t d = s_delay_us + (s_jitter_us > 0 ? (int64_t)(rnd() % (uint64_t)(s_jitter_us + 1)) : 0);
+    if (urand() < s_spike_p) d += (int64_t)(-log(1.0 - urand()) * (double)s_spike_us);
+    return d > 0 ? d : 1;
+}
+
+static int sim_send(transport_t *t, const uint8_t *dst, const uint8_t *frame, size_t len)
+{
+    sim_node_t *from = t->priv;
+    for (int k = 0; k < s_n_nodes; ++k) {
+        sim_node_t *to = &s_nodes[k];
+        if (to == from) continue;
+        if (!transport_is_broadcast(dst) && memcmp(dst, to->addr, TRANSPORT_ADDR_LEN) != 0) continue;
+        s_frames_sent++;
+        if (urand() < s_loss[from->idx][k]) {
+            s_frames_lost++;
+            continue;
+        }
+        flight_t f = { .t = s_now + link_delay(), .order = s_order++, .to = k, .from = from->idx,
+                       .len = (uint8_t)len };
+        memcpy(f.frame, frame, len);
+        heap_push(&f);
+    }
+    transport_report_tx(t, dst ? dst : TRANSPORT_BROADCAST, true);
+    return 0;
+}
+
+static void sim_own_addr(transport_t *t, uint8_t *addr)
+{
+    memcpy(addr, ((sim_node_t *)t->priv)->addr, TRANSPORT_ADDR_LEN);
+}
+
+static int64_t sim_now_us(transport_t *t)
+{
+    return local_at(t->priv, s_now);
+}
+
+// ----------------------
+// Measurements
+// ----------------------
+typedef struct {
+    uint8_t  song_id;
+    uint64_t epoch_us;             // conductor clock
+    int64_t  epoch_true;
+    int64_t  stop_true;            // conductor sent STOP, 0 = not yet
+    int64_t  start_true[MAX_NODES];
+    bool     started[MAX_NODES];
+    bool     joined[MAX_NODES];
+    int64_t  cut_true[MAX_NODES];  // STOP took effect
+} song_rec_t;
+
+typedef struct {
+    double *v;
+    size_t  n;
+} series_t;
+
+static song_rec_t s_songs[MAX_SONGS];
+static int        s_n_songs;
+static series_t   s_clock_err, s_play_err;
+
+static void series_add(series_t *s, double v)
+{
+    if (!s->v) s->v = malloc(MAX_SAMPLES * sizeof(double));
+    if (s->v && s->n < MAX_SAMPLES) s->v[s->n++] = fabs(v);
+}
+
+static int cmp_dbl(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void series_print(const char *name, series_t *s, const char *unit)
+{
+    if (!s->n) {
+        printf("%-20s (no samples)\n", name);
+        return;
+    }
+    qsort(s->v, s->n, sizeof(double), cmp_dbl);
+    printf("%-20s |err| p50 %7.1f  p99 %7.1f  max %7.1f %s   (%zu samples)\n", name,
+           s->v[s->n / 2], s->v[(s->n * 99) / 100], s->v[s->n - 1], unit, s->n);
+}
+
+static song_rec_t *song_of(uint64_t epoch_us)
+{
+    for (int i = s_n_songs - 1; i >= 0; --i) {
+        if (s_songs[i].epoch_us == epoch_us) return &s_songs[i];
+    }
+    return NULL;
+}
+
+static void on_event(void *ctx, const host_ev_t *ev)
+{
+    sim_node_t *s = ctx;
+    int k = s->idx;
+    trace(ev->type, (int64_t)ev->sample);
+    song_rec_t *r = song_of(ev->epoch_us);
+    if (!r) return;
+    int64_t at = true_at(s, ev->local_us);
+
+    switch (ev->type) {
+    case HOST_EV_START:
+        if (!r->started[k]) {
+            r->started[k]    = true;
+            r->joined[k]     = ev->join;
+            r->start_true[k] = at;
+        }
+        break;
+    case HOST_EV_STOP:
+    case HOST_EV_END:
+        if (ev->type == HOST_EV_STOP && r->stop_true && !r->cut_true[k]) r->cut_true[k] = at;
+        s->slips += s->node.slip.skipped + s->node.slip.repeated;
+        s->jumps += s->node.slip.jumps;
+        break;
+    case HOST_EV_TIMELINE: {
+        // Where the song really is at that sample vs where the conductor's
+        // clock says it should be
+        double ideal = (double)(local_at(&s_nodes[0], at) - (int64_t)r->epoch_us) * HOST_NODE_RATE / 1e6;
+        series_add(&s_play_err, ((double)s->node.song_pos - ideal) * 1e6 / HOST_NODE_RATE);
+        break;
+    }
+    }
+}
+
+// A heartbeat just reached performer k: how far off is its conductor clock?
+static void check_clock(sim_node_t *s, const flight_t *f)
+{
+    wire_frame_t w;
+    int64_t remote;
+    if (s->idx == 0 || wire_parse(f->frame, f->len, &w) != WIRE_OK || w.type != MSG_HEARTBEAT) return;
+    if (!clock_sync_to_remote(&s->node.ctl.clock.sync, local_at(s, s_now), &remote, NULL)) return;
+    series_add(&s_clock_err, (double)(remote - local_at(&s_nodes[0], s_now)));
+}
+
+// ----------------------
+// Run
+// ----------------------
+static void deliver(const flight_t *f)
+{
+    sim_node_t *to = &s_nodes[f->to];
+    trace(f->t, ((int64_t)f->from << 16) | ((int64_t)f->to << 8) | f->len);
+    transport_deliver(&to->tp, s_nodes[f->from].addr, f->frame, f->len, local_at(to, s_now));
+    check_clock(to, f);
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: orch_sim [-n 1..%d] [-s seed] [-l loss%%] [-d delay_us] [-j jitter_us] [-x spike%%]\n"
+            "                [-X spike_mean_us] [-p ppm] [-S songs] [-T secs] [-w secs]\n"
+            "                [-L from:to:loss%%] [-P node:ppm]\n", RELIABLE_MAX_PEERS);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    int n_perf = 4, n_play = 6;
+    uint64_t seed = 1;
+    double loss = 0.05, ppm = 40, play_s = 10, warm_s = 3;
+    const char *links[32], *drifts[MAX_NODES];
+    int n_links = 0, n_drifts = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        if (a[0] != '-' || !a[1] || a[2] || i + 1 >= argc) usage();
+        const char *v = argv[++i];
+        switch (a[1]) {
+        case 'n': n_perf = atoi(v); break;
+        case 's': seed = strtoull(v, NULL, 0); break;
+        case 'l': loss = atof(v) / 100.0; break;
+        case 'd': s_delay_us = atoll(v); break;
+        case 'j': s_jitter_us = atoll(v); break;
+        case 'x': s_spike_p = atof(v) / 100.0; break;
+        case 'X': s_spike_us = atoll(v); break;
+        case 'p': ppm = atof(v); break;
+        case 'S': n_play = atoi(v); break;
+        case 'T': play_s = atof(v); break;
+        case 'w': warm_s = atof(v); break;
+        case 'L': if (n_links < 32) links[n_links++] = v; break;
+        case 'P': if (n_drifts < MAX_NODES) drifts[n_drifts++] = v; break;
+        default: usage();
+        }
+    }
+    if (n_perf < 1 || n_perf > RELIABLE_MAX_PEERS || n_play < 1 || n_play > MAX_SONGS || play_s <= 0) usage();
+    s_rng = seed ? seed : 1;
+    s_n_nodes = 1 + n_perf;
+
+    for (int i = 0; i < s_n_nodes; ++i) {
+        for (int k = 0; k < s_n_nodes; ++k) s_loss[i][k] = loss;
+    }
+    for (int i = 0; i < n_links; ++i) {
+        int from, to;
+        double pct;
+        if (sscanf(links[i], "%d:%d:%lf", &from, &to, &pct) != 3 || from < 0 || to < 0
+            || from >= s_n_nodes || to >= s_n_nodes) usage();
+        s_loss[from][to] = pct / 100.0;
+    }
+
+    // Nodes boot with unrelated clocks drifting by up to +-ppm
+    for (int i = 0; i < s_n_nodes; ++i) {
+        sim_node_t *s = &s_nodes[i];
+        s->idx       = i;
+        s->offset_us = 1000000 + (int64_t)(rnd() % 60000000);
+        s->ppm       = (2.0 * urand() - 1.0) * ppm;
+        const uint8_t addr[TRANSPORT_ADDR_LEN] = { 0x02, 'S', 'I', 'M', 0, (uint8_t)i };
+        memcpy(s->addr, addr, sizeof(addr));
+    }
+    for (int i = 0; i < n_drifts; ++i) {
+        int node;
+        double p;
+        if (sscanf(drifts[i], "%d:%lf", &node, &p) != 2 || node < 0 || node >= s_n_nodes) usage();
+        s_nodes[node].ppm = p;
+    }
+    for (int i = 0; i < s_n_nodes; ++i) {
+        sim_node_t *s = &s_nodes[i];
+        s->tp = (transport_t){ .name = "sim", .send = sim_send, .own_addr = sim_own_addr,
+                               .now_us = sim_now_us, .priv = s };
+        host_node_init(&s->node, &s->tp, (uint8_t)i, (uint16_t)rnd(), NULL, on_event, s);
+    }
+
+    printf("orch_sim: seed %llu, %d performers, loss %.1f%%, delay %lld + U(0..%lld) us, "
+           "spikes %.1f%% x exp(%lld us), drift +-%.0f ppm\n",
+           (unsigned long long)seed, n_perf, loss * 100, (long long)s_delay_us, (long long)s_jitter_us,
+           s_spike_p * 100, (long long)s_spike_us, ppm);
+    for (int i = 0; i < s_n_nodes; ++i) printf("  node %d: %+6.1f ppm%s\n", i, s_nodes[i].ppm, i ? "" : " (conductor)");
+
+    // Conductor script on true time: START, STOP after play_s, gap, next
+    host_node_t *cond = &s_nodes[0].node;
+    int64_t script_t = (int64_t)(warm_s * 1e6);
+    int played = 0;
+    bool playing = false;
+    int64_t end_t = script_t + (int64_t)n_play * ((int64_t)(play_s * 1e6) + SONG_GAP_US + ORCH_START_LEAD_US)
+                    + 2000000;
+
+    while (s_now < end_t) {
+        // Next thing to happen: a frame landing, a node's timer or block, the script
+        int64_t next = end_t;
+        if (s_heap_n && s_heap[0].t < next) next = s_heap[0].t;
+        if (played < n_play || playing) {
+            if (script_t < next) next = script_t;
+        }
+        for (int i = 0; i < s_n_nodes; ++i) {
+            int64_t t = true_at(&s_nodes[i], host_node_next_us(&s_nodes[i].node));
+            if (t < next) next = t;
+        }
+        if (next > s_now) s_now = next;
+
+        while (s_heap_n && s_heap[0].t <= s_now) {
+            flight_t f;
+            heap_pop(&f);
+            deliver(&f);
+        }
+        if ((played < n_play || playing) && s_now >= script_t) {
+            if (playing) {
+                host_node_stop(cond);
+                s_songs[s_n_songs - 1].stop_true = s_now;
+                playing = false;
+                played++;
+                script_t = s_now + SONG_GAP_US;
+            } else {
+                song_rec_t *r = &s_songs[s_n_songs++];
+                r->song_id    = (uint8_t)(played % song_count());
+                r->epoch_us   = host_node_start(cond, r->song_id);
+                r->epoch_true = true_at(&s_nodes[0], (int64_t)r->epoch_us);
+                playing = true;
+                script_t = r->epoch_true + (int64_t)(play_s * 1e6);
+            }
+        }
+        for (int i = 0; i < s_n_nodes; ++i) {
+            host_node_poll(&s_nodes[i].node);
+            host_node_render(&s_nodes[i].node, local_at(&s_nodes[i], s_now));
+        }
+    }
+
+    // ----------------------
+    // Report
+    // ----------------------
+    printf("\n%d songs x %.1f s, frames: %llu sent, %llu lost (%.1f%%)\n\n", s_n_songs, play_s,
+           (unsigned long long)s_frames_sent, (unsigned long long)s_frames_lost,
+           s_frames_sent ? 100.0 * (double)s_frames_lost / (double)s_frames_sent : 0.0);
+    printf("song  id  start spread  worst vs epoch  joins  missed  stop prop. avg / max\n");
+    double spread_sum = 0, spread_max = 0, prop_sum = 0, prop_max = 0;
+    int missed_total = 0, n_prop = 0;
+    for (int j = 0; j < s_n_songs; ++j) {
+        song_rec_t *r = &s_songs[j];
+        int64_t lo = INT64_MAX, hi = INT64_MIN, worst = 0;
+        int joins = 0, missed = 0, n_cut = 0;
+        double cut_sum = 0, cut_max = 0;
+        for (int k = 1; k < s_n_nodes; ++k) {
+            if (!r->started[k]) {
+                missed++;
+                continue;
+            }
+            joins += r->joined[k];
+            if (r->start_true[k] < lo) lo = r->start_true[k];
+            if (r->start_true[k] > hi) hi = r->start_true[k];
+            int64_t e = r->start_true[k] - r->epoch_true;
+            if (llabs(e) > llabs(worst)) worst = e;
+            if (r->stop_true && r->cut_true[k]) {
+                double p = (double)(r->cut_true[k] - r->stop_true) / 1000.0;
+                cut_sum += p;
+                if (p > cut_max) cut_max = p;
+                n_cut++;
+            }
+        }
+        double spread = hi >= lo ? (double)(hi - lo) : 0;
+        spread_sum += spread;
+        if (spread > spread_max) spread_max = spread;
+        missed_total += missed;
+        printf("%4d  %2u  %9.0f us  %+11lld us  %5d  %6d", j, (unsigned)r->song_id, spread, (long long)worst,
+               joins, missed);
+        if (n_cut) {
+            printf("  %7.1f / %5.1f ms\n", cut_sum / n_cut, cut_max);
+            prop_sum += cut_sum;
+            n_prop += n_cut;
+            if (cut_max > prop_max) prop_max = cut_max;
+        } else {
+            printf("  (ended before STOP)\n");
+        }
+    }
+    printf("\nstart spread         avg %7.1f  max %7.1f us\n", spread_sum / s_n_songs, spread_max);
+    if (n_prop) printf("stop propagation     avg %7.1f  max %7.1f ms\n", prop_sum / n_prop, prop_max);
+    series_print("clock error", &s_clock_err, "us");
+    series_print("playback error", &s_play_err, "us");
+
+    printf("\nnode  slips  jumps  acked/sent  retries  ack latency avg\n");
+    const reliable_tx_t *rtx = host_node_delivery(cond);
+    for (int k = 1; k < s_n_nodes; ++k) {
+        const reliable_peer_stats_t *p = NULL;
+        for (int i = 0; i < rtx->n_peers; ++i) {
+            if (memcmp(rtx->peers[i].mac, s_nodes[k].addr, TRANSPORT_ADDR_LEN) == 0) p = &rtx->peers[i];
+        }
+        printf("%4d  %5u  %5u  %5u/%-5u  %7u  %9lld us\n", k, (unsigned)s_nodes[k].slips,
+               (unsigned)s_nodes[k].jumps, p ? (unsigned)p->delivered : 0, p ? (unsigned)p->sent : 0,
+               p ? (unsigned)p->retries : 0,
+               p && p->delivered ? (long long)(p->lat_sum_us / p->delivered) : 0LL);
+    }
+    printf("\ntrace hash %016llx\n", (unsigned long long)s_trace);
+    return missed_total ? 1 : 0;
+}
@@ -0,0 +1,212 @@
+// tools/reliable_sim.c — START delivery under packet loss, with and without ACKs
+//
+// Drives src/reliable.c (the same code espnow_comm.c uses) through a small
+// event simulation: one conductor, four performers, every frame in either
+// direction lost independently with probability p, 1-3 ms air + stack delay.
+// For each loss rate it reports how many performers got the START before
+// the 200 ms lead ran out, the added latency (first transmission -> ACK)
+// and transmissions per command, against today's single broadcast. Also
+// checks that no performer ever acts on a duplicate. Unicast retries are
+// modelled with the same loss as broadcasts (ESP-NOW's MAC-level unicast
+// retries would only improve on this). Exits non-zero if delivery at 20%
+// loss falls below 99.9% or a duplicate is acted on.
+//
+// Build & run from the repository root:
+//   cc -O2 -Iinclude tools/reliable_sim.c src/reliable.c -o reliable_sim
+//   ./reliable_sim
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "reliable.h"
+
+#define N_PERF       4
+#define COMMANDS     20000
+#define LEAD_US      200000
+#define MARGIN_US    20000
+#define MAX_EVENTS   256
+
+typedef enum { EV_TO_PERF, EV_TO_COND } ev_kind_t;
+
+typedef struct {
+    int64_t   t;
+    ev_kind_t kind;
+    int       peer;
+    uint16_t  seq;
+} event_t;
+
+static event_t  s_ev[MAX_EVENTS];
+static int      s_n_ev;
+static double   s_loss;
+static uint64_t s_rng = 88172645463325252ull;
+static int64_t  s_now;
+static int      s_tx_count;
+
+static uint32_t rnd(void)
+{
+    // xorshift64
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 7;
+    s_rng ^= s_rng << 17;
+    return (uint32_t)(s_rng >> 32);
+}
+
+static int lost(void)         { return rnd() < (uint32_t)(s_loss * 4294967295.0); }
+static int64_t air_us(void)   { return 1000 + rnd() % 2000; }
+
+static void push(int64_t t, ev_kind_t kind, int peer, uint16_t seq)
+{
+    if (s_n_ev < MAX_EVENTS) s_ev[s_n_ev++] = (event_t){ t, kind, peer, seq };
+}
+
+static int pop_earliest(event_t *out)
+{
+    if (!s_n_ev) return 0;
+    int k = 0;
+    for (int i = 1; i < s_n_ev; ++i) if (s_ev[i].t < s_ev[k].t) k = i;
+    *out = s_ev[k];
+    s_ev[k] = s_ev[--s_n_ev];
+    return 1;
+}
+
+static uint8_t s_macs[N_PERF][6];
+
+static int peer_of(const uint8_t mac[6])
+{
+    for (int i = 0; i < N_PERF; ++i) if (memcmp(s_macs[i], mac, 6) == 0) return i;
+    return -1;
+}
+
+// Conductor -> one performer
+static void sim_send(void *ctx, const uint8_t mac[6], const uint8_t *frame, size_t len)
+{
+    (void)ctx; (void)len;
+    s_tx_count++;
+    uint16_t seq = (uint16_t)(frame[0] | (frame[1] << 8));
+    if (!lost()) push(s_now + air_us(), EV_TO_PERF, peer_of(mac), seq);
+}
+
+typedef struct {
+    long    delivered, expected, dup_acted;
+    long    tx;
+    int64_t lats[COMMANDS * N_PERF];   // first transmission -> first ACK
+    long    n_lat;
+} result_t;
+
+static int cmp_i64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void run(double loss, result_t *r)
+{
+    reliable_tx_t tx;
+    reliable_rx_t rx[N_PERF];
+    reliable_tx_init(&tx);
+    for (int i = 0; i < N_PERF; ++i) reliable_rx_init(&rx[i]);
+    reliable_tx_set_peers(&tx, (const uint8_t (*)[6])s_macs, N_PERF);
+    memset(r, 0, sizeof(*r));
+    s_loss = loss;
+
+    for (int c = 0; c < COMMANDS; ++c) {
+        uint16_t seq = (uint16_t)c;
+        uint8_t frame[2] = { (uint8_t)seq, (uint8_t)(seq >> 8) };
+        int acted[N_PERF] = {0};
+        int acked[N_PERF] = {0};
+        int64_t start = (int64_t)c * 1000000;
+        s_now = start;
+        s_n_ev = 0;
+        s_tx_count = 0;
+
+        // First transmission is a broadcast: one frame, each peer may lose it
+        s_tx_count++;
+        for (int i = 0; i < N_PERF; ++i) {
+            if (!lost()) push(s_now + air_us(), EV_TO_PERF, i, seq);
+        }
+        reliable_tx_submit(&tx, frame, sizeof(frame), 0, seq, s_now, s_now + LEAD_US - MARGIN_US, NULL, NULL);
+        int64_t next = reliable_tx_poll(&tx, s_now, sim_send, NULL, NULL);
+
+        for (;;) {
+            event_t ev;
+            int have = s_n_ev > 0;
+            if (have) {
+                int k = 0;
+                for (int i = 1; i < s_n_ev; ++i) if (s_ev[i].t < s_ev[k].t) k = i;
+                have = s_ev[k].t <= next;
+            }
+            if (have) {
+                pop_earliest(&ev);
+                s_now = ev.t;
+                if (ev.kind == EV_TO_PERF) {
+                    // Performer: ACK every copy, act once, and only if in time
+                    if (!lost()) push(s_now + 200 + air_us(), EV_TO_COND, ev.peer, ev.seq);
+                    if (!reliable_rx_seen(&rx[ev.peer], s_macs[ev.peer], ev.seq) &&
+                        s_now < start + LEAD_US) {
+                        acted[ev.peer]++;
+                    }
+                } else if (reliable_tx_ack(&tx, s_macs[ev.peer], ev.seq, s_now) && !acked[ev.peer]) {
+                    acked[ev.peer] = 1;
+                    r->lats[r->n_lat++] = s_now - start;
+                }
+            } else if (next != INT64_MAX) {
+                s_now = next;
+            } else {
+                break;
+            }
+            next = reliable_tx_poll(&tx, s_now, sim_send, NULL, NULL);
+        }
+
+        for (int i = 0; i < N_PERF; ++i) {
+            r->expected++;
+            if (acted[i]) r->delivered++;
+            if (acted[i] > 1) r->dup_acted++;
+        }
+        r->tx += s_tx_count;
+    }
+    qsort(r->lats, (size_t)r->n_lat, sizeof(r->lats[0]), cmp_i64);
+}
+
+static double lat_avg_ms(const result_t *r)
+{
+    int64_t sum = 0;
+    for (long i = 0; i < r->n_lat; ++i) sum += r->lats[i];
+    return r->n_lat ? (double)sum / (double)r->n_lat / 1000.0 : 0.0;
+}
+
+static double lat_pct_ms(const result_t *r, double pct)
+{
+    if (!r->n_lat) return 0.0;
+    long i = (long)(pct / 100.0 * (double)(r->n_lat - 1));
+    return (double)r->lats[i] / 1000.0;
+}
+
+int main(void)
+{
+    static const double losses[] = { 0.0, 0.05, 0.10, 0.20, 0.30, 0.50 };
+    static result_t r;
+    int fail = 0;
+
+    for (int i = 0; i < N_PERF; ++i) {
+        uint8_t mac[6] = { 0x24, 0x0A, 0xC4, 0x00, 0x00, (uint8_t)(i + 1) };
+        memcpy(s_macs[i], mac, 6);
+    }
+
+    printf("%d START commands x %d performers, %d ms lead\n", COMMANDS, N_PERF, LEAD_US / 1000);
+    printf("%6s %14s %14s %11s %11s %11s %8s %6s\n",
+           "loss", "single bcast", "with ACKs", "ack avg ms", "ack p95 ms", "ack max ms", "tx/cmd", "dups");
+    for (size_t k = 0; k < sizeof(losses) / sizeof(losses[0]); ++k) {
+        run(losses[k], &r);
+        double rate = 100.0 * (double)r.delivered / (double)r.expected;
+        printf("%5.0f%% %13.2f%% %13.3f%% %11.2f %11.2f %11.2f %8.2f %6ld\n",
+               losses[k] * 100.0, (1.0 - losses[k]) * 100.0, rate,
+               lat_avg_ms(&r), lat_pct_ms(&r, 95.0), lat_pct_ms(&r, 100.0),
+               (double)r.tx / COMMANDS, r.dup_acted);
+        if (r.dup_acted) fail = 1;
+        if (losses[k] <= 0.20 && rate < 99.9) fail = 1;
+    }
+    printf("%s\n", fail ? "FAIL" : "OK");
+    return fail;
+}
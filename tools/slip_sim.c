@@ -0,0 +1,177 @@
+// tools/slip_sim.c — inter-device skew with and without sample-slip correction
+//
+// Four performers play the same song from the same conductor epoch. Each
+// one's I2S clock is off nominal by a different amount (-45..+48 ppm, the
+// XTAL tolerance when use_apll = false), and each starts with a random
+// error within the clock-sync bound. The render stage runs ahead of the DAC
+// by the ring plus DMA depth, exactly like src/audio.c, and every 500 ms
+// heartbeat each performer measures its audible position against the
+// conductor timeline (with clock-sync noise) and feeds src/slip.c.
+//
+// Reports the worst-case skew between any two devices over the longest
+// song and over a 10 minute run, with and without correction, plus the
+// slips each device needed. Exits non-zero if the corrected 10 minute run
+// ever exceeds 300 us of skew.
+//
+// Build & run from the repository root:
+//   cc -O2 -Iinclude tools/slip_sim.c src/slip.c src/songs.c src/note_timeline.c src/song_pack.c -o slip_sim
+//   ./slip_sim
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "slip.h"
+#include "songs.h"
+
+#define SAMPLE_RATE    44100
+#define BLOCK          441              // AUDIO_TICK_MS = 10
+#define AHEAD_BLOCKS   5                // PCM_RING_BLOCKS 4 + DMA 8 x 64 samples
+#define HEARTBEAT_US   500000
+#define SYNC_NOISE_US  80               // clock-sync error per reading, +-
+#define ANCHOR_NOISE_US 20              // feeder wake-up jitter, +-
+#define N_DEV          4
+#define STEP_US        1000
+
+static const double k_ppm[N_DEV] = { -45.0, -12.0, 20.0, 48.0 };
+
+typedef struct {
+    double     rate;            // output samples per true second
+    double     t0_us;           // true time of output sample 0
+    slip_ctl_t slip;
+    int64_t   *blk_pos;         // song position at block start
+    int64_t   *blk_cum;         // net slip rendered up to the end of the block
+    int64_t    next_pos;        // song position of the next block to render
+    long       rendered;        // blocks rendered so far
+    long       cap;
+} dev_t_;
+
+static uint64_t s_rng = 0x9E3779B97F4A7C15ull;
+
+static double urand(double a)   // uniform in [-a, a]
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 7;
+    s_rng ^= s_rng << 17;
+    return ((double)(s_rng >> 11) / (double)(1ull << 53) * 2.0 - 1.0) * a;
+}
+
+static double out_index(const dev_t_ *d, double t_us)
+{
+    return (t_us - d->t0_us) * d->rate / 1e6;
+}
+
+// Song position (samples) the DAC is playing at true time t
+static double audible(const dev_t_ *d, double t_us)
+{
+    double o = out_index(d, t_us);
+    if (o < 0) return o;
+    long k = (long)(o / BLOCK);
+    if (k >= d->rendered) k = d->rendered - 1;
+    return (double)d->blk_pos[k] + (o - (double)k * BLOCK);
+}
+
+static void render_until(dev_t_ *d, double t_us, int correct)
+{
+    // Render stays AHEAD_BLOCKS in front of the block being played
+    long need = (long)(out_index(d, t_us) / BLOCK) + AHEAD_BLOCKS + 1;
+    while (d->rendered < need && d->rendered < d->cap) {
+        long k = d->rendered++;
+        int slip = correct ? slip_next(&d->slip) : 0;
+        d->blk_pos[k] = d->next_pos;
+        d->blk_cum[k] = d->slip.cum;
+        d->next_pos  += BLOCK + slip;
+    }
+}
+
+static void measure(dev_t_ *d, double t_us)
+{
+    long k = (long)(out_index(d, t_us) / BLOCK);
+    if (k < 0 || k >= d->rendered) return;
+    double expected = (t_us + urand(SYNC_NOISE_US)) * SAMPLE_RATE / 1e6;
+    double played = audible(d, t_us + urand(ANCHOR_NOISE_US));
+    int32_t err = (int32_t)(played - expected + (played >= expected ? 0.5 : -0.5));
+    int32_t in_flight = (int32_t)(d->slip.cum - d->blk_cum[k]);
+    d->next_pos += slip_measure(&d->slip, err, in_flight);
+}
+
+typedef struct {
+    double   worst_us;
+    uint32_t skipped[N_DEV], repeated[N_DEV], jumps[N_DEV];
+} result_t;
+
+static void run(double dur_us, int correct, result_t *r)
+{
+    dev_t_ dev[N_DEV];
+    long cap = (long)(dur_us / 1e6 * SAMPLE_RATE / BLOCK) + AHEAD_BLOCKS + 16;
+    s_rng = 0x9E3779B97F4A7C15ull;
+    for (int i = 0; i < N_DEV; ++i) {
+        memset(&dev[i], 0, sizeof(dev[i]));
+        dev[i].rate    = SAMPLE_RATE * (1.0 + k_ppm[i] * 1e-6);
+        dev[i].t0_us   = urand(SYNC_NOISE_US);
+        dev[i].cap     = cap;
+        dev[i].blk_pos = calloc((size_t)cap, sizeof(int64_t));
+        dev[i].blk_cum = calloc((size_t)cap, sizeof(int64_t));
+        slip_init(&dev[i].slip);
+    }
+
+    memset(r, 0, sizeof(*r));
+    double next_hb = HEARTBEAT_US;
+    for (double t = 0; t < dur_us; t += STEP_US) {
+        double lo = 1e18, hi = -1e18;
+        for (int i = 0; i < N_DEV; ++i) {
+            render_until(&dev[i], t, correct);
+            double p = audible(&dev[i], t);
+            if (p < lo) lo = p;
+            if (p > hi) hi = p;
+        }
+        if (t > 2 * STEP_US && (hi - lo) * 1e6 / SAMPLE_RATE > r->worst_us) {
+            r->worst_us = (hi - lo) * 1e6 / SAMPLE_RATE;
+        }
+        if (correct && t >= next_hb) {
+            for (int i = 0; i < N_DEV; ++i) measure(&dev[i], t);
+            next_hb += HEARTBEAT_US;
+        }
+    }
+    for (int i = 0; i < N_DEV; ++i) {
+        r->skipped[i]  = dev[i].slip.skipped;
+        r->repeated[i] = dev[i].slip.repeated;
+        r->jumps[i]    = dev[i].slip.jumps;
+        free(dev[i].blk_pos);
+        free(dev[i].blk_cum);
+    }
+}
+
+static void report(const char *what, double dur_us, double *corrected_worst)
+{
+    result_t off, on;
+    run(dur_us, 0, &off);
+    run(dur_us, 1, &on);
+    printf("%-24s %7.1f s   skew: uncorrected %8.0f us   corrected %6.0f us\n",
+           what, dur_us / 1e6, off.worst_us, on.worst_us);
+    for (int i = 0; i < N_DEV; ++i) {
+        printf("    device %d (%+5.1f ppm): %5u skipped, %5u repeated, %u jumps\n",
+               i + 1, k_ppm[i], (unsigned)on.skipped[i], (unsigned)on.repeated[i], (unsigned)on.jumps[i]);
+    }
+    if (corrected_worst) *corrected_worst = on.worst_us;
+}
+
+int main(void)
+{
+    uint32_t longest_ms = 0;
+    for (uint8_t s = 0; s < total_songs; ++s) {
+        uint32_t ms = song_duration_ms(s);
+        if (ms > longest_ms) longest_ms = ms;
+    }
+
+    printf("%d devices, I2S clocks %+.0f..%+.0f ppm, start/sync error +-%d us, heartbeat %d ms\n\n",
+           N_DEV, k_ppm[0], k_ppm[N_DEV - 1], SYNC_NOISE_US, HEARTBEAT_US / 1000);
+    report("longest song", (double)longest_ms * 1000.0, NULL);
+    double worst_long = 0;
+    report("10 minute run", 600e6, &worst_long);
+
+    int fail = worst_long > 300.0;
+    printf("%s\n", fail ? "FAIL: corrected skew above 300 us" : "OK");
+    return fail;
+}
@@ -0,0 +1,208 @@
+// tools/song_pack_bench.c — packed melody size and decode cost vs. note_t arrays
+//
+// Decodes every melody in src/songs.c back to the 4-byte note_t form it used
+// to be stored in and re-encodes it, which must give back the same bytes.
+// Also round-trips random melodies with pitches and durations outside the
+// tables (the escaped forms) and checks song_pack_skip() against decoding.
+//
+// Reports flash per melody and for the whole library (tables included),
+// how many notes repeat their predecessor (what run-length coding could
+// still save), and the cost per note of reading a note_t array vs. the
+// streaming decoder. Exits non-zero on any round-trip mismatch.
+//
+// Build & run from the repository root:
+//   cc -O2 -Iinclude tools/song_pack_bench.c src/song_pack.c src/songs.c src/note_timeline.c -o song_pack_bench
+//   ./song_pack_bench
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "song_pack.h"
+#include "songs.h"
+
+#define MAX_NOTES 1024
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint16_t decode_all(const song_pack_tables_t *t, const uint8_t *packed, uint16_t count,
+                           note_t *out)
+{
+    song_pack_iter_t it;
+    uint16_t n = 0;
+    song_pack_iter_init(&it, t, packed, count);
+    while (n < MAX_NOTES && song_pack_next(&it, &out[n])) n++;
+    return n;
+}
+
+// ----------------------
+// Round trips
+// ----------------------
+static unsigned check_melody(const song_pack_tables_t *t, const uint8_t *packed, uint16_t count,
+                             size_t *bytes, unsigned *repeats)
+{
+    static note_t notes[MAX_NOTES];
+    static uint8_t again[MAX_NOTES * SONG_PACK_MAX_NOTE];
+    uint16_t n = decode_all(t, packed, count, notes);
+    if (n != count) return 1;
+
+    size_t len = song_pack_encode(t, notes, n, again, sizeof(again));
+    *bytes = len;
+    *repeats = 0;
+    for (uint16_t i = 1; i < n; ++i) {
+        if (notes[i].frequency == notes[i - 1].frequency &&
+            notes[i].duration_ms == notes[i - 1].duration_ms) (*repeats)++;
+    }
+    return memcmp(again, packed, len) != 0;
+}
+
+static uint64_t s_rng = 0x2545F4914F6CDD1Dull;
+
+static uint32_t rnd(uint32_t n)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 7;
+    s_rng ^= s_rng << 17;
+    return (uint32_t)(s_rng >> 33) % n;
+}
+
+// Random melodies, about a quarter of the pitches and durations off-table
+static unsigned check_escapes(void)
+{
+    static note_t in[MAX_NOTES], out[MAX_NOTES];
+    static uint8_t buf[MAX_NOTES * SONG_PACK_MAX_NOTE];
+    const song_pack_tables_t *t = &song_tables;
+    unsigned bad = 0;
+
+    for (int round = 0; round < 200; ++round) {
+        uint16_t count = (uint16_t)(1 + rnd(MAX_NOTES));
+        for (uint16_t i = 0; i < count; ++i) {
+            in[i].frequency   = rnd(4) ? t->pitch_hz[rnd(t->n_pitch)] : (uint16_t)rnd(65536);
+            in[i].duration_ms = rnd(4) ? t->dur_ms[rnd(t->n_dur)] : (uint16_t)rnd(65536);
+        }
+        size_t need = song_pack_encode(t, in, count, NULL, 0);
+        if (need > sizeof(buf) || song_pack_encode(t, in, count, buf, sizeof(buf)) != need) {
+            bad++;
+            continue;
+        }
+        if (decode_all(t, buf, count, out) != count || memcmp(in, out, count * sizeof(note_t))) bad++;
+
+        // Skipping to any note must land where decoding would
+        uint16_t k = (uint16_t)rnd(count);
+        song_pack_iter_t it;
+        note_t n;
+        song_pack_iter_init(&it, t, buf, count);
+        song_pack_skip(&it, k);
+        if (!song_pack_next(&it, &n) || memcmp(&n, &in[k], sizeof(n))) bad++;
+    }
+    return bad;
+}
+
+// ----------------------
+// Decode cost
+// ----------------------
+static volatile uint32_t s_sink;
+
+static void bench_decode(void)
+{
+    static note_t arrays[32][MAX_NOTES];
+    const uint8_t *packed[32];
+    uint16_t counts[32];
+    int n_mel = 0;
+    size_t notes_total = 0;
+
+    for (uint8_t s = 0; s < total_songs; ++s) {
+        const song_t *song = &songs[s];
+        for (int p = -1; p < 5 && n_mel < 32; ++p) {
+            const uint8_t *m = p < 0 ? song->notes : song->parts[p].notes;
+            uint16_t c = p < 0 ? song->note_count : song->parts[p].note_count;
+            if (!m || !c) continue;
+            packed[n_mel] = m;
+            counts[n_mel] = decode_all(song->tables, m, c, arrays[n_mel]);
+            notes_total += counts[n_mel];
+            n_mel++;
+        }
+    }
+
+    enum { REPS = 20000 };
+    uint32_t sum = 0;
+    double t0 = now_s();
+    for (int r = 0; r < REPS; ++r) {
+        for (int m = 0; m < n_mel; ++m) {
+            const note_t *a = arrays[m];
+            for (uint16_t i = 0; i < counts[m]; ++i) sum += a[i].frequency + a[i].duration_ms;
+        }
+        s_sink = sum;
+    }
+    double t1 = now_s();
+    for (int r = 0; r < REPS; ++r) {
+        for (int m = 0; m < n_mel; ++m) {
+            song_pack_iter_t it;
+            note_t n;
+            song_pack_iter_init(&it, &song_tables, packed[m], counts[m]);
+            while (song_pack_next(&it, &n)) sum += n.frequency + n.duration_ms;
+        }
+        s_sink = sum;
+    }
+    double t2 = now_s();
+
+    double per = 1e9 / ((double)notes_total * REPS);
+    printf("Per note: note_t array %.2f ns, packed decoder %.2f ns (%.2f ns more, once per note, not per sample)\n",
+           (t1 - t0) * per, (t2 - t1) * per, (t2 - t1 - (t1 - t0)) * per);
+}
+
+int main(void)
+{
+    unsigned bad = 0;
+    size_t raw_total = 0, packed_total = 0, notes_total = 0;
+    unsigned rep_total = 0;
+
+    printf("%-20s %-5s %5s %9s %8s %7s\n", "song", "part", "notes", "note_t B", "packed B", "repeats");
+    for (uint8_t s = 0; s < total_songs; ++s) {
+        const song_t *song = &songs[s];
+        for (int p = -1; p < 5; ++p) {
+            const uint8_t *m = p < 0 ? song->notes : song->parts[p].notes;
+            uint16_t c = p < 0 ? song->note_count : song->parts[p].note_count;
+            if (!m || !c) continue;
+            size_t bytes = 0;
+            unsigned rep = 0;
+            unsigned b = check_melody(song->tables, m, c, &bytes, &rep);
+            char part[8];
+            if (p < 0) snprintf(part, sizeof(part), "lead");
+            else snprintf(part, sizeof(part), "p%d", p);
+            printf("%-20s %-5s %5u %9zu %8zu %7u%s\n", song->name, part, (unsigned)c,
+                   (size_t)c * sizeof(note_t), bytes, rep, b ? "  MISMATCH" : "");
+            bad += b;
+            raw_total += (size_t)c * sizeof(note_t);
+            packed_total += bytes;
+            notes_total += c;
+            rep_total += rep;
+        }
+    }
+
+    size_t tables = (size_t)(song_tables.n_pitch + song_tables.n_dur) * sizeof(uint16_t);
+    printf("\nLibrary: %zu notes, note_t %zu B, packed %zu B + %zu B tables = %.2f B/note (%.1fx smaller)\n",
+           notes_total, raw_total, packed_total, tables,
+           (double)(packed_total + tables) / (double)notes_total,
+           (double)raw_total / (double)(packed_total + tables));
+    printf("Repeated notes: %u of %zu (%.1f%%), the most run-length coding could save\n",
+           rep_total, notes_total, 100.0 * rep_total / (double)notes_total);
+    printf("Per 64 KB of flash: %u notes as note_t, about %u packed\n",
+           (unsigned)(65536 / sizeof(note_t)),
+           (unsigned)(65536.0 * (double)notes_total / (double)packed_total));
+
+    unsigned esc_bad = check_escapes();
+    printf("Escaped pitches/durations round trip: %s\n", esc_bad ? "MISMATCH" : "ok");
+    bad += esc_bad;
+
+    bench_decode();
+
+    printf("%s\n", bad ? "FAIL: packed melodies do not round-trip" : "OK");
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,363 @@
+// tools/songlib.c — build and verify song library partition images
+//
+// Builds the image for the "songs" data partition (include/song_lib.h)
+// from the built-in songs in src/songs.c and/or binary song records written
+// by tools/midi2song.c -b. Song ids follow the order on the command line,
+// the built-in songs first. Every melody is re-packed against the built-in
+// pitch/duration tables; melodies shared by several slots are stored once.
+//
+// Verifying opens the image with the firmware's own song_lib_open() (CRC,
+// offsets, every melody inside the image), decodes every melody and lists
+// the songs. A freshly built image is verified the same way before it is
+// written, and built-in songs are checked note for note against songs.c.
+//
+// Build & run from the repository root:
+//   cc -O2 -Iinclude tools/songlib.c src/song_lib.c src/song_pack.c src/songs.c src/note_timeline.c -o songlib
+//   ./songlib -o songs.bin [-B] [-s 0x30000] [extra.song ...]   build (-B: no built-in songs)
+//   ./songlib -c songs.bin                                      verify and list
+//
+// Flash it to the partition (offset from partitions.csv):
+//   parttool.py write_partition --partition-name songs --input songs.bin
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "song_lib.h"
+#include "songs.h"
+
+#define SLOTS         6           // lead, parts[0..4]
+#define DEFAULT_SIZE  0x30000     // "songs" in partitions.csv
+
+typedef struct {
+    const uint8_t *bytes;         // packed against t, NULL = empty slot
+    uint16_t       count;
+    uint8_t        envelope;
+} src_mel_t;
+
+typedef struct {
+    char               name[SONG_LIB_NAME_LEN];
+    uint8_t            type, parts_mask, envelope;
+    song_pack_tables_t t;
+    src_mel_t          mel[SLOTS];
+} src_song_t;
+
+static void die(const char *msg, const char *what)
+{
+    fprintf(stderr, "songlib: %s%s%s\n", msg, what ? ": " : "", what ? what : "");
+    exit(1);
+}
+
+static uint8_t *read_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) die("cannot open", path);
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = malloc(n > 0 ? (size_t)n : 1);
+    if (!buf || fread(buf, 1, (size_t)n, f) != (size_t)n) die("cannot read", path);
+    fclose(f);
+    *len = (size_t)n;
+    return buf;
+}
+
+// ----------------------
+// Sources
+// ----------------------
+static void from_builtin(const song_t *s, src_song_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    snprintf(out->name, sizeof(out->name), "%s", s->name);
+    out->type       = (uint8_t)s->type;
+    out->parts_mask = s->parts_mask;
+    out->envelope   = s->envelope;
+    out->t          = *s->tables;
+    out->mel[0] = (src_mel_t){ s->notes, s->note_count, 0 };
+    for (int p = 0; p < 5; ++p) {
+        out->mel[1 + p] = (src_mel_t){ s->parts[p].notes, s->parts[p].note_count, s->parts[p].envelope };
+    }
+}
+
+static uint16_t rd16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+// Song record from midi2song -b (layout in tools/midi2song.c)
+static void from_record(const char *path, src_song_t *out)
+{
+    size_t len;
+    uint8_t *b = read_file(path, &len);
+    if (len < 34 || memcmp(b, "OSNG", 4) || b[4] != 1) die("not a song record", path);
+
+    memset(out, 0, sizeof(*out));
+    memcpy(out->name, b + 8, SONG_LIB_NAME_LEN - 1);
+    out->type       = b[5];
+    out->parts_mask = b[6];
+    out->envelope   = b[7];
+
+    uint8_t np = b[32], nd = b[33];
+    size_t pos = 34;
+    if (np > SONG_PACK_MAX_PITCHES || nd > SONG_PACK_MAX_DURS ||
+        pos + 2u * (np + nd) + SLOTS * 6u > len) die("truncated song record", path);
+    uint16_t *tab = malloc(2u * (np + nd) + 2);
+    for (int i = 0; i < np + nd; ++i, pos += 2) tab[i] = rd16(b + pos);
+    out->t = (song_pack_tables_t){ tab, tab + np, np, nd };
+
+    uint16_t bytes[SLOTS];
+    uint8_t  alias[SLOTS];
+    for (int s = 0; s < SLOTS; ++s, pos += 6) {
+        out->mel[s].count    = rd16(b + pos);
+        bytes[s]             = rd16(b + pos + 2);
+        out->mel[s].envelope = b[pos + 4];
+        alias[s]             = b[pos + 5];
+    }
+    for (int s = 0; s < SLOTS; ++s) {
+        if (alias[s] != 0xFF || !bytes[s]) continue;
+        if (pos + bytes[s] > len) die("truncated song record", path);
+        out->mel[s].bytes = b + pos;
+        pos += bytes[s];
+    }
+    for (int s = 0; s < SLOTS; ++s) {
+        if (alias[s] < SLOTS && alias[s] != s) out->mel[s].bytes = out->mel[alias[s]].bytes;
+    }
+}
+
+// ----------------------
+// Build
+// ----------------------
+typedef struct {
+    uint8_t *buf;
+    size_t   len, cap;
+} out_t;
+
+static size_t put(out_t *o, const void *p, size_t n)
+{
+    while (o->len + n > o->cap) {
+        o->cap = o->cap ? o->cap * 2 : 4096;
+        o->buf = realloc(o->buf, o->cap);
+        if (!o->buf) die("out of memory", NULL);
+    }
+    size_t at = o->len;
+    if (p) memcpy(o->buf + at, p, n);
+    else memset(o->buf + at, 0, n);
+    o->len += n;
+    return at;
+}
+
+static void align4(out_t *o)
+{
+    while (o->len & 3u) put(o, NULL, 1);
+}
+
+// Re-pack one source melody against the library tables; returns its offset
+static uint32_t put_melody(out_t *o, const song_pack_tables_t *lib_t, const src_song_t *s, int slot)
+{
+    const src_mel_t *m = &s->mel[slot];
+    if (!m->bytes || !m->count) return 0;
+
+    // Shared with an earlier slot of the same song: same bytes
+    static const uint8_t *seen_src[SLOTS];
+    static uint32_t seen_off[SLOTS];
+    if (slot == 0) memset(seen_src, 0, sizeof(seen_src));
+    for (int k = 0; k < slot; ++k) {
+        if (seen_src[k] == m->bytes) return seen_off[k];
+    }
+
+    note_t *notes = malloc((size_t)m->count * sizeof(*notes));
+    song_pack_iter_t it;
+    song_pack_iter_init(&it, &s->t, m->bytes, m->count);
+    for (uint16_t i = 0; i < m->count; ++i) song_pack_next(&it, &notes[i]);
+    size_t n = song_pack_encode(lib_t, notes, m->count, NULL, 0);
+    size_t at = put(o, NULL, n);
+    song_pack_encode(lib_t, notes, m->count, o->buf + at, n);
+    free(notes);
+
+    seen_src[slot] = m->bytes;
+    seen_off[slot] = (uint32_t)at;
+    return (uint32_t)at;
+}
+
+static out_t build(const src_song_t *songs_in, int n)
+{
+    const song_pack_tables_t *t = &song_tables;
+    out_t o = { 0 };
+    song_lib_hdr_t h = { .magic = SONG_LIB_MAGIC, .version = SONG_LIB_VERSION,
+                         .song_count = (uint16_t)n, .n_pitch = t->n_pitch, .n_dur = t->n_dur };
+    put(&o, NULL, sizeof(h));
+
+    h.tables_off = (uint32_t)put(&o, t->pitch_hz, 2u * t->n_pitch);
+    put(&o, t->dur_ms, 2u * t->n_dur);
+    align4(&o);
+    h.index_off = (uint32_t)put(&o, NULL, 4u * n);
+    size_t rec0 = put(&o, NULL, sizeof(song_lib_rec_t) * n);
+
+    for (int i = 0; i < n; ++i) {
+        const src_song_t *s = &songs_in[i];
+        song_lib_rec_t r;
+        memset(&r, 0, sizeof(r));
+        memcpy(r.name, s->name, sizeof(r.name) - 1);
+        r.type       = s->type;
+        r.parts_mask = s->parts_mask;
+        r.envelope   = s->envelope;
+        for (int slot = 0; slot < SLOTS; ++slot) {
+            song_lib_mel_t *m = slot ? &r.parts[slot - 1] : &r.lead;
+            m->off      = put_melody(&o, t, s, slot);
+            m->count    = m->off ? s->mel[slot].count : 0;
+            m->envelope = s->mel[slot].envelope;
+        }
+        uint32_t rec_off = (uint32_t)(rec0 + i * sizeof(r));
+        memcpy(o.buf + rec_off, &r, sizeof(r));
+        memcpy(o.buf + h.index_off + 4u * i, &rec_off, 4);
+    }
+    align4(&o);
+
+    h.total_len = (uint32_t)o.len;
+    h.crc32 = song_lib_crc32(0, o.buf + sizeof(h), o.len - sizeof(h));
+    memcpy(o.buf, &h, sizeof(h));
+    return o;
+}
+
+// ----------------------
+// Verify
+// ----------------------
+static uint32_t melody_ms(const song_pack_tables_t *t, const uint8_t *notes, uint16_t count,
+                          uint16_t *decoded)
+{
+    song_pack_iter_t it;
+    note_t n;
+    uint32_t ms = 0;
+    *decoded = 0;
+    song_pack_iter_init(&it, t, notes, count);
+    while (song_pack_next(&it, &n)) {
+        ms += n.duration_ms;
+        (*decoded)++;
+    }
+    return ms;
+}
+
+static int same_melody(const song_pack_tables_t *ta, const uint8_t *a,
+                       const song_pack_tables_t *tb, const uint8_t *b, uint16_t count)
+{
+    song_pack_iter_t ia, ib;
+    note_t na, nb;
+    song_pack_iter_init(&ia, ta, a, count);
+    song_pack_iter_init(&ib, tb, b, count);
+    while (song_pack_next(&ia, &na)) {
+        if (!song_pack_next(&ib, &nb) || na.frequency != nb.frequency ||
+            na.duration_ms != nb.duration_ms) return 0;
+    }
+    return 1;
+}
+
+static const char *const k_types[] = { "solo", "duet", "quintet" };
+
+// n_builtin: how many leading songs must match songs.c
+static int verify(const uint8_t *img, size_t len, int n_builtin)
+{
+    song_lib_t lib;
+    song_lib_err_t err = song_lib_open(&lib, img, len);
+    if (err != SONG_LIB_OK) {
+        fprintf(stderr, "songlib: image rejected: %s\n", song_lib_err_str(err));
+        return 1;
+    }
+
+    int bad = 0;
+    printf("%u songs, %u bytes, crc32 %08X, tables %u pitches / %u durations\n",
+           (unsigned)song_lib_count(&lib), (unsigned)lib.hdr->total_len, (unsigned)lib.hdr->crc32,
+           (unsigned)lib.tables.n_pitch, (unsigned)lib.tables.n_dur);
+    printf("%3s %-24s %-8s %5s %6s %9s\n", "id", "name", "type", "parts", "notes", "length");
+    for (uint16_t i = 0; i < song_lib_count(&lib); ++i) {
+        song_t s;
+        song_lib_song(&lib, i, &s);
+        uint32_t longest = 0, notes = 0;
+        const uint8_t *mel[SLOTS] = { s.notes };
+        uint16_t cnt[SLOTS] = { s.note_count };
+        for (int p = 0; p < 5; ++p) {
+            mel[1 + p] = s.parts[p].notes;
+            cnt[1 + p] = s.parts[p].note_count;
+        }
+        for (int k = 0; k < SLOTS; ++k) {
+            if (!mel[k]) continue;
+            uint16_t decoded;
+            uint32_t ms = melody_ms(s.tables, mel[k], cnt[k], &decoded);
+            if (decoded != cnt[k]) bad++;
+            if (ms > longest) longest = ms;
+            notes += cnt[k];
+        }
+        if (i < n_builtin) {
+            const song_t *ref = &songs[i];
+            const uint8_t *rmel[SLOTS] = { ref->notes };
+            uint16_t rcnt[SLOTS] = { ref->note_count };
+            for (int p = 0; p < 5; ++p) {
+                rmel[1 + p] = ref->parts[p].notes;
+                rcnt[1 + p] = ref->parts[p].note_count;
+            }
+            for (int k = 0; k < SLOTS; ++k) {
+                if (cnt[k] != rcnt[k] ||
+                    (cnt[k] && !same_melody(s.tables, mel[k], ref->tables, rmel[k], cnt[k]))) bad++;
+            }
+            if (strcmp(s.name, ref->name)) bad++;
+        }
+        printf("%3u %-24s %-8s  0x%02X %6u %7.1f s\n", (unsigned)i, s.name,
+               s.type <= SONG_TYPE_QUINTET ? k_types[s.type] : "?", (unsigned)s.parts_mask,
+               (unsigned)notes, longest / 1000.0);
+    }
+    printf("%s\n", bad ? "FAIL: melodies do not decode as built" : "OK");
+    return bad ? 1 : 0;
+}
+
+// ----------------------
+// Main
+// ----------------------
+static void usage(void)
+{
+    fprintf(stderr, "usage: songlib -o songs.bin [-B] [-s size] [extra.song ...]\n"
+                    "       songlib -c songs.bin\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    const char *out_path = NULL, *check_path = NULL;
+    int builtin = 1;
+    size_t size = DEFAULT_SIZE;
+    const char *records[SONG_LIB_MAX_SONGS];
+    int n_rec = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-o") && i + 1 < argc) out_path = argv[++i];
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc) check_path = argv[++i];
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc) size = strtoul(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "-B")) builtin = 0;
+        else if (argv[i][0] != '-' && n_rec < SONG_LIB_MAX_SONGS) records[n_rec++] = argv[i];
+        else usage();
+    }
+
+    if (check_path) {
+        size_t len;
+        uint8_t *img = read_file(check_path, &len);
+        int rc = verify(img, len, 0);
+        free(img);
+        return rc;
+    }
+    if (!out_path) usage();
+
+    int n_builtin = builtin ? total_songs : 0;
+    int n = n_builtin + n_rec;
+    if (n == 0 || n > SONG_LIB_MAX_SONGS) die("need 1..255 songs", NULL);
+    src_song_t *src = calloc((size_t)n, sizeof(*src));
+    for (int i = 0; i < n_builtin; ++i) from_builtin(&songs[i], &src[i]);
+    for (int i = 0; i < n_rec; ++i) from_record(records[i], &src[n_builtin + i]);
+
+    out_t img = build(src, n);
+    if (img.len > size) {
+        fprintf(stderr, "songlib: image is %zu bytes, partition holds %zu\n", img.len, size);
+        return 1;
+    }
+    if (verify(img.buf, img.len, n_builtin)) return 1;
+
+    FILE *f = fopen(out_path, "wb");
+    if (!f || fwrite(img.buf, 1, img.len, f) != img.len || fclose(f)) die("cannot write", out_path);
+    printf("wrote %s: %zu of %zu bytes\n", out_path, img.len, size);
+    return 0;
+}
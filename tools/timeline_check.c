@@ -0,0 +1,212 @@
+// tools/timeline_check.c — verify note boundaries are sample-exact
+//
+// Drives the note sequencer (src/note_timeline.c) over every song in
+// src/songs.c with the same block loop the audio engine uses, for several
+// AUDIO_TICK_MS block sizes, and checks that note N always starts at
+// floor(cum_ms(N) * 44100 / 1000) — i.e. the cumulative timing error is zero
+// regardless of block size. The old ms->tick rounding drift is shown for
+// comparison. Also checks that the binary-search seek over the cumulative
+// index (songs_index_init) lands in exactly the same sequencer state as the
+// linear walk, and times both. Exits non-zero on any mismatch.
+//
+// Build & run from the repository root:
+//   cc -O2 -Iinclude tools/timeline_check.c src/note_timeline.c src/songs.c src/song_pack.c -o timeline_check
+//   ./timeline_check
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "note_timeline.h"
+#include "songs.h"
+
+#define SAMPLE_RATE 44100
+#define MAX_NOTES   1024
+
+// A melody as packed in songs.c plus its notes decoded for the reference sums
+typedef struct {
+    const song_pack_tables_t *t;
+    const uint8_t *packed;
+    uint16_t       count;
+    note_t         notes[MAX_NOTES];
+} melody_t;
+
+static const uint32_t tick_ms_options[] = { 1, 2, 5, 10, 20, 40 };
+
+// Legacy scheme: each note rounded to whole ticks (min 1 for sounding notes)
+static int64_t legacy_drift_samples(const note_t *notes, uint16_t count, uint32_t tick_ms)
+{
+    uint64_t ms = 0, ticks = 0;
+    for (uint16_t i = 0; i < count; ++i) {
+        uint32_t t = (notes[i].duration_ms + tick_ms / 2) / tick_ms;
+        if (notes[i].frequency != 0 && t == 0) t = 1;
+        ticks += t;
+        ms += notes[i].duration_ms;
+    }
+    uint64_t spt = (uint64_t)SAMPLE_RATE * tick_ms / 1000;
+    return (int64_t)(ticks * spt) - (int64_t)note_timeline_ms_to_sample(ms, SAMPLE_RATE);
+}
+
+// Same block walk as cursor_render_tick() in src/audio.c; returns the number
+// of notes whose start sample differs from the exact timeline.
+static unsigned check_blocks(const melody_t *m, uint32_t block)
+{
+    const note_t *notes = m->notes;
+    uint16_t count = m->count;
+    note_seq_t seq;
+    note_seq_start(&seq, m->t, m->packed, count, SAMPLE_RATE);
+
+    unsigned errors = 0;
+    uint64_t cum_ms = 0;
+    uint16_t expect_idx = 0;
+
+    // Expected start of the current note
+    #define CHECK_START()                                                       \
+        do {                                                                    \
+            while (expect_idx < seq.index) cum_ms += notes[expect_idx++].duration_ms; \
+            uint64_t want = note_timeline_ms_to_sample(cum_ms, SAMPLE_RATE);    \
+            if (seq.pos != want) errors++;                                      \
+        } while (0)
+
+    if (!note_seq_done(&seq)) CHECK_START();
+    while (!note_seq_done(&seq)) {
+        uint32_t filled = 0;
+        while (filled < block && !note_seq_done(&seq)) {
+            uint32_t n = note_seq_run(&seq);
+            if (n > block - filled) n = block - filled;
+            filled += n;
+            if (note_seq_advance(&seq, n)) CHECK_START();
+        }
+    }
+    #undef CHECK_START
+
+    // The melody must also end exactly on the last boundary
+    uint64_t total_ms = 0;
+    for (uint16_t i = 0; i < count; ++i) total_ms += notes[i].duration_ms;
+    if (seq.pos != note_timeline_ms_to_sample(total_ms, SAMPLE_RATE)) errors++;
+    return errors;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static double   s_seek_linear_s, s_seek_index_s;
+static unsigned s_seeks;
+
+static int same_state(const note_seq_t *a, const note_seq_t *b)
+{
+    const note_t *na = note_seq_note(a), *nb = note_seq_note(b);
+    return a->index == b->index && a->pos == b->pos && a->note_start == b->note_start &&
+           a->clk.end == b->clk.end && a->clk.rem == b->clk.rem &&
+           (na == NULL) == (nb == NULL) &&
+           (!na || (na->frequency == nb->frequency && na->duration_ms == nb->duration_ms));
+}
+
+// Indexed vs linear seek to every boundary (and its neighbours) plus a
+// sweep through the melody, past the end included
+static unsigned check_seek(const melody_t *m, const uint32_t *cum)
+{
+    if (!cum) return 1;
+    uint16_t count = m->count;
+    note_seq_t lin, idx;
+    note_seq_start(&lin, m->t, m->packed, count, SAMPLE_RATE);
+    note_seq_start(&idx, m->t, m->packed, count, SAMPLE_RATE);
+    note_seq_set_index(&idx, cum);
+
+    unsigned errors = 0;
+    uint64_t end = note_timeline_ms_to_sample(cum[count], SAMPLE_RATE);
+    #define SEEK_BOTH(at)                                                       \
+        do {                                                                    \
+            uint64_t at_ = (at);                                                \
+            if (note_seq_seek(&lin, at_) != note_seq_seek(&idx, at_) ||         \
+                !same_state(&lin, &idx)) errors++;                              \
+        } while (0)
+    for (uint16_t i = 0; i <= count; ++i) {
+        uint64_t b = note_timeline_ms_to_sample(cum[i], SAMPLE_RATE);
+        if (b) SEEK_BOTH(b - 1);
+        SEEK_BOTH(b);
+        SEEK_BOTH(b + 1);
+    }
+    for (uint64_t at = 0; at < end + 2000; at += 997) SEEK_BOTH(at);
+    #undef SEEK_BOTH
+
+    // Cost of one seek to a pseudo-random position
+    enum { REPS = 2000 };
+    uint64_t x = 12345, sink = 0;
+    double t0 = now_s();
+    for (int r = 0; r < REPS; ++r) {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        sink += note_seq_seek(&lin, (x >> 20) % (end + 1)) + lin.index;
+    }
+    double t1 = now_s();
+    for (int r = 0; r < REPS; ++r) {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        sink += note_seq_seek(&idx, (x >> 20) % (end + 1)) + idx.index;
+    }
+    double t2 = now_s();
+    s_seek_linear_s += t1 - t0;
+    s_seek_index_s  += t2 - t1;
+    s_seeks += REPS;
+    if (sink == 1) printf(" ");   // keep the loops
+    return errors;
+}
+
+static unsigned check_melody(const char *song, const char *part, const song_pack_tables_t *t,
+                             const uint8_t *packed, uint16_t count, const uint32_t *cum)
+{
+    static melody_t m;
+    song_pack_iter_t it;
+    if (count > MAX_NOTES) return 1;
+    m.t = t;
+    m.packed = packed;
+    m.count = count;
+    song_pack_iter_init(&it, t, packed, count);
+    for (uint16_t i = 0; i < count; ++i) song_pack_next(&it, &m.notes[i]);
+
+    unsigned bad = 0;
+    printf("  %-20s %-5s %3u notes  legacy drift:", song, part, (unsigned)count);
+    for (size_t k = 0; k < sizeof(tick_ms_options) / sizeof(tick_ms_options[0]); ++k) {
+        int64_t d = legacy_drift_samples(m.notes, count, tick_ms_options[k]);
+        printf(" %+6.1fms", (double)d * 1000.0 / SAMPLE_RATE);
+        bad += check_blocks(&m, SAMPLE_RATE * tick_ms_options[k] / 1000);
+    }
+    printf("  | new error: %s", bad ? "MISMATCH" : "0");
+    unsigned seek_bad = check_seek(&m, cum);
+    printf("  | seek: %s\n", seek_bad ? "MISMATCH" : "ok");
+    return bad + seek_bad;
+}
+
+int main(void)
+{
+    unsigned bad = 0;
+    printf("Tick sizes (ms):");
+    for (size_t k = 0; k < sizeof(tick_ms_options) / sizeof(tick_ms_options[0]); ++k) {
+        printf(" %u", (unsigned)tick_ms_options[k]);
+    }
+    printf("\n");
+
+    songs_index_init();
+    for (uint8_t s = 0; s < total_songs; ++s) {
+        const song_t *song = &songs[s];
+        bad += check_melody(song->name, "lead", song->tables, song->notes, song->note_count,
+                            song_melody_index(s, song->notes));
+        for (int p = 0; p < 5; ++p) {
+            if (song->parts[p].notes && song->parts[p].note_count) {
+                char name[8];
+                snprintf(name, sizeof(name), "p%d", p);
+                bad += check_melody(song->name, name, song->tables, song->parts[p].notes,
+                                    song->parts[p].note_count,
+                                    song_melody_index(s, song->parts[p].notes));
+            }
+        }
+    }
+
+    printf("Seek: linear walk %.0f ns, indexed %.0f ns per seek (%u seeks)\n",
+           s_seek_linear_s * 1e9 / s_seeks, s_seek_index_s * 1e9 / s_seeks, s_seeks);
+    printf("%s\n", bad ? "FAIL: note boundaries drifted" : "OK: cumulative timing error is zero for every song and tick size");
+    return bad ? 1 : 0;
+}
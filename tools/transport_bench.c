@@ -0,0 +1,240 @@
+// tools/transport_bench.c — N nodes as Linux processes on the UDP transport
+//
+// Runs src/transport_udp.c (the transport.h backend the firmware's control
+// code can sit on off-device) with one conductor and N performer processes
+// on loopback multicast. The conductor sends wire_proto HEARTBEAT frames
+// with WIRE_F_ACK_REQ, alternating a broadcast to all and a unicast to one
+// performer in turn; performers ACK by unicast. Reports, per performer,
+// ACKs received, round-trip time (avg, p99, max) and frames that reached a
+// node they were not addressed to, plus the conductor's send rate. Exits
+// non-zero if a frame is misdelivered or fewer than 99% are acknowledged.
+//
+// Build & run from the repository root:
+//   cc -O2 -Iinclude tools/transport_bench.c src/transport_udp.c src/transport.c src/wire_proto.c -o transport_bench
+//   ./transport_bench [performers (4)] [rounds (2000)] [interface address]
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "transport.h"
+#include "wire_proto.h"
+#include "orchestra.h"   // msg_type_t
+
+#define MAX_PERF      32
+#define GAP_US        2000      // between conductor sends
+#define DRAIN_US      200000    // wait for late ACKs after the last round
+#define STOP_SONG     0xFF      // SYNC_STOP with this song id ends a performer
+#define IDLE_EXIT_MS  2000      // ... as does this long without frames (a lost STOP)
+
+typedef struct {
+    uint32_t acked;
+    uint32_t expected;
+    uint32_t stray;             // ACKs for frames not addressed to this node
+    int64_t *rtt;               // per acked frame, for the percentile
+    int64_t  rtt_sum, rtt_max;
+} perf_stats_t;
+
+static uint16_t     s_port;
+static const char  *s_iface;
+static int          s_n_perf;
+static int          s_rounds;
+
+// Conductor bookkeeping: per round, when it was sent and to whom (0 = all)
+static int64_t     *s_sent_us;
+static uint8_t     *s_sent_to;
+static perf_stats_t s_perf[MAX_PERF + 1];
+static uint8_t      s_joined[MAX_PERF + 1];
+
+static int cmp_i64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void addr_of(uint16_t node, uint8_t *addr)
+{
+    const uint8_t a[TRANSPORT_ADDR_LEN] = { 0x02, 'O', 'R', 'C', (uint8_t)(node >> 8), (uint8_t)node };
+    memcpy(addr, a, sizeof(a));
+}
+
+static void send_ctrl(transport_t *t, const uint8_t *dst, uint8_t type, uint8_t flags, uint16_t seq, uint8_t song)
+{
+    uint8_t buf[WIRE_MAX_FRAME];
+    wire_writer_t w;
+    wire_begin(&w, buf, sizeof(buf), type, flags, 0, seq);
+    wire_ctrl_t c = { .song_id = song, .timestamp = (uint64_t)transport_now_us(t) };
+    wire_put_ctrl(&w, &c);
+    transport_send(t, dst, buf, wire_finish(&w));
+}
+
+// ----------------------
+// Performer process
+// ----------------------
+static int s_done;
+static uint8_t s_self;
+
+static void perf_rx(void *ctx, const uint8_t *src, const uint8_t *frame, size_t len, int64_t rx_us)
+{
+    transport_t *t = ctx;
+    (void)rx_us;
+    wire_frame_t f;
+    if (wire_parse(frame, len, &f) != WIRE_OK) return;
+    if (f.type == MSG_SYNC_STOP) {
+        wire_ctrl_t c;
+        if (wire_get_ctrl(&f, &c) && c.song_id == STOP_SONG) s_done = 1;
+        return;
+    }
+    if (f.type != MSG_HEARTBEAT || !(f.flags & WIRE_F_ACK_REQ)) return;
+
+    uint8_t buf[WIRE_MAX_FRAME];
+    wire_writer_t w;
+    wire_begin(&w, buf, sizeof(buf), MSG_ACK, WIRE_F_NONE, s_self, 0);
+    wire_put_ack(&w, &(wire_ack_t){ .seq = f.seq, .type = f.type });
+    transport_send(t, src, buf, wire_finish(&w));
+}
+
+static int run_performer(int node)
+{
+    transport_t *t = transport_udp_open((uint16_t)node, TRANSPORT_UDP_GROUP, s_port, s_iface);
+    if (!t) {
+        perror("performer: transport_udp_open");
+        return 1;
+    }
+    s_self = (uint8_t)node;
+    transport_set_rx(t, perf_rx, t);
+    int idle_ms = 0;
+    while (!s_done && idle_ms < IDLE_EXIT_MS) idle_ms = transport_poll(t, 100) ? 0 : idle_ms + 100;
+    transport_udp_close(t);
+    return 0;
+}
+
+// ----------------------
+// Conductor
+// ----------------------
+static void cond_rx(void *ctx, const uint8_t *src, const uint8_t *frame, size_t len, int64_t rx_us)
+{
+    (void)ctx;
+    (void)src;
+    wire_frame_t f;
+    wire_ack_t a;
+    if (wire_parse(frame, len, &f) != WIRE_OK || f.type != MSG_ACK || !wire_get_ack(&f, &a)) return;
+    int p = f.sender;
+    if (p < 1 || p > s_n_perf) return;
+
+    s_joined[p] = 1;
+    if (a.seq == 0 || a.seq > s_rounds) return;   // join pings
+    int r = a.seq - 1;
+    perf_stats_t *st = &s_perf[p];
+    if (s_sent_to[r] && s_sent_to[r] != p) {
+        st->stray++;
+        return;
+    }
+    int64_t rtt = rx_us - s_sent_us[r];
+    st->rtt[st->acked++] = rtt;
+    st->rtt_sum += rtt;
+    if (rtt > st->rtt_max) st->rtt_max = rtt;
+}
+
+static void pump(transport_t *t, int64_t until_us)
+{
+    while (transport_now_us(t) < until_us) {
+        int64_t left = until_us - transport_now_us(t);
+        transport_poll(t, (int)(left / 1000));
+        if (left < 1000) transport_poll(t, 0);
+    }
+}
+
+static int run_conductor(void)
+{
+    transport_t *t = transport_udp_open(0, TRANSPORT_UDP_GROUP, s_port, s_iface);
+    if (!t) {
+        perror("conductor: transport_udp_open");
+        return 1;
+    }
+    transport_set_rx(t, cond_rx, NULL);
+
+    s_sent_us = calloc((size_t)s_rounds, sizeof(*s_sent_us));
+    s_sent_to = calloc((size_t)s_rounds, sizeof(*s_sent_to));
+    for (int p = 1; p <= s_n_perf; ++p) s_perf[p].rtt = calloc((size_t)s_rounds, sizeof(int64_t));
+
+    // Wait until every performer answers
+    int joined = 0;
+    for (int tries = 0; tries < 100 && joined < s_n_perf; ++tries) {
+        send_ctrl(t, NULL, MSG_HEARTBEAT, WIRE_F_ACK_REQ, 0, 0);
+        pump(t, transport_now_us(t) + 50000);
+        joined = 0;
+        for (int p = 1; p <= s_n_perf; ++p) joined += s_joined[p];
+    }
+    if (joined < s_n_perf) {
+        fprintf(stderr, "only %d of %d performers joined\n", joined, s_n_perf);
+        return 1;
+    }
+
+    // Even rounds to everyone, odd rounds to one performer in turn
+    int64_t t0 = transport_now_us(t);
+    for (int r = 0; r < s_rounds; ++r) {
+        uint8_t dst[TRANSPORT_ADDR_LEN];
+        s_sent_to[r] = (r & 1) ? (uint8_t)(1 + (r / 2) % s_n_perf) : 0;
+        if (s_sent_to[r]) addr_of(s_sent_to[r], dst);
+        for (int p = 1; p <= s_n_perf; ++p) {
+            if (!s_sent_to[r] || s_sent_to[r] == p) s_perf[p].expected++;
+        }
+        s_sent_us[r] = transport_now_us(t);
+        send_ctrl(t, s_sent_to[r] ? dst : NULL, MSG_HEARTBEAT, WIRE_F_ACK_REQ, (uint16_t)(r + 1), 0);
+        pump(t, t0 + (int64_t)(r + 1) * GAP_US);
+    }
+    int64_t elapsed = transport_now_us(t) - t0;
+    pump(t, transport_now_us(t) + DRAIN_US);
+    for (int i = 0; i < 3; ++i) send_ctrl(t, NULL, MSG_SYNC_STOP, WIRE_F_NONE, 0, STOP_SONG);
+
+    printf("%d performers, %d rounds (half broadcast, half unicast), %.0f frames/s sent\n\n",
+           s_n_perf, s_rounds, s_rounds * 1e6 / (double)elapsed);
+    printf("node   acked          rtt avg   p99      max      stray\n");
+    uint32_t acked = 0, expected = 0, stray = 0;
+    for (int p = 1; p <= s_n_perf; ++p) {
+        perf_stats_t *st = &s_perf[p];
+        qsort(st->rtt, st->acked, sizeof(int64_t), cmp_i64);
+        int64_t p99 = st->acked ? st->rtt[(st->acked * 99) / 100] : 0;
+        printf("%-6d %5u/%-5u    %5lld us %5lld us %6lld us  %u\n", p, (unsigned)st->acked,
+               (unsigned)st->expected, st->acked ? (long long)(st->rtt_sum / st->acked) : 0LL,
+               (long long)p99, (long long)st->rtt_max, (unsigned)st->stray);
+        acked += st->acked;
+        expected += st->expected;
+        stray += st->stray;
+    }
+    double rate = expected ? 100.0 * acked / expected : 0.0;
+    printf("\ndelivered %.2f%%, %u misdelivered\n", rate, (unsigned)stray);
+    transport_udp_close(t);
+    return stray == 0 && rate >= 99.0 ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    s_n_perf = argc > 1 ? atoi(argv[1]) : 4;
+    s_rounds = argc > 2 ? atoi(argv[2]) : 2000;
+    s_iface  = argc > 3 ? argv[3] : NULL;
+    if (s_n_perf < 1 || s_n_perf > MAX_PERF || s_rounds < 1 || s_rounds > 60000) {
+        fprintf(stderr, "usage: %s [performers 1..%d] [rounds] [interface address]\n", argv[0], MAX_PERF);
+        return 2;
+    }
+    // A port of our own, so parallel runs do not hear each other
+    s_port = (uint16_t)(TRANSPORT_UDP_PORT + 1 + getpid() % 1000);
+
+    pid_t pids[MAX_PERF];
+    for (int p = 1; p <= s_n_perf; ++p) {
+        pids[p - 1] = fork();
+        if (pids[p - 1] == 0) return run_performer(p);
+    }
+    int rc = run_conductor();
+    for (int p = 0; p < s_n_perf; ++p) {
+        int status;
+        if (rc != 0) kill(pids[p], SIGTERM);
+        waitpid(pids[p], &status, 0);
+    }
+    return rc;
+}
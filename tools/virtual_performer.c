@@ -0,0 +1,475 @@
+// tools/virtual_performer.c — a ROLE_PART_n performer on Linux, rendering to WAV
+//
+// Joins an orchestra session on the UDP multicast transport
+// (transport_udp.c) as tools/host_node.c: the same wire frames, clock sync,
+// ACKs and replicated state as a device, and its part rendered by the
+// audio engine's play cursor (part_mix.c) at the sample the START epoch
+// falls on. The conductor side (-C) plays a list of songs and stops each
+// after the song or after -l seconds.
+//
+// The WAV (mono, 16-bit, 44.1 kHz) carries its own timing: a bext chunk
+// whose TimeReference is the global sample of its first sample (sample g
+// sounds at g / 44100 s on the node's clock, CLOCK_MONOTONIC for the UDP
+// transport), and a cue point per START/JOIN, STOP and END labelled
+// "<what> song <id> epoch <us>". Nodes on one machine share the clock, so
+// -a lines the files up and reports per song how far apart the parts
+// started and stopped, and each start against the epoch. It exits non-zero
+// if any start spread exceeds 1 ms.
+//
+// Build & run from the repository root:
+//   cc -O2 -Iinclude -Itools tools/virtual_performer.c tools/host_node.c src/transport_udp.c src/transport.c src/wire_proto.c src/clock_sync.c src/reliable.c src/orch_state.c src/orch_ctl.c src/disco.c src/part_mix.c src/slip.c src/note_timeline.c src/synth.c src/songs.c src/song_lib.c src/song_pack.c -lm -o virtual_performer
+//   for r in 1 2 3 4; do ./virtual_performer -r $r -o part$r.wav & done
+//   ./virtual_performer -C -s 0,2 -l 8; wait
+//   ./virtual_performer -a part1.wav part2.wav part3.wav part4.wav
+//
+// Options: -p port, -i interface address (LAN; default loopback), -t secs
+// to run (performers otherwise exit 3 s after the conductor goes quiet),
+// -w secs the conductor waits before the first song (default 5: enough for
+// every performer's clock_sync window to span the 2 s it needs to fit drift).
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_node.h"
+#include "songs.h"
+
+#define MAX_CUES      256
+#define MAX_FILES     16
+#define IDLE_EXIT_US  3000000     // performer: conductor gone quiet
+#define SONG_GAP_US   1000000     // conductor: between songs
+#define ALIGN_MAX_US  1000        // -a: worst start spread accepted
+
+// bext fixed part (EBU Tech 3285 v1), TimeReference at byte 338
+#define BEXT_LEN      602
+#define BEXT_TIMEREF  338
+#define HDR_LEN       (12 + 8 + 16 + 8 + BEXT_LEN + 8)
+
+static void die(const char *what, const char *arg)
+{
+    fprintf(stderr, "virtual_performer: %s%s%s\n", what, arg ? ": " : "", arg ? arg : "");
+    exit(1);
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: virtual_performer -r 1..4 -o out.wav [-t secs] [-p port] [-i iface]\n"
+            "       virtual_performer -C [-s song,song,...] [-l secs] [-w secs] [-p port] [-i iface]\n"
+            "       virtual_performer -a file.wav file.wav ...\n");
+    exit(2);
+}
+
+static void put_u16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put_u32(uint8_t *p, uint32_t v) { put_u16(p, (uint16_t)v); put_u16(p + 2, (uint16_t)(v >> 16)); }
+static uint16_t get_u16(const uint8_t *p) { return (uint16_t)(p[0] | p[1] << 8); }
+static uint32_t get_u32(const uint8_t *p) { return get_u16(p) | (uint32_t)get_u16(p + 2) << 16; }
+
+// ----------------------
+// WAV writer
+// ----------------------
+typedef struct {
+    uint32_t pos;             // sample offset in the data chunk
+    char     label[64];
+} cue_t;
+
+typedef struct {
+    FILE    *f;
+    bool     started;
+    uint64_t first;           // global sample of data sample 0
+    uint32_t frames;
+    cue_t    cues[MAX_CUES];
+    int      n_cues;
+} wav_t;
+
+static void wav_pcm(wav_t *w, uint64_t first, const int16_t *pcm, size_t n)
+{
+    if (!w->started) {
+        w->started = true;
+        w->first   = first;
+    }
+    uint8_t buf[2 * HOST_NODE_BLOCK];
+    for (size_t i = 0; i < n; ++i) put_u16(buf + 2 * i, (uint16_t)pcm[i]);
+    if (fwrite(buf, 2, n, w->f) != n) die("write failed", NULL);
+    w->frames += (uint32_t)n;
+}
+
+static void wav_cue(wav_t *w, uint64_t sample, const char *what, const host_ev_t *ev)
+{
+    if (w->n_cues >= MAX_CUES || !w->started || sample < w->first) return;
+    cue_t *c = &w->cues[w->n_cues++];
+    c->pos = (uint32_t)(sample - w->first);
+    snprintf(c->label, sizeof(c->label), "%s song %u epoch %llu", what, (unsigned)ev->song_id,
+             (unsigned long long)ev->epoch_us);
+}
+
+// Header (sizes and TimeReference are known now), then cue + LIST/adtl after the data
+static void wav_close(wav_t *w)
+{
+    uint8_t cue[12 + 24 * MAX_CUES];
+    uint8_t list[12 + MAX_CUES * (12 + 64)];
+    size_t cue_len = 0, list_len = 0;
+    if (w->n_cues) {
+        memcpy(cue, "cue ", 4);
+        put_u32(cue + 4, 4 + 24 * (uint32_t)w->n_cues);
+        put_u32(cue + 8, (uint32_t)w->n_cues);
+        cue_len = 12;
+        memcpy(list, "LIST", 4);
+        memcpy(list + 8, "adtl", 4);
+        list_len = 12;
+        for (int i = 0; i < w->n_cues; ++i) {
+            uint8_t *p = cue + cue_len;
+            memset(p, 0, 24);
+            put_u32(p, (uint32_t)i + 1);
+            put_u32(p + 4, w->cues[i].pos);
+            memcpy(p + 8, "data", 4);
+            put_u32(p + 20, w->cues[i].pos);
+            cue_len += 24;
+
+            size_t text = strlen(w->cues[i].label) + 1;
+            uint8_t *l = list + list_len;
+            memcpy(l, "labl", 4);
+            put_u32(l + 4, (uint32_t)(4 + text));
+            put_u32(l + 8, (uint32_t)i + 1);
+            memcpy(l + 12, w->cues[i].label, text);
+            if (text & 1) l[12 + text++] = 0;
+            list_len += 12 + text;
+        }
+        put_u32(list + 4, (uint32_t)(list_len - 8));
+        fwrite(cue, 1, cue_len, w->f);
+        fwrite(list, 1, list_len, w->f);
+    }
+
+    uint8_t h[HDR_LEN];
+    memset(h, 0, sizeof(h));
+    uint32_t data_len = 2 * w->frames;
+    memcpy(h, "RIFF", 4);
+    put_u32(h + 4, (uint32_t)(HDR_LEN - 8 + data_len + cue_len + list_len));
+    memcpy(h + 8, "WAVE", 4);
+    memcpy(h + 12, "fmt ", 4);
+    put_u32(h + 16, 16);
+    put_u16(h + 20, 1);                          // PCM
+    put_u16(h + 22, 1);                          // mono
+    put_u32(h + 24, HOST_NODE_RATE);
+    put_u32(h + 28, HOST_NODE_RATE * 2);
+    put_u16(h + 32, 2);
+    put_u16(h + 34, 16);
+    uint8_t *b = h + 36;
+    memcpy(b, "bext", 4);
+    put_u32(b + 4, BEXT_LEN);
+    snprintf((char *)b + 8, 256, "orchestra virtual performer");
+    put_u32(b + 8 + BEXT_TIMEREF, (uint32_t)w->first);
+    put_u32(b + 8 + BEXT_TIMEREF + 4, (uint32_t)(w->first >> 32));
+    put_u16(b + 8 + BEXT_TIMEREF + 8, 1);        // version
+    memcpy(h + HDR_LEN - 8, "data", 4);
+    put_u32(h + HDR_LEN - 4, data_len);
+    fseek(w->f, 0, SEEK_SET);
+    fwrite(h, 1, sizeof(h), w->f);
+    fclose(w->f);
+}
+
+// ----------------------
+// Session
+// ----------------------
+typedef struct {
+    wav_t   *wav;
+    uint8_t  part;
+    int32_t  max_err;         // worst heartbeat timeline error, samples
+    uint32_t n_checks;
+} perf_ctx_t;
+
+static void perf_pcm(void *ctx, uint64_t first, const int16_t *pcm, size_t n)
+{
+    wav_pcm(((perf_ctx_t *)ctx)->wav, first, pcm, n);
+}
+
+static void perf_event(void *ctx, const host_ev_t *ev)
+{
+    perf_ctx_t *p = ctx;
+    static const char *const what[] = { "start", "stop", "end", "timeline" };
+    if (ev->type == HOST_EV_TIMELINE) {
+        int32_t e = ev->err < 0 ? -ev->err : ev->err;
+        if (e > p->max_err) p->max_err = e;
+        p->n_checks++;
+        return;
+    }
+    const char *w = (ev->type == HOST_EV_START && ev->join) ? "join" : what[ev->type];
+    printf("part %u: %-5s song %u at sample %llu (%+lld us vs epoch on the local clock)\n",
+           (unsigned)p->part, w, (unsigned)ev->song_id, (unsigned long long)ev->sample,
+           (long long)(ev->local_us - (int64_t)ev->epoch_us));
+    wav_cue(p->wav, ev->sample, w, ev);
+}
+
+// Songs from "-s 0,2,5"; all songs if none given
+static int parse_songs(const char *arg, uint8_t *song_ids)
+{
+    int n = 0;
+    if (!arg) {
+        for (; n < song_count(); ++n) song_ids[n] = (uint8_t)n;
+        return n;
+    }
+    for (const char *p = arg; *p && n < 255;) {
+        char *end;
+        long id = strtol(p, &end, 10);
+        if (end == p || id < 0 || id >= song_count()) die("bad song list", arg);
+        song_ids[n++] = (uint8_t)id;
+        p = *end == ',' ? end + 1 : end;
+        if (*end && *end != ',') die("bad song list", arg);
+    }
+    return n;
+}
+
+// Pump the transport until the node's next timer or block is due
+static void pump(host_node_t *n)
+{
+    int64_t now = transport_now_us(n->tp);
+    host_node_poll(n);
+    host_node_render(n, now);
+    int64_t wait = host_node_next_us(n) - transport_now_us(n->tp);
+    if (wait > 50000) wait = 50000;
+    transport_poll(n->tp, wait > 0 ? (int)(wait / 1000) : 0);
+}
+
+static int run_conductor(transport_t *tp, const uint8_t *song_ids, int n_songs, double limit_s, double wait_s)
+{
+    static host_node_t n;
+    int64_t now = transport_now_us(tp);
+    host_node_init(&n, tp, HOST_NODE_CONDUCTOR, (uint16_t)(now ^ (now >> 16)), NULL, NULL, NULL);
+
+    int64_t next = now + (int64_t)(wait_s * 1e6);
+    bool playing = false;
+    for (int i = 0; i < n_songs || playing;) {
+        pump(&n);
+        now = transport_now_us(tp);
+        if (now < next) continue;
+        if (playing) {
+            host_node_stop(&n);
+            playing = false;
+            next = now + SONG_GAP_US;
+            i++;
+            continue;
+        }
+        uint64_t epoch = host_node_start(&n, song_ids[i]);
+        int64_t len_us = (int64_t)song_duration_ms(song_ids[i]) * 1000;
+        if (limit_s > 0 && limit_s * 1e6 < len_us) len_us = (int64_t)(limit_s * 1e6);
+        next = (int64_t)epoch + len_us + 200000;
+        playing = true;
+        printf("conductor: song %u (%s), epoch %llu, %d performers\n", (unsigned)song_ids[i],
+               song_get(song_ids[i])->name, (unsigned long long)epoch, (int)n.acks);
+    }
+    for (int64_t end = transport_now_us(tp) + 500000; transport_now_us(tp) < end;) pump(&n);
+
+    const reliable_tx_t *rtx = host_node_delivery(&n);
+    for (int i = 0; i < rtx->n_peers; ++i) {
+        const reliable_peer_stats_t *p = &rtx->peers[i];
+        printf("conductor: performer %u: %u/%u commands acked, %u retries, avg %lld us\n",
+               (unsigned)p->mac[5], (unsigned)p->delivered, (unsigned)p->sent, (unsigned)p->retries,
+               p->delivered ? (long long)(p->lat_sum_us / p->delivered) : 0LL);
+    }
+    return 0;
+}
+
+static int run_performer(transport_t *tp, uint8_t part, const char *out_path, double run_s)
+{
+    static host_node_t n;
+    static wav_t wav;
+    perf_ctx_t ctx = { .wav = &wav, .part = part };
+    wav.f = fopen(out_path, "wb");
+    if (!wav.f) die("cannot open", out_path);
+    fseek(wav.f, HDR_LEN, SEEK_SET);
+    host_node_init(&n, tp, part, 0, perf_pcm, perf_event, &ctx);
+
+    int64_t start = transport_now_us(tp);
+    for (;;) {
+        int64_t now = transport_now_us(tp);
+        if (run_s > 0 ? now - start >= (int64_t)(run_s * 1e6) : n.ctl.heard_us && now - n.ctl.heard_us >= IDLE_EXIT_US) break;
+        pump(&n);
+    }
+    printf("part %u: %.1f s written, %u timeline checks, worst %d samples, %u slips, %u jumps\n",
+           (unsigned)part, wav.frames / (double)HOST_NODE_RATE, (unsigned)ctx.n_checks,
+           (int)ctx.max_err, (unsigned)(n.slip.skipped + n.slip.repeated), (unsigned)n.slip.jumps);
+    wav_close(&wav);
+    return 0;
+}
+
+// ----------------------
+// Alignment (-a)
+// ----------------------
+typedef struct {
+    char     what[8];         // start / join / stop / end
+    unsigned song;
+    uint64_t epoch;
+    uint64_t sample;          // global
+} mark_t;
+
+typedef struct {
+    const char *path;
+    mark_t      marks[MAX_CUES];
+    int         n;
+} marks_t;
+
+static void read_marks(const char *path, marks_t *m)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) die("cannot open", path);
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = malloc((size_t)len);
+    if (!buf || fread(buf, 1, (size_t)len, f) != (size_t)len) die("cannot read", path);
+    fclose(f);
+    if (len < 12 || memcmp(buf, "RIFF", 4) || memcmp(buf + 8, "WAVE", 4)) die("not a WAV file", path);
+
+    uint64_t timeref = 0;
+    bool have_ref = false;
+    uint32_t cue_pos[MAX_CUES + 1] = { 0 };
+    m->path = path;
+    m->n = 0;
+    for (long p = 12; p + 8 <= len;) {
+        uint32_t sz = get_u32(buf + p + 4);
+        const uint8_t *d = buf + p + 8;
+        if (p + 8 + (long)sz > len) break;
+        if (!memcmp(buf + p, "fmt ", 4) && sz >= 16 && get_u32(d + 4) != HOST_NODE_RATE) {
+            die("sample rate is not 44100", path);
+        } else if (!memcmp(buf + p, "bext", 4) && sz >= BEXT_TIMEREF + 8) {
+            timeref  = get_u32(d + BEXT_TIMEREF) | (uint64_t)get_u32(d + BEXT_TIMEREF + 4) << 32;
+            have_ref = true;
+        } else if (!memcmp(buf + p, "cue ", 4) && sz >= 4) {
+            for (uint32_t i = 0; i < get_u32(d) && 4 + 24 * (i + 1) <= sz; ++i) {
+                uint32_t id = get_u32(d + 4 + 24 * i);
+                if (id >= 1 && id <= MAX_CUES) cue_pos[id] = get_u32(d + 4 + 24 * i + 20);
+            }
+        } else if (!memcmp(buf + p, "LIST", 4) && sz >= 4 && !memcmp(d, "adtl", 4)) {
+            for (uint32_t q = 4; q + 12 <= sz;) {
+                uint32_t lsz = get_u32(d + q + 4);
+                uint32_t id  = get_u32(d + q + 8);
+                mark_t *k = &m->marks[m->n];
+                unsigned long long epoch;
+                if (!memcmp(d + q, "labl", 4) && lsz > 4 && q + 8 + lsz <= sz && id >= 1 && id <= MAX_CUES
+                    && m->n < MAX_CUES
+                    && sscanf((const char *)d + q + 12, "%7s song %u epoch %llu", k->what, &k->song, &epoch) == 3) {
+                    k->epoch  = epoch;
+                    k->sample = id;   // resolved below, cues may come later
+                    m->n++;
+                }
+                q += 8 + lsz + (lsz & 1);
+            }
+        }
+        p += 8 + (long)sz + (sz & 1);
+    }
+    free(buf);
+    if (!have_ref) die("no bext TimeReference (not written by virtual_performer?)", path);
+    for (int i = 0; i < m->n; ++i) m->marks[i].sample = timeref + cue_pos[m->marks[i].sample];
+}
+
+static const mark_t *find_mark(const marks_t *m, uint64_t epoch, bool start)
+{
+    for (int i = 0; i < m->n; ++i) {
+        const mark_t *k = &m->marks[i];
+        bool is_start = !strcmp(k->what, "start") || !strcmp(k->what, "join");
+        if (k->epoch == epoch && is_start == start) return k;
+    }
+    return NULL;
+}
+
+static int run_align(char **paths, int n_files)
+{
+    static marks_t files[MAX_FILES];
+    for (int i = 0; i < n_files; ++i) read_marks(paths[i], &files[i]);
+
+    // Every epoch that any file started, in order of appearance
+    uint64_t epochs[MAX_CUES];
+    unsigned song_of[MAX_CUES];
+    int n_epochs = 0;
+    for (int i = 0; i < n_files; ++i) {
+        for (int j = 0; j < files[i].n; ++j) {
+            const mark_t *k = &files[i].marks[j];
+            if (strcmp(k->what, "start") && strcmp(k->what, "join")) continue;
+            int e = 0;
+            while (e < n_epochs && epochs[e] != k->epoch) e++;
+            if (e == n_epochs && n_epochs < MAX_CUES) {
+                song_of[n_epochs] = k->song;
+                epochs[n_epochs++] = k->epoch;
+            }
+        }
+    }
+
+    int rc = n_epochs ? 0 : 1;
+    for (int e = 0; e < n_epochs; ++e) {
+        printf("song %u, epoch %llu\n", song_of[e], (unsigned long long)epochs[e]);
+        uint64_t s_min = UINT64_MAX, s_max = 0, t_min = UINT64_MAX, t_max = 0;
+        int n_start = 0, n_stop = 0;
+        for (int i = 0; i < n_files; ++i) {
+            const mark_t *s = find_mark(&files[i], epochs[e], true);
+            const mark_t *t = find_mark(&files[i], epochs[e], false);
+            printf("  %-24s", files[i].path);
+            if (s) {
+                int64_t us = host_node_sample_us(s->sample) - (int64_t)epochs[e];
+                printf("  %-5s %+7lld us vs epoch", s->what, (long long)us);
+                if (s->sample < s_min) s_min = s->sample;
+                if (s->sample > s_max) s_max = s->sample;
+                n_start++;
+            } else {
+                printf("  %-26s", "(no start)");
+            }
+            if (t) {
+                printf("   %s at +%.3f s", t->what,
+                       (t->sample - (s ? s->sample : t->sample)) / (double)HOST_NODE_RATE);
+                if (t->sample < t_min) t_min = t->sample;
+                if (t->sample > t_max) t_max = t->sample;
+                n_stop++;
+            }
+            printf("\n");
+        }
+        double start_us = n_start ? (s_max - s_min) * 1e6 / HOST_NODE_RATE : 0;
+        double stop_us  = n_stop ? (t_max - t_min) * 1e6 / HOST_NODE_RATE : 0;
+        printf("  start spread %.1f us (%llu samples) over %d parts, stop spread %.1f us over %d\n\n",
+               start_us, (unsigned long long)(n_start ? s_max - s_min : 0), n_start, stop_us, n_stop);
+        if (n_start < 2 || start_us > ALIGN_MAX_US) rc = 1;
+    }
+    printf("%s\n", rc ? "FAIL" : "aligned");
+    return rc;
+}
+
+int main(int argc, char **argv)
+{
+    const char *out_path = NULL, *song_arg = NULL, *iface = NULL;
+    int part = 0, conductor = 0, align = 0;
+    uint16_t port = TRANSPORT_UDP_PORT;
+    double run_s = 0, limit_s = 0, wait_s = 5.0;
+    char *files[MAX_FILES];
+    int n_files = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-r") && i + 1 < argc) part = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) out_path = argv[++i];
+        else if (!strcmp(argv[i], "-C")) conductor = 1;
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc) song_arg = argv[++i];
+        else if (!strcmp(argv[i], "-l") && i + 1 < argc) limit_s = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-w") && i + 1 < argc) wait_s = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) run_s = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-p") && i + 1 < argc) port = (uint16_t)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-i") && i + 1 < argc) iface = argv[++i];
+        else if (!strcmp(argv[i], "-a")) align = 1;
+        else if (align && argv[i][0] != '-' && n_files < MAX_FILES) files[n_files++] = argv[i];
+        else usage();
+    }
+    if (align) return n_files ? run_align(files, n_files) : (usage(), 2);
+    if (conductor == (part != 0) || (part && (part > 4 || !out_path))) usage();
+
+    transport_t *tp = transport_udp_open(conductor ? 0 : (uint16_t)part, TRANSPORT_UDP_GROUP, port, iface);
+    if (!tp) die("cannot open the UDP transport", iface);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    int rc;
+    if (conductor) {
+        uint8_t song_ids[255];
+        int n_songs = parse_songs(song_arg, song_ids);
+        rc = run_conductor(tp, song_ids, n_songs, limit_s, wait_s);
+    } else {
+        rc = run_performer(tp, (uint8_t)part, out_path, run_s);
+    }
+    transport_udp_close(tp);
+    return rc;
+}
@@ -0,0 +1,238 @@
+// tools/wire_bench.c — frame size and parse cost: wire_proto vs raw structs
+//
+// Compares the packed wire format (src/wire_proto.c) with the structs that
+// used to go on air as-is (espnow_msg_t, discovery_msg_t, copied here
+// verbatim): bytes per frame and ns per parse. Also round-trips every
+// payload type and checks that corrupted, truncated and foreign-version
+// frames are rejected. Exits non-zero on any failure.
+//
+// Build & run from the repository root:
+//   cc -O2 -Iinclude tools/wire_bench.c src/wire_proto.c -o wire_bench
+//   ./wire_bench
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "wire_proto.h"
+
+// ----------------------
+// Legacy on-air structs
+// ----------------------
+typedef enum { L_MSG_SYNC_START = 0, L_MSG_SYNC_STOP, L_MSG_SONG_SELECT, L_MSG_HEARTBEAT } legacy_msg_type_t;
+
+typedef struct {
+    legacy_msg_type_t type;
+    uint8_t song_id;
+    uint64_t timestamp;
+    uint8_t sender_id;
+} legacy_espnow_msg_t;
+
+typedef struct {
+    int      type;          // discovery_msg_type_t
+    int      role;          // device_role_t
+    uint8_t  mac_address[6];
+    char     device_name[32];
+    uint32_t timestamp;
+} legacy_discovery_msg_t;
+
+#define ITERS 5000000
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static volatile uint64_t sink;
+
+// Receive path of the old espnow_recv_cb(): length check + memcpy
+static int legacy_parse_ctrl(const uint8_t *data, int len, legacy_espnow_msg_t *out)
+{
+    if (len != (int)sizeof(*out)) return 0;
+    memcpy(out, data, sizeof(*out));
+    return 1;
+}
+
+static int wire_parse_ctrl(const uint8_t *data, int len, wire_ctrl_t *out)
+{
+    wire_frame_t f;
+    if (wire_parse(data, (size_t)len, &f) != WIRE_OK) return 0;
+    return wire_get_ctrl(&f, out);
+}
+
+static size_t build_ctrl(uint8_t *buf, uint8_t type, uint16_t seq, const wire_ctrl_t *c)
+{
+    wire_writer_t w;
+    wire_begin(&w, buf, WIRE_MAX_FRAME, type, WIRE_F_NONE, 3, seq);
+    wire_put_ctrl(&w, c);
+    return wire_finish(&w);
+}
+
+static size_t build_disco(uint8_t *buf, const wire_disco_t *d)
+{
+    wire_writer_t w;
+    wire_begin(&w, buf, WIRE_MAX_FRAME, WIRE_T_DISCO, WIRE_F_NONE, 1, 7);
+    wire_put_disco(&w, d);
+    return wire_finish(&w);
+}
+
+static size_t build_clock(uint8_t *buf, int response, const wire_clock_t *c)
+{
+    wire_writer_t w;
+    wire_begin(&w, buf, WIRE_MAX_FRAME, response ? 5 : 4, WIRE_F_NONE, 2, 9);
+    wire_put_clock(&w, response, c);
+    return wire_finish(&w);
+}
+
+// ----------------------
+// Correctness
+// ----------------------
+static int checks(void)
+{
+    int bad = 0;
+    uint8_t buf[WIRE_MAX_FRAME];
+    wire_frame_t f;
+
+    #define CHECK(cond, what) do { if (!(cond)) { printf("  FAIL: %s\n", what); bad++; } } while (0)
+
+    // Known CRC-16/CCITT-FALSE check value
+    CHECK(wire_crc16((const uint8_t *)"123456789", 9) == 0x29B1, "crc16 check value");
+
+    wire_ctrl_t c = { .song_id = 7, .timestamp = 0x0123456789ABCDEFull }, c2;
+    size_t n = build_ctrl(buf, 0, 0xBEEF, &c);
+    CHECK(wire_parse(buf, n, &f) == WIRE_OK, "ctrl parses");
+    CHECK(f.seq == 0xBEEF && f.sender == 3 && f.type == 0, "ctrl header");
+    CHECK(wire_get_ctrl(&f, &c2) && c2.song_id == 7 && c2.timestamp == c.timestamp, "ctrl payload");
+
+    wire_ctrl_t cs = c;
+    cs.has_state = true;
+    cs.state = (orch_state_t){ .boot_id = 0x1234, .version = 0xFFFF, .playing = true, .song_id = 5,
+                               .start_epoch_us = 0x0102030405060708ull, .tempo_pct = 100,
+                               .volume_q15 = 2621 };
+    n = build_ctrl(buf, 3, 2, &cs);
+    CHECK(wire_parse(buf, n, &f) == WIRE_OK && wire_get_ctrl(&f, &c2) && c2.has_state &&
+          c2.state.boot_id == 0x1234 && c2.state.version == 0xFFFF && c2.state.playing &&
+          c2.state.song_id == 5 && c2.state.start_epoch_us == cs.state.start_epoch_us &&
+          c2.state.tempo_pct == 100 && c2.state.volume_q15 == 2621, "ctrl + state round trip");
+    n = build_ctrl(buf, 3, 2, &c);
+    CHECK(wire_parse(buf, n, &f) == WIRE_OK && wire_get_ctrl(&f, &c2) && !c2.has_state,
+          "ctrl from an older sender has no state");
+
+    wire_clock_t k = { .target = 4, .req_seq = 77, .t1 = 1, .t2 = 2, .t3 = 3 }, k2;
+    n = build_clock(buf, 1, &k);
+    CHECK(wire_parse(buf, n, &f) == WIRE_OK && wire_get_clock(&f, 1, &k2) &&
+          k2.target == 4 && k2.req_seq == 77 && k2.t1 == 1 && k2.t2 == 2 && k2.t3 == 3, "clock resp");
+
+    wire_disco_t d = { .role = 2, .mac = { 1, 2, 3, 4, 5, 6 }, .timestamp = 1234 }, d2;
+    strcpy(d.name, "M5GO-PART_2");
+    n = build_disco(buf, &d);
+    CHECK(wire_parse(buf, n, &f) == WIRE_OK && WIRE_T_IS_DISCO(f.type) && wire_get_disco(&f, &d2) &&
+          d2.role == 2 && memcmp(d2.mac, d.mac, 6) == 0 && strcmp(d2.name, d.name) == 0 &&
+          d2.timestamp == 1234, "disco round trip");
+
+    // Every single-bit flip must be caught
+    n = build_ctrl(buf, 0, 1, &c);
+    unsigned missed = 0;
+    for (size_t i = 0; i < n * 8; ++i) {
+        buf[i / 8] ^= (uint8_t)(1u << (i % 8));
+        if (wire_parse(buf, n, &f) == WIRE_OK) missed++;
+        buf[i / 8] ^= (uint8_t)(1u << (i % 8));
+    }
+    CHECK(missed == 0, "single-bit errors detected");
+
+    CHECK(wire_parse(buf, n - 1, &f) == WIRE_ERR_LEN, "truncated frame rejected");
+    CHECK(wire_parse(buf, 5, &f) == WIRE_ERR_SHORT, "short frame rejected");
+    legacy_espnow_msg_t old = { L_MSG_SYNC_START, 1, 123, 0 };
+    CHECK(wire_parse((const uint8_t *)&old, sizeof(old), &f) != WIRE_OK, "legacy struct rejected");
+
+    // Minor version bump with an appended field: still readable
+    wire_writer_t w;
+    wire_begin(&w, buf, sizeof(buf), 0, 0, 3, 1);
+    w.buf[1] = (WIRE_VERSION_MAJOR << 4) | (WIRE_VERSION_MINOR + 1);
+    wire_put_ctrl(&w, &cs);
+    wire_put_u32(&w, 0xDEADBEEF);   // field from the future
+    n = wire_finish(&w);
+    CHECK(wire_parse(buf, n, &f) == WIRE_OK && wire_get_ctrl(&f, &c2) && c2.timestamp == c.timestamp &&
+          c2.has_state && c2.state.version == cs.state.version, "newer minor version readable");
+
+    // Different major version: rejected
+    wire_begin(&w, buf, sizeof(buf), 0, 0, 3, 1);
+    w.buf[1] = (uint8_t)((WIRE_VERSION_MAJOR + 1) << 4);
+    wire_put_ctrl(&w, &c);
+    n = wire_finish(&w);
+    CHECK(wire_parse(buf, n, &f) == WIRE_ERR_VERSION, "other major version rejected");
+
+    #undef CHECK
+    return bad;
+}
+
+// ----------------------
+// Cost
+// ----------------------
+static void bench(void)
+{
+    uint8_t buf[WIRE_MAX_FRAME];
+    wire_ctrl_t c = { .song_id = 3, .timestamp = 123456789 };
+    size_t wlen = build_ctrl(buf, 0, 1, &c);
+
+    legacy_espnow_msg_t lm = { L_MSG_SYNC_START, 3, 123456789, 1 };
+    uint8_t lbuf[sizeof(lm)];
+    memcpy(lbuf, &lm, sizeof(lm));
+
+    wire_disco_t d = { .role = 2, .mac = { 1, 2, 3, 4, 5, 6 }, .timestamp = 1234 };
+    strcpy(d.name, "M5GO-PART_2");
+    uint8_t dbuf[WIRE_MAX_FRAME];
+    size_t dlen = build_disco(dbuf, &d);
+
+    wire_clock_t k = { .target = 4, .req_seq = 77, .t1 = 1, .t2 = 2, .t3 = 3 };
+    uint8_t kbuf[WIRE_MAX_FRAME];
+    size_t req_len  = build_clock(kbuf, 0, &k);
+    size_t resp_len = build_clock(kbuf, 1, &k);
+
+    printf("%-22s %8s %8s\n", "frame", "legacy", "wire");
+    wire_ctrl_t cs = c;
+    cs.has_state = true;
+    uint8_t sbuf[WIRE_MAX_FRAME];
+    size_t slen = build_ctrl(sbuf, 0, 1, &cs);
+
+    printf("%-22s %7zuB %7zuB\n", "control (START etc.)", sizeof(legacy_espnow_msg_t), wlen);
+    printf("%-22s %8s %7zuB\n", "  ... with state", "-", slen);
+    printf("%-22s %7zuB %7zuB\n", "discovery", sizeof(legacy_discovery_msg_t), dlen);
+    printf("%-22s %8s %7zuB / %zuB\n", "clock req / resp", "-", req_len, resp_len);
+
+    double t0 = now_s();
+    for (long i = 0; i < ITERS; ++i) {
+        legacy_espnow_msg_t m;
+        lbuf[1] = (uint8_t)i;
+        sink += legacy_parse_ctrl(lbuf, (int)sizeof(lbuf), &m) + m.timestamp;
+    }
+    double t1 = now_s();
+    for (long i = 0; i < ITERS; ++i) {
+        wire_ctrl_t m;
+        sink += wire_parse_ctrl(buf, (int)wlen, &m) + m.timestamp;
+    }
+    double t2 = now_s();
+    for (long i = 0; i < ITERS; ++i) {
+        c.song_id = (uint8_t)i;
+        sink += build_ctrl(buf, 0, (uint16_t)i, &c);
+    }
+    double t3 = now_s();
+
+    printf("\nparse control frame:  legacy %6.1f ns   wire %6.1f ns (header + CRC + decode)\n",
+           (t1 - t0) * 1e9 / ITERS, (t2 - t1) * 1e9 / ITERS);
+    printf("build control frame:  wire %6.1f ns\n", (t3 - t2) * 1e9 / ITERS);
+}
+
+int main(void)
+{
+    printf("== Correctness ==\n");
+    int bad = checks();
+    printf("  %s\n", bad ? "FAILED" : "all checks passed");
+
+    printf("\n== Size and cost ==\n");
+    bench();
+    return bad ? 1 : 0;
+}